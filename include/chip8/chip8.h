@@ -0,0 +1,224 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <chip8/display.h>
+
+namespace chip8
+{
+
+	enum class Platform : std::uint8_t
+	{
+		chip8,
+		schip,
+		xoChip,
+	};
+
+	const char *platformName(Platform platform);
+
+	//The behaviours that differ between interpreters.
+	//Use defaultQuirks to get the usual set for a platform.
+	struct Quirks
+	{
+		bool vfReset = true;          //8XY1, 8XY2 and 8XY3 set VF to 0
+		bool memoryIncrement = true;  //FX55 and FX65 leave I after the last register
+		bool displayWait = true;      //DXYN waits for the vertical blank (ends the frame) in lores
+		bool clipping = true;         //sprites are clipped at the screen edges instead of wrapping
+		bool shiftVx = false;         //8XY6 and 8XYE shift VX instead of VY
+		bool jumpVx = false;          //BXNN jumps to XNN + VX instead of NNN + V0
+	};
+
+	Quirks defaultQuirks(Platform platform);
+
+	//packed in the order of the fields, for files and plugins
+	std::uint32_t quirksToBits(const Quirks &quirks);
+	Quirks quirksFromBits(std::uint32_t bits);
+	int defaultInstructionsPerFrame(Platform platform);
+
+	//How runFrame decides when the frame is over.
+	enum class Timing : std::uint8_t
+	{
+		instructions, //instructionsPerFrame instructions
+		cosmacVip,    //the machine cycles of the VIP interpreter, see vipTiming.h
+	};
+
+	constexpr int memorySize = 0x10000; //xo-chip has 64 KB, the others only use the first 4 KB
+	constexpr int stackSize = 16;
+	constexpr std::uint16_t programStart = 0x200;
+	constexpr std::uint16_t smallFontAddress = 0x50;
+	constexpr std::uint16_t bigFontAddress = 0xA0;
+
+	//Everything the program can observe. It is a plain struct so a snapshot is just a copy.
+	struct State
+	{
+		std::uint8_t memory[memorySize] = {};
+		std::uint8_t v[16] = {};
+		std::uint16_t i = 0;
+		std::uint16_t pc = programStart;
+		std::uint16_t stack[stackSize] = {};
+		std::uint8_t sp = 0;
+
+		std::uint8_t delayTimer = 0;
+		std::uint8_t soundTimer = 0;
+
+		std::uint8_t planeMask = 1; //xo-chip FX01, the planes DXYN, 00E0 and the scrolls work on
+		std::uint8_t pitch = 64; //xo-chip FX3A
+		std::uint8_t audioPattern[16] = {}; //xo-chip F002
+		std::uint8_t flags[16] = {}; //schip FX75 and FX85
+
+		std::uint16_t keys = 0; //bit N set means key N is down
+		std::uint16_t waitKeys = 0; //keys pressed since FX0A started waiting
+		std::uint8_t keyRegister = 0;
+		bool waitingForKey = false;
+		bool halted = false; //00FD
+
+		std::uint32_t rng = 1; //xorshift state for CXNN, part of the state so runs are deterministic
+
+		//Bit N is set when row N of the display changed since the last takeDirtyRows.
+		//Set by DXYN (only for the rows the sprite touched), 00E0, the scrolls and resolution changes.
+		std::uint64_t dirtyRows = ~0ull;
+
+		//Timing::cosmacVip, the machine cycles left in the frame, negative when the last instruction
+		//ran past the end of the frame. The debt is paid at the start of the next one.
+		std::int32_t cycleBalance = 0;
+
+		std::uint64_t instructionCount = 0;
+		std::uint64_t frameCount = 0;
+
+		Display display;
+
+		//Kept up to date by every write to the memory and the display so hashState doesn't
+		//have to read 66 KB. Use writeMemory to change the memory and call rehashState after
+		//editing the memory or the display any other way.
+		std::uint64_t memoryHash = 0;
+		std::uint64_t displayHash = 0;
+	};
+
+	//The key of one memory byte in State::memoryHash. The hash xors the keys of all non zero bytes
+	//so a write only removes the key of the old value and adds the one of the new value.
+	inline std::uint64_t memoryByteKey(std::uint32_t address, std::uint8_t value)
+	{
+		if (!value) { return 0; }
+
+		//splitmix64 finalizer
+		std::uint64_t z = (((std::uint64_t)address << 8) | value) + 0x9E3779B97F4A7C15ull;
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		return z ^ (z >> 31);
+	}
+
+	//address has to be masked already
+	inline void writeMemory(State &state, std::uint32_t address, std::uint8_t value)
+	{
+		std::uint8_t &byte = state.memory[address];
+		state.memoryHash ^= memoryByteKey(address, byte) ^ memoryByteKey(address, value);
+		byte = value;
+	}
+
+	//the key of one display row in State::displayHash, 0 for an empty row
+	std::uint64_t displayRowKey(int plane, int row, const std::uint8_t *bytes);
+
+	//recomputes memoryHash and displayHash from scratch
+	void rehashState(State &state);
+
+	//A hash of everything the program can observe (not the counters or the dirty rows),
+	//two runs with the same hash every frame behaved the same.
+	//It only reads the registers, the memory and the display come from the incremental hashes.
+	std::uint64_t hashState(const State &state);
+
+	//False for a state the core can't run: the stack pointer, the key register or the planes out of range,
+	//or a bool that isn't 0 or 1. Check a state that came from outside (a client, the network) before running it.
+	bool validState(const State &state);
+
+	constexpr std::uint32_t defaultSeed = 0x2545F491;
+
+	//Runs recompiled code from state.pc until it reaches an instruction it doesn't translate
+	//(drawing, key waits, code it didn't know about or that was changed) or the budget runs out.
+	//Returns the number of instructions executed, the interpreter continues from state.pc.
+	using CompiledRunner = int (*)(State &state, int budget);
+
+	struct Debugger;
+
+	struct Chip8
+	{
+		State state;
+
+		Platform platform = Platform::chip8;
+		Quirks quirks = {};
+		int instructionsPerFrame = 11;
+		std::uint16_t memoryMask = 0xFFF;
+		std::uint32_t seed = defaultSeed; //the one reset was called with, movies store it
+
+		//set by the owner after reset like instructionsPerFrame, the recompiled code is not used with the VIP timing
+		Timing timing = Timing::instructions;
+
+		//set by the owner after loading a rom that has a recompiled plugin, cleared by reset
+		CompiledRunner compiled = nullptr;
+
+		//Set by the owner, kept by reset. The frames only pay for it while it has something set,
+		//the recompiled code is not used then. See debugger.h.
+		Debugger *debugger = nullptr;
+
+		//Clears the state and loads the fonts. The rom has to be loaded again after this.
+		void reset(Platform platform, Quirks quirks, std::uint32_t seed = defaultSeed);
+		void reset(Platform platform) { reset(platform, defaultQuirks(platform)); }
+
+		//Replaces the state with one taken between two frames, a frame the debugger stopped is dropped.
+		void restoreState(const State &snapshot)
+		{
+			if (&snapshot != &state) { state = snapshot; }
+			resumeExecuted = -1;
+			keyWaitEnded = false;
+		}
+
+		//copies the rom at 0x200, returns false if it doesn't fit in the memory of the platform
+		bool loadRom(const std::uint8_t *data, std::size_t size);
+
+		//Executes one instruction. Does nothing while halted or waiting for a key.
+		void step();
+
+		//Executes up to instructionsPerFrame instructions (or the VIP cycles of a frame with Timing::cosmacVip),
+		//stops early on the display wait and while waiting for a key, then ticks the timers.
+		//Returns the number of executed instructions.
+		//When the debugger stops in the middle, the frame is not over (see midFrame) and the next call finishes it.
+		int runFrame();
+
+		//true after the debugger stopped a frame before its end
+		bool midFrame() const { return resumeExecuted >= 0; }
+
+		void setKeys(std::uint16_t keys) { state.keys = keys; }
+
+		//returns the rows that changed since the last call and clears them
+		std::uint64_t takeDirtyRows()
+		{
+			std::uint64_t rows = state.dirtyRows;
+			state.dirtyRows = 0;
+			return rows;
+		}
+
+	private:
+
+		//The loop of runFrame, one per timing so the instruction count loop doesn't pay for the cycle table,
+		//and one with the checks of the debugger so the others don't pay for those.
+		template <Timing mode, bool debug> int runFrameWith();
+		template <bool debug> void stepWith();
+		bool finishKeyWait();
+		template <bool debug> void store(std::uint32_t address, std::uint8_t value);
+
+		void draw(int xRegister, int yRegister, int n);
+		void clearDisplay();
+		void scrollDown(int n);
+		void scrollUp(int n);
+		void scrollRight();
+		void scrollLeft();
+		void setHires(bool hires);
+		void rehashDisplay();
+		void toggleRowHash(int plane, int row);
+		void skip();
+		std::uint8_t random();
+
+		bool drewThisInstruction = false; //used for the display wait
+		int resumeExecuted = -1; //the instructions the frame the debugger stopped ran already
+		bool keyWaitEnded = false; //the next instruction ends the frame, kept over a stop of the debugger before it
+	};
+
+}
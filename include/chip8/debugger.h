@@ -0,0 +1,255 @@
+#pragma once
+#include <algorithm>
+#include <bitset>
+#include <cstdint>
+#include <vector>
+#include <chip8/chip8.h>
+#include <chip8/memoryHeat.h>
+#include <chip8/romProfiler.h>
+#include <chip8/trace.h>
+
+namespace chip8
+{
+
+	//Breakpoints and watchpoints for Chip8::debugger.
+	//The core only runs its debug loop while armed() is true, without a debugger or with nothing set
+	//the frames run the normal loop. In the debug loop every instruction looks up its address in a bit set,
+	//only the instructions with a breakpoint evaluate the conditions.
+	//When the core stops in the middle of a frame, the next runFrame finishes that frame.
+	struct Debugger
+	{
+		//what a condition compares with its value
+		enum Operand : std::uint8_t
+		{
+			operandV0 = 0, //to operandVF = 15
+			operandI = 16,
+			operandDelayTimer = 17,
+		};
+
+		enum class Compare : std::uint8_t
+		{
+			always,
+			equal,
+			notEqual,
+			less,
+			lessEqual,
+			greater,
+			greaterEqual,
+		};
+
+		//stops before the instruction at address runs when the condition holds
+		struct Breakpoint
+		{
+			std::uint16_t address = programStart;
+			Compare compare = Compare::always;
+			std::uint8_t operand = operandV0;
+			std::uint16_t value = 0;
+			bool enabled = true;
+			std::uint64_t hits = 0;
+		};
+
+		//stops after an instruction wrote a memory range or changed a register
+		struct Watchpoint
+		{
+			enum Kind : std::uint8_t
+			{
+				memory,   //any write to address .. address + size - 1, even of the same value
+				registerV, //V[address] changed
+				registerI, //I changed
+			};
+
+			Kind kind = memory;
+			std::uint16_t address = 0;
+			std::uint16_t size = 1;
+			bool enabled = true;
+			std::uint64_t hits = 0;
+		};
+
+		enum class StopReason : std::uint8_t
+		{
+			none,
+			breakpoint,
+			watchpoint,
+			step,   //stepInstructions ran out or runToInstruction got there
+			paused, //set by the owner, the core doesn't stop for it
+			rewound, //set by History after going back, the core doesn't stop for it
+		};
+
+		struct Stop
+		{
+			StopReason reason = StopReason::none;
+			int index = -1; //of the breakpoint or watchpoint
+			std::uint16_t pc = 0; //of the next instruction, with the memoryMask applied
+			std::uint16_t instructionPc = 0; //of the instruction that wrote, for watchpoints
+			std::uint16_t address = 0; //what the watchpoint saw written
+			std::uint16_t oldValue = 0;
+			std::uint16_t newValue = 0;
+		};
+
+		std::vector<Breakpoint> breakpoints;
+		std::vector<Watchpoint> watchpoints;
+
+		//call after changing breakpoints or watchpoints, it builds the bit sets the core checks
+		void update();
+
+		//Stops after this many instructions. While it runs the breakpoints still stop first.
+		void stepInstructions(std::uint32_t count);
+
+		static constexpr std::uint64_t noInstruction = ~0ull;
+
+		//Stops after the instruction that makes State::instructionCount reach count, noInstruction clears it.
+		void runToInstruction(std::uint64_t count) { stopAtInstruction = count; }
+
+		//clears the stop, a breakpoint at the instruction the core stopped at doesn't stop again right away
+		void resume();
+
+		bool stopped() const { return stop.reason != StopReason::none; }
+		bool armed() const
+		{
+			return anyBreakpoint || anyMemoryWatch || anyRegisterWatch || stepsLeft || trace || heat || profiler ||
+				stopAtInstruction != noInstruction;
+		}
+
+		Stop stop;
+
+		//records every instruction the debug loop runs while set
+		Trace *trace = nullptr;
+
+		//counts the reads, writes and executes of every byte while set
+		MemoryHeat *heat = nullptr;
+
+		//counts and times the instructions by address, opcode and call stack while set
+		RomProfiler *profiler = nullptr;
+
+		//the checks of the debug loop of the core, see runFrameWith
+
+		//true to stop before the instruction at state.pc, a PC past the memory runs the wrapped address like the core
+		bool beforeInstruction(const State &state, std::uint32_t memoryMask)
+		{
+			if (anyRegisterWatch || trace)
+			{
+				std::copy(state.v, state.v + 16, registersBefore);
+				iBefore = state.i;
+			}
+			pcMask = memoryMask;
+			instructionPc = (std::uint16_t)(state.pc & memoryMask);
+			if (trace || profiler)
+			{
+				instructionOpcode = (std::uint16_t)(state.memory[instructionPc] << 8 | state.memory[(instructionPc + 1) & memoryMask]);
+			}
+
+			if (anyBreakpoint && breakAt.test(instructionPc) && instructionPc != resumePc && checkBreakpoints(state)) { return true; }
+
+			//last so the checks aren't timed
+			if (profiler) { profiler->beforeInstruction(); }
+			return false;
+		}
+
+		//memoryMask applied already
+		void memoryWritten(std::uint32_t address, std::uint8_t oldValue, std::uint8_t newValue)
+		{
+			if (heat) { heat->count(MemoryHeat::write, address); }
+			if (watchAt.test(address)) { checkMemoryWatch(address, oldValue, newValue); }
+		}
+
+		//the instruction reads count bytes from address, the sprites of DXYN and the loads
+		void memoryRead(std::uint32_t address, int count, std::uint32_t memoryMask)
+		{
+			if (!heat) { return; }
+			for (int b = 0; b < count; b++) { heat->count(MemoryHeat::read, (address + b) & memoryMask); }
+		}
+
+		//FX0A got its key, only V[state.keyRegister] changed since oldValue. True to stop before the next instruction
+		bool afterKeyWait(const State &state, std::uint8_t oldValue, std::uint32_t memoryMask)
+		{
+			if (!anyRegisterWatch || stopped()) { return false; }
+
+			std::copy(state.v, state.v + 16, registersBefore);
+			registersBefore[state.keyRegister & 0xF] = oldValue;
+			iBefore = state.i;
+			pcMask = memoryMask;
+			instructionPc = (std::uint16_t)((state.pc - 2) & memoryMask); //the FX0A
+			checkRegisterWatch(state);
+
+			if (!stopped()) { return false; }
+			stop.pc = (std::uint16_t)(state.pc & memoryMask);
+			return true;
+		}
+
+		//true to stop after the instruction that just ran
+		bool afterInstruction(const State &state)
+		{
+			resumePc = -1;
+			if (profiler) { profiler->afterInstruction(state, instructionPc, instructionOpcode); }
+			if (trace) { recordTrace(state); }
+			if (heat)
+			{
+				heat->count(MemoryHeat::execute, instructionPc);
+				heat->count(MemoryHeat::execute, (instructionPc + 1) & pcMask);
+			}
+			if (anyRegisterWatch && !stopped()) { checkRegisterWatch(state); }
+			if (stepsLeft && !--stepsLeft && !stopped())
+			{
+				stop = {};
+				stop.reason = StopReason::step;
+			}
+			if (state.instructionCount == stopAtInstruction)
+			{
+				stopAtInstruction = noInstruction;
+				if (!stopped())
+				{
+					stop = {};
+					stop.reason = StopReason::step;
+				}
+			}
+
+			if (!stopped()) { return false; }
+			stop.pc = (std::uint16_t)(state.pc & pcMask);
+			return true;
+		}
+
+		std::bitset<memorySize> breakAt;
+		std::bitset<memorySize> watchAt;
+		bool anyMemoryWatch = false;
+
+	private:
+
+		bool checkBreakpoints(const State &state);
+		void checkMemoryWatch(std::uint32_t address, std::uint8_t oldValue, std::uint8_t newValue);
+		void checkRegisterWatch(const State &state);
+
+		void recordTrace(const State &state)
+		{
+			TraceEntry entry;
+			entry.pc = instructionPc;
+			entry.opcode = instructionOpcode;
+			entry.i = state.i;
+			for (int r = 0; r < 16; r++)
+			{
+				if (state.v[r] != registersBefore[r])
+				{
+					entry.changedRegister = (std::uint8_t)r;
+					entry.value = state.v[r];
+					break;
+				}
+			}
+			trace->record(entry);
+		}
+
+		bool anyBreakpoint = false;
+		bool anyRegisterWatch = false;
+		std::uint32_t stepsLeft = 0;
+		std::uint64_t stopAtInstruction = noInstruction;
+		std::int32_t resumePc = -1;
+
+		std::uint16_t instructionPc = 0; //masked
+		std::uint32_t pcMask = memorySize - 1; //the memoryMask of the emulator
+		std::uint16_t instructionOpcode = 0;
+		std::uint8_t registersBefore[16] = {};
+		std::uint16_t iBefore = 0;
+	};
+
+	const char *debuggerOperandName(std::uint8_t operand);
+	const char *debuggerCompareName(Debugger::Compare compare);
+
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace chip8
+{
+
+	//XOR+RLE deltas between two buffers of the same size, for sending states and displays.
+	//The bytes are xored with the base and stored as runs: a varint count of unchanged (zero) bytes,
+	//a varint count of changed bytes and the changed bytes, until the end of the buffer.
+	//A frame of a chip8 game changes a few bytes of the display, so a delta is a few bytes too.
+
+	//appends the delta of current from base to out, a null base is all zeros
+	void encodeDelta(const std::uint8_t *base, const std::uint8_t *current, std::size_t size, std::vector<std::uint8_t> &out);
+
+	//Xors a delta into data, which has to be the base it was made from.
+	//Returns the number of bytes of the delta read, 0 if it is broken or not for this size.
+	std::size_t applyDelta(std::uint8_t *data, std::size_t size, const std::uint8_t *delta, std::size_t deltaSize);
+
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <chip8/chip8.h>
+
+namespace chip8
+{
+
+	//One instruction in text, Cowgod's mnemonics with the ones of schip and xo-chip.
+	//operand is the word after F000 (LD I, NNNN), address the name of the address of 1NNN, 2NNN, ANNN, BNNN
+	//or F000 or null for the hex. Returns the length, like snprintf.
+	int disassembleInstruction(std::uint16_t opcode, std::uint16_t operand, const char *address, char *out, std::size_t size);
+
+	//The memory of a program as rows of code and data with labels, for the disassembly view of the debugger.
+	//The rows come from the code reachable from 0x200 (see findCode), and from any address the program
+	//was seen running that wasn't code yet (loaded or generated code), so sprites aren't shown as instructions.
+	//The text of a row is made the first time it is asked for and kept with the bytes it was made from:
+	//a row whose bytes the program wrote since is made again, the others cost a compare. So the core is not
+	//told about writes and pays nothing, only the rows on screen are ever looked at.
+	struct Disassembly
+	{
+		//the data rows are at most this many bytes, and aligned to it
+		static constexpr int dataRowBytes = 8;
+
+		struct Row
+		{
+			std::uint16_t address = 0;
+			std::uint8_t size = 0;
+			bool code = false;
+		};
+
+		//forgets the code found while running, for a new rom
+		void clear();
+
+		//lays the rows out again from the memory of the emulator
+		void analyze(const Chip8 &emulator);
+
+		//Call with the PC before showing the rows, it is a bit test unless the program runs code
+		//that wasn't found before. Returns true when the rows were laid out again.
+		bool follow(const Chip8 &emulator, std::uint16_t pc);
+
+		bool analyzed() const { return !rows.empty(); }
+
+		std::size_t rowCount() const { return rows.size(); }
+		const Row &row(std::size_t index) const { return rows[index]; }
+
+		//the row with the address in it
+		std::size_t rowOf(std::uint16_t address) const;
+
+		//the text of the instruction or the bytes of a row, kept until the program writes one of its bytes
+		const char *text(const State &state, std::size_t index);
+
+		//sub_2A4 for the targets of calls, label_2A4 for the ones of jumps, data_300 for the ones of I, false for the others
+		bool label(std::uint16_t address, char *out, std::size_t size) const;
+
+		struct Stats
+		{
+			std::uint64_t made = 0; //texts made
+			std::uint64_t kept = 0; //texts that were still good
+			int analyses = 0;
+		};
+		Stats stats;
+
+	private:
+
+		enum LabelKind : std::uint8_t
+		{
+			noLabel,
+			dataLabel,
+			jumpLabel,
+			callLabel,
+		};
+
+		struct Line
+		{
+			bool made = false;
+			std::uint8_t bytes[dataRowBytes] = {};
+			char text[48] = {};
+		};
+
+		std::vector<Row> rows;
+		std::vector<Line> lines; //one per row
+		std::vector<bool> code; //the instructions found, by address
+		std::vector<std::uint8_t> labels; //LabelKind by address
+		std::vector<std::uint16_t> entries; //0x200 and the addresses seen running
+		std::uint32_t memoryMask = 0xFFF;
+		std::int32_t lastMissed = -1; //a PC findCode didn't find code at, not tried again
+	};
+
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+
+namespace chip8
+{
+
+	constexpr int displayMaxWidth = 128;
+	constexpr int displayMaxHeight = 64;
+	constexpr int displayRowBytes = displayMaxWidth / 8;
+	constexpr int displayPlanes = 2;
+
+	//The display is stored as bit rows, the most significant bit is the leftmost pixel.
+	//Plane 0 is the only one used by chip8 and schip, xo-chip adds plane 1.
+	//In lores mode only the top left 64x32 pixels are used.
+	//The planes are contiguous so the whole display can be uploaded as one texture.
+	struct Display
+	{
+		std::uint8_t planes[displayPlanes][displayMaxHeight][displayRowBytes] = {};
+		bool hires = false;
+
+		int width() const { return hires ? displayMaxWidth : displayMaxWidth / 2; }
+		int height() const { return hires ? displayMaxHeight : displayMaxHeight / 2; }
+
+		bool getPixel(int plane, int x, int y) const
+		{
+			return (planes[plane][y][x >> 3] >> (7 - (x & 7))) & 1;
+		}
+
+		//returns the palette index of the pixel (plane 0 is bit 0, plane 1 is bit 1)
+		int getColorIndex(int x, int y) const
+		{
+			return getPixel(0, x, y) | (getPixel(1, x, y) << 1);
+		}
+
+		void clear() { std::memset(planes, 0, sizeof(planes)); }
+	};
+
+}
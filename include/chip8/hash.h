@@ -0,0 +1,11 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+namespace chip8
+{
+
+	//64 bit xxHash (XXH64), used to identify roms no matter where they are stored
+	std::uint64_t xxHash64(const void *data, std::size_t size, std::uint64_t seed = 0);
+
+}
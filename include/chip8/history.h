@@ -0,0 +1,95 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+#include <chip8/chip8.h>
+#include <chip8/debugger.h>
+
+namespace chip8
+{
+
+	//Reverse debugging: going back to an earlier instruction of the run.
+	//It keeps a keyframe (the state as a delta from zeros, a few KB) every keyframeInterval frames
+	//and the keys of every frame. Going back restores the last keyframe before the target and runs
+	//the frames since with the logged keys, in the debug loop of the core so it stops on the exact instruction.
+	//Any target costs at most keyframeInterval frames of emulation, no matter how old it is.
+	//The frames run on a copy of the emulator, which replaces the emulator only once it got there.
+	//
+	//A position is State::instructionCount right after that instruction ran. After a key wait
+	//the instruction after FX0A ends its frame, so it lands at the end of the frame.
+	//Going back drops the frames after the position, running from there records new ones.
+	struct History
+	{
+		int keyframeInterval = 60;
+
+		//older keyframes and keys are dropped, 10 minutes of emulated time
+		std::uint64_t maxFrames = 60 * 60 * 10;
+
+		void clear();
+
+		//Call before every runFrame that starts a frame, after setKeys. A frame that doesn't follow
+		//the last one (a reset, a loaded state) starts the history again from it.
+		void beginFrame(const Chip8 &emulator);
+
+		//the oldest instruction count seek can go to, false while nothing is recorded
+		bool oldest(std::uint64_t &instructionCount) const;
+
+		//Goes back to the instruction count, which can't be after the current one.
+		//Chip8::debugger is kept, the frames run with a debugger of the history.
+		bool seek(Chip8 &emulator, std::uint64_t instructionCount);
+
+		//Goes back one instruction and stops the debugger there (StopReason::rewound).
+		bool stepBack(Chip8 &emulator, Debugger &debugger);
+
+		//Goes back to the last time a breakpoint or watchpoint of debugger stopped before the current instruction,
+		//and stops the debugger there as it did then. False if none did since the oldest keyframe.
+		bool runBack(Chip8 &emulator, Debugger &debugger);
+
+		struct Stats
+		{
+			std::size_t keyframes = 0;
+			std::size_t keyframeBytes = 0;
+			std::uint64_t frames = 0; //recorded
+			std::uint64_t lastReplayedFrames = 0; //by the last seek, stepBack or runBack
+		};
+		Stats stats() const;
+
+	private:
+
+		struct Keyframe
+		{
+			std::uint64_t frame = 0;
+			std::uint64_t instructionCount = 0;
+			std::vector<std::uint8_t> delta;
+		};
+
+		//the frame after the last one recorded
+		std::uint64_t endFrame() const { return firstFrame + keys.size(); }
+
+		//the emulator is where the recording ended, nothing else changed it since
+		bool current(const Chip8 &emulator) const;
+
+		//copies the settings of the emulator to the replayer and arms replayDebugger with the stops of stops
+		void prepare(const Chip8 &emulator, const Debugger *stops);
+
+		//Restores a keyframe in the replayer, replayDebugger stops at runTo from there.
+		//replay runs the frames after it with the logged keys, until a stop of replayDebugger (returns true)
+		//or the start of frame endFrame or of one after endCount instructions.
+		void restore(std::size_t keyframe, std::uint64_t runTo);
+		bool replay(std::uint64_t endFrame, std::uint64_t endCount);
+
+		//the replayer replaces the emulator, what was recorded after it is dropped
+		void land(Chip8 &emulator);
+
+		std::deque<Keyframe> keyframes;
+		std::deque<std::uint16_t> keys; //of the frames from firstFrame
+		std::uint64_t firstFrame = 0;
+		std::uint64_t lastInstructionCount = 0;
+
+		std::unique_ptr<Chip8> replayer; //66 KB, allocated the first time
+		Debugger replayDebugger;
+		std::uint64_t replayedFrames = 0;
+	};
+
+}
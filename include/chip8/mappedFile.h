@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+namespace chip8
+{
+
+	//A read only view of a whole file (mmap or MapViewOfFile).
+	//Nothing is copied, the pages are read from the disk when they are first touched.
+	//create makes a new file of a given size and a writable view of it instead.
+	struct MappedFile
+	{
+		MappedFile() = default;
+		MappedFile(const MappedFile &) = delete;
+		MappedFile &operator=(const MappedFile &) = delete;
+		MappedFile(MappedFile &&other) noexcept;
+		MappedFile &operator=(MappedFile &&other) noexcept;
+		~MappedFile() { close(); }
+
+		const std::uint8_t *data = nullptr;
+		std::size_t size = 0;
+
+		//returns false if the file can't be opened, an empty file opens with data = nullptr
+		bool open(const char *path);
+
+		//Creates or truncates the file with this size (not 0) and maps it for writing, nullptr on failure.
+		//The system writes the pages back to the file, at the latest after close.
+		std::uint8_t *create(const char *path, std::size_t size);
+		void close();
+
+	private:
+
+	#ifdef _WIN32
+		void *mapping = nullptr;
+	#endif
+	};
+
+}
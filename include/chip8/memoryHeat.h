@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <chip8/chip8.h>
+
+namespace chip8
+{
+
+	//How often the program read, wrote and executed every byte of the memory, for the heat map of the debugger.
+	//Set it as Debugger::heat, the debug loop of the core counts then (see debugger.h).
+	//The counters are 16 bits, saturating, one plane per kind in a single array (384 KB).
+	//decay makes them fade so the map shows what is hot now, it is one SIMD pass over the array.
+	struct MemoryHeat
+	{
+		enum Kind
+		{
+			read,
+			write,
+			execute,
+			kinds,
+		};
+
+		MemoryHeat();
+
+		void clear();
+
+		//every counter loses 1/2^shift of its value and 1 more, call once per shown frame
+		void decay(int shift = 4);
+
+		void count(Kind kind, std::uint32_t address)
+		{
+			std::uint16_t &c = counts[kind * memorySize + address];
+			c += c != 0xFFFF;
+		}
+
+		std::uint16_t get(Kind kind, std::uint32_t address) const { return counts[kind * memorySize + address]; }
+
+		//the plane of a kind, memorySize counters
+		const std::uint16_t *plane(Kind kind) const { return &counts[kind * memorySize]; }
+
+	private:
+
+		std::unique_ptr<std::uint16_t[]> counts;
+	};
+
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <chip8/chip8.h>
+
+namespace chip8
+{
+
+	//A recorded run: the settings the emulator was reset with, the keypad of every frame
+	//and the state hash after every hashInterval frames to check a replay against.
+	//The keys are stored as runs of identical frames, most frames repeat the previous one.
+	struct Movie
+	{
+		std::uint64_t romHash = 0;
+		Platform platform = Platform::chip8;
+		Quirks quirks = {};
+		int instructionsPerFrame = 11;
+		Timing timing = Timing::instructions;
+		std::uint32_t seed = defaultSeed;
+
+		struct KeyRun
+		{
+			std::uint16_t keys = 0;
+			std::uint32_t frames = 0;
+		};
+
+		std::vector<KeyRun> keyRuns;
+		std::uint32_t frameCount = 0;
+
+		int hashInterval = 1;
+		std::vector<std::uint64_t> hashes;
+
+		//Starts a new movie from the settings of the emulator, call it right after reset and loadRom.
+		void begin(const Chip8 &emulator, std::uint64_t romHash, int hashInterval = 1);
+
+		//call after runFrame with the keys that frame ran with
+		void recordFrame(std::uint16_t keys, std::uint64_t stateHash);
+
+		//resets the emulator with the settings of the movie, the rom has to be loaded after this
+		void resetEmulator(Chip8 &emulator) const;
+
+		//returns false if the file can't be written or read or isn't a movie
+		bool save(const char *path) const;
+		bool load(const char *path);
+	};
+
+	//Feeds the keys of a movie back frame by frame and checks the state hashes.
+	struct MoviePlayer
+	{
+		const Movie *movie = nullptr;
+		std::uint32_t frame = 0;
+
+		//the first frame whose hash didn't match, -1 while the replay is in sync
+		std::int64_t desyncFrame = -1;
+
+		void start(const Movie &movie);
+		bool finished() const { return !movie || frame >= movie->frameCount; }
+
+		//the keys of the next frame
+		std::uint16_t keys() const;
+
+		//Call after runFrame with the hash of the state. Returns false when it doesn't match the movie.
+		bool endFrame(std::uint64_t stateHash);
+
+	private:
+
+		std::size_t run = 0;
+		std::uint32_t frameInRun = 0;
+	};
+
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+#include <chip8/chip8.h>
+
+//The interface between the game and the plugins made by chip8-recompiler.
+//The generated code only needs this header, it doesn't link with the core.
+
+#ifdef _WIN32
+#define CHIP8_PLUGIN_EXPORT extern "C" __declspec(dllexport)
+#else
+#define CHIP8_PLUGIN_EXPORT extern "C" __attribute__((visibility("default")))
+#endif
+
+//the function every plugin exports, returns a pointer to its RecompiledRom
+#define CHIP8_RECOMPILED_ROM_ENTRY "chip8GetRecompiledRom"
+
+namespace chip8
+{
+
+	//bumped when State or the meaning of CompiledRunner changes
+	constexpr std::uint32_t recompiledAbiVersion = 3;
+
+	struct RecompiledRom
+	{
+		std::uint32_t abiVersion = recompiledAbiVersion;
+		std::uint32_t stateSize = sizeof(State);
+
+		//the plugin is only used for the exact rom and settings it was made for,
+		//the translated code has the quirks and the memory size baked in
+		std::uint64_t romHash = 0;
+		Platform platform = Platform::chip8;
+		std::uint32_t quirks = 0; //quirksToBits
+
+		int translatedInstructions = 0;
+		CompiledRunner run = nullptr;
+	};
+
+	using GetRecompiledRom = const RecompiledRom *(*)();
+
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <chip8/chip8.h>
+
+namespace chip8
+{
+
+	//Rollback for two players on one keypad, without the network part (see chip8net/netplay.h).
+	//Every frame runs right away with a prediction of the remote keys (the last ones that arrived).
+	//When the real keys of a frame that already ran turn out different, the state of that frame is
+	//restored and the frames since are run again with the corrected keys before the next frame.
+	//The two players press keys of the same keypad, a frame runs with the keys of both or'ed together.
+	struct Rollback
+	{
+		//how far the local frame can run ahead of the last remote keys, the oldest frame that can be restored
+		static constexpr int maxFrames = 8;
+
+		//the frames of keys kept, the remote side can be up to maxFrames ahead too
+		static constexpr int inputFrames = 4 * maxFrames;
+
+		//call after the emulator was reset and the rom loaded, the session starts at frame 0
+		void start(Chip8 &emulator);
+
+		//the next frame advance runs
+		std::uint32_t frame = 0;
+
+		//the remote keys of the frames before this one arrived
+		std::uint32_t confirmedFrames = 0;
+
+		//False when the local side is maxFrames ahead of the remote keys, the frame has to wait.
+		bool canAdvance() const { return frame < confirmedFrames + maxFrames; }
+
+		//Runs the pending rollback and then the next frame with the local keys and the predicted remote ones.
+		//Returns false (and runs nothing) while canAdvance is false.
+		bool advance(std::uint16_t localKeys);
+
+		//The keys of the remote player for a frame. They have to come in order: a frame other than
+		//confirmedFrames is ignored, so it is fine to get the same frames again.
+		void addRemoteInput(std::uint32_t remoteFrame, std::uint16_t keys);
+
+		//restores the first mispredicted frame and runs the frames since again, advance calls it
+		void resimulate();
+
+		//the local keys of a frame in the last inputFrames frames, for sending them
+		std::uint16_t localKeys(std::uint32_t inputFrame) const { return inputs[inputFrame % inputFrames].local; }
+
+		//The last frame that ran with the real keys of both players and its state hash (after the frame),
+		//the two sides compare them to find desyncs. False before the first one or while a rollback is pending.
+		bool confirmedHash(std::uint32_t &hashFrame, std::uint64_t &hash) const;
+
+		//compares with the hash of the other side, sets desyncFrame when they differ
+		void checkRemoteHash(std::uint32_t hashFrame, std::uint64_t hash);
+
+		//the first frame whose hash differs from the other side, -1 while in sync
+		std::int64_t desyncFrame = -1;
+
+		struct Stats
+		{
+			std::uint64_t rollbacks = 0;
+			std::uint64_t resimulatedFrames = 0;
+			int mostResimulatedFrames = 0; //the longest single rollback
+			std::uint64_t stalledFrames = 0; //advance calls that had to wait for the remote keys
+		};
+		Stats stats;
+
+	private:
+
+		struct FrameInput
+		{
+			std::uint16_t local = 0;
+			std::uint16_t remote = 0; //the prediction until the frame is confirmed
+		};
+
+		void runFrame(std::uint32_t runFrame);
+
+		Chip8 *emulator = nullptr;
+
+		FrameInput inputs[inputFrames] = {};
+		std::uint16_t lastRemoteKeys = 0;
+
+		//the state before and the hash after the last frames, maxFrames + 1 so the oldest one can be restored
+		std::unique_ptr<State[]> snapshots;
+		std::uint64_t hashes[maxFrames + 1] = {};
+
+		//the first frame that ran with a wrong prediction, rollbackPending tells if there is one
+		std::uint32_t rollbackFrame = 0;
+		bool rollbackPending = false;
+	};
+
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <chip8/chip8.h>
+
+namespace chip8
+{
+
+	//What a static pass over the rom found and the settings picked from it.
+	struct RomAnalysis
+	{
+		Platform platform = Platform::chip8;
+		Quirks quirks = {};
+		int instructionsPerFrame = 11;
+
+		int reachableInstructions = 0;
+
+		bool usesSchip = false;    //00CN 00FB-00FF DXY0 FX30 FX75 FX85
+		bool usesXoChip = false;   //00DN 5XY2 5XY3 F000 FN01 F002 FX3A
+		bool usesHighMemory = false; //code, a rom or I past 0xFFF
+		bool indexWraps = false; //reads or writes at an I set by ANNN run past 0xFFF
+
+		bool shiftsOtherRegister = false; //8XY6 or 8XYE with X != Y, the shift quirk matters
+		bool shiftsFromVy = false; //one of those has Y != 0, so the program means the shift of VY
+		bool reliesOnIndexIncrement = false; //I is used after FX55 / FX65 without being set again
+		bool indirectJumps = false; //BNNN, the code after it can't be followed
+		bool pacedByDelayTimer = false; //busy waits on FX07, so the speed doesn't change the game speed
+	};
+
+	//Recursive descent disassembly from 0x200: jumps, calls and both sides of every skip are followed,
+	//so sprites and other data between the code are not mistaken for instructions.
+	//codeAddresses gets the address of every reachable instruction, sorted.
+	RomAnalysis analyzeRom(const std::uint8_t *rom, std::size_t size,
+		std::vector<std::uint16_t> *codeAddresses = nullptr);
+
+	//The instructions reachable from the entry points, followed the same way, sorted.
+	//rom is loaded at 0x200 like for analyzeRom, it can be the memory of a running program from there.
+	void findCode(const std::uint8_t *rom, std::size_t size, const std::uint16_t *entries, std::size_t entryCount,
+		std::vector<std::uint16_t> &codeAddresses);
+
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <chip8/chip8.h>
+#include <chip8/hash.h>
+
+namespace chip8
+{
+
+	struct RomInfo
+	{
+		std::string path; //absolute, with forward slashes
+		std::uint64_t size = 0;
+		std::int64_t modifiedTime = 0; //file clock ticks, only compared for equality
+		std::uint64_t hash = 0;
+
+		//picked by analyzeRom when the rom is first hashed, can be changed by the user and are kept
+		//as long as the content of the file stays the same
+		Platform platform = Platform::chip8;
+		Quirks quirks = {};
+		int instructionsPerFrame = 11;
+	};
+
+	//The roms we know about, saved as a small text file between runs.
+	//Files are identified by path and only opened again when their size or modification time change.
+	struct RomLibrary
+	{
+		std::vector<RomInfo> roms;
+
+		//the folders the user added, scanned again on startup
+		std::vector<std::string> folders;
+
+		//set when something changed since the last load or save
+		bool modified = false;
+
+		struct ScanStats
+		{
+			int files = 0;
+			int hashed = 0; //files that were new or changed
+			int removed = 0;
+		};
+
+		//returns false if the index can't be read, the library is left empty in that case
+		bool load(const char *indexPath);
+
+		//writes to a temporary file first so a crash doesn't lose the index
+		bool save(const char *indexPath);
+
+		//Adds the roms under directory and drops the entries of files that are no longer there.
+		ScanStats scan(const char *directory, bool recursive = true);
+
+		//Adds or refreshes a single file, returns nullptr if it can't be read.
+		//The pointer is valid until the library is changed again.
+		const RomInfo *update(const char *path);
+
+		//Adds the rom or replaces the entry with the same path. If the hash didn't change
+		//only the size and time are updated so the settings the user picked are kept.
+		const RomInfo *set(const RomInfo &info);
+
+		bool remove(const std::string &path);
+
+		//drops every entry under the folder, the folder ends with '/'
+		int removeUnder(const std::string &folder);
+
+		//true if the entry for path has the same size and time
+		bool isUpToDate(const std::string &path, std::uint64_t size, std::int64_t modifiedTime) const;
+
+		const RomInfo *find(const std::string &path) const;
+		const RomInfo *findByHash(std::uint64_t hash) const;
+
+		//checks the extension (.ch8 .c8 .sc8 .xo8 .hc8)
+		static bool isRomFile(const std::string &path);
+
+		static std::string normalizePath(const char *path);
+
+		//the size and time as they are stored in the index, returns false if it isn't a regular file
+		static bool statFile(const std::string &path, std::uint64_t &size, std::int64_t &modifiedTime);
+
+		//Maps the file, hashes it and analyzes it. Doesn't touch any library
+		//so it can be called from any thread.
+		static bool inspect(const std::string &path, std::int64_t modifiedTime, RomInfo &info);
+
+	private:
+
+		std::unordered_map<std::string, std::size_t> byPath;
+
+		RomInfo *refresh(const std::string &path, std::uint64_t size, std::int64_t modifiedTime);
+		void rebuildLookup();
+	};
+
+}
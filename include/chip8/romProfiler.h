@@ -0,0 +1,124 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#include <chip8/chip8.h>
+
+namespace chip8
+{
+
+	//Where a rom spends its instructions and the host's time, for tuning chip8 programs.
+	//Set it as Debugger::profiler, the debug loop of the core reports every instruction then (see debugger.h).
+	//
+	//Every instruction is counted by address, by kind of opcode (8XY4, DXYN...) and by call stack.
+	//The call stacks follow SP, so 2NNN pushes the subroutine at the new PC and 00EE pops it.
+	//The host time is sampled: a random instruction about every sampleInterval is timed and stands for
+	//the instructions since the last sample, so the estimate costs two clock reads per interval.
+	struct RomProfiler
+	{
+		struct Counter
+		{
+			std::uint64_t instructions = 0;
+			double nanoseconds = 0; //estimated
+		};
+
+		//a subroutine, inclusive of what it calls, recursion counted once
+		struct Function
+		{
+			std::uint16_t address = 0;
+			bool root = false; //the code outside any subroutine
+			std::uint64_t calls = 0;
+			Counter self;
+			Counter total;
+		};
+
+		//the mean instructions between two timed ones
+		int sampleInterval = 64;
+
+		RomProfiler();
+
+		void clear();
+
+		//the hooks of the debug loop
+		void beforeInstruction()
+		{
+			if (--countdown) { return; }
+			sampling = true;
+			sampleStart = std::chrono::steady_clock::now();
+		}
+
+		void afterInstruction(const State &state, std::uint16_t pc, std::uint16_t opcode)
+		{
+			double nanoseconds = 0;
+			if (sampling) { nanoseconds = endSample(); }
+
+			Counter &byAddress = addresses[pc];
+			Counter &byOpcode = opcodes[opcodeKind(opcode)];
+			byAddress.instructions++;
+			byOpcode.instructions++;
+			byAddress.nanoseconds += nanoseconds;
+			byOpcode.nanoseconds += nanoseconds;
+
+			if (!started) { start(state, pc, opcode); }
+			Node &node = nodes[nodeStack[depth]];
+			node.self.instructions++;
+			node.self.nanoseconds += nanoseconds;
+			instructions++;
+
+			if (state.sp != depth) { followStack(state); }
+		}
+
+		std::uint64_t totalInstructions() const { return instructions; }
+
+		const Counter &address(std::uint16_t address) const { return addresses[address]; }
+
+		//by opcodeKind
+		const Counter &opcode(std::uint16_t kind) const { return opcodes[kind]; }
+
+		//the opcode with its operands masked out, 8XY4 is 8004 and DXYN is D000
+		static std::uint16_t opcodeKind(std::uint16_t opcode);
+
+		//8XY4, DXYN, 00EE... at least 5 chars
+		static void opcodeKindName(std::uint16_t kind, char *out);
+
+		std::vector<Function> functions() const;
+
+		//One line per call stack, "main;sub_2A4;sub_31E 1234", the value is the instructions or the
+		//estimated nanoseconds that ran in the last subroutine. The format of flamegraph.pl, speedscope and others.
+		bool saveCollapsedStacks(const char *path, bool nanoseconds) const;
+
+	private:
+
+		struct Node
+		{
+			std::uint16_t address = 0;
+			std::int32_t parent = -1;
+			std::uint64_t calls = 0;
+			Counter self;
+			std::vector<std::int32_t> children;
+		};
+
+		//the call tree stops growing here, deeper calls count in their caller
+		static constexpr std::size_t maxNodes = 1 << 16;
+
+		double endSample();
+		void start(const State &state, std::uint16_t pc, std::uint16_t opcode);
+		void followStack(const State &state);
+
+		std::vector<Counter> addresses; //memorySize
+		std::vector<Counter> opcodes; //by kind, 64K
+		std::vector<Node> nodes; //0 is the root, parents before their children
+		std::int32_t nodeStack[stackSize + 1] = {};
+		int depth = 0;
+		bool started = false;
+		std::uint64_t instructions = 0;
+
+		std::chrono::steady_clock::time_point sampleStart;
+		bool sampling = false;
+		std::uint32_t countdown = 1;
+		std::uint32_t sampleWeight = 1; //the instructions the next sample stands for
+		std::uint32_t rng = 0x9E3779B9;
+		double clockOverhead = 0; //of the two clock reads, taken off the samples
+	};
+
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <chip8/romLibrary.h>
+
+namespace chip8
+{
+
+	//Walks rom folders in the background and hashes the new and changed files on a pool of threads.
+	//The results are queued and only applied to the library in poll, on the thread that owns it,
+	//so the library itself doesn't need any locking.
+	//With watch the folders stay watched after the first walk (inotify, linux only)
+	//and only the files that change are hashed again.
+	struct RomScanner
+	{
+		RomScanner() = default;
+		RomScanner(const RomScanner &) = delete;
+		RomScanner &operator=(const RomScanner &) = delete;
+		~RomScanner() { stop(); }
+
+		//Stops the previous scan and starts a new one. Files the library already has with
+		//the same size and time are not opened. threadCount 0 uses one thread per core.
+		void start(const RomLibrary &library, const std::vector<std::string> &folders,
+			bool watch = true, int threadCount = 0);
+
+		void stop();
+
+		//applies the results found so far to the library, returns the number of changed entries
+		int poll(RomLibrary &library);
+
+		//true until the folders were walked once and all the files found were hashed
+		bool scanning() const { return walking || pendingJobs > 0; }
+
+		bool watching() const { return watchingFolders; }
+
+		std::atomic<int> filesFound = 0;
+		std::atomic<int> filesHashed = 0;
+
+	private:
+
+		struct Job
+		{
+			std::string path;
+			std::int64_t modifiedTime = 0;
+		};
+
+		struct Result
+		{
+			enum Type : std::uint8_t
+			{
+				updated,
+				removed,
+				removedFolder,
+			};
+
+			Type type = updated;
+			RomInfo info; //only the path for the removals
+		};
+
+		struct KnownFile
+		{
+			std::uint64_t size = 0;
+			std::int64_t modifiedTime = 0;
+		};
+
+		std::thread walker;
+		std::vector<std::thread> workers;
+
+		std::mutex mutex;
+		std::condition_variable jobAvailable;
+		std::deque<Job> jobs;
+		std::vector<Result> results;
+
+		//what the library has once the results are applied, only used by the walker
+		std::unordered_map<std::string, KnownFile> known;
+
+		std::atomic<bool> stopping = false;
+		std::atomic<bool> walking = false;
+		std::atomic<bool> watchingFolders = false;
+		std::atomic<int> pendingJobs = 0;
+
+		void walkerMain(std::vector<std::string> folders, bool watch);
+		void workerMain();
+
+		//Queues the new and changed roms under folder and adds them to seen.
+		//The folder and its subfolders are added to directories. Returns false if the walk didn't finish.
+		bool walk(const std::string &folder, std::unordered_set<std::string> &seen, std::vector<std::string> &directories);
+		void queueFile(const std::string &path, bool force);
+		void pushResult(Result result);
+
+		//a removed file, or everything under a folder path ending in '/'
+		void pushRemoval(const std::string &path, bool folder);
+
+		//removes what is known under the fully walked folders but wasn't seen
+		void removeUnseen(const std::unordered_set<std::string> &seen, const std::vector<std::string> &completeFolders);
+	};
+
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+
+namespace chip8
+{
+
+	constexpr std::uint8_t traceNoRegister = 0xFF;
+
+	//one executed instruction, 8 bytes
+	struct TraceEntry
+	{
+		std::uint16_t pc = 0;
+		std::uint16_t opcode = 0;
+		std::uint16_t i = 0; //after the instruction
+		std::uint8_t changedRegister = traceNoRegister; //the lowest V register the instruction changed
+		std::uint8_t value = 0; //its new value
+	};
+
+	static_assert(sizeof(TraceEntry) == 8, "the trace files store the entries as they are");
+
+	//The last instructions the debug loop of the core ran, in a ring buffer allocated once.
+	//Set it as Debugger::trace to record, see debugger.h.
+	//
+	//The trace files (.c8t): "C8TRACE1", u32 the size of an entry, u32 0, u64 the entry count,
+	//u64 the index of the first entry since the recording started, then the entries as they are in memory.
+	//All little endian, like the hosts the emulator runs on.
+	struct Trace
+	{
+		//keeps the last 2^capacityLog2 instructions
+		explicit Trace(int capacityLog2 = 22);
+
+		void record(const TraceEntry &entry)
+		{
+			entries[written & mask] = entry;
+			written++;
+		}
+
+		void clear() { written = 0; }
+
+		std::size_t capacity() const { return mask + 1; }
+
+		//the entries kept, at most capacity
+		std::size_t size() const { return written < capacity() ? (std::size_t)written : capacity(); }
+
+		//all the instructions recorded since the last clear
+		std::uint64_t recorded() const { return written; }
+
+		//the index since the last clear of the oldest entry kept
+		std::uint64_t first() const { return written - size(); }
+
+		//0 is the oldest entry kept
+		const TraceEntry &operator[](std::size_t index) const { return entries[(first() + index) & mask]; }
+
+		//writes the entries kept, oldest first, through a mapping of the file
+		bool save(const char *path) const;
+
+	private:
+
+		std::unique_ptr<TraceEntry[]> entries;
+		std::size_t mask = 0;
+		std::uint64_t written = 0;
+	};
+
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <cstdint>
+#include <chip8/chip8.h>
+
+//The cost of the instructions of the original COSMAC VIP interpreter, used by Timing::cosmacVip.
+//The numbers are machine cycles (8 clocks of the 1.76 MHz 1802) taken from published measurements
+//of the VIP interpreter, rounded; they are close enough for the roms that depend on the speed
+//of the VIP but not a simulation of the 1802.
+namespace chip8
+{
+
+	//1760640 Hz / 8 clocks / 60 Hz
+	constexpr int vipMachineCyclesPerFrame = 3668;
+
+	//the 1861 takes the bus for 128 lines of 8 bytes and the interrupt routine runs every frame
+	constexpr int vipDisplayDmaCycles = 1024;
+	constexpr int vipInterruptCycles = 46;
+
+	//what is left for the interpreter every frame
+	constexpr int vipCyclesPerFrame = vipMachineCyclesPerFrame - vipDisplayDmaCycles - vipInterruptCycles;
+
+	//the fetch and the jump through the opcode table, paid by every instruction
+	constexpr int vipFetchCycles = 68;
+
+	//the cost of every 8XYN, 00E0 and DXYN have parts that depend on the operands
+	constexpr int vipAluCycles = 44;
+	constexpr int vipClearCycles = 24 + 3078;
+	constexpr int vipDrawCycles = 26;
+	constexpr int vipDrawRowCycles = 14;
+	constexpr int vipDrawShiftedRowCycles = 34; //the row is shifted into two bytes when x isn't a multiple of 8
+
+	//The cost of the instruction at state.pc in machine cycles, read before it runs.
+	//The skips cost more when they are taken, FX33 depends on the digits and FX55/FX65 on the registers.
+	inline int vipInstructionCycles(std::uint16_t opcode, const State &state)
+	{
+		int x = (opcode >> 8) & 0xF;
+		int y = (opcode >> 4) & 0xF;
+		std::uint8_t nn = (std::uint8_t)opcode;
+		int cycles = vipFetchCycles;
+
+		switch (opcode >> 12)
+		{
+		case 0x0: cycles += opcode == 0x00E0 ? vipClearCycles : 10; break;
+		case 0x1: cycles += 12; break;
+		case 0x2: cycles += 26; break;
+		case 0x3: cycles += state.v[x] == nn ? 14 : 10; break;
+		case 0x4: cycles += state.v[x] != nn ? 14 : 10; break;
+		case 0x5: cycles += state.v[x] == state.v[y] ? 18 : 14; break;
+		case 0x6: cycles += 6; break;
+		case 0x7: cycles += 10; break;
+		case 0x8: cycles += vipAluCycles; break;
+		case 0x9: cycles += state.v[x] != state.v[y] ? 18 : 14; break;
+		case 0xA: cycles += 12; break;
+		case 0xB: cycles += 22; break;
+		case 0xC: cycles += 36; break;
+		case 0xD:
+		{
+			int rows = opcode & 0xF;
+			cycles += vipDrawCycles + rows * ((state.v[x] & 7) ? vipDrawShiftedRowCycles : vipDrawRowCycles);
+			break;
+		}
+		case 0xE:
+		{
+			bool down = (state.keys >> (state.v[x] & 0xF)) & 1;
+			bool taken = nn == 0x9E ? down : !down;
+			cycles += taken ? 18 : 14;
+			break;
+		}
+		case 0xF:
+			switch (nn)
+			{
+			case 0x1E: cycles += 16; break;
+			case 0x29: cycles += 16; break;
+			case 0x33:
+			{
+				std::uint8_t value = state.v[x];
+				cycles += 80 + 16 * (value / 100 + (value / 10) % 10 + value % 10);
+				break;
+			}
+			case 0x55:
+			case 0x65: cycles += 14 + 14 * (x + 1); break;
+			default: cycles += 10; break;
+			}
+			break;
+		}
+
+		return cycles;
+	}
+
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <chip8/chip8.h>
+#include <chip8/rollback.h>
+
+struct _ENetHost;
+struct _ENetPeer;
+
+namespace chip8
+{
+
+	//Two player netplay over ENet with rollback (see rollback.h). Only the keypad of every frame
+	//goes over the network: each input packet has the local keys of the frames the other side
+	//didn't acknowledge yet, so a lost packet is covered by the next one and the packets can be unreliable.
+	//The host picks the rom settings, the guest needs the same rom.
+	struct Netplay
+	{
+		enum Status
+		{
+			idle,
+			connecting, //the host waits for the guest, the guest for the settings of the host
+			playing,
+			disconnected,
+			failed, //error says why
+		};
+
+		Status status = idle;
+		std::string error;
+
+		Rollback rollback;
+
+		//The emulator has to be reset with the settings to play with already, the session starts
+		//with a fresh reset once the guest connected. Port 0 picks a free one, see port().
+		bool host(Chip8 &emulator, const std::uint8_t *rom, std::size_t romSize, std::uint16_t port);
+
+		//the emulator gets the settings of the host when they arrive
+		bool join(Chip8 &emulator, const std::uint8_t *rom, std::size_t romSize, const char *address, std::uint16_t port);
+
+		void close();
+		~Netplay() { close(); }
+
+		//the local port, useful after hosting on port 0
+		std::uint16_t port() const;
+
+		//0 for the host, 1 for the guest
+		int player() const { return hosting ? 0 : 1; }
+
+		//handles the packets that arrived, call every host frame before advance
+		void poll();
+
+		//Runs the next frame with the local keys and sends them.
+		//Returns false when nothing ran: not playing yet or waiting for the keys of the other side.
+		bool advance(std::uint16_t localKeys);
+
+	private:
+
+		void start();
+		void sendSettings();
+		void sendInput();
+		void receive(const std::uint8_t *data, std::size_t size);
+
+		_ENetHost *enetHost = nullptr;
+		_ENetPeer *peer = nullptr;
+		bool hosting = false;
+
+		Chip8 *emulator = nullptr;
+		std::vector<std::uint8_t> rom;
+		std::uint64_t romHash = 0;
+
+		//the frames of local keys the other side has
+		std::uint32_t remoteAck = 0;
+	};
+
+}
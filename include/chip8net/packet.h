@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace chip8
+{
+
+	//the fields of the network packets, little endian
+
+	inline void writeInt(std::vector<std::uint8_t> &out, std::uint64_t value, int bytes)
+	{
+		for (int i = 0; i < bytes; i++) { out.push_back((std::uint8_t)(value >> (i * 8))); }
+	}
+
+	struct PacketReader
+	{
+		const std::uint8_t *data = nullptr;
+		std::size_t size = 0;
+		std::size_t position = 0;
+		bool ok = true; //false after reading past the end
+
+		PacketReader(const std::uint8_t *data, std::size_t size): data(data), size(size) {}
+
+		std::uint64_t readInt(int bytes)
+		{
+			if (position + bytes > size) { ok = false; return 0; }
+			std::uint64_t value = 0;
+			for (int i = 0; i < bytes; i++) { value |= (std::uint64_t)data[position + i] << (i * 8); }
+			position += bytes;
+			return value;
+		}
+
+		const std::uint8_t *rest() const { return data + position; }
+		std::size_t restSize() const { return size - position; }
+	};
+
+}
@@ -0,0 +1,119 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <chip8/chip8.h>
+
+struct _ENetHost;
+struct _ENetPeer;
+
+namespace chip8
+{
+
+	//Streams a session to spectators over ENet. Every frame the spectators get the keys it ran with
+	//(7 bytes) and run their own core. Every keyframeInterval frames the ones that aren't in sync
+	//yet get the whole state (XOR+RLE against zeros, see delta.h) and the ones that are get its hash.
+	//Until its first keyframe a spectator that joined in the middle of the session sees the display
+	//through XOR+RLE deltas of the framebuffer instead, starting with the whole display when it joins.
+	struct Broadcaster
+	{
+		int keyframeInterval = 120;
+
+		//the emulator has to outlive the broadcaster, the spectators get its settings when they join
+		bool start(const Chip8 &emulator, std::uint16_t port, int maxSpectators = 1024);
+		void close();
+		~Broadcaster() { close(); }
+
+		bool active() const { return enetHost != nullptr; }
+
+		//the local port, useful after starting on port 0
+		std::uint16_t port() const;
+
+		//handles the spectators that joined or left
+		void poll();
+
+		//call after every frame with the keys it ran with
+		void endFrame(std::uint16_t keys);
+
+		struct Stats
+		{
+			int spectators = 0;
+			std::uint64_t frames = 0;
+			std::uint64_t sentBytes = 0; //the payload of all packets to all spectators
+			std::uint64_t keyframeBytes = 0;
+			std::uint64_t deltaBytes = 0;
+		};
+		Stats stats;
+
+	private:
+
+		struct Viewer
+		{
+			bool hasDisplay = false; //got the full display, the next deltas are against the previous frame
+			bool synced = false; //got a keyframe, runs its own core
+		};
+
+		void send(const std::vector<std::uint8_t> &data, bool (*to)(const Viewer &viewer), std::uint64_t *counter);
+		void sendSettings(_ENetPeer *peer);
+
+		_ENetHost *enetHost = nullptr;
+		const Chip8 *emulator = nullptr;
+
+		Display previousDisplay;
+		std::vector<std::uint8_t> message;
+	};
+
+	//Watches a Broadcaster: the display from the deltas until the first keyframe, then the display of
+	//its own core. When the hash of a keyframe doesn't match it asks for the next keyframe.
+	struct Spectator
+	{
+		enum Status
+		{
+			idle,
+			connecting,
+			watchingDisplay, //only has the display, from the deltas
+			synced, //runs the core with the keys of the broadcaster
+			disconnected,
+			failed,
+		};
+
+		Status status = idle;
+
+		bool join(const char *address, std::uint16_t port);
+		void close();
+		~Spectator() { close(); }
+
+		//handles everything that arrived, runs the frames of the keys that arrived when synced
+		void poll();
+
+		//the display to show, from the core when synced
+		const Display &display() const { return status == synced ? emulator->state.display : deltaDisplay; }
+
+		//the rows that changed since the last call, like Chip8::takeDirtyRows
+		std::uint64_t takeDirtyRows();
+
+		//the next frame of the session, the emulator runs it when its keys arrive
+		std::uint32_t frame = 0;
+
+		//the core, its state is only meaningful while synced
+		std::unique_ptr<Chip8> emulator = std::make_unique<Chip8>();
+
+		std::int64_t desyncFrame = -1; //the last frame whose hash didn't match the keyframe
+		int resyncs = 0;
+		std::uint64_t receivedBytes = 0;
+
+	private:
+
+		void receive(const std::uint8_t *data, std::size_t size);
+		void requestKeyframe();
+
+		_ENetHost *enetHost = nullptr;
+		_ENetPeer *peer = nullptr;
+
+		Display deltaDisplay;
+		std::uint64_t deltaDirtyRows = 0;
+		bool waitingForFullDisplay = true; //the deltas and keyframes before it are ignored
+	};
+
+}
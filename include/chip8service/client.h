@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <chip8service/protocol.h>
+
+namespace chip8
+{
+
+	struct Display;
+
+	struct ServiceResponse
+	{
+		std::uint8_t status = serviceOk;
+		std::uint32_t id = 0;
+		std::vector<std::uint8_t> body;
+	};
+
+	//A blocking client of the emulation service (see protocol.h), for one thread.
+	//The helpers send a request and wait for its response. To pipeline, send many requests
+	//and receive the responses after: the helpers keep the responses they weren't waiting for.
+	struct ServiceClient
+	{
+		bool connect(const char *path);
+		void close();
+		~ServiceClient() { close(); }
+
+		//returns the id of the request, 0 if it couldn't be sent
+		std::uint32_t send(std::uint8_t type, std::uint32_t session, const std::vector<std::uint8_t> &body = {});
+		//the next response of any request
+		bool receive(ServiceResponse &response);
+		//the response of one request
+		bool receive(std::uint32_t id, ServiceResponse &response);
+
+		//0 on failure
+		std::uint32_t open();
+		bool closeSession(std::uint32_t session);
+		//platform -1 lets the analyzer of the service pick the settings
+		bool loadRom(std::uint32_t session, const std::uint8_t *rom, std::size_t size, int platform = -1);
+		bool setKeys(std::uint32_t session, std::uint16_t keys);
+		bool step(std::uint32_t session, std::uint32_t frames, std::uint64_t *stateHash = nullptr);
+		bool framebuffer(std::uint32_t session, Display &display);
+		bool saveState(std::uint32_t session, std::vector<std::uint8_t> &savedState);
+		bool loadState(std::uint32_t session, const std::vector<std::uint8_t> &savedState);
+
+		std::string error;
+
+	private:
+
+		//sends and waits, a status other than ok is an error
+		bool call(std::uint8_t type, std::uint32_t session, const std::vector<std::uint8_t> &body, ServiceResponse &response);
+
+		int socket = -1;
+		std::uint32_t nextId = 1;
+		std::vector<std::uint8_t> input;
+		std::unordered_map<std::uint32_t, ServiceResponse> received;
+	};
+
+	const char *serviceStatusName(std::uint8_t status);
+
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+
+//The protocol of the emulation service (chip8-headless --serve) over a Unix domain socket.
+//
+//Every message is a little endian u32 with the size of the rest, then:
+//  request   u8 type, u32 id, u32 session, the body
+//  response  u8 status, u32 id of the request, the body
+//
+//A client can send many requests before reading the responses. The requests of one session run
+//in order, the ones of different sessions run in parallel on the thread pool, so the responses
+//can come in a different order than the requests: match them by id.
+namespace chip8
+{
+
+	enum ServiceRequest : std::uint8_t
+	{
+		serviceOpen = 1,        //-> u32 session (the session of the request is ignored)
+		serviceClose = 2,
+		serviceLoadRom = 3,     //u8 platform (0xFF: the analyzer picks the settings), the rom -> u8 platform, u32 quirks, u32 instructions per frame
+		serviceSetKeys = 4,     //u16 keys
+		serviceStep = 5,        //u32 frames -> u64 frame count, u64 state hash
+		serviceFramebuffer = 6, //-> u8 hires, the planes of chip8::Display
+		serviceSaveState = 7,   //-> a saved state
+		serviceLoadState = 8,   //a saved state from serviceSaveState
+	};
+
+	//A saved state: u8 platform, u32 quirks, u32 instructions per frame, u8 timing, u32 seed,
+	//u32 the size of chip8::State, then the state as a delta against zeros (see delta.h).
+	//It is only for the same build of the core. A state that fails chip8::validState is serviceBadRequest.
+
+	enum ServiceStatus : std::uint8_t
+	{
+		serviceOk = 0,
+		serviceUnknownSession = 1,
+		serviceBadRequest = 2,
+		serviceRomTooBig = 3,
+		serviceUnknownRequest = 4,
+	};
+
+	constexpr std::uint32_t serviceMaxMessageSize = 1 << 20;
+	constexpr int serviceRequestHeaderSize = 9;
+	constexpr int serviceResponseHeaderSize = 5;
+
+	constexpr std::uint8_t serviceAnalyzePlatform = 0xFF;
+
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <chip8service/protocol.h>
+
+namespace chip8
+{
+
+	//Serves emulator sessions over a Unix domain socket, see protocol.h.
+	//One thread reads the connections, the requests run on a pool of worker threads.
+	//A session runs one request at a time, in the order they came, on any worker.
+	struct ServiceServer
+	{
+		//binds the socket (removing a stale one at the path) and starts the workers
+		bool start(const char *path, int threads);
+
+		//reads the connections until stop is called, from any thread
+		void run();
+		void stop();
+
+		~ServiceServer();
+
+		std::string error;
+
+		std::atomic<std::uint64_t> requests{0};
+		std::atomic<int> sessions{0};
+
+		struct Connection;
+		struct Session;
+
+	private:
+
+		struct Job
+		{
+			std::shared_ptr<Connection> connection;
+			std::vector<std::uint8_t> request;
+		};
+
+		void dispatch(const std::shared_ptr<Connection> &connection, std::vector<std::uint8_t> &&request);
+		void execute(Session &session, const Job &job);
+		void work();
+
+		std::string path;
+		int listenSocket = -1;
+		int wakePipe[2] = {-1, -1};
+		std::atomic<bool> stopping{false};
+
+		std::mutex mutex;
+		std::condition_variable jobsReady;
+		std::unordered_map<std::uint32_t, std::shared_ptr<Session>> sessionTable;
+		std::deque<std::shared_ptr<Session>> readySessions;
+		std::uint32_t nextSession = 1;
+
+		std::vector<std::thread> workers;
+	};
+
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+#include <chip8/chip8.h>
+#include <chip8/debugger.h>
+#include <chip8/history.h>
+
+//The imgui window of the debugger: the registers, the breakpoints and watchpoints,
+//pause, step and continue, and stepping and running back. The emulator doesn't run frames while it is stopped.
+struct DebuggerWindow
+{
+	chip8::Debugger debugger;
+
+	//the game calls beginFrame on it
+	chip8::History history;
+
+	bool show = true;
+
+	//false while stopped, the game skips runFrame then
+	bool running() const { return !debugger.stopped(); }
+
+	//canRewind is false while something else follows the frames, like a movie being recorded
+	void render(chip8::Chip8 &emulator, bool canRewind);
+
+private:
+
+	int newAddress = chip8::programStart;
+	int newCompare = 0;
+	int newOperand = 0;
+	int newValue = 0;
+
+	int newWatchKind = 0;
+	int newWatchAddress = 0;
+	int newWatchSize = 1;
+
+	const char *rewindStatus = "";
+	float rewindMilliseconds = 0;
+};
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+#include <chip8/chip8.h>
+#include <chip8/debugger.h>
+#include <chip8/disassembly.h>
+
+//The imgui window of the disassembly: the memory as code and data with labels, following the PC.
+//A click on an instruction toggles a breakpoint on it. Only the rows on screen are disassembled, see disassembly.h.
+struct DisassemblyWindow
+{
+	chip8::Disassembly disassembly;
+
+	bool show = true;
+
+	//call after loading a rom
+	void clear()
+	{
+		disassembly.clear();
+		lastPc = -1;
+	}
+
+	void render(const chip8::Chip8 &emulator, chip8::Debugger &debugger);
+
+private:
+
+	bool followPc = true;
+	std::int32_t lastPc = -1;
+	std::int32_t scrollToRow = -1;
+	int goToAddress = chip8::programStart;
+};
@@ -0,0 +1,85 @@
+#pragma once
+#include <gl2d/gl2d.h>
+#include <chip8/display.h>
+
+//Draws the chip8 display using the gpu.
+//The display bit rows are uploaded as they are (one R8UI texture, plane 0 on top of plane 1)
+//and the palette lookup, the phosphor persistence and the scaling with the pixel grid
+//are all done in shaders. The persistence is kept at the display resolution
+//in two frame buffers that are swapped every update.
+struct DisplayPresenter
+{
+	DisplayPresenter() {};
+
+	//it owns gl resources and a renderer
+	DisplayPresenter(const DisplayPresenter &) = delete;
+	DisplayPresenter &operator=(const DisplayPresenter &) = delete;
+
+	//palette index 0 is the background, 1 is plane 0, 2 is plane 1 and 3 is both planes
+	gl2d::Color4f palette[4] =
+	{
+		{0.05f, 0.07f, 0.05f, 1},
+		{0.55f, 1.0f, 0.55f, 1},
+		{0.9f, 0.45f, 0.1f, 1},
+		{1, 1, 1, 1},
+	};
+
+	//how long (in seconds) a pixel takes to fade to about a third after it turns off, 0 disables it
+	float persistence = 0.04f;
+
+	//how dark the pixel grid is, 0 disables it
+	float gridStrength = 0.3f;
+
+	gl2d::ShaderProgram phosphorShader = {};
+	gl2d::ShaderProgram gridShader = {};
+
+	//used to render into the persistence buffers
+	gl2d::Renderer2D offscreenRenderer;
+	gl2d::FrameBuffer persistenceBuffers[2] = {};
+	int currentBuffer = 0;
+	glm::ivec2 resolution = {};
+
+	GLuint displayTexture = 0;
+
+	void create();
+	void cleanup();
+
+	//Uploads the rows of the display set in dirtyRows (see chip8::Chip8::takeDirtyRows)
+	//and advances the phosphor effect by deltaTime seconds.
+	//Only the span between the first and the last dirty row is uploaded, nothing if no row is dirty.
+	//Call it once per frame, before render.
+	void update(const chip8::Display &display, std::uint64_t dirtyRows, float deltaTime);
+
+	struct UploadStats
+	{
+		int bytesThisFrame = 0;
+		int rowsThisFrame = 0;
+		std::uint64_t totalBytes = 0;
+		std::uint64_t skippedFrames = 0; //frames where nothing was uploaded
+	}uploadStats;
+
+	//Draws the display in rect. Everything already queued in the renderer is flushed first
+	//because the display is drawn with its own shader.
+	void render(gl2d::Renderer2D &renderer, glm::vec4 rect);
+
+	//the biggest rect with the display aspect ratio that fits in the given size, centered
+	glm::vec4 fitRect(glm::vec4 area);
+
+private:
+
+	struct
+	{
+		GLint display = -1;
+		GLint resolution = -1;
+		GLint palette = -1;
+		GLint decay = -1;
+	}phosphorUniforms;
+
+	struct
+	{
+		GLint resolution = -1;
+		GLint gridStrength = -1;
+	}gridUniforms;
+
+	void resize(glm::ivec2 newResolution);
+};
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <gl2d/gl2d.h>
+#include <chip8/chip8.h>
+#include <chip8/debugger.h>
+#include <chip8/memoryHeat.h>
+
+//The imgui window of the memory heat map: a pixel per byte, red for the writes, green for the executes
+//and blue for the reads, brighter the more often. The counters fade every shown frame so hot loops
+//and the tables they read stand out. It uploads one texture a frame while it collects.
+struct MemoryHeatWindow
+{
+	MemoryHeatWindow() {};
+
+	//it owns a gl texture
+	MemoryHeatWindow(const MemoryHeatWindow &) = delete;
+	MemoryHeatWindow &operator=(const MemoryHeatWindow &) = delete;
+
+	bool show = true;
+
+	void render(const chip8::Chip8 &emulator, chip8::Debugger &debugger);
+
+	void cleanup();
+
+private:
+
+	//allocated the first time collecting starts
+	std::unique_ptr<chip8::MemoryHeat> heat;
+
+	gl2d::Texture texture;
+	int textureWidth = 0;
+	int textureHeight = 0;
+	std::vector<std::uint32_t> pixels;
+
+	bool fade = true;
+	int fadeShift = 4;
+};
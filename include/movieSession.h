@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <chip8/chip8.h>
+#include <chip8/movie.h>
+#include <chip8/romLibrary.h>
+
+//Recording and replaying movies in the game, with a small imgui window to start and stop them.
+//Replays ignore the keypad and run unthrottled, the state hash is checked every frame.
+struct MovieSession
+{
+	enum Mode
+	{
+		none,
+		recording,
+		playing,
+	};
+
+	Mode mode = none;
+	chip8::Movie movie;
+	chip8::MoviePlayer player;
+	std::string moviePath;
+	std::string status;
+
+	bool show = true;
+
+	//restarts the rom with the current settings and records from the first frame
+	bool startRecording(chip8::Chip8 &emulator, const chip8::RomInfo &rom, const std::string &path);
+
+	//saves the movie
+	bool stopRecording();
+
+	//restarts the rom with the settings of the movie
+	bool startReplay(chip8::Chip8 &emulator, const chip8::RomInfo &rom, const std::string &path);
+
+	bool unthrottled() const { return mode == playing; }
+
+	//the keys of the next frame, the ones of the movie while playing
+	std::uint16_t frameKeys(std::uint16_t keypad) const { return mode == playing ? player.keys() : keypad; }
+
+	//call after each runFrame with the keys it ran with
+	void endFrame(const chip8::Chip8 &emulator, std::uint16_t keys);
+
+	//the window, rom is nullptr when no rom is loaded
+	void render(chip8::Chip8 &emulator, const chip8::RomInfo *rom);
+
+	//the movie next to the rom, rom.ch8 -> rom.ch8.c8m
+	static std::string defaultPath(const chip8::RomInfo &rom) { return rom.path + ".c8m"; }
+};
@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+
+//Small imgui window with the per frame counters of the emulator and the renderer.
+struct ProfilerOverlay
+{
+	static constexpr int historySize = 120;
+
+	float frameTimes[historySize] = {}; //ms
+	float uploadedBytes[historySize] = {};
+	int historyPosition = 0;
+
+	//counters of the last frame
+	float frameTime = 0;
+	int emulatedFrames = 0;
+	int instructions = 0;
+	int uploadedBytesThisFrame = 0;
+	int uploadedRowsThisFrame = 0;
+	std::uint64_t totalUploadedBytes = 0;
+	std::uint64_t skippedUploads = 0;
+
+	bool show = true;
+
+	//call once per host frame after the counters were set
+	void endFrame();
+
+	void render();
+};
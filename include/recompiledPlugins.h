@@ -0,0 +1,21 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <chip8/chip8.h>
+#include <chip8/recompiled.h>
+
+//Loads the plugins made by chip8-recompiler (chip8rom_<rom file name>.dll/.so) from the folder of the game.
+//A plugin is only used if it was made from the same rom for the same platform and quirks,
+//otherwise the rom just runs in the interpreter.
+struct RecompiledPlugins
+{
+	//file name -> handle from SDL_LoadObject, nullptr when there is no plugin so it isn't searched again
+	std::unordered_map<std::string, void *> loaded;
+
+	//returns the recompiled rom for this rom and settings or nullptr
+	const chip8::RecompiledRom *find(const std::string &romPath, std::uint64_t romHash,
+		chip8::Platform platform, const chip8::Quirks &quirks);
+
+	void cleanup();
+};
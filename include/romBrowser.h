@@ -0,0 +1,39 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "imgui.h"
+#include "imfilebrowser.h"
+#include <chip8/romLibrary.h>
+#include <chip8/romScanner.h>
+
+//Imgui window with the roms of the library folders.
+//The folders are scanned in the background and the list fills in as the results come.
+struct RomBrowser
+{
+	chip8::RomLibrary library;
+	chip8::RomScanner scanner;
+	std::string indexPath;
+
+	ImGui::FileBrowser folderPicker{ImGuiFileBrowserFlags_SelectDirectory | ImGuiFileBrowserFlags_CloseOnEsc};
+	char filter[128] = {};
+
+	//indexes in library.roms that pass the filter, sorted by file name
+	std::vector<int> visible;
+	bool visibleDirty = true;
+
+	bool show = true;
+
+	//loads the index and starts scanning the saved folders
+	void create(const char *indexPath);
+	void cleanup();
+
+	void addFolder(const std::string &folder);
+	void removeFolder(int index);
+
+	//Shows the window. Returns true and sets pickedPath when a rom was double clicked.
+	bool render(std::string &pickedPath);
+
+private:
+
+	void rebuildVisible();
+};
@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <chip8/chip8.h>
+#include <chip8/debugger.h>
+#include <chip8/romProfiler.h>
+
+//The imgui window of the rom profiler: the subroutines, addresses and kinds of opcodes
+//by instructions and estimated host time, in tables sorted by any column,
+//and the call stacks saved for flame graph tools.
+struct RomProfilerWindow
+{
+	bool show = true;
+
+	void render(const chip8::Chip8 &emulator, chip8::Debugger &debugger);
+
+private:
+
+	//allocated the first time profiling starts
+	std::unique_ptr<chip8::RomProfiler> profiler;
+
+	//the rows of the tables, sorted again when the sort or the counts change
+	std::vector<chip8::RomProfiler::Function> functions;
+	std::vector<std::uint16_t> addresses;
+	std::vector<std::uint16_t> opcodes;
+
+	const char *status = "";
+};
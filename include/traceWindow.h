@@ -0,0 +1,21 @@
+#pragma once
+#include <memory>
+#include <chip8/debugger.h>
+#include <chip8/trace.h>
+
+//The imgui window of the execution trace: records through the debugger
+//and lists the last instructions, only the rows on screen are formatted.
+struct TraceWindow
+{
+	bool show = true;
+
+	void render(chip8::Debugger &debugger);
+
+private:
+
+	//allocated the first time recording starts, 32 MB
+	std::unique_ptr<chip8::Trace> trace;
+
+	bool follow = true;
+	const char *status = "";
+};
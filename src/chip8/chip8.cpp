@@ -0,0 +1,784 @@
+#include <chip8/chip8.h>
+#include <chip8/debugger.h>
+#include <chip8/hash.h>
+#include <chip8/vipTiming.h>
+#include <algorithm>
+#include <cstring>
+
+namespace chip8
+{
+
+	static const std::uint8_t smallFont[16 * 5] =
+	{
+		0xF0, 0x90, 0x90, 0x90, 0xF0, //0
+		0x20, 0x60, 0x20, 0x20, 0x70, //1
+		0xF0, 0x10, 0xF0, 0x80, 0xF0, //2
+		0xF0, 0x10, 0xF0, 0x10, 0xF0, //3
+		0x90, 0x90, 0xF0, 0x10, 0x10, //4
+		0xF0, 0x80, 0xF0, 0x10, 0xF0, //5
+		0xF0, 0x80, 0xF0, 0x90, 0xF0, //6
+		0xF0, 0x10, 0x20, 0x40, 0x40, //7
+		0xF0, 0x90, 0xF0, 0x90, 0xF0, //8
+		0xF0, 0x90, 0xF0, 0x10, 0xF0, //9
+		0xF0, 0x90, 0xF0, 0x90, 0x90, //A
+		0xE0, 0x90, 0xE0, 0x90, 0xE0, //B
+		0xF0, 0x80, 0x80, 0x80, 0xF0, //C
+		0xE0, 0x90, 0x90, 0x90, 0xE0, //D
+		0xF0, 0x80, 0xF0, 0x80, 0xF0, //E
+		0xF0, 0x80, 0xF0, 0x80, 0x80, //F
+	};
+
+	static const std::uint8_t bigFont[16 * 10] =
+	{
+		0x3C, 0x7E, 0xE7, 0xC3, 0xC3, 0xC3, 0xC3, 0xE7, 0x7E, 0x3C, //0
+		0x18, 0x38, 0x58, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x3C, //1
+		0x3E, 0x7F, 0xC3, 0x06, 0x0C, 0x18, 0x30, 0x60, 0xFF, 0xFF, //2
+		0x3C, 0x7E, 0xC3, 0x03, 0x0E, 0x0E, 0x03, 0xC3, 0x7E, 0x3C, //3
+		0x06, 0x0E, 0x1E, 0x36, 0x66, 0xC6, 0xFF, 0xFF, 0x06, 0x06, //4
+		0xFF, 0xFF, 0xC0, 0xC0, 0xFC, 0xFE, 0x03, 0xC3, 0x7E, 0x3C, //5
+		0x3E, 0x7C, 0xC0, 0xC0, 0xFC, 0xFE, 0xC3, 0xC3, 0x7E, 0x3C, //6
+		0xFF, 0xFF, 0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0x60, 0x60, //7
+		0x3C, 0x7E, 0xC3, 0xC3, 0x7E, 0x7E, 0xC3, 0xC3, 0x7E, 0x3C, //8
+		0x3C, 0x7E, 0xC3, 0xC3, 0x7F, 0x3F, 0x03, 0x03, 0x3E, 0x7C, //9
+		0x7E, 0xFF, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, 0xC3, 0xC3, 0xC3, //A
+		0xFC, 0xFC, 0xC3, 0xC3, 0xFC, 0xFC, 0xC3, 0xC3, 0xFC, 0xFC, //B
+		0x3C, 0xFF, 0xC3, 0xC0, 0xC0, 0xC0, 0xC0, 0xC3, 0xFF, 0x3C, //C
+		0xFC, 0xFE, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xFE, 0xFC, //D
+		0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, //E
+		0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC0, 0xC0, 0xC0, 0xC0, //F
+	};
+
+	const char *platformName(Platform platform)
+	{
+		switch (platform)
+		{
+		case Platform::chip8: return "CHIP-8";
+		case Platform::schip: return "SCHIP";
+		case Platform::xoChip: return "XO-CHIP";
+		}
+		return "unknown";
+	}
+
+	Quirks defaultQuirks(Platform platform)
+	{
+		Quirks q;
+
+		switch (platform)
+		{
+		case Platform::chip8:
+			break;
+
+		case Platform::schip:
+			q.vfReset = false;
+			q.memoryIncrement = false;
+			q.displayWait = false;
+			q.clipping = true;
+			q.shiftVx = true;
+			q.jumpVx = true;
+			break;
+
+		case Platform::xoChip:
+			q.vfReset = false;
+			q.memoryIncrement = true;
+			q.displayWait = false;
+			q.clipping = false;
+			q.shiftVx = false;
+			q.jumpVx = false;
+			break;
+		}
+
+		return q;
+	}
+
+	std::uint32_t quirksToBits(const Quirks &quirks)
+	{
+		return (quirks.vfReset << 0) | (quirks.memoryIncrement << 1) | (quirks.displayWait << 2) |
+			(quirks.clipping << 3) | (quirks.shiftVx << 4) | (quirks.jumpVx << 5);
+	}
+
+	Quirks quirksFromBits(std::uint32_t bits)
+	{
+		Quirks quirks;
+		quirks.vfReset = bits & (1 << 0);
+		quirks.memoryIncrement = bits & (1 << 1);
+		quirks.displayWait = bits & (1 << 2);
+		quirks.clipping = bits & (1 << 3);
+		quirks.shiftVx = bits & (1 << 4);
+		quirks.jumpVx = bits & (1 << 5);
+		return quirks;
+	}
+
+	std::uint64_t hashState(const State &state)
+	{
+		//the small fields are packed first so the padding of State never gets hashed
+		std::uint8_t packed[128] = {};
+		std::size_t size = 0;
+		auto put = [&](const void *data, std::size_t bytes)
+		{
+			std::memcpy(packed + size, data, bytes);
+			size += bytes;
+		};
+
+		put(state.v, sizeof(state.v));
+		put(&state.i, sizeof(state.i));
+		put(&state.pc, sizeof(state.pc));
+		put(state.stack, sizeof(state.stack));
+		put(&state.sp, sizeof(state.sp));
+		put(&state.delayTimer, sizeof(state.delayTimer));
+		put(&state.soundTimer, sizeof(state.soundTimer));
+		put(&state.planeMask, sizeof(state.planeMask));
+		put(&state.pitch, sizeof(state.pitch));
+		put(state.audioPattern, sizeof(state.audioPattern));
+		put(state.flags, sizeof(state.flags));
+		put(&state.waitKeys, sizeof(state.waitKeys));
+		put(&state.keyRegister, sizeof(state.keyRegister));
+		std::uint8_t waitingForKey = state.waitingForKey, halted = state.halted, hires = state.display.hires;
+		put(&waitingForKey, 1);
+		put(&halted, 1);
+		put(&hires, 1);
+		put(&state.rng, sizeof(state.rng));
+		put(&state.cycleBalance, sizeof(state.cycleBalance));
+
+		//the registers are only ~100 bytes, cheaper to hash here than to track on every write
+		return xxHash64(packed, size, state.memoryHash ^ (state.displayHash * 0x9E3779B97F4A7C15ull));
+	}
+
+	bool validState(const State &state)
+	{
+		//the bytes, a bool with any other value can't be read as one
+		auto isBool = [](const bool &value)
+		{
+			std::uint8_t byte;
+			std::memcpy(&byte, &value, 1);
+			return byte <= 1;
+		};
+
+		return state.sp < stackSize && state.keyRegister < 16 && state.planeMask <= 3 &&
+			isBool(state.waitingForKey) && isBool(state.halted) && isBool(state.display.hires);
+	}
+
+	std::uint64_t displayRowKey(int plane, int row, const std::uint8_t *bytes)
+	{
+		std::uint64_t a = 0, b = 0;
+		std::memcpy(&a, bytes, 8);
+		std::memcpy(&b, bytes + 8, 8);
+		if (!(a | b)) { return 0; }
+
+		return xxHash64(bytes, displayRowBytes, (std::uint64_t)(plane * displayMaxHeight + row + 1));
+	}
+
+	static std::uint64_t hashDisplay(const Display &display)
+	{
+		std::uint64_t hash = 0;
+		for (int p = 0; p < displayPlanes; p++)
+		{
+			for (int y = 0; y < displayMaxHeight; y++)
+			{
+				hash ^= displayRowKey(p, y, display.planes[p][y]);
+			}
+		}
+		return hash;
+	}
+
+	void rehashState(State &state)
+	{
+		state.memoryHash = 0;
+		for (std::uint32_t a = 0; a < memorySize; a++)
+		{
+			state.memoryHash ^= memoryByteKey(a, state.memory[a]);
+		}
+
+		state.displayHash = hashDisplay(state.display);
+	}
+
+	int defaultInstructionsPerFrame(Platform platform)
+	{
+		switch (platform)
+		{
+		case Platform::chip8: return 11;
+		case Platform::schip: return 30;
+		case Platform::xoChip: return 1000;
+		}
+		return 11;
+	}
+
+	void Chip8::reset(Platform platform, Quirks quirks, std::uint32_t seed)
+	{
+		this->platform = platform;
+		this->quirks = quirks;
+		instructionsPerFrame = defaultInstructionsPerFrame(platform);
+		memoryMask = platform == Platform::xoChip ? 0xFFFF : 0xFFF;
+		compiled = nullptr;
+		timing = Timing::instructions;
+		resumeExecuted = -1;
+		keyWaitEnded = false;
+		this->seed = seed;
+
+		state = State{};
+		state.rng = seed ? seed : 1;
+
+		std::memcpy(&state.memory[smallFontAddress], smallFont, sizeof(smallFont));
+		std::memcpy(&state.memory[bigFontAddress], bigFont, sizeof(bigFont));
+		rehashState(state);
+	}
+
+	bool Chip8::loadRom(const std::uint8_t *data, std::size_t size)
+	{
+		if (size > (std::size_t)memoryMask + 1 - programStart)
+		{
+			return false;
+		}
+
+		for (std::size_t a = 0; a < size; a++)
+		{
+			writeMemory(state, (std::uint32_t)(programStart + a), data[a]);
+		}
+		return true;
+	}
+
+	std::uint8_t Chip8::random()
+	{
+		std::uint32_t x = state.rng;
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		state.rng = x;
+		return (std::uint8_t)(x >> 24);
+	}
+
+	void Chip8::skip()
+	{
+		//xo-chip skips over the whole 4 byte F000 NNNN instruction
+		if (platform == Platform::xoChip &&
+			state.memory[state.pc & memoryMask] == 0xF0 && state.memory[(state.pc + 1) & memoryMask] == 0x00)
+		{
+			state.pc += 4;
+		}
+		else
+		{
+			state.pc += 2;
+		}
+	}
+
+	//the whole display operations rehash every row, they touch most of them anyway
+	void Chip8::rehashDisplay()
+	{
+		state.displayHash = hashDisplay(state.display);
+	}
+
+	//xors the key of a row in or out, called before and after a draw changes it
+	void Chip8::toggleRowHash(int plane, int row)
+	{
+		state.displayHash ^= displayRowKey(plane, row, state.display.planes[plane][row]);
+	}
+
+	void Chip8::clearDisplay()
+	{
+		for (int p = 0; p < displayPlanes; p++)
+		{
+			if (state.planeMask & (1 << p))
+			{
+				std::memset(state.display.planes[p], 0, sizeof(state.display.planes[p]));
+			}
+		}
+
+		rehashDisplay();
+		state.dirtyRows = ~0ull;
+	}
+
+	void Chip8::setHires(bool hires)
+	{
+		state.display.hires = hires;
+		state.display.clear();
+		rehashDisplay();
+		state.dirtyRows = ~0ull;
+	}
+
+	void Chip8::scrollDown(int n)
+	{
+		Display &d = state.display;
+		const int h = d.height();
+		const int rowBytes = d.width() / 8;
+
+		for (int p = 0; p < displayPlanes; p++)
+		{
+			if (!(state.planeMask & (1 << p))) { continue; }
+
+			for (int y = h - 1; y >= 0; y--)
+			{
+				if (y >= n) { std::memcpy(d.planes[p][y], d.planes[p][y - n], rowBytes); }
+				else { std::memset(d.planes[p][y], 0, rowBytes); }
+			}
+		}
+
+		rehashDisplay();
+		state.dirtyRows = ~0ull;
+	}
+
+	void Chip8::scrollUp(int n)
+	{
+		Display &d = state.display;
+		const int h = d.height();
+		const int rowBytes = d.width() / 8;
+
+		for (int p = 0; p < displayPlanes; p++)
+		{
+			if (!(state.planeMask & (1 << p))) { continue; }
+
+			for (int y = 0; y < h; y++)
+			{
+				if (y + n < h) { std::memcpy(d.planes[p][y], d.planes[p][y + n], rowBytes); }
+				else { std::memset(d.planes[p][y], 0, rowBytes); }
+			}
+		}
+
+		rehashDisplay();
+		state.dirtyRows = ~0ull;
+	}
+
+	void Chip8::scrollRight()
+	{
+		Display &d = state.display;
+		const int h = d.height();
+		const int rowBytes = d.width() / 8;
+
+		for (int p = 0; p < displayPlanes; p++)
+		{
+			if (!(state.planeMask & (1 << p))) { continue; }
+
+			for (int y = 0; y < h; y++)
+			{
+				std::uint8_t *row = d.planes[p][y];
+				for (int b = rowBytes - 1; b >= 0; b--)
+				{
+					row[b] = (std::uint8_t)((row[b] >> 4) | (b > 0 ? row[b - 1] << 4 : 0));
+				}
+			}
+		}
+
+		rehashDisplay();
+		state.dirtyRows = ~0ull;
+	}
+
+	void Chip8::scrollLeft()
+	{
+		Display &d = state.display;
+		const int h = d.height();
+		const int rowBytes = d.width() / 8;
+
+		for (int p = 0; p < displayPlanes; p++)
+		{
+			if (!(state.planeMask & (1 << p))) { continue; }
+
+			for (int y = 0; y < h; y++)
+			{
+				std::uint8_t *row = d.planes[p][y];
+				for (int b = 0; b < rowBytes; b++)
+				{
+					row[b] = (std::uint8_t)((row[b] << 4) | (b + 1 < rowBytes ? row[b + 1] >> 4 : 0));
+				}
+			}
+		}
+
+		rehashDisplay();
+		state.dirtyRows = ~0ull;
+	}
+
+	void Chip8::draw(int xRegister, int yRegister, int n)
+	{
+		Display &d = state.display;
+		const int w = d.width();
+		const int h = d.height();
+		const int rowBytes = w / 8;
+
+		const int x = state.v[xRegister] % w;
+		const int y = state.v[yRegister] % h;
+
+		const bool big = n == 0 && platform != Platform::chip8;
+		const int rows = big ? 16 : n;
+		const int spriteBytes = big ? 2 : 1;
+
+		std::uint16_t address = state.i;
+		int collisions = 0;
+
+		//xors one sprite byte at pixel px, returns true if a lit pixel was turned off
+		auto drawByte = [&](std::uint8_t *row, int px, std::uint8_t bits) -> bool
+		{
+			if (!bits) { return false; }
+
+			if (px >= w)
+			{
+				if (quirks.clipping) { return false; }
+				px -= w;
+			}
+
+			const int index = px >> 3;
+			const int shift = px & 7;
+			bool hit = false;
+
+			const std::uint8_t left = (std::uint8_t)(bits >> shift);
+			hit |= (row[index] & left) != 0;
+			row[index] ^= left;
+
+			if (shift)
+			{
+				int next = index + 1;
+				if (next >= rowBytes)
+				{
+					if (quirks.clipping) { return hit; }
+					next = 0;
+				}
+
+				const std::uint8_t right = (std::uint8_t)(bits << (8 - shift));
+				hit |= (row[next] & right) != 0;
+				row[next] ^= right;
+			}
+
+			return hit;
+		};
+
+		for (int p = 0; p < displayPlanes; p++)
+		{
+			if (!(state.planeMask & (1 << p))) { continue; }
+
+			for (int r = 0; r < rows; r++)
+			{
+				std::uint8_t spriteRow[2] = {};
+				for (int b = 0; b < spriteBytes; b++)
+				{
+					spriteRow[b] = state.memory[address++ & memoryMask];
+				}
+
+				int py = y + r;
+				if (py >= h)
+				{
+					if (quirks.clipping)
+					{
+						//schip counts the clipped rows as collisions in hires
+						if (platform == Platform::schip && d.hires) { collisions++; }
+						continue;
+					}
+					py -= h;
+				}
+
+				//an empty sprite row doesn't change any pixel
+				if (!(spriteRow[0] | spriteRow[1])) { continue; }
+
+				std::uint8_t *row = d.planes[p][py];
+				bool hit = false;
+				toggleRowHash(p, py);
+				for (int b = 0; b < spriteBytes; b++)
+				{
+					hit |= drawByte(row, x + b * 8, spriteRow[b]);
+				}
+				toggleRowHash(p, py);
+				state.dirtyRows |= 1ull << py;
+
+				if (hit) { collisions++; }
+			}
+		}
+
+		if (platform == Platform::schip && d.hires)
+		{
+			state.v[0xF] = (std::uint8_t)collisions;
+		}
+		else
+		{
+			state.v[0xF] = collisions ? 1 : 0;
+		}
+	}
+
+	template <bool debug>
+	void Chip8::store(std::uint32_t address, std::uint8_t value)
+	{
+		if constexpr (debug) { debugger->memoryWritten(address, state.memory[address], value); }
+		writeMemory(state, address, value);
+	}
+
+	void Chip8::step()
+	{
+		stepWith<false>();
+	}
+
+	bool Chip8::finishKeyWait()
+	{
+		State &s = state;
+
+		//FX0A finishes when a key is released, like on the original hardware
+		std::uint16_t released = s.waitKeys & ~s.keys;
+		if (!released)
+		{
+			s.waitKeys |= s.keys;
+			return false;
+		}
+
+		int key = 0;
+		while (!(released & (1 << key))) { key++; }
+		s.v[s.keyRegister & 0xF] = (std::uint8_t)key;
+		s.waitingForKey = false;
+		s.waitKeys = 0;
+		return true;
+	}
+
+	template <bool debug>
+	void Chip8::stepWith()
+	{
+		State &s = state;
+
+		if (s.halted) { return; }
+
+		if (s.waitingForKey && !finishKeyWait()) { return; }
+
+		const std::uint16_t opcode = (std::uint16_t)((s.memory[s.pc & memoryMask] << 8) | s.memory[(s.pc + 1) & memoryMask]);
+		s.pc += 2;
+		s.instructionCount++;
+
+		const int x = (opcode >> 8) & 0xF;
+		const int y = (opcode >> 4) & 0xF;
+		const int n = opcode & 0xF;
+		const std::uint8_t nn = opcode & 0xFF;
+		const std::uint16_t nnn = opcode & 0xFFF;
+
+		switch (opcode >> 12)
+		{
+		case 0x0:
+			if ((opcode & 0xFFF0) == 0x00C0) { scrollDown(n); }
+			else if ((opcode & 0xFFF0) == 0x00D0) { scrollUp(n); }
+			else if (opcode == 0x00E0) { clearDisplay(); }
+			else if (opcode == 0x00EE) { s.sp = (s.sp - 1) & (stackSize - 1); s.pc = s.stack[s.sp]; }
+			else if (opcode == 0x00FB) { scrollRight(); }
+			else if (opcode == 0x00FC) { scrollLeft(); }
+			else if (opcode == 0x00FD) { s.halted = true; }
+			else if (opcode == 0x00FE) { setHires(false); }
+			else if (opcode == 0x00FF) { setHires(true); }
+			//0NNN machine code routines are not supported
+			break;
+
+		case 0x1: s.pc = nnn; break;
+
+		case 0x2:
+			s.stack[s.sp] = s.pc;
+			s.sp = (s.sp + 1) & (stackSize - 1);
+			s.pc = nnn;
+			break;
+
+		case 0x3: if (s.v[x] == nn) { skip(); } break;
+		case 0x4: if (s.v[x] != nn) { skip(); } break;
+
+		case 0x5:
+			if (n == 0) { if (s.v[x] == s.v[y]) { skip(); } }
+			else if (n == 2 || n == 3)
+			{
+				//xo-chip save and load a range of registers, I doesn't change
+				int step = x <= y ? 1 : -1;
+				if constexpr (debug) { if (n == 3) { debugger->memoryRead(s.i, (y - x) * step + 1, memoryMask); } }
+				for (int r = x, a = 0;; r += step, a++)
+				{
+					if (n == 2) { store<debug>((s.i + a) & memoryMask, s.v[r]); }
+					else { s.v[r] = s.memory[(s.i + a) & memoryMask]; }
+					if (r == y) { break; }
+				}
+			}
+			break;
+
+		case 0x6: s.v[x] = nn; break;
+		case 0x7: s.v[x] += nn; break;
+
+		case 0x8:
+		{
+			std::uint8_t flag = 0;
+			switch (n)
+			{
+			case 0x0: s.v[x] = s.v[y]; break;
+			case 0x1: s.v[x] |= s.v[y]; if (quirks.vfReset) { s.v[0xF] = 0; } break;
+			case 0x2: s.v[x] &= s.v[y]; if (quirks.vfReset) { s.v[0xF] = 0; } break;
+			case 0x3: s.v[x] ^= s.v[y]; if (quirks.vfReset) { s.v[0xF] = 0; } break;
+			case 0x4: { int r = s.v[x] + s.v[y]; s.v[x] = (std::uint8_t)r; s.v[0xF] = r > 0xFF; } break;
+			case 0x5: flag = s.v[x] >= s.v[y]; s.v[x] -= s.v[y]; s.v[0xF] = flag; break;
+			case 0x6:
+			{
+				std::uint8_t value = quirks.shiftVx ? s.v[x] : s.v[y];
+				s.v[x] = value >> 1; s.v[0xF] = value & 1;
+			}
+			break;
+			case 0x7: flag = s.v[y] >= s.v[x]; s.v[x] = s.v[y] - s.v[x]; s.v[0xF] = flag; break;
+			case 0xE:
+			{
+				std::uint8_t value = quirks.shiftVx ? s.v[x] : s.v[y];
+				s.v[x] = (std::uint8_t)(value << 1); s.v[0xF] = value >> 7;
+			}
+			break;
+			}
+		}
+		break;
+
+		case 0x9: if (n == 0 && s.v[x] != s.v[y]) { skip(); } break;
+		case 0xA: s.i = nnn; break;
+		case 0xB: s.pc = quirks.jumpVx ? (std::uint16_t)(nnn + s.v[x]) : (std::uint16_t)(nnn + s.v[0]); break;
+		case 0xC: s.v[x] = random() & nn; break;
+		case 0xD:
+			if constexpr (debug)
+			{
+				//the sprite of every selected plane, one after the other
+				const int bytes = n == 0 && platform != Platform::chip8 ? 32 : n;
+				debugger->memoryRead(s.i, bytes * ((s.planeMask & 1) + ((s.planeMask >> 1) & 1)), memoryMask);
+			}
+			draw(x, y, n);
+			drewThisInstruction = true;
+			break;
+
+		case 0xE:
+			if (nn == 0x9E) { if (s.keys & (1 << (s.v[x] & 0xF))) { skip(); } }
+			else if (nn == 0xA1) { if (!(s.keys & (1 << (s.v[x] & 0xF)))) { skip(); } }
+			break;
+
+		case 0xF:
+			switch (nn)
+			{
+			case 0x00:
+				if (opcode == 0xF000)
+				{
+					s.i = (std::uint16_t)((s.memory[s.pc & memoryMask] << 8) | s.memory[(s.pc + 1) & memoryMask]);
+					s.pc += 2;
+				}
+				break;
+			case 0x01: s.planeMask = x & 3; break;
+			case 0x02:
+				if constexpr (debug) { debugger->memoryRead(s.i, 16, memoryMask); }
+				for (int a = 0; a < 16; a++) { s.audioPattern[a] = s.memory[(s.i + a) & memoryMask]; }
+				break;
+			case 0x07: s.v[x] = s.delayTimer; break;
+			case 0x0A: s.waitingForKey = true; s.keyRegister = (std::uint8_t)x; s.waitKeys = 0; break;
+			case 0x15: s.delayTimer = s.v[x]; break;
+			case 0x18: s.soundTimer = s.v[x]; break;
+			case 0x1E: s.i += s.v[x]; break;
+			case 0x29: s.i = (std::uint16_t)(smallFontAddress + (s.v[x] & 0xF) * 5); break;
+			case 0x30: s.i = (std::uint16_t)(bigFontAddress + (s.v[x] & 0xF) * 10); break;
+			case 0x33:
+				store<debug>(s.i & memoryMask, s.v[x] / 100);
+				store<debug>((s.i + 1) & memoryMask, (s.v[x] / 10) % 10);
+				store<debug>((s.i + 2) & memoryMask, s.v[x] % 10);
+				break;
+			case 0x3A: s.pitch = s.v[x]; break;
+			case 0x55:
+				for (int r = 0; r <= x; r++) { store<debug>((s.i + r) & memoryMask, s.v[r]); }
+				if (quirks.memoryIncrement) { s.i += x + 1; }
+				break;
+			case 0x65:
+				if constexpr (debug) { debugger->memoryRead(s.i, x + 1, memoryMask); }
+				for (int r = 0; r <= x; r++) { s.v[r] = s.memory[(s.i + r) & memoryMask]; }
+				if (quirks.memoryIncrement) { s.i += x + 1; }
+				break;
+			case 0x75: for (int r = 0; r <= x; r++) { s.flags[r] = s.v[r]; } break;
+			case 0x85: for (int r = 0; r <= x; r++) { s.v[r] = s.flags[r]; } break;
+			}
+			break;
+		}
+	}
+
+	template <Timing mode, bool debug>
+	int Chip8::runFrameWith()
+	{
+		constexpr bool vip = mode == Timing::cosmacVip;
+		int executed = 0;
+
+		//finishing a frame the debugger stopped, the VIP cycles of it are in the balance already
+		const int resumed = std::max(resumeExecuted, 0);
+		if (resumeExecuted >= 0)
+		{
+			executed = resumeExecuted;
+			resumeExecuted = -1;
+		}
+		else if constexpr (vip) { state.cycleBalance += vipCyclesPerFrame; }
+
+		while (vip ? state.cycleBalance > 0 : executed < instructionsPerFrame)
+		{
+			if (state.halted || state.waitingForKey)
+			{
+				//the key state is seen once a frame, the instruction after FX0A runs below and ends the frame
+				const std::uint8_t waitedValue = state.v[state.keyRegister & 0xF];
+				if (state.halted || !finishKeyWait())
+				{
+					if constexpr (vip) { state.cycleBalance = std::min(state.cycleBalance, 0); }
+					break;
+				}
+				keyWaitEnded = true;
+
+				if constexpr (debug)
+				{
+					if (debugger->afterKeyWait(state, waitedValue, memoryMask))
+					{
+						resumeExecuted = executed;
+						return executed - resumed;
+					}
+				}
+			}
+
+			if constexpr (debug)
+			{
+				if (debugger->beforeInstruction(state, memoryMask))
+				{
+					resumeExecuted = executed;
+					return executed - resumed;
+				}
+			}
+
+			if constexpr (vip)
+			{
+				std::uint16_t opcode = (std::uint16_t)(state.memory[state.pc & memoryMask] << 8 |
+					state.memory[(state.pc + 1) & memoryMask]);
+				state.cycleBalance -= vipInstructionCycles(opcode, state);
+			}
+			else if (!debug && compiled && !keyWaitEnded)
+			{
+				//the recompiled code never draws or waits, those are always stepped here
+				executed += compiled(state, instructionsPerFrame - executed);
+				if (executed >= instructionsPerFrame) { break; }
+			}
+
+			drewThisInstruction = false;
+			stepWith<debug>();
+			executed++;
+
+			const bool displayWait = drewThisInstruction && quirks.displayWait && !state.display.hires;
+
+			if constexpr (debug)
+			{
+				//a stop on the instruction that ends the frame lets the frame end
+				if (debugger->afterInstruction(state) && !displayWait && !keyWaitEnded)
+				{
+					resumeExecuted = executed;
+					return executed - resumed;
+				}
+			}
+
+			if (displayWait || keyWaitEnded)
+			{
+				//the VIP waits for the interrupt, the rest of the frame goes to the display or the key
+				keyWaitEnded = false;
+				if constexpr (vip) { state.cycleBalance = std::min(state.cycleBalance, 0); }
+				break;
+			}
+		}
+
+		if (state.delayTimer) { state.delayTimer--; }
+		if (state.soundTimer) { state.soundTimer--; }
+		state.frameCount++;
+
+		return executed - resumed;
+	}
+
+	int Chip8::runFrame()
+	{
+		//the debug loop only while the debugger has something set, see debugger.h
+		if (debugger && debugger->armed())
+		{
+			if (timing == Timing::cosmacVip) { return runFrameWith<Timing::cosmacVip, true>(); }
+			return runFrameWith<Timing::instructions, true>();
+		}
+
+		if (timing == Timing::cosmacVip) { return runFrameWith<Timing::cosmacVip, false>(); }
+		return runFrameWith<Timing::instructions, false>();
+	}
+
+}
@@ -0,0 +1,155 @@
+#include <chip8/debugger.h>
+
+namespace chip8
+{
+
+	void Debugger::update()
+	{
+		breakAt.reset();
+		watchAt.reset();
+		anyBreakpoint = false;
+		anyMemoryWatch = false;
+		anyRegisterWatch = false;
+
+		for (const Breakpoint &breakpoint : breakpoints)
+		{
+			if (!breakpoint.enabled) { continue; }
+			breakAt.set(breakpoint.address);
+			anyBreakpoint = true;
+		}
+
+		for (const Watchpoint &watchpoint : watchpoints)
+		{
+			if (!watchpoint.enabled) { continue; }
+			if (watchpoint.kind == Watchpoint::memory)
+			{
+				for (std::uint32_t a = 0; a < watchpoint.size; a++) { watchAt.set((watchpoint.address + a) % memorySize); }
+				anyMemoryWatch |= watchpoint.size > 0;
+			}
+			else { anyRegisterWatch = true; }
+		}
+	}
+
+	void Debugger::stepInstructions(std::uint32_t count)
+	{
+		resume();
+		stepsLeft = count;
+	}
+
+	void Debugger::resume()
+	{
+		resumePc = stop.reason == StopReason::breakpoint || stop.reason == StopReason::rewound ? stop.pc : -1;
+		stop = {};
+	}
+
+	static std::uint16_t operandValue(const State &state, std::uint8_t operand)
+	{
+		if (operand < 16) { return state.v[operand]; }
+		if (operand == Debugger::operandI) { return state.i; }
+		return state.delayTimer;
+	}
+
+	bool Debugger::checkBreakpoints(const State &state)
+	{
+		for (std::size_t b = 0; b < breakpoints.size(); b++)
+		{
+			Breakpoint &breakpoint = breakpoints[b];
+			if (!breakpoint.enabled || breakpoint.address != instructionPc) { continue; }
+
+			std::uint16_t value = operandValue(state, breakpoint.operand);
+			bool hit = false;
+			switch (breakpoint.compare)
+			{
+			case Compare::always: hit = true; break;
+			case Compare::equal: hit = value == breakpoint.value; break;
+			case Compare::notEqual: hit = value != breakpoint.value; break;
+			case Compare::less: hit = value < breakpoint.value; break;
+			case Compare::lessEqual: hit = value <= breakpoint.value; break;
+			case Compare::greater: hit = value > breakpoint.value; break;
+			case Compare::greaterEqual: hit = value >= breakpoint.value; break;
+			}
+			if (!hit) { continue; }
+
+			breakpoint.hits++;
+			stop = {};
+			stop.reason = StopReason::breakpoint;
+			stop.index = (int)b;
+			stop.pc = instructionPc;
+			stepsLeft = 0;
+			return true;
+		}
+		return false;
+	}
+
+	void Debugger::checkMemoryWatch(std::uint32_t address, std::uint8_t oldValue, std::uint8_t newValue)
+	{
+		//the first write of the instruction is the one reported
+		if (stopped()) { return; }
+
+		for (std::size_t w = 0; w < watchpoints.size(); w++)
+		{
+			Watchpoint &watchpoint = watchpoints[w];
+			if (!watchpoint.enabled || watchpoint.kind != Watchpoint::memory) { continue; }
+			if ((address - watchpoint.address) % memorySize >= watchpoint.size) { continue; }
+
+			watchpoint.hits++;
+			stop = {};
+			stop.reason = StopReason::watchpoint;
+			stop.index = (int)w;
+			stop.instructionPc = instructionPc;
+			stop.address = (std::uint16_t)address;
+			stop.oldValue = oldValue;
+			stop.newValue = newValue;
+			stepsLeft = 0;
+			return;
+		}
+	}
+
+	void Debugger::checkRegisterWatch(const State &state)
+	{
+		for (std::size_t w = 0; w < watchpoints.size(); w++)
+		{
+			Watchpoint &watchpoint = watchpoints[w];
+			if (!watchpoint.enabled || watchpoint.kind == Watchpoint::memory) { continue; }
+
+			bool isI = watchpoint.kind == Watchpoint::registerI;
+			std::uint16_t before = isI ? iBefore : registersBefore[watchpoint.address & 0xF];
+			std::uint16_t after = isI ? state.i : state.v[watchpoint.address & 0xF];
+			if (before == after) { continue; }
+
+			watchpoint.hits++;
+			stop = {};
+			stop.reason = StopReason::watchpoint;
+			stop.index = (int)w;
+			stop.instructionPc = instructionPc;
+			stop.address = isI ? 0 : watchpoint.address & 0xF;
+			stop.oldValue = before;
+			stop.newValue = after;
+			stepsLeft = 0;
+			return;
+		}
+	}
+
+	const char *debuggerOperandName(std::uint8_t operand)
+	{
+		static const char *names[] = {"V0", "V1", "V2", "V3", "V4", "V5", "V6", "V7",
+			"V8", "V9", "VA", "VB", "VC", "VD", "VE", "VF", "I", "DT"};
+		return operand < sizeof(names) / sizeof(names[0]) ? names[operand] : "?";
+	}
+
+	const char *debuggerCompareName(Debugger::Compare compare)
+	{
+		switch (compare)
+		{
+		case Debugger::Compare::always: return "always";
+		case Debugger::Compare::equal: return "==";
+		case Debugger::Compare::notEqual: return "!=";
+		case Debugger::Compare::less: return "<";
+		case Debugger::Compare::lessEqual: return "<=";
+		case Debugger::Compare::greater: return ">";
+		case Debugger::Compare::greaterEqual: return ">=";
+		}
+		return "?";
+	}
+
+}
@@ -0,0 +1,74 @@
+#include <chip8/delta.h>
+
+namespace chip8
+{
+
+	static void writeVarint(std::vector<std::uint8_t> &out, std::size_t value)
+	{
+		while (value >= 0x80)
+		{
+			out.push_back((std::uint8_t)(value | 0x80));
+			value >>= 7;
+		}
+		out.push_back((std::uint8_t)value);
+	}
+
+	static bool readVarint(const std::uint8_t *data, std::size_t size, std::size_t &position, std::size_t &value)
+	{
+		value = 0;
+		for (int shift = 0; shift < 35; shift += 7)
+		{
+			if (position >= size) { return false; }
+			std::uint8_t byte = data[position++];
+			value |= (std::size_t)(byte & 0x7F) << shift;
+			if (!(byte & 0x80)) { return true; }
+		}
+		return false;
+	}
+
+	void encodeDelta(const std::uint8_t *base, const std::uint8_t *current, std::size_t size, std::vector<std::uint8_t> &out)
+	{
+		auto changed = [&](std::size_t i) { return (base ? base[i] : 0) != current[i]; };
+
+		std::size_t i = 0;
+		while (i < size)
+		{
+			std::size_t same = i;
+			while (same < size && !changed(same)) { same++; }
+
+			//a short run of unchanged bytes costs more as a new run than as changed bytes
+			std::size_t end = same;
+			while (end < size)
+			{
+				if (changed(end)) { end++; continue; }
+
+				std::size_t gap = end;
+				while (gap < size && gap < end + 3 && !changed(gap)) { gap++; }
+				if (gap == size || gap == end + 3) { break; }
+				end = gap;
+			}
+
+			writeVarint(out, same - i);
+			writeVarint(out, end - same);
+			for (std::size_t c = same; c < end; c++) { out.push_back((std::uint8_t)((base ? base[c] : 0) ^ current[c])); }
+			i = end;
+		}
+	}
+
+	std::size_t applyDelta(std::uint8_t *data, std::size_t size, const std::uint8_t *delta, std::size_t deltaSize)
+	{
+		std::size_t position = 0;
+		std::size_t i = 0;
+		while (i < size)
+		{
+			std::size_t same = 0, changed = 0;
+			if (!readVarint(delta, deltaSize, position, same) || !readVarint(delta, deltaSize, position, changed)) { return 0; }
+			if (same > size - i || changed > size - i - same || changed > deltaSize - position) { return 0; }
+
+			i += same;
+			for (std::size_t c = 0; c < changed; c++) { data[i++] ^= delta[position++]; }
+		}
+		return position;
+	}
+
+}
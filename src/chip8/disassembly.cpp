@@ -0,0 +1,244 @@
+#include <chip8/disassembly.h>
+#include <chip8/romAnalyzer.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace chip8
+{
+
+	int disassembleInstruction(std::uint16_t opcode, std::uint16_t operand, const char *address, char *out, std::size_t size)
+	{
+		const int x = (opcode >> 8) & 0xF;
+		const int y = (opcode >> 4) & 0xF;
+		const int n = opcode & 0xF;
+		const int nn = opcode & 0xFF;
+		const int nnn = opcode & 0xFFF;
+
+		char hex[8];
+		std::snprintf(hex, sizeof(hex), "%03X", nnn);
+		const char *target = address ? address : hex;
+
+		switch (opcode >> 12)
+		{
+		case 0x0:
+			if (opcode == 0x00E0) { return std::snprintf(out, size, "CLS"); }
+			if (opcode == 0x00EE) { return std::snprintf(out, size, "RET"); }
+			if ((opcode & 0xFFF0) == 0x00C0) { return std::snprintf(out, size, "SCD %X", n); }
+			if ((opcode & 0xFFF0) == 0x00D0) { return std::snprintf(out, size, "SCU %X", n); }
+			if (opcode == 0x00FB) { return std::snprintf(out, size, "SCR"); }
+			if (opcode == 0x00FC) { return std::snprintf(out, size, "SCL"); }
+			if (opcode == 0x00FD) { return std::snprintf(out, size, "EXIT"); }
+			if (opcode == 0x00FE) { return std::snprintf(out, size, "LOW"); }
+			if (opcode == 0x00FF) { return std::snprintf(out, size, "HIGH"); }
+			return std::snprintf(out, size, "SYS %s", target);
+		case 0x1: return std::snprintf(out, size, "JP %s", target);
+		case 0x2: return std::snprintf(out, size, "CALL %s", target);
+		case 0x3: return std::snprintf(out, size, "SE V%X, %02X", x, nn);
+		case 0x4: return std::snprintf(out, size, "SNE V%X, %02X", x, nn);
+		case 0x5:
+			if (n == 0) { return std::snprintf(out, size, "SE V%X, V%X", x, y); }
+			if (n == 2) { return std::snprintf(out, size, "SAVE V%X-V%X", x, y); }
+			if (n == 3) { return std::snprintf(out, size, "LOAD V%X-V%X", x, y); }
+			break;
+		case 0x6: return std::snprintf(out, size, "LD V%X, %02X", x, nn);
+		case 0x7: return std::snprintf(out, size, "ADD V%X, %02X", x, nn);
+		case 0x8:
+		{
+			static const char *names[16] = {"LD", "OR", "AND", "XOR", "ADD", "SUB", "SHR", "SUBN",
+				nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, "SHL", nullptr};
+			if (names[n]) { return std::snprintf(out, size, "%s V%X, V%X", names[n], x, y); }
+			break;
+		}
+		case 0x9:
+			if (n == 0) { return std::snprintf(out, size, "SNE V%X, V%X", x, y); }
+			break;
+		case 0xA: return std::snprintf(out, size, "LD I, %s", target);
+		case 0xB: return std::snprintf(out, size, "JP V0, %s", target);
+		case 0xC: return std::snprintf(out, size, "RND V%X, %02X", x, nn);
+		case 0xD: return std::snprintf(out, size, "DRW V%X, V%X, %X", x, y, n);
+		case 0xE:
+			if (nn == 0x9E) { return std::snprintf(out, size, "SKP V%X", x); }
+			if (nn == 0xA1) { return std::snprintf(out, size, "SKNP V%X", x); }
+			break;
+		case 0xF:
+			if (opcode == 0xF000)
+			{
+				if (address) { return std::snprintf(out, size, "LD I, %s", address); }
+				return std::snprintf(out, size, "LD I, %04X", operand);
+			}
+			if (opcode == 0xF002) { return std::snprintf(out, size, "AUDIO"); }
+			switch (nn)
+			{
+			case 0x01: return std::snprintf(out, size, "PLANE %X", x);
+			case 0x07: return std::snprintf(out, size, "LD V%X, DT", x);
+			case 0x0A: return std::snprintf(out, size, "LD V%X, K", x);
+			case 0x15: return std::snprintf(out, size, "LD DT, V%X", x);
+			case 0x18: return std::snprintf(out, size, "LD ST, V%X", x);
+			case 0x1E: return std::snprintf(out, size, "ADD I, V%X", x);
+			case 0x29: return std::snprintf(out, size, "LD F, V%X", x);
+			case 0x30: return std::snprintf(out, size, "LD HF, V%X", x);
+			case 0x33: return std::snprintf(out, size, "LD B, V%X", x);
+			case 0x3A: return std::snprintf(out, size, "PITCH V%X", x);
+			case 0x55: return std::snprintf(out, size, "LD [I], V%X", x);
+			case 0x65: return std::snprintf(out, size, "LD V%X, [I]", x);
+			case 0x75: return std::snprintf(out, size, "LD R, V%X", x);
+			case 0x85: return std::snprintf(out, size, "LD V%X, R", x);
+			}
+			break;
+		}
+
+		return std::snprintf(out, size, "DW %04X", opcode);
+	}
+
+	static std::uint16_t readWord(const State &state, std::uint32_t address, std::uint32_t mask)
+	{
+		return (std::uint16_t)(state.memory[address & mask] << 8 | state.memory[(address + 1) & mask]);
+	}
+
+	void Disassembly::clear()
+	{
+		rows.clear();
+		lines.clear();
+		entries.clear();
+		lastMissed = -1;
+	}
+
+	void Disassembly::analyze(const Chip8 &emulator)
+	{
+		const State &state = emulator.state;
+		memoryMask = emulator.memoryMask;
+		const std::uint32_t end = memoryMask + 1;
+
+		if (entries.empty()) { entries.push_back(programStart); }
+		std::vector<std::uint16_t> found;
+		findCode(&state.memory[programStart], end - programStart, entries.data(), entries.size(), found);
+
+		code.assign(end, false);
+		labels.assign(end, noLabel);
+		for (std::uint16_t address : found)
+		{
+			if (address >= end) { continue; }
+			code[address] = true;
+
+			const std::uint16_t opcode = readWord(state, address, memoryMask);
+			LabelKind kind = noLabel;
+			std::uint32_t target = opcode & 0xFFF;
+			switch (opcode >> 12)
+			{
+			case 0x1: case 0xB: kind = jumpLabel; break;
+			case 0x2: kind = callLabel; break;
+			case 0xA: kind = dataLabel; break;
+			case 0xF:
+				if (opcode == 0xF000)
+				{
+					kind = dataLabel;
+					target = readWord(state, address + 2, memoryMask);
+				}
+				break;
+			}
+			if (kind == noLabel || target >= end) { continue; }
+			labels[target] = std::max(labels[target], (std::uint8_t)kind);
+		}
+
+		//an instruction that overlaps the one before it (a skip into the middle) stays inside that row
+		rows.clear();
+		std::uint32_t address = 0;
+		while (address < end)
+		{
+			Row row;
+			row.address = (std::uint16_t)address;
+			if (code[address] && address + 1 < end)
+			{
+				row.code = true;
+				row.size = readWord(state, address, memoryMask) == 0xF000 && address + 3 < end ? 4 : 2;
+			}
+			else
+			{
+				std::uint32_t rowEnd = std::min((address / dataRowBytes + 1) * dataRowBytes, end);
+				std::uint32_t next = address + 1;
+				while (next < rowEnd && !code[next] && !labels[next]) { next++; }
+				row.size = (std::uint8_t)(next - address);
+			}
+			rows.push_back(row);
+			address += row.size;
+		}
+
+		lines.assign(rows.size(), Line{});
+		stats.analyses++;
+	}
+
+	bool Disassembly::follow(const Chip8 &emulator, std::uint16_t pc)
+	{
+		pc &= emulator.memoryMask;
+		const bool found = analyzed() && emulator.memoryMask == memoryMask;
+		if (found)
+		{
+			//below 0x200 or where nothing can be followed, findCode wouldn't find it either
+			if (code[pc] || pc < programStart || pc == lastMissed) { return false; }
+			entries.push_back(pc);
+		}
+
+		analyze(emulator);
+		if (found && !code[pc])
+		{
+			lastMissed = pc;
+			entries.pop_back();
+		}
+		return true;
+	}
+
+	std::size_t Disassembly::rowOf(std::uint16_t address) const
+	{
+		auto after = std::upper_bound(rows.begin(), rows.end(), address,
+			[](std::uint16_t address, const Row &row) { return address < row.address; });
+		return after == rows.begin() ? 0 : (std::size_t)(after - rows.begin()) - 1;
+	}
+
+	const char *Disassembly::text(const State &state, std::size_t index)
+	{
+		const Row &row = rows[index];
+		Line &line = lines[index];
+		const std::uint8_t *bytes = &state.memory[row.address];
+
+		if (line.made && std::memcmp(line.bytes, bytes, row.size) == 0)
+		{
+			stats.kept++;
+			return line.text;
+		}
+		line.made = true;
+		std::memcpy(line.bytes, bytes, row.size);
+		stats.made++;
+
+		if (row.code)
+		{
+			const std::uint16_t opcode = (std::uint16_t)(bytes[0] << 8 | bytes[1]);
+			const std::uint16_t operand = row.size == 4 ? (std::uint16_t)(bytes[2] << 8 | bytes[3]) : 0;
+
+			int kind = opcode >> 12;
+			bool hasAddress = kind == 0x1 || kind == 0x2 || kind == 0xA || kind == 0xB || opcode == 0xF000;
+			char name[16];
+			bool named = hasAddress && label(opcode == 0xF000 ? operand : opcode & 0xFFF, name, sizeof(name));
+			disassembleInstruction(opcode, operand, named ? name : nullptr, line.text, sizeof(line.text));
+		}
+		else
+		{
+			int length = std::snprintf(line.text, sizeof(line.text), "DB");
+			for (int b = 0; b < row.size; b++)
+			{
+				length += std::snprintf(line.text + length, sizeof(line.text) - length, " %02X", bytes[b]);
+			}
+		}
+		return line.text;
+	}
+
+	bool Disassembly::label(std::uint16_t address, char *out, std::size_t size) const
+	{
+		if (address >= labels.size() || labels[address] == noLabel) { return false; }
+
+		static const char *prefixes[] = {"", "data", "label", "sub"};
+		std::snprintf(out, size, address > 0xFFF ? "%s_%04X" : "%s_%03X", prefixes[labels[address]], address);
+		return true;
+	}
+
+}
@@ -0,0 +1,108 @@
+#include <chip8/hash.h>
+
+namespace chip8
+{
+
+	static const std::uint64_t prime1 = 11400714785074694791ull;
+	static const std::uint64_t prime2 = 14029467366897019727ull;
+	static const std::uint64_t prime3 = 1609587929392839161ull;
+	static const std::uint64_t prime4 = 9650029242287828579ull;
+	static const std::uint64_t prime5 = 2870177450012600261ull;
+
+	static std::uint64_t rotateLeft(std::uint64_t x, int r)
+	{
+		return (x << r) | (x >> (64 - r));
+	}
+
+	//little endian reads byte by byte, the data has no alignment
+	static std::uint64_t read64(const std::uint8_t *p)
+	{
+		std::uint64_t v = 0;
+		for (int i = 7; i >= 0; i--) { v = (v << 8) | p[i]; }
+		return v;
+	}
+
+	static std::uint32_t read32(const std::uint8_t *p)
+	{
+		return (std::uint32_t)p[0] | ((std::uint32_t)p[1] << 8) |
+			((std::uint32_t)p[2] << 16) | ((std::uint32_t)p[3] << 24);
+	}
+
+	static std::uint64_t xxRound(std::uint64_t acc, std::uint64_t input)
+	{
+		acc += input * prime2;
+		acc = rotateLeft(acc, 31);
+		return acc * prime1;
+	}
+
+	static std::uint64_t xxMergeRound(std::uint64_t acc, std::uint64_t value)
+	{
+		acc ^= xxRound(0, value);
+		return acc * prime1 + prime4;
+	}
+
+	std::uint64_t xxHash64(const void *data, std::size_t size, std::uint64_t seed)
+	{
+		const std::uint8_t *p = (const std::uint8_t *)data;
+		const std::uint8_t *end = p + size;
+		std::uint64_t h = 0;
+
+		if (size >= 32)
+		{
+			std::uint64_t v1 = seed + prime1 + prime2;
+			std::uint64_t v2 = seed + prime2;
+			std::uint64_t v3 = seed;
+			std::uint64_t v4 = seed - prime1;
+
+			const std::uint8_t *limit = end - 32;
+			do
+			{
+				v1 = xxRound(v1, read64(p)); p += 8;
+				v2 = xxRound(v2, read64(p)); p += 8;
+				v3 = xxRound(v3, read64(p)); p += 8;
+				v4 = xxRound(v4, read64(p)); p += 8;
+			} while (p <= limit);
+
+			h = rotateLeft(v1, 1) + rotateLeft(v2, 7) + rotateLeft(v3, 12) + rotateLeft(v4, 18);
+			h = xxMergeRound(h, v1);
+			h = xxMergeRound(h, v2);
+			h = xxMergeRound(h, v3);
+			h = xxMergeRound(h, v4);
+		}
+		else
+		{
+			h = seed + prime5;
+		}
+
+		h += (std::uint64_t)size;
+
+		while (p + 8 <= end)
+		{
+			h ^= xxRound(0, read64(p));
+			h = rotateLeft(h, 27) * prime1 + prime4;
+			p += 8;
+		}
+
+		if (p + 4 <= end)
+		{
+			h ^= (std::uint64_t)read32(p) * prime1;
+			h = rotateLeft(h, 23) * prime2 + prime3;
+			p += 4;
+		}
+
+		while (p < end)
+		{
+			h ^= (*p) * prime5;
+			h = rotateLeft(h, 11) * prime1;
+			p++;
+		}
+
+		h ^= h >> 33;
+		h *= prime2;
+		h ^= h >> 29;
+		h *= prime3;
+		h ^= h >> 32;
+		return h;
+	}
+
+}
@@ -0,0 +1,202 @@
+#include <chip8/history.h>
+#include <chip8/delta.h>
+#include <algorithm>
+#include <cstring>
+
+namespace chip8
+{
+
+	void History::clear()
+	{
+		keyframes.clear();
+		keys.clear();
+		firstFrame = 0;
+		lastInstructionCount = 0;
+	}
+
+	void History::beginFrame(const Chip8 &emulator)
+	{
+		const State &s = emulator.state;
+		if (keys.empty() || s.frameCount != endFrame() || s.instructionCount < lastInstructionCount)
+		{
+			clear();
+			firstFrame = s.frameCount;
+		}
+		lastInstructionCount = s.instructionCount;
+
+		if ((s.frameCount - firstFrame) % keyframeInterval == 0)
+		{
+			Keyframe keyframe;
+			keyframe.frame = s.frameCount;
+			keyframe.instructionCount = s.instructionCount;
+			encodeDelta(nullptr, (const std::uint8_t *)&s, sizeof(State), keyframe.delta);
+			keyframes.push_back(std::move(keyframe));
+		}
+		keys.push_back(s.keys);
+
+		//the oldest keyframe goes once the one after it is maxFrames old
+		while (keyframes.size() > 1 && endFrame() - keyframes[1].frame >= maxFrames)
+		{
+			keyframes.pop_front();
+			keys.erase(keys.begin(), keys.begin() + (std::ptrdiff_t)(keyframes.front().frame - firstFrame));
+			firstFrame = keyframes.front().frame;
+		}
+	}
+
+	bool History::oldest(std::uint64_t &instructionCount) const
+	{
+		if (keyframes.empty()) { return false; }
+		instructionCount = keyframes.front().instructionCount;
+		return true;
+	}
+
+	bool History::current(const Chip8 &emulator) const
+	{
+		//in the middle of a frame its keys are recorded already
+		return !keyframes.empty() && emulator.state.frameCount + (emulator.midFrame() ? 1 : 0) == endFrame() &&
+			emulator.state.instructionCount >= lastInstructionCount;
+	}
+
+	void History::prepare(const Chip8 &emulator, const Debugger *stops)
+	{
+		if (!replayer) { replayer = std::make_unique<Chip8>(); }
+		*replayer = emulator;
+		replayer->debugger = &replayDebugger;
+
+		replayDebugger.breakpoints.clear();
+		replayDebugger.watchpoints.clear();
+		if (stops)
+		{
+			replayDebugger.breakpoints = stops->breakpoints;
+			replayDebugger.watchpoints = stops->watchpoints;
+		}
+		replayDebugger.update();
+
+		replayedFrames = 0;
+	}
+
+	void History::restore(std::size_t keyframe, std::uint64_t runTo)
+	{
+		replayDebugger.stop = {};
+		replayDebugger.resume();
+		replayDebugger.runToInstruction(runTo);
+
+		//the delta is from zeros, the padding included
+		State &state = replayer->state;
+		std::memset((void *)&state, 0, sizeof(State));
+		const std::vector<std::uint8_t> &delta = keyframes[keyframe].delta;
+		applyDelta((std::uint8_t *)&state, sizeof(State), delta.data(), delta.size());
+		replayer->restoreState(state);
+	}
+
+	bool History::replay(std::uint64_t endFrame, std::uint64_t endCount)
+	{
+		Chip8 &chip8 = *replayer;
+		for (;;)
+		{
+			if (!chip8.midFrame())
+			{
+				if (chip8.state.frameCount >= endFrame || chip8.state.instructionCount >= endCount) { return false; }
+				chip8.setKeys(keys[(std::size_t)(chip8.state.frameCount - firstFrame)]);
+				replayedFrames++;
+			}
+
+			chip8.runFrame();
+			if (replayDebugger.stopped()) { return true; }
+		}
+	}
+
+	void History::land(Chip8 &emulator)
+	{
+		Debugger *debugger = emulator.debugger;
+		emulator = *replayer;
+		emulator.debugger = debugger;
+
+		//the display is not the one presented anymore
+		emulator.state.dirtyRows = ~0ull;
+
+		//the frames after the position run again with new keys
+		const std::uint64_t end = emulator.state.frameCount + (emulator.midFrame() ? 1 : 0);
+		while (endFrame() > end) { keys.pop_back(); }
+		while (!keyframes.empty() && keyframes.back().frame >= end) { keyframes.pop_back(); }
+		lastInstructionCount = emulator.state.instructionCount;
+	}
+
+	bool History::seek(Chip8 &emulator, std::uint64_t instructionCount)
+	{
+		if (!current(emulator) || instructionCount > emulator.state.instructionCount ||
+			instructionCount < keyframes.front().instructionCount)
+		{
+			return false;
+		}
+
+		//the last keyframe before the target, a target right at the first keyframe is that keyframe
+		auto after = std::lower_bound(keyframes.begin(), keyframes.end(), instructionCount,
+			[](const Keyframe &keyframe, std::uint64_t count) { return keyframe.instructionCount < count; });
+		std::size_t keyframe = after == keyframes.begin() ? 0 : (std::size_t)(after - keyframes.begin()) - 1;
+
+		prepare(emulator, nullptr);
+		restore(keyframe, instructionCount);
+		replay(endFrame(), instructionCount);
+
+		land(emulator);
+		return true;
+	}
+
+	bool History::stepBack(Chip8 &emulator, Debugger &debugger)
+	{
+		if (!emulator.state.instructionCount || !seek(emulator, emulator.state.instructionCount - 1)) { return false; }
+
+		debugger.stop = {};
+		debugger.stop.reason = Debugger::StopReason::rewound;
+		debugger.stop.pc = (std::uint16_t)(emulator.state.pc & emulator.memoryMask);
+		return true;
+	}
+
+	bool History::runBack(Chip8 &emulator, Debugger &debugger)
+	{
+		if (!current(emulator)) { return false; }
+		const std::uint64_t position = emulator.state.instructionCount;
+
+		//the keyframes from the newest, the first one with stops before the position has the last one
+		prepare(emulator, &debugger);
+		for (std::size_t keyframe = keyframes.size(); keyframe-- > 0;)
+		{
+			const std::uint64_t segmentEnd = keyframe + 1 < keyframes.size() ? keyframes[keyframe + 1].frame : endFrame();
+
+			restore(keyframe, position);
+			int stops = 0;
+			while (replay(segmentEnd, position) && replayer->state.instructionCount < position)
+			{
+				stops++;
+				replayDebugger.resume();
+			}
+			if (!stops) { continue; }
+
+			//again up to the last one
+			restore(keyframe, position);
+			for (int s = 0; s < stops; s++)
+			{
+				if (s) { replayDebugger.resume(); }
+				replay(segmentEnd, position);
+			}
+
+			land(emulator);
+			debugger.stop = replayDebugger.stop;
+			return true;
+		}
+
+		return false;
+	}
+
+	History::Stats History::stats() const
+	{
+		Stats stats;
+		stats.keyframes = keyframes.size();
+		for (const Keyframe &keyframe : keyframes) { stats.keyframeBytes += keyframe.delta.size(); }
+		stats.frames = keys.size();
+		stats.lastReplayedFrames = replayedFrames;
+		return stats;
+	}
+
+}
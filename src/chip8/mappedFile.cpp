@@ -0,0 +1,178 @@
+#include <chip8/mappedFile.h>
+#include <utility>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace chip8
+{
+
+	MappedFile::MappedFile(MappedFile &&other) noexcept
+	{
+		*this = std::move(other);
+	}
+
+	MappedFile &MappedFile::operator=(MappedFile &&other) noexcept
+	{
+		if (this != &other)
+		{
+			close();
+			std::swap(data, other.data);
+			std::swap(size, other.size);
+		#ifdef _WIN32
+			std::swap(mapping, other.mapping);
+		#endif
+		}
+		return *this;
+	}
+
+#ifdef _WIN32
+
+	bool MappedFile::open(const char *path)
+	{
+		close();
+
+		HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr,
+			OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE) { return false; }
+
+		LARGE_INTEGER fileSize = {};
+		if (!GetFileSizeEx(file, &fileSize))
+		{
+			CloseHandle(file);
+			return false;
+		}
+
+		//a zero sized file can't be mapped
+		if (fileSize.QuadPart == 0)
+		{
+			CloseHandle(file);
+			return true;
+		}
+
+		HANDLE fileMapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		CloseHandle(file); //the mapping keeps the file open
+		if (!fileMapping) { return false; }
+
+		void *view = MapViewOfFile(fileMapping, FILE_MAP_READ, 0, 0, 0);
+		if (!view)
+		{
+			CloseHandle(fileMapping);
+			return false;
+		}
+
+		mapping = fileMapping;
+		data = (const std::uint8_t *)view;
+		size = (std::size_t)fileSize.QuadPart;
+		return true;
+	}
+
+	std::uint8_t *MappedFile::create(const char *path, std::size_t size)
+	{
+		close();
+		if (!size) { return nullptr; }
+
+		HANDLE file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, 0, nullptr,
+			CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) { return nullptr; }
+
+		HANDLE fileMapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE,
+			(DWORD)((std::uint64_t)size >> 32), (DWORD)size, nullptr);
+		CloseHandle(file);
+		if (!fileMapping) { return nullptr; }
+
+		void *view = MapViewOfFile(fileMapping, FILE_MAP_WRITE, 0, 0, size);
+		if (!view)
+		{
+			CloseHandle(fileMapping);
+			return nullptr;
+		}
+
+		mapping = fileMapping;
+		data = (const std::uint8_t *)view;
+		this->size = size;
+		return (std::uint8_t *)view;
+	}
+
+	void MappedFile::close()
+	{
+		if (data) { UnmapViewOfFile(data); }
+		if (mapping) { CloseHandle(mapping); }
+		data = nullptr;
+		size = 0;
+		mapping = nullptr;
+	}
+
+#else
+
+	bool MappedFile::open(const char *path)
+	{
+		close();
+
+		int file = ::open(path, O_RDONLY);
+		if (file < 0) { return false; }
+
+		struct stat fileStat = {};
+		if (fstat(file, &fileStat) != 0 || !S_ISREG(fileStat.st_mode))
+		{
+			::close(file);
+			return false;
+		}
+
+		//a zero sized file can't be mapped
+		if (fileStat.st_size == 0)
+		{
+			::close(file);
+			return true;
+		}
+
+		void *view = mmap(nullptr, (std::size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+		::close(file); //the mapping keeps the file open
+		if (view == MAP_FAILED) { return false; }
+
+		data = (const std::uint8_t *)view;
+		size = (std::size_t)fileStat.st_size;
+		return true;
+	}
+
+	std::uint8_t *MappedFile::create(const char *path, std::size_t size)
+	{
+		close();
+		if (!size) { return nullptr; }
+
+		int file = ::open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+		if (file < 0) { return nullptr; }
+
+		if (ftruncate(file, (off_t)size) != 0)
+		{
+			::close(file);
+			return nullptr;
+		}
+
+		void *view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+		::close(file);
+		if (view == MAP_FAILED) { return nullptr; }
+
+		data = (const std::uint8_t *)view;
+		this->size = size;
+		return (std::uint8_t *)view;
+	}
+
+	void MappedFile::close()
+	{
+		if (data) { munmap((void *)data, size); }
+		data = nullptr;
+		size = 0;
+	}
+
+#endif
+
+}
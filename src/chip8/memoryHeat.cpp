@@ -0,0 +1,59 @@
+#include <chip8/memoryHeat.h>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define CHIP8_HEAT_SSE2
+#elif defined(__ARM_NEON)
+	#include <arm_neon.h>
+	#define CHIP8_HEAT_NEON
+#endif
+
+namespace chip8
+{
+
+	constexpr std::size_t heatCounters = (std::size_t)MemoryHeat::kinds * memorySize;
+	static_assert(heatCounters % 8 == 0, "the SIMD pass has no tail");
+
+	MemoryHeat::MemoryHeat()
+	{
+		counts = std::make_unique<std::uint16_t[]>(heatCounters);
+	}
+
+	void MemoryHeat::clear()
+	{
+		std::fill(counts.get(), counts.get() + heatCounters, (std::uint16_t)0);
+	}
+
+	void MemoryHeat::decay(int shift)
+	{
+		std::uint16_t *c = counts.get();
+
+	#if defined(CHIP8_HEAT_SSE2)
+		const __m128i one = _mm_set1_epi16(1);
+		const __m128i count = _mm_cvtsi32_si128(shift);
+		for (std::size_t i = 0; i < heatCounters; i += 8)
+		{
+			__m128i v = _mm_loadu_si128((const __m128i *)(c + i));
+			v = _mm_subs_epu16(_mm_sub_epi16(v, _mm_srl_epi16(v, count)), one);
+			_mm_storeu_si128((__m128i *)(c + i), v);
+		}
+	#elif defined(CHIP8_HEAT_NEON)
+		const uint16x8_t one = vdupq_n_u16(1);
+		const int16x8_t count = vdupq_n_s16((std::int16_t)-shift);
+		for (std::size_t i = 0; i < heatCounters; i += 8)
+		{
+			uint16x8_t v = vld1q_u16(c + i);
+			v = vqsubq_u16(vsubq_u16(v, vshlq_u16(v, count)), one);
+			vst1q_u16(c + i, v);
+		}
+	#else
+		for (std::size_t i = 0; i < heatCounters; i++)
+		{
+			std::uint16_t v = (std::uint16_t)(c[i] - (c[i] >> shift));
+			c[i] = v ? v - 1 : 0;
+		}
+	#endif
+	}
+
+}
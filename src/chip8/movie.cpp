@@ -0,0 +1,224 @@
+#include <chip8/movie.h>
+#include <cstdio>
+#include <cstring>
+
+namespace chip8
+{
+
+	void Movie::begin(const Chip8 &emulator, std::uint64_t romHash, int hashInterval)
+	{
+		this->romHash = romHash;
+		platform = emulator.platform;
+		quirks = emulator.quirks;
+		instructionsPerFrame = emulator.instructionsPerFrame;
+		timing = emulator.timing;
+		seed = emulator.seed;
+		this->hashInterval = hashInterval > 0 ? hashInterval : 1;
+
+		keyRuns.clear();
+		hashes.clear();
+		frameCount = 0;
+	}
+
+	void Movie::recordFrame(std::uint16_t keys, std::uint64_t stateHash)
+	{
+		if (keyRuns.empty() || keyRuns.back().keys != keys)
+		{
+			keyRuns.push_back({keys, 0});
+		}
+		keyRuns.back().frames++;
+
+		frameCount++;
+		if (frameCount % hashInterval == 0) { hashes.push_back(stateHash); }
+	}
+
+	void Movie::resetEmulator(Chip8 &emulator) const
+	{
+		emulator.reset(platform, quirks, seed);
+		emulator.instructionsPerFrame = instructionsPerFrame;
+		emulator.timing = timing;
+	}
+
+	//little endian, the same on every machine
+	static const char movieMagic[8] = {'C', '8', 'M', 'O', 'V', 'I', 'E', '3'};
+
+	static void writeInt(std::vector<std::uint8_t> &out, std::uint64_t value, int bytes)
+	{
+		for (int i = 0; i < bytes; i++) { out.push_back((std::uint8_t)(value >> (i * 8))); }
+	}
+
+	//run lengths are usually small, 7 bits per byte
+	static void writeVarint(std::vector<std::uint8_t> &out, std::uint32_t value)
+	{
+		while (value >= 0x80)
+		{
+			out.push_back((std::uint8_t)(value | 0x80));
+			value >>= 7;
+		}
+		out.push_back((std::uint8_t)value);
+	}
+
+	struct MovieReader
+	{
+		const std::uint8_t *data = nullptr;
+		std::size_t size = 0;
+		std::size_t position = 0;
+		bool ok = true;
+
+		std::uint64_t readInt(int bytes)
+		{
+			if (position + bytes > size) { ok = false; return 0; }
+			std::uint64_t value = 0;
+			for (int i = 0; i < bytes; i++) { value |= (std::uint64_t)data[position + i] << (i * 8); }
+			position += bytes;
+			return value;
+		}
+
+		std::uint32_t readVarint()
+		{
+			std::uint32_t value = 0;
+			for (int shift = 0; shift < 35; shift += 7)
+			{
+				if (position >= size) { break; }
+				std::uint8_t byte = data[position++];
+				value |= (std::uint32_t)(byte & 0x7F) << shift;
+				if (!(byte & 0x80)) { return value; }
+			}
+			ok = false;
+			return 0;
+		}
+	};
+
+	bool Movie::save(const char *path) const
+	{
+		std::vector<std::uint8_t> out;
+		out.insert(out.end(), movieMagic, movieMagic + sizeof(movieMagic));
+		writeInt(out, romHash, 8);
+		writeInt(out, (std::uint8_t)platform, 1);
+		writeInt(out, quirksToBits(quirks), 4);
+		writeInt(out, (std::uint32_t)instructionsPerFrame, 4);
+		writeInt(out, (std::uint8_t)timing, 1);
+		writeInt(out, seed, 4);
+		writeInt(out, frameCount, 4);
+		writeInt(out, (std::uint32_t)hashInterval, 4);
+
+		writeInt(out, keyRuns.size(), 4);
+		for (const KeyRun &run : keyRuns)
+		{
+			writeInt(out, run.keys, 2);
+			writeVarint(out, run.frames);
+		}
+
+		writeInt(out, hashes.size(), 4);
+		for (std::uint64_t hash : hashes) { writeInt(out, hash, 8); }
+
+		std::FILE *file = std::fopen(path, "wb");
+		if (!file) { return false; }
+		bool ok = std::fwrite(out.data(), 1, out.size(), file) == out.size();
+		return (std::fclose(file) == 0) && ok;
+	}
+
+	bool Movie::load(const char *path)
+	{
+		std::FILE *file = std::fopen(path, "rb");
+		if (!file) { return false; }
+
+		std::vector<std::uint8_t> data;
+		std::uint8_t buffer[4096];
+		std::size_t read = 0;
+		while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+		{
+			data.insert(data.end(), buffer, buffer + read);
+		}
+		std::fclose(file);
+
+		if (data.size() < sizeof(movieMagic) || std::memcmp(data.data(), movieMagic, sizeof(movieMagic)) != 0)
+		{
+			return false;
+		}
+
+		MovieReader reader;
+		reader.data = data.data();
+		reader.size = data.size();
+		reader.position = sizeof(movieMagic);
+
+		Movie movie;
+		movie.romHash = reader.readInt(8);
+		std::uint8_t platformValue = (std::uint8_t)reader.readInt(1);
+		movie.quirks = quirksFromBits((std::uint32_t)reader.readInt(4));
+		movie.instructionsPerFrame = (int)reader.readInt(4);
+		std::uint8_t timingValue = (std::uint8_t)reader.readInt(1);
+		movie.seed = (std::uint32_t)reader.readInt(4);
+		movie.frameCount = (std::uint32_t)reader.readInt(4);
+		movie.hashInterval = (int)reader.readInt(4);
+
+		if (platformValue > (std::uint8_t)Platform::xoChip || movie.hashInterval <= 0) { return false; }
+		if (timingValue > (std::uint8_t)Timing::cosmacVip) { return false; }
+		movie.platform = (Platform)platformValue;
+		movie.timing = (Timing)timingValue;
+
+		//the counts are checked against what is left so a broken file can't ask for gigabytes
+		std::uint32_t runCount = (std::uint32_t)reader.readInt(4);
+		if (!reader.ok || runCount > (reader.size - reader.position) / 3) { return false; }
+
+		std::uint64_t framesInRuns = 0;
+		movie.keyRuns.resize(runCount);
+		for (KeyRun &run : movie.keyRuns)
+		{
+			run.keys = (std::uint16_t)reader.readInt(2);
+			run.frames = reader.readVarint();
+			framesInRuns += run.frames;
+		}
+
+		std::uint32_t hashCount = (std::uint32_t)reader.readInt(4);
+		if (!reader.ok || hashCount > (reader.size - reader.position) / 8) { return false; }
+
+		movie.hashes.resize(hashCount);
+		for (std::uint64_t &hash : movie.hashes) { hash = reader.readInt(8); }
+
+		if (!reader.ok || framesInRuns != movie.frameCount) { return false; }
+
+		*this = std::move(movie);
+		return true;
+	}
+
+	void MoviePlayer::start(const Movie &movie)
+	{
+		this->movie = &movie;
+		frame = 0;
+		desyncFrame = -1;
+		run = 0;
+		frameInRun = 0;
+	}
+
+	std::uint16_t MoviePlayer::keys() const
+	{
+		if (finished() || run >= movie->keyRuns.size()) { return 0; }
+		return movie->keyRuns[run].keys;
+	}
+
+	bool MoviePlayer::endFrame(std::uint64_t stateHash)
+	{
+		if (finished()) { return true; }
+
+		frame++;
+		if (run < movie->keyRuns.size() && ++frameInRun >= movie->keyRuns[run].frames)
+		{
+			run++;
+			frameInRun = 0;
+		}
+
+		if (frame % movie->hashInterval == 0)
+		{
+			std::size_t index = frame / movie->hashInterval - 1;
+			if (index < movie->hashes.size() && movie->hashes[index] != stateHash)
+			{
+				if (desyncFrame < 0) { desyncFrame = frame - 1; }
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+}
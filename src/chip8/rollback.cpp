@@ -0,0 +1,114 @@
+#include <chip8/rollback.h>
+#include <algorithm>
+
+namespace chip8
+{
+
+	void Rollback::start(Chip8 &emulator)
+	{
+		this->emulator = &emulator;
+		frame = 0;
+		confirmedFrames = 0;
+		desyncFrame = -1;
+		stats = {};
+
+		std::fill(inputs, inputs + inputFrames, FrameInput{});
+		lastRemoteKeys = 0;
+		rollbackPending = false;
+
+		//66 KB each, allocated once
+		if (!snapshots) { snapshots = std::make_unique<State[]>(maxFrames + 1); }
+	}
+
+	void Rollback::runFrame(std::uint32_t runFrame)
+	{
+		const FrameInput &input = inputs[runFrame % inputFrames];
+		snapshots[runFrame % (maxFrames + 1)] = emulator->state;
+
+		emulator->setKeys(input.local | input.remote);
+		emulator->runFrame();
+
+		hashes[runFrame % (maxFrames + 1)] = hashState(emulator->state);
+	}
+
+	bool Rollback::advance(std::uint16_t localKeys)
+	{
+		resimulate();
+
+		if (!canAdvance())
+		{
+			stats.stalledFrames++;
+			return false;
+		}
+
+		FrameInput &input = inputs[frame % inputFrames];
+		input.local = localKeys;
+		if (frame >= confirmedFrames) { input.remote = lastRemoteKeys; }
+
+		runFrame(frame);
+		frame++;
+		return true;
+	}
+
+	void Rollback::addRemoteInput(std::uint32_t remoteFrame, std::uint16_t keys)
+	{
+		//a frame too far ahead would overwrite the keys of a frame that can still be restored
+		if (remoteFrame != confirmedFrames || remoteFrame >= frame + inputFrames - maxFrames) { return; }
+
+		FrameInput &input = inputs[remoteFrame % inputFrames];
+
+		//the keys come in order so the first wrong prediction is the oldest
+		if (remoteFrame < frame && input.remote != keys && !rollbackPending)
+		{
+			rollbackPending = true;
+			rollbackFrame = remoteFrame;
+		}
+
+		input.remote = keys;
+		lastRemoteKeys = keys;
+		confirmedFrames++;
+	}
+
+	void Rollback::resimulate()
+	{
+		if (!rollbackPending) { return; }
+		rollbackPending = false;
+
+		emulator->state = snapshots[rollbackFrame % (maxFrames + 1)];
+
+		//the rows drawn by the frames that were thrown away have to be presented again too
+		emulator->state.dirtyRows = ~0ull;
+
+		for (std::uint32_t f = rollbackFrame; f < frame; f++)
+		{
+			//the frames after the last remote keys get the newer prediction
+			if (f >= confirmedFrames) { inputs[f % inputFrames].remote = lastRemoteKeys; }
+			runFrame(f);
+		}
+
+		int count = (int)(frame - rollbackFrame);
+		stats.rollbacks++;
+		stats.resimulatedFrames += count;
+		stats.mostResimulatedFrames = std::max(stats.mostResimulatedFrames, count);
+	}
+
+	bool Rollback::confirmedHash(std::uint32_t &hashFrame, std::uint64_t &hash) const
+	{
+		std::uint32_t confirmed = std::min(confirmedFrames, frame);
+		if (rollbackPending || !confirmed) { return false; }
+
+		hashFrame = confirmed - 1;
+		hash = hashes[hashFrame % (maxFrames + 1)];
+		return true;
+	}
+
+	void Rollback::checkRemoteHash(std::uint32_t hashFrame, std::uint64_t hash)
+	{
+		//only frames that are final here and still in the ring can be compared, a later packet has a newer one
+		std::uint32_t confirmed = std::min(confirmedFrames, frame);
+		if (desyncFrame >= 0 || rollbackPending || hashFrame >= confirmed || hashFrame + maxFrames + 1 <= frame) { return; }
+
+		if (hashes[hashFrame % (maxFrames + 1)] != hash) { desyncFrame = hashFrame; }
+	}
+
+}
@@ -0,0 +1,254 @@
+#include <chip8/romAnalyzer.h>
+#include <vector>
+#include <algorithm>
+
+namespace chip8
+{
+
+	struct Analyzer
+	{
+		const std::uint8_t *rom = nullptr;
+		std::size_t size = 0;
+
+		std::vector<bool> visited;
+		std::vector<unsigned> pending;
+
+		//I along the straight code being followed, -1 when it isn't known
+		int index = -1;
+
+		RomAnalysis result;
+
+		bool inRom(unsigned address) const
+		{
+			return address >= programStart && address - programStart + 1 < size;
+		}
+
+		std::uint16_t read(unsigned address) const
+		{
+			return (std::uint16_t)((rom[address - programStart] << 8) | rom[address - programStart + 1]);
+		}
+
+		//F000 NNNN is the only 4 byte instruction, skips jump over all of it
+		unsigned instructionSize(unsigned address) const
+		{
+			return inRom(address) && read(address) == 0xF000 ? 4 : 2;
+		}
+	};
+
+	//FX07, skip if VX is 0, jump back to the FX07
+	static bool isDelayWait(const Analyzer &a, unsigned address, int x)
+	{
+		if (!a.inRom(address + 2)) { return false; }
+
+		std::uint16_t test = a.read(address + 2);
+		if (test != (0x3000 | (x << 8)) && test != (0x4000 | (x << 8))) { return false; } //3X00 or 4X00
+
+		for (unsigned jump = address + 4; jump <= address + 6; jump += 2)
+		{
+			if (a.inRom(jump) && a.read(jump) == (0x1000 | address)) { return true; }
+		}
+		return false;
+	}
+
+	//Another FX55 or FX65 right after one, with I not set in between, only works if I moved past
+	//the registers, so the program was written for the original increment.
+	static bool isSequentialLoadStore(const Analyzer &a, unsigned address)
+	{
+		for (int i = 1; i <= 4; i++)
+		{
+			unsigned next = address + i * 2;
+			if (!a.inRom(next)) { return false; }
+
+			std::uint16_t op = a.read(next);
+			if ((op & 0xF0FF) == 0xF055 || (op & 0xF0FF) == 0xF065) { return true; }
+
+			//only register arithmetic in between, anything else may set I or leave this path
+			int kind = op >> 12;
+			if (kind != 0x6 && kind != 0x7 && kind != 0x8 && kind != 0xC) { return false; }
+		}
+		return false;
+	}
+
+	//a read or write of bytes at I that runs past 0xFFF, where 4 KB of memory wraps around
+	static void accessAtIndex(Analyzer &a, int bytes)
+	{
+		if (a.index >= 0 && a.index + bytes > 0x1000) { a.result.indexWraps = true; }
+	}
+
+	static void followCode(Analyzer &a, unsigned address)
+	{
+		RomAnalysis &r = a.result;
+
+		//a path starts where a jump, call or skip goes, I can be anything there
+		a.index = -1;
+		bool maybeSkipped = false;
+
+		while (a.inRom(address) && !a.visited[address])
+		{
+			a.visited[address] = true;
+			r.reachableInstructions++;
+			if (address > 0xFFF) { r.usesHighMemory = true; }
+
+			const std::uint16_t op = a.read(address);
+			const int x = (op >> 8) & 0xF;
+			const int y = (op >> 4) & 0xF;
+			const int n = op & 0xF;
+			const int nn = op & 0xFF;
+			const unsigned nnn = op & 0xFFF;
+
+			unsigned next = address + 2;
+			bool skip = false;
+
+			switch (op >> 12)
+			{
+			case 0x0:
+				if (op == 0x00EE) { return; }
+				if (op == 0x00FD) { r.usesSchip = true; return; }
+				if ((op & 0xFFF0) == 0x00C0 && n) { r.usesSchip = true; }
+				else if ((op & 0xFFF0) == 0x00D0 && n) { r.usesXoChip = true; }
+				else if (op >= 0x00FB && op <= 0x00FF) { r.usesSchip = true; }
+				break;
+
+			case 0x1:
+				if (nnn != address) { a.pending.push_back(nnn); }
+				return;
+
+			case 0x2: a.pending.push_back(nnn); break;
+
+			case 0x3: case 0x4: skip = true; break;
+
+			case 0x5:
+				if (n == 0) { skip = true; }
+				else if (n == 2 || n == 3)
+				{
+					r.usesXoChip = true;
+					accessAtIndex(a, (x > y ? x - y : y - x) + 1);
+				}
+				break;
+
+			case 0x8:
+				if ((n == 0x6 || n == 0xE) && x != y)
+				{
+					r.shiftsOtherRegister = true;
+					if (y) { r.shiftsFromVy = true; }
+				}
+				break;
+
+			case 0x9: skip = true; break;
+
+			case 0xA: a.index = maybeSkipped ? -1 : (int)nnn; break;
+
+			case 0xB:
+				//jump tables, only the base is known
+				r.indirectJumps = true;
+				a.pending.push_back(nnn);
+				return;
+
+			case 0xD:
+				if (n == 0) { r.usesSchip = true; }
+				accessAtIndex(a, n ? n : 32);
+				break;
+
+			case 0xE: skip = (nn == 0x9E || nn == 0xA1); break;
+
+			case 0xF:
+				if (op == 0xF000)
+				{
+					r.usesXoChip = true;
+					next = address + 4;
+					a.index = maybeSkipped || !a.inRom(address + 2) ? -1 : a.read(address + 2);
+					if (a.index > 0xFFF) { r.usesHighMemory = true; }
+					break;
+				}
+				if (op == 0xF002) { accessAtIndex(a, 16); }
+				if (nn == 0x33) { accessAtIndex(a, 3); }
+				if (nn == 0x55 || nn == 0x65) { accessAtIndex(a, x + 1); }
+
+				if (nn == 0x01 && x <= 3) { r.usesXoChip = true; }
+				else if (op == 0xF002 || nn == 0x3A) { r.usesXoChip = true; }
+				else if (nn == 0x30 || nn == 0x75 || nn == 0x85) { r.usesSchip = true; }
+				else if (nn == 0x07 && isDelayWait(a, address, x)) { r.pacedByDelayTimer = true; }
+				else if ((nn == 0x55 || nn == 0x65) && isSequentialLoadStore(a, address)) { r.reliesOnIndexIncrement = true; }
+
+				//FX1E, the fonts and the increment quirk move I somewhere not followed here
+				if (nn == 0x1E || nn == 0x29 || nn == 0x30 || nn == 0x55 || nn == 0x65) { a.index = -1; }
+				break;
+			}
+
+			if (skip) { a.pending.push_back(next + a.instructionSize(next)); }
+
+			//the instruction after a skip may not run, what it sets isn't known
+			maybeSkipped = skip;
+			address = next;
+		}
+	}
+
+	static void analyze(Analyzer &a, const std::uint8_t *rom, std::size_t size,
+		const std::uint16_t *entries, std::size_t entryCount, std::vector<std::uint16_t> *codeAddresses)
+	{
+		a.rom = rom;
+		a.size = std::min(size, (std::size_t)(memorySize - programStart));
+		a.visited.resize(memorySize + 4);
+
+		a.pending.assign(entries, entries + entryCount);
+		while (!a.pending.empty())
+		{
+			unsigned address = a.pending.back();
+			a.pending.pop_back();
+			followCode(a, address);
+		}
+
+		if (codeAddresses)
+		{
+			codeAddresses->clear();
+			for (unsigned address = programStart; address < a.visited.size(); address++)
+			{
+				if (a.visited[address]) { codeAddresses->push_back((std::uint16_t)address); }
+			}
+		}
+	}
+
+	void findCode(const std::uint8_t *rom, std::size_t size, const std::uint16_t *entries, std::size_t entryCount,
+		std::vector<std::uint16_t> &codeAddresses)
+	{
+		Analyzer a;
+		analyze(a, rom, size, entries, entryCount, &codeAddresses);
+	}
+
+	RomAnalysis analyzeRom(const std::uint8_t *rom, std::size_t size, std::vector<std::uint16_t> *codeAddresses)
+	{
+		Analyzer a;
+		const std::uint16_t entry = programStart;
+		analyze(a, rom, size, &entry, 1, codeAddresses);
+
+		RomAnalysis &r = a.result;
+
+		//only xo-chip has more than 4 KB of memory
+		if (size > (std::size_t)0x1000 - programStart) { r.usesHighMemory = true; }
+
+		//I running past 0xFFF would wrap into the interpreter's memory on the 4 KB machines,
+		//a program does that only when it was written for the 64 KB of xo-chip
+		if (r.indexWraps) { r.usesHighMemory = true; }
+
+		if (r.usesXoChip || r.usesHighMemory) { r.platform = Platform::xoChip; }
+		else if (r.usesSchip) { r.platform = Platform::schip; }
+		else { r.platform = Platform::chip8; }
+
+		r.quirks = defaultQuirks(r.platform);
+		r.instructionsPerFrame = defaultInstructionsPerFrame(r.platform);
+
+		//8X06 and 8X0E are how the programs for schip's shift of VX are written, the original shifts
+		//VY into VX so a program for it shifts from other registers than V0 too. Schip keeps its quirk,
+		//its programs were only ever tried with it.
+		if (r.shiftsOtherRegister && r.platform != Platform::schip) { r.quirks.shiftVx = !r.shiftsFromVy; }
+
+		//schip 1.1 doesn't move I, a program that needs it to was written for the original behaviour
+		if (r.reliesOnIndexIncrement) { r.quirks.memoryIncrement = true; }
+
+		//the program keeps its own pace, it can run a bit faster for smoother animation
+		if (r.pacedByDelayTimer && r.platform == Platform::chip8) { r.instructionsPerFrame = 15; }
+
+		return r;
+	}
+
+}
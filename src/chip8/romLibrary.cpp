@@ -0,0 +1,383 @@
+#include <chip8/romLibrary.h>
+#include <chip8/mappedFile.h>
+#include <chip8/romAnalyzer.h>
+#include <filesystem>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <cctype>
+
+namespace fs = std::filesystem;
+
+namespace chip8
+{
+
+	static const char *indexHeader = "chip8-rom-index 4";
+
+	bool RomLibrary::load(const char *indexPath)
+	{
+		roms.clear();
+		folders.clear();
+		byPath.clear();
+		modified = false;
+
+		std::FILE *file = std::fopen(indexPath, "rb");
+		if (!file) { return false; }
+
+		bool ok = true;
+		char line[4096] = {};
+		if (!std::fgets(line, sizeof(line), file) || std::strncmp(line, indexHeader, std::strlen(indexHeader)) != 0)
+		{
+			ok = false;
+		}
+
+		//"folder path" lines, then one rom per line: hash size time platform quirks ipf path,
+		//the path is last so it can have spaces
+		while (ok && std::fgets(line, sizeof(line), file))
+		{
+			std::size_t length = std::strlen(line);
+			while (length && (line[length - 1] == '\n' || line[length - 1] == '\r')) { line[--length] = 0; }
+			if (!length) { continue; }
+
+			if (std::strncmp(line, "folder ", 7) == 0)
+			{
+				folders.push_back(line + 7);
+				continue;
+			}
+
+			RomInfo info;
+			unsigned long long hash = 0, size = 0;
+			long long modifiedTime = 0;
+			unsigned platform = 0, quirks = 0;
+			int ipf = 0, pathStart = 0;
+			if (std::sscanf(line, "%llx %llu %lld %u %x %d %n", &hash, &size, &modifiedTime,
+				&platform, &quirks, &ipf, &pathStart) != 6 || !line[pathStart] || platform > (unsigned)Platform::xoChip)
+			{
+				ok = false;
+				break;
+			}
+
+			info.hash = hash;
+			info.size = size;
+			info.modifiedTime = modifiedTime;
+			info.platform = (Platform)platform;
+			info.quirks = quirksFromBits(quirks);
+			info.instructionsPerFrame = ipf;
+			info.path = line + pathStart;
+			roms.push_back(std::move(info));
+		}
+
+		std::fclose(file);
+
+		if (!ok)
+		{
+			roms.clear();
+			folders.clear();
+			return false;
+		}
+
+		rebuildLookup();
+		return true;
+	}
+
+	bool RomLibrary::save(const char *indexPath)
+	{
+		std::string temporaryPath = std::string(indexPath) + ".tmp";
+
+		std::FILE *file = std::fopen(temporaryPath.c_str(), "wb");
+		if (!file) { return false; }
+
+		bool ok = std::fprintf(file, "%s\n", indexHeader) > 0;
+		for (const std::string &folder : folders)
+		{
+			if (!ok) { break; }
+			ok = std::fprintf(file, "folder %s\n", folder.c_str()) > 0;
+		}
+		for (const RomInfo &info : roms)
+		{
+			if (!ok) { break; }
+			ok = std::fprintf(file, "%016llx %llu %lld %u %x %d %s\n",
+				(unsigned long long)info.hash, (unsigned long long)info.size, (long long)info.modifiedTime,
+				(unsigned)info.platform, quirksToBits(info.quirks), info.instructionsPerFrame,
+				info.path.c_str()) > 0;
+		}
+
+		ok = (std::fclose(file) == 0) && ok;
+
+		std::error_code error;
+		if (ok) { fs::rename(temporaryPath, indexPath, error); }
+		if (!ok || error)
+		{
+			fs::remove(temporaryPath, error);
+			return false;
+		}
+
+		modified = false;
+		return true;
+	}
+
+	std::string RomLibrary::normalizePath(const char *path)
+	{
+		std::error_code error;
+		fs::path absolute = fs::absolute(fs::u8path(path), error);
+		if (error) { return path; }
+		return absolute.lexically_normal().generic_u8string();
+	}
+
+	bool RomLibrary::isRomFile(const std::string &path)
+	{
+		std::size_t dot = path.find_last_of('.');
+		if (dot == std::string::npos || path.find('/', dot) != std::string::npos) { return false; }
+
+		std::string extension = path.substr(dot + 1);
+		for (char &c : extension) { c = (char)std::tolower((unsigned char)c); }
+
+		return extension == "ch8" || extension == "c8" || extension == "sc8" ||
+			extension == "xo8" || extension == "hc8";
+	}
+
+	static std::int64_t fileTime(const fs::file_time_type &time)
+	{
+		return (std::int64_t)time.time_since_epoch().count();
+	}
+
+	bool RomLibrary::inspect(const std::string &path, std::int64_t modifiedTime, RomInfo &info)
+	{
+		MappedFile file;
+		if (!file.open(path.c_str())) { return false; }
+
+		info.path = path;
+		info.size = file.size;
+		info.modifiedTime = modifiedTime;
+		info.hash = xxHash64(file.data, file.size);
+
+		//the result is kept in the index, so this only runs for new and changed files
+		RomAnalysis analysis = analyzeRom(file.data, file.size);
+		info.platform = analysis.platform;
+		info.quirks = analysis.quirks;
+		info.instructionsPerFrame = analysis.instructionsPerFrame;
+		return true;
+	}
+
+	const RomInfo *RomLibrary::set(const RomInfo &info)
+	{
+		modified = true;
+
+		auto found = byPath.find(info.path);
+		if (found == byPath.end())
+		{
+			byPath[info.path] = roms.size();
+			roms.push_back(info);
+			return &roms.back();
+		}
+
+		RomInfo &old = roms[found->second];
+		if (old.hash == info.hash)
+		{
+			//touched but not changed, keep what the user picked
+			old.size = info.size;
+			old.modifiedTime = info.modifiedTime;
+		}
+		else
+		{
+			old = info;
+		}
+		return &old;
+	}
+
+	bool RomLibrary::remove(const std::string &path)
+	{
+		auto found = byPath.find(path);
+		if (found == byPath.end()) { return false; }
+
+		//the order doesn't matter, move the last one in the hole
+		std::size_t index = found->second;
+		byPath.erase(found);
+		if (index != roms.size() - 1)
+		{
+			roms[index] = std::move(roms.back());
+			byPath[roms[index].path] = index;
+		}
+		roms.pop_back();
+		modified = true;
+		return true;
+	}
+
+	int RomLibrary::removeUnder(const std::string &folder)
+	{
+		auto inFolder = [&](const RomInfo &info) { return info.path.compare(0, folder.size(), folder) == 0; };
+
+		std::size_t count = roms.size();
+		roms.erase(std::remove_if(roms.begin(), roms.end(), inFolder), roms.end());
+
+		int removed = (int)(count - roms.size());
+		if (removed)
+		{
+			modified = true;
+			rebuildLookup();
+		}
+		return removed;
+	}
+
+	bool RomLibrary::isUpToDate(const std::string &path, std::uint64_t size, std::int64_t modifiedTime) const
+	{
+		const RomInfo *info = find(path);
+		return info && info->size == size && info->modifiedTime == modifiedTime;
+	}
+
+	RomInfo *RomLibrary::refresh(const std::string &path, std::uint64_t size, std::int64_t modifiedTime)
+	{
+		auto found = byPath.find(path);
+		if (found != byPath.end())
+		{
+			RomInfo *info = &roms[found->second];
+
+			//the common case, nothing to read
+			if (info->size == size && info->modifiedTime == modifiedTime) { return info; }
+		}
+
+		RomInfo info;
+		if (!inspect(path, modifiedTime, info)) { return nullptr; }
+		return const_cast<RomInfo *>(set(info));
+	}
+
+	bool RomLibrary::statFile(const std::string &path, std::uint64_t &size, std::int64_t &modifiedTime)
+	{
+		std::error_code error;
+		fs::directory_entry entry(fs::u8path(path), error);
+		if (error || !entry.is_regular_file(error)) { return false; }
+
+		size = entry.file_size(error);
+		if (error) { return false; }
+		fs::file_time_type time = entry.last_write_time(error);
+		if (error) { return false; }
+
+		modifiedTime = fileTime(time);
+		return true;
+	}
+
+	const RomInfo *RomLibrary::update(const char *path)
+	{
+		std::string normalized = normalizePath(path);
+
+		std::uint64_t size = 0;
+		std::int64_t modifiedTime = 0;
+		if (!statFile(normalized, size, modifiedTime)) { return nullptr; }
+
+		return refresh(normalized, size, modifiedTime);
+	}
+
+	RomLibrary::ScanStats RomLibrary::scan(const char *directory, bool recursive)
+	{
+		ScanStats stats;
+
+		std::string root = normalizePath(directory);
+		if (!root.empty() && root.back() != '/') { root += '/'; }
+
+		std::vector<bool> seen(roms.size(), false);
+
+		auto visit = [&](const fs::directory_entry &entry)
+		{
+			std::error_code error;
+			if (!entry.is_regular_file(error)) { return; }
+
+			std::string path = entry.path().lexically_normal().generic_u8string();
+			if (!isRomFile(path)) { return; }
+
+			std::uint64_t size = entry.file_size(error);
+			if (error) { return; }
+			fs::file_time_type time = entry.last_write_time(error);
+			if (error) { return; }
+
+			std::size_t count = roms.size();
+			auto found = byPath.find(path);
+			std::uint64_t oldHash = found != byPath.end() ? roms[found->second].hash : 0;
+			std::int64_t oldTime = found != byPath.end() ? roms[found->second].modifiedTime : 0;
+
+			RomInfo *info = refresh(path, size, fileTime(time));
+			if (!info) { return; }
+
+			stats.files++;
+			if (roms.size() != count || info->hash != oldHash || info->modifiedTime != oldTime) { stats.hashed++; }
+
+			std::size_t index = info - roms.data();
+			if (index < seen.size()) { seen[index] = true; }
+		};
+
+		std::error_code error;
+		auto options = fs::directory_options::skip_permission_denied;
+		if (recursive)
+		{
+			for (fs::recursive_directory_iterator it(fs::u8path(root), options, error), end; !error && it != end; it.increment(error))
+			{
+				visit(*it);
+			}
+		}
+		else
+		{
+			for (fs::directory_iterator it(fs::u8path(root), options, error), end; !error && it != end; it.increment(error))
+			{
+				visit(*it);
+			}
+		}
+
+		//the entries under this directory that weren't found are gone,
+		//if the walk didn't finish nothing is dropped
+		if (!error)
+		{
+			std::size_t write = 0;
+			for (std::size_t read = 0; read < roms.size(); read++)
+			{
+				bool inDirectory = roms[read].path.compare(0, root.size(), root) == 0;
+				bool nested = roms[read].path.find('/', root.size()) != std::string::npos;
+				bool gone = read < seen.size() && !seen[read] && inDirectory && (recursive || !nested);
+
+				if (gone)
+				{
+					stats.removed++;
+					continue;
+				}
+
+				if (write != read) { roms[write] = std::move(roms[read]); }
+				write++;
+			}
+			roms.resize(write);
+
+			if (stats.removed)
+			{
+				modified = true;
+				rebuildLookup();
+			}
+		}
+
+		return stats;
+	}
+
+	const RomInfo *RomLibrary::find(const std::string &path) const
+	{
+		auto found = byPath.find(path);
+		if (found == byPath.end()) { return nullptr; }
+		return &roms[found->second];
+	}
+
+	const RomInfo *RomLibrary::findByHash(std::uint64_t hash) const
+	{
+		for (const RomInfo &info : roms)
+		{
+			if (info.hash == hash) { return &info; }
+		}
+		return nullptr;
+	}
+
+	void RomLibrary::rebuildLookup()
+	{
+		byPath.clear();
+		byPath.reserve(roms.size());
+		for (std::size_t i = 0; i < roms.size(); i++)
+		{
+			byPath[roms[i].path] = i;
+		}
+	}
+
+}
@@ -0,0 +1,204 @@
+#include <chip8/romProfiler.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <map>
+
+namespace chip8
+{
+
+	RomProfiler::RomProfiler()
+	{
+		clear();
+
+		//the cheapest of a few back to back reads, what a sample costs without an instruction
+		double overhead = 1e9;
+		for (int i = 0; i < 100; i++)
+		{
+			auto a = std::chrono::steady_clock::now();
+			auto b = std::chrono::steady_clock::now();
+			overhead = std::min(overhead, std::chrono::duration<double, std::nano>(b - a).count());
+		}
+		clockOverhead = overhead;
+	}
+
+	void RomProfiler::clear()
+	{
+		addresses.assign(memorySize, Counter{});
+		opcodes.assign(0x10000, Counter{});
+		nodes.clear();
+		depth = 0;
+		started = false;
+		instructions = 0;
+		sampling = false;
+		countdown = 1;
+		sampleWeight = 1;
+	}
+
+	double RomProfiler::endSample()
+	{
+		auto now = std::chrono::steady_clock::now();
+		sampling = false;
+		double measured = std::chrono::duration<double, std::nano>(now - sampleStart).count() - clockOverhead;
+		double estimate = std::max(measured, 0.0) * sampleWeight;
+
+		//a random interval so a loop can't always be sampled at the same instruction
+		rng ^= rng << 13;
+		rng ^= rng >> 17;
+		rng ^= rng << 5;
+		countdown = 1 + rng % (std::uint32_t)std::max(1, sampleInterval * 2 - 1);
+		sampleWeight = countdown;
+
+		return estimate;
+	}
+
+	void RomProfiler::start(const State &state, std::uint16_t pc, std::uint16_t opcode)
+	{
+		started = true;
+		nodes.assign(1, Node{});
+		nodes[0].address = pc;
+
+		//the depth before the first instruction, so a first call or return is followed,
+		//started in a subroutine what is above it counts in the root
+		int sp = state.sp;
+		if ((opcode & 0xF000) == 0x2000 && sp) { sp--; }
+		if (opcode == 0x00EE) { sp++; }
+		depth = std::min(sp, stackSize);
+		std::fill(nodeStack, nodeStack + depth + 1, 0);
+	}
+
+	void RomProfiler::followStack(const State &state)
+	{
+		const int sp = std::min<int>(state.sp, stackSize);
+		if (depth > sp) { depth = sp; }
+
+		//2NNN pushes one at a time, the new PC is the subroutine
+		while (depth < sp)
+		{
+			const std::int32_t parent = nodeStack[depth];
+			std::int32_t child = parent;
+			for (std::int32_t c : nodes[parent].children)
+			{
+				if (nodes[c].address == state.pc) { child = c; break; }
+			}
+			if (child == parent && nodes.size() < maxNodes)
+			{
+				child = (std::int32_t)nodes.size();
+				Node node;
+				node.address = state.pc;
+				node.parent = parent;
+				nodes.push_back(node);
+				nodes[parent].children.push_back(child);
+			}
+
+			nodes[child].calls++;
+			nodeStack[++depth] = child;
+		}
+	}
+
+	std::uint16_t RomProfiler::opcodeKind(std::uint16_t opcode)
+	{
+		switch (opcode >> 12)
+		{
+		case 0x0:
+			if ((opcode & 0xFFF0) == 0x00C0 || (opcode & 0xFFF0) == 0x00D0) { return opcode & 0xFFF0; }
+			if (opcode == 0x00E0 || opcode == 0x00EE || (opcode >= 0x00FB && opcode <= 0x00FF)) { return opcode; }
+			return 0x0000;
+		case 0x5: case 0x8: case 0x9: return opcode & 0xF00F;
+		case 0xE: case 0xF: return opcode == 0xF000 || opcode == 0xF002 ? opcode : opcode & 0xF0FF;
+		default: return opcode & 0xF000;
+		}
+	}
+
+	void RomProfiler::opcodeKindName(std::uint16_t kind, char *out)
+	{
+		const int group = kind >> 12;
+		switch (group)
+		{
+		case 0x0:
+			if (kind == 0x0000) { std::snprintf(out, 5, "0NNN"); }
+			else if (kind == 0x00C0 || kind == 0x00D0) { std::snprintf(out, 5, "00%XN", (kind >> 4) & 0xF); }
+			else { std::snprintf(out, 5, "%04X", kind); }
+			break;
+		case 0x1: case 0x2: case 0xA: case 0xB: std::snprintf(out, 5, "%XNNN", group); break;
+		case 0x5: case 0x8: case 0x9: std::snprintf(out, 5, "%XXY%X", group, kind & 0xF); break;
+		case 0xD: std::snprintf(out, 5, "DXYN"); break;
+		case 0xE: case 0xF:
+			if (kind == 0xF000 || kind == 0xF002) { std::snprintf(out, 5, "%04X", kind); }
+			else { std::snprintf(out, 5, "%XX%02X", group, kind & 0xFF); }
+			break;
+		default: std::snprintf(out, 5, "%XXNN", group); break;
+		}
+	}
+
+	static void add(RomProfiler::Counter &to, const RomProfiler::Counter &counter)
+	{
+		to.instructions += counter.instructions;
+		to.nanoseconds += counter.nanoseconds;
+	}
+
+	std::vector<RomProfiler::Function> RomProfiler::functions() const
+	{
+		std::vector<Function> result;
+		if (nodes.empty()) { return result; }
+
+		//the parents come before their children, one pass from the end sums the subtrees
+		std::vector<Counter> subtree(nodes.size());
+		for (std::size_t n = nodes.size(); n-- > 0;)
+		{
+			add(subtree[n], nodes[n].self);
+			if (n) { add(subtree[nodes[n].parent], subtree[n]); }
+		}
+
+		Function root;
+		root.address = nodes[0].address;
+		root.root = true;
+		std::map<std::uint16_t, Function> subroutines;
+
+		for (std::size_t n = 0; n < nodes.size(); n++)
+		{
+			const Node &node = nodes[n];
+			Function *function = &root;
+			if (n)
+			{
+				function = &subroutines[node.address];
+				function->address = node.address;
+			}
+			function->calls += node.calls;
+			add(function->self, node.self);
+
+			//a recursive call is already in the total of the outer one
+			bool nested = false;
+			for (std::int32_t p = node.parent; p > 0 && !nested; p = nodes[p].parent) { nested = nodes[p].address == node.address; }
+			if (!nested) { add(function->total, subtree[n]); }
+		}
+
+		result.push_back(root);
+		for (auto &subroutine : subroutines) { result.push_back(subroutine.second); }
+		return result;
+	}
+
+	bool RomProfiler::saveCollapsedStacks(const char *path, bool nanoseconds) const
+	{
+		std::FILE *file = std::fopen(path, "wb");
+		if (!file) { return false; }
+
+		std::int32_t stack[stackSize + 2];
+		for (std::size_t n = 0; n < nodes.size(); n++)
+		{
+			const Node &node = nodes[n];
+			const double value = nanoseconds ? std::round(node.self.nanoseconds) : (double)node.self.instructions;
+			if (value <= 0) { continue; }
+
+			int count = 0;
+			for (std::int32_t p = (std::int32_t)n; p > 0; p = nodes[p].parent) { stack[count++] = p; }
+
+			std::fprintf(file, "main");
+			while (count--) { std::fprintf(file, nodes[stack[count]].address > 0xFFF ? ";sub_%04X" : ";sub_%03X", nodes[stack[count]].address); }
+			std::fprintf(file, " %.0f\n", value);
+		}
+
+		return std::fclose(file) == 0;
+	}
+
+}
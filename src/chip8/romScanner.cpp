@@ -0,0 +1,347 @@
+#include <chip8/romScanner.h>
+#include <filesystem>
+#include <algorithm>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace chip8
+{
+
+	void RomScanner::start(const RomLibrary &library, const std::vector<std::string> &folders,
+		bool watch, int threadCount)
+	{
+		stop();
+
+		known.clear();
+		known.reserve(library.roms.size());
+		for (const RomInfo &info : library.roms)
+		{
+			known[info.path] = {info.size, info.modifiedTime};
+		}
+
+		filesFound = 0;
+		filesHashed = 0;
+		stopping = false;
+		walking = true;
+
+		if (threadCount <= 0) { threadCount = std::max(1, (int)std::thread::hardware_concurrency()); }
+
+		for (int i = 0; i < threadCount; i++)
+		{
+			workers.emplace_back(&RomScanner::workerMain, this);
+		}
+
+		walker = std::thread(&RomScanner::walkerMain, this, folders, watch);
+	}
+
+	void RomScanner::stop()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		jobAvailable.notify_all();
+
+		if (walker.joinable()) { walker.join(); }
+		for (std::thread &worker : workers) { worker.join(); }
+		workers.clear();
+
+		jobs.clear();
+		results.clear();
+		pendingJobs = 0;
+		walking = false;
+		watchingFolders = false;
+	}
+
+	int RomScanner::poll(RomLibrary &library)
+	{
+		std::vector<Result> ready;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			ready.swap(results);
+		}
+
+		int changed = 0;
+		for (const Result &result : ready)
+		{
+			switch (result.type)
+			{
+			case Result::updated: library.set(result.info); changed++; break;
+			case Result::removed: changed += library.remove(result.info.path); break;
+			case Result::removedFolder: changed += library.removeUnder(result.info.path); break;
+			}
+		}
+
+		return changed;
+	}
+
+	void RomScanner::pushResult(Result result)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		results.push_back(std::move(result));
+	}
+
+	void RomScanner::pushRemoval(const std::string &path, bool folder)
+	{
+		if (folder)
+		{
+			for (auto it = known.begin(); it != known.end();)
+			{
+				if (it->first.compare(0, path.size(), path) == 0) { it = known.erase(it); }
+				else { ++it; }
+			}
+		}
+		else { known.erase(path); }
+
+		Result result;
+		result.type = folder ? Result::removedFolder : Result::removed;
+		result.info.path = path;
+		pushResult(std::move(result));
+	}
+
+	void RomScanner::removeUnseen(const std::unordered_set<std::string> &seen, const std::vector<std::string> &completeFolders)
+	{
+		std::vector<std::string> gone;
+		for (const auto &file : known)
+		{
+			if (seen.count(file.first)) { continue; }
+
+			for (const std::string &folder : completeFolders)
+			{
+				if (file.first.compare(0, folder.size(), folder) == 0)
+				{
+					gone.push_back(file.first);
+					break;
+				}
+			}
+		}
+
+		for (const std::string &path : gone) { pushRemoval(path, false); }
+	}
+
+	void RomScanner::queueFile(const std::string &path, bool force)
+	{
+		std::uint64_t size = 0;
+		std::int64_t modifiedTime = 0;
+		if (!RomLibrary::statFile(path, size, modifiedTime)) { return; }
+
+		filesFound++;
+
+		if (!force)
+		{
+			auto found = known.find(path);
+			if (found != known.end() && found->second.size == size && found->second.modifiedTime == modifiedTime)
+			{
+				return;
+			}
+		}
+
+		//what the library will have once the result is applied
+		known[path] = {size, modifiedTime};
+
+		pendingJobs++;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			jobs.push_back({path, modifiedTime});
+		}
+		jobAvailable.notify_one();
+	}
+
+	void RomScanner::workerMain()
+	{
+		while (true)
+		{
+			Job job;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				jobAvailable.wait(lock, [&]() { return stopping || !jobs.empty(); });
+				if (stopping) { return; }
+
+				job = std::move(jobs.front());
+				jobs.pop_front();
+			}
+
+			Result result;
+			if (RomLibrary::inspect(job.path, job.modifiedTime, result.info))
+			{
+				pushResult(std::move(result));
+			}
+
+			filesHashed++;
+			pendingJobs--;
+		}
+	}
+
+	bool RomScanner::walk(const std::string &folder, std::unordered_set<std::string> &seen,
+		std::vector<std::string> &directories)
+	{
+		directories.push_back(folder);
+
+		std::error_code error;
+		fs::recursive_directory_iterator it(fs::u8path(folder), fs::directory_options::skip_permission_denied, error);
+		for (fs::recursive_directory_iterator end; !error && it != end && !stopping; it.increment(error))
+		{
+			std::error_code typeError;
+			const fs::directory_entry &entry = *it;
+
+			if (entry.is_directory(typeError))
+			{
+				directories.push_back(entry.path().lexically_normal().generic_u8string() + '/');
+			}
+			else if (entry.is_regular_file(typeError))
+			{
+				std::string path = entry.path().lexically_normal().generic_u8string();
+				if (!RomLibrary::isRomFile(path)) { continue; }
+
+				queueFile(path, false);
+				seen.insert(std::move(path));
+			}
+		}
+
+		return !error && !stopping;
+	}
+
+	void RomScanner::walkerMain(std::vector<std::string> folders, bool watch)
+	{
+		for (std::string &folder : folders)
+		{
+			folder = RomLibrary::normalizePath(folder.c_str());
+			if (folder.empty() || folder.back() != '/') { folder += '/'; }
+		}
+
+		std::unordered_set<std::string> seen;
+		std::vector<std::string> directories;
+		std::vector<std::string> completeFolders;
+
+		for (const std::string &folder : folders)
+		{
+			if (walk(folder, seen, directories)) { completeFolders.push_back(folder); }
+		}
+		removeUnseen(seen, completeFolders);
+
+		walking = false;
+
+	#ifdef __linux__
+		if (!watch || stopping) { return; }
+
+		int notify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (notify < 0) { return; }
+
+		//watch descriptor -> folder, with the trailing '/'
+		std::unordered_map<int, std::string> watches;
+		const std::uint32_t watchMask = IN_CREATE | IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM |
+			IN_DELETE | IN_ONLYDIR;
+
+		auto addWatches = [&]()
+		{
+			for (const std::string &directory : directories)
+			{
+				int descriptor = inotify_add_watch(notify, directory.c_str(), watchMask);
+				if (descriptor >= 0) { watches[descriptor] = directory; }
+			}
+			directories.clear();
+		};
+
+		addWatches();
+		watchingFolders = true;
+
+		alignas(inotify_event) char buffer[16 * 1024];
+		pollfd descriptor = {notify, POLLIN, 0};
+		while (!stopping)
+		{
+			//the timeout is how fast stop is noticed
+			if (::poll(&descriptor, 1, 100) <= 0) { continue; }
+
+			ssize_t length = read(notify, buffer, sizeof(buffer));
+			if (length <= 0) { continue; }
+
+			bool overflow = false;
+			for (char *p = buffer; p < buffer + length;)
+			{
+				const inotify_event *event = (const inotify_event *)p;
+				p += sizeof(inotify_event) + event->len;
+
+				if (event->mask & IN_Q_OVERFLOW) { overflow = true; continue; }
+
+				auto found = watches.find(event->wd);
+				if (found == watches.end()) { continue; }
+
+				if (event->mask & IN_IGNORED)
+				{
+					watches.erase(found);
+					continue;
+				}
+
+				if (!event->len) { continue; }
+				std::string path = found->second + event->name;
+
+				if (event->mask & IN_ISDIR)
+				{
+					if (event->mask & (IN_CREATE | IN_MOVED_TO))
+					{
+						walk(path + '/', seen, directories);
+					}
+					else if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+					{
+						path += '/';
+
+						//a move sends no IN_IGNORED, the watches under it would report the old paths
+						if (event->mask & IN_MOVED_FROM)
+						{
+							for (auto it = watches.begin(); it != watches.end();)
+							{
+								if (it->second.compare(0, path.size(), path) == 0)
+								{
+									inotify_rm_watch(notify, it->first);
+									it = watches.erase(it);
+								}
+								else { ++it; }
+							}
+						}
+
+						pushRemoval(path, true);
+					}
+				}
+				else if (RomLibrary::isRomFile(path))
+				{
+					if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+					{
+						queueFile(path, true);
+					}
+					else if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+					{
+						pushRemoval(path, false);
+					}
+				}
+			}
+
+			//events were lost, walk everything again, unchanged files are still skipped
+			//and what isn't there anymore is removed like after the first walk
+			if (overflow)
+			{
+				seen.clear();
+				completeFolders.clear();
+				for (const std::string &folder : folders)
+				{
+					if (walk(folder, seen, directories)) { completeFolders.push_back(folder); }
+				}
+				removeUnseen(seen, completeFolders);
+			}
+
+			addWatches();
+		}
+
+		close(notify);
+		watchingFolders = false;
+	#else
+		(void)watch;
+	#endif
+	}
+
+}
@@ -0,0 +1,47 @@
+#include <chip8/trace.h>
+#include <chip8/mappedFile.h>
+#include <cstring>
+
+namespace chip8
+{
+
+	static const char traceMagic[8] = {'C', '8', 'T', 'R', 'A', 'C', 'E', '1'};
+	constexpr std::size_t traceHeaderSize = 32;
+
+	Trace::Trace(int capacityLog2)
+	{
+		std::size_t capacity = (std::size_t)1 << capacityLog2;
+		entries = std::make_unique<TraceEntry[]>(capacity);
+		mask = capacity - 1;
+	}
+
+	static void putInt(std::uint8_t *out, std::uint64_t value, int bytes)
+	{
+		for (int b = 0; b < bytes; b++) { out[b] = (std::uint8_t)(value >> (b * 8)); }
+	}
+
+	bool Trace::save(const char *path) const
+	{
+		const std::size_t count = size();
+
+		MappedFile file;
+		std::uint8_t *out = file.create(path, traceHeaderSize + count * sizeof(TraceEntry));
+		if (!out) { return false; }
+
+		std::memcpy(out, traceMagic, sizeof(traceMagic));
+		putInt(out + 8, sizeof(TraceEntry), 4);
+		putInt(out + 12, 0, 4);
+		putInt(out + 16, count, 8);
+		putInt(out + 24, first(), 8);
+
+		//the ring wraps at most once, two copies in order
+		std::uint8_t *data = out + traceHeaderSize;
+		const std::size_t start = (std::size_t)(first() & mask);
+		const std::size_t tail = count < capacity() - start ? count : capacity() - start;
+		std::memcpy(data, &entries[start], tail * sizeof(TraceEntry));
+		std::memcpy(data + tail * sizeof(TraceEntry), &entries[0], (count - tail) * sizeof(TraceEntry));
+
+		return true;
+	}
+
+}
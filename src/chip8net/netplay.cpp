@@ -0,0 +1,276 @@
+#include <chip8net/netplay.h>
+#include <chip8net/packet.h>
+#include <chip8/hash.h>
+#include <enet/enet.h>
+#include <algorithm>
+
+namespace chip8
+{
+
+	//the packets, little endian
+	enum PacketType : std::uint8_t
+	{
+		settingsPacket = 'S', //host to guest, reliable: rom hash, platform, quirks, instructions per frame, timing, seed
+		inputPacket = 'I', //both ways, unreliable: ack, confirmed frame and hash, first frame, count, the keys
+	};
+
+	enum Channel : std::uint8_t
+	{
+		inputChannel,
+		settingsChannel,
+		channelCount,
+	};
+
+	constexpr std::uint32_t noHashFrame = 0xFFFFFFFF;
+
+	bool Netplay::host(Chip8 &emulator, const std::uint8_t *rom, std::size_t romSize, std::uint16_t port)
+	{
+		close();
+		if (enet_initialize() != 0)
+		{
+			status = failed;
+			error = "Can't start ENet";
+			return false;
+		}
+
+		ENetAddress address = {};
+		address.host = ENET_HOST_ANY;
+		address.port = port;
+		enetHost = enet_host_create(&address, 1, channelCount, 0, 0);
+		if (!enetHost)
+		{
+			enet_deinitialize();
+			status = failed;
+			error = "Can't listen on port " + std::to_string(port);
+			return false;
+		}
+
+		hosting = true;
+		this->emulator = &emulator;
+		this->rom.assign(rom, rom + romSize);
+		romHash = xxHash64(rom, romSize);
+		status = connecting;
+		return true;
+	}
+
+	bool Netplay::join(Chip8 &emulator, const std::uint8_t *rom, std::size_t romSize, const char *address, std::uint16_t port)
+	{
+		close();
+		if (enet_initialize() != 0)
+		{
+			status = failed;
+			error = "Can't start ENet";
+			return false;
+		}
+
+		ENetAddress hostAddress = {};
+		enetHost = enet_host_create(nullptr, 1, channelCount, 0, 0);
+		if (!enetHost || enet_address_set_host(&hostAddress, address) != 0)
+		{
+			close();
+			status = failed;
+			error = std::string("Can't connect to ") + address;
+			return false;
+		}
+		hostAddress.port = port;
+
+		peer = enet_host_connect(enetHost, &hostAddress, channelCount, 0);
+		if (!peer)
+		{
+			close();
+			status = failed;
+			error = std::string("Can't connect to ") + address;
+			return false;
+		}
+
+		hosting = false;
+		this->emulator = &emulator;
+		this->rom.assign(rom, rom + romSize);
+		romHash = xxHash64(rom, romSize);
+		status = connecting;
+		return true;
+	}
+
+	void Netplay::close()
+	{
+		if (!enetHost) { return; }
+
+		if (peer)
+		{
+			enet_peer_disconnect_now(peer, 0);
+			peer = nullptr;
+		}
+		enet_host_destroy(enetHost);
+		enetHost = nullptr;
+		enet_deinitialize();
+
+		if (status == playing || status == connecting) { status = disconnected; }
+	}
+
+	std::uint16_t Netplay::port() const
+	{
+		if (!enetHost) { return 0; }
+
+		ENetAddress address = {};
+		if (enet_socket_get_address(enetHost->socket, &address) != 0) { return 0; }
+		return address.port;
+	}
+
+	//both sides start from a fresh reset with the settings of the host
+	void Netplay::start()
+	{
+		int instructionsPerFrame = emulator->instructionsPerFrame;
+		Timing timing = emulator->timing;
+		CompiledRunner compiled = emulator->compiled;
+
+		emulator->reset(emulator->platform, emulator->quirks, emulator->seed);
+		emulator->instructionsPerFrame = instructionsPerFrame;
+		emulator->timing = timing;
+		emulator->compiled = compiled;
+		emulator->loadRom(rom.data(), rom.size());
+		rollback.start(*emulator);
+		remoteAck = 0;
+		status = playing;
+	}
+
+	void Netplay::sendSettings()
+	{
+		std::vector<std::uint8_t> out;
+		writeInt(out, settingsPacket, 1);
+		writeInt(out, romHash, 8);
+		writeInt(out, (std::uint8_t)emulator->platform, 1);
+		writeInt(out, quirksToBits(emulator->quirks), 4);
+		writeInt(out, (std::uint32_t)emulator->instructionsPerFrame, 4);
+		writeInt(out, (std::uint8_t)emulator->timing, 1);
+		writeInt(out, emulator->seed, 4);
+
+		enet_peer_send(peer, settingsChannel, enet_packet_create(out.data(), out.size(), ENET_PACKET_FLAG_RELIABLE));
+	}
+
+	void Netplay::sendInput()
+	{
+		//the other side can't be more than 2 * maxFrames behind, see Rollback::inputFrames
+		std::uint32_t frame = rollback.frame;
+		std::uint32_t first = std::max(remoteAck, frame > 2 * Rollback::maxFrames ? frame - 2 * Rollback::maxFrames : 0);
+
+		std::uint32_t hashFrame = noHashFrame;
+		std::uint64_t hash = 0;
+		if (!rollback.confirmedHash(hashFrame, hash)) { hashFrame = noHashFrame; }
+
+		std::vector<std::uint8_t> out;
+		writeInt(out, inputPacket, 1);
+		writeInt(out, rollback.confirmedFrames, 4);
+		writeInt(out, hashFrame, 4);
+		writeInt(out, hash, 8);
+		writeInt(out, first, 4);
+		writeInt(out, frame - first, 1);
+		for (std::uint32_t f = first; f < frame; f++) { writeInt(out, rollback.localKeys(f), 2); }
+
+		enet_peer_send(peer, inputChannel, enet_packet_create(out.data(), out.size(), 0));
+		enet_host_flush(enetHost);
+	}
+
+	void Netplay::receive(const std::uint8_t *data, std::size_t size)
+	{
+		PacketReader reader(data, size);
+
+		std::uint8_t type = (std::uint8_t)reader.readInt(1);
+
+		if (type == settingsPacket && !hosting && status == connecting)
+		{
+			std::uint64_t hostRomHash = reader.readInt(8);
+			std::uint8_t platform = (std::uint8_t)reader.readInt(1);
+			Quirks quirks = quirksFromBits((std::uint32_t)reader.readInt(4));
+			int instructionsPerFrame = (int)reader.readInt(4);
+			std::uint8_t timing = (std::uint8_t)reader.readInt(1);
+			std::uint32_t seed = (std::uint32_t)reader.readInt(4);
+
+			if (!reader.ok || platform > (std::uint8_t)Platform::xoChip || timing > (std::uint8_t)Timing::cosmacVip)
+			{
+				status = failed;
+				error = "The host sent broken settings";
+				return;
+			}
+			if (hostRomHash != romHash)
+			{
+				status = failed;
+				error = "The host plays another rom";
+				return;
+			}
+
+			emulator->reset((Platform)platform, quirks, seed);
+			emulator->instructionsPerFrame = instructionsPerFrame;
+			emulator->timing = (Timing)timing;
+			start();
+		}
+		else if (type == inputPacket && status == playing)
+		{
+			std::uint32_t ack = (std::uint32_t)reader.readInt(4);
+			std::uint32_t hashFrame = (std::uint32_t)reader.readInt(4);
+			std::uint64_t hash = reader.readInt(8);
+			std::uint32_t first = (std::uint32_t)reader.readInt(4);
+			int count = (int)reader.readInt(1);
+			if (!reader.ok) { return; }
+
+			remoteAck = std::max(remoteAck, std::min(ack, rollback.frame));
+
+			for (int k = 0; k < count; k++)
+			{
+				std::uint16_t keys = (std::uint16_t)reader.readInt(2);
+				if (!reader.ok) { break; }
+				rollback.addRemoteInput(first + k, keys);
+			}
+
+			if (hashFrame != noHashFrame) { rollback.checkRemoteHash(hashFrame, hash); }
+		}
+	}
+
+	void Netplay::poll()
+	{
+		if (!enetHost) { return; }
+
+		ENetEvent event;
+		while (enetHost && enet_host_service(enetHost, &event, 0) > 0)
+		{
+			switch (event.type)
+			{
+			case ENET_EVENT_TYPE_CONNECT:
+				if (hosting && !peer)
+				{
+					peer = event.peer;
+					start();
+					sendSettings();
+				}
+				break;
+
+			case ENET_EVENT_TYPE_RECEIVE:
+				receive(event.packet->data, event.packet->dataLength);
+				enet_packet_destroy(event.packet);
+				break;
+
+			case ENET_EVENT_TYPE_DISCONNECT:
+				if (event.peer == peer)
+				{
+					peer = nullptr;
+					if (status != failed) { status = disconnected; }
+				}
+				break;
+
+			default:
+				break;
+			}
+		}
+	}
+
+	bool Netplay::advance(std::uint16_t localKeys)
+	{
+		if (status != playing || !peer) { return false; }
+
+		bool ran = rollback.advance(localKeys);
+
+		//sent even when stalled, the other side might be waiting for the ack
+		sendInput();
+		return ran;
+	}
+
+}
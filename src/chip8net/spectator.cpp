@@ -0,0 +1,422 @@
+#include <chip8net/spectator.h>
+#include <chip8net/packet.h>
+#include <chip8/delta.h>
+#include <enet/enet.h>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+namespace chip8
+{
+
+	//all on one reliable channel so they arrive in the order they were sent
+	enum SpectatorPacket : std::uint8_t
+	{
+		spectatorSettings = 'S', //platform, quirks, instructions per frame, timing, seed, the next frame
+		spectatorFrame = 'F', //frame, keys
+		spectatorFullDisplay = 'D', //frame, hires, delta against an empty display
+		spectatorDisplayDelta = 'd', //frame, hires, delta against the display of the frame before
+		spectatorKeyframe = 'K', //the next frame, the size of the state, delta against zeros
+		spectatorHash = 'H', //frame, the state hash after it
+		spectatorResync = 'R', //spectator to broadcaster: the state didn't match, send a keyframe
+	};
+
+	//the keyframes are the bytes of the state, the spectators have to use the same build of the core
+	static_assert(std::is_trivially_copyable_v<State>, "the keyframes copy the state as bytes");
+
+	bool Broadcaster::start(const Chip8 &emulator, std::uint16_t port, int maxSpectators)
+	{
+		close();
+		if (enet_initialize() != 0) { return false; }
+
+		ENetAddress address = {};
+		address.host = ENET_HOST_ANY;
+		address.port = port;
+		enetHost = enet_host_create(&address, (std::size_t)maxSpectators, 1, 0, 0);
+		if (!enetHost)
+		{
+			enet_deinitialize();
+			return false;
+		}
+
+		this->emulator = &emulator;
+		previousDisplay = emulator.state.display;
+		stats = {};
+		return true;
+	}
+
+	void Broadcaster::close()
+	{
+		if (!enetHost) { return; }
+
+		for (std::size_t p = 0; p < enetHost->peerCount; p++)
+		{
+			ENetPeer *peer = &enetHost->peers[p];
+			delete (Viewer *)peer->data;
+			peer->data = nullptr;
+			if (peer->state != ENET_PEER_STATE_DISCONNECTED) { enet_peer_disconnect_now(peer, 0); }
+		}
+
+		enet_host_destroy(enetHost);
+		enetHost = nullptr;
+		enet_deinitialize();
+		stats.spectators = 0;
+	}
+
+	std::uint16_t Broadcaster::port() const
+	{
+		if (!enetHost) { return 0; }
+
+		ENetAddress address = {};
+		if (enet_socket_get_address(enetHost->socket, &address) != 0) { return 0; }
+		return address.port;
+	}
+
+	void Broadcaster::sendSettings(ENetPeer *peer)
+	{
+		message.clear();
+		writeInt(message, spectatorSettings, 1);
+		writeInt(message, (std::uint8_t)emulator->platform, 1);
+		writeInt(message, quirksToBits(emulator->quirks), 4);
+		writeInt(message, (std::uint32_t)emulator->instructionsPerFrame, 4);
+		writeInt(message, (std::uint8_t)emulator->timing, 1);
+		writeInt(message, emulator->seed, 4);
+		writeInt(message, stats.frames, 4);
+
+		enet_peer_send(peer, 0, enet_packet_create(message.data(), message.size(), ENET_PACKET_FLAG_RELIABLE));
+		stats.sentBytes += message.size();
+
+		//the display of the last frame right away, the deltas of the next frames are against it
+		message.clear();
+		writeInt(message, spectatorFullDisplay, 1);
+		writeInt(message, stats.frames - 1, 4);
+		writeInt(message, previousDisplay.hires, 1);
+		encodeDelta(nullptr, &previousDisplay.planes[0][0][0], sizeof(previousDisplay.planes), message);
+
+		enet_peer_send(peer, 0, enet_packet_create(message.data(), message.size(), ENET_PACKET_FLAG_RELIABLE));
+		stats.sentBytes += message.size();
+		stats.deltaBytes += message.size();
+		((Viewer *)peer->data)->hasDisplay = true;
+	}
+
+	//one packet for all the spectators it goes to, enet counts the references
+	void Broadcaster::send(const std::vector<std::uint8_t> &data, bool (*to)(const Viewer &viewer), std::uint64_t *counter)
+	{
+		ENetPacket *packet = nullptr;
+		for (std::size_t p = 0; p < enetHost->peerCount; p++)
+		{
+			ENetPeer *peer = &enetHost->peers[p];
+			if (peer->state != ENET_PEER_STATE_CONNECTED || !peer->data || !to(*(Viewer *)peer->data)) { continue; }
+
+			if (!packet) { packet = enet_packet_create(data.data(), data.size(), ENET_PACKET_FLAG_RELIABLE); }
+			if (enet_peer_send(peer, 0, packet) == 0)
+			{
+				stats.sentBytes += data.size();
+				if (counter) { *counter += data.size(); }
+			}
+		}
+
+		if (packet && packet->referenceCount == 0) { enet_packet_destroy(packet); }
+	}
+
+	void Broadcaster::poll()
+	{
+		if (!enetHost) { return; }
+
+		ENetEvent event;
+		while (enet_host_service(enetHost, &event, 0) > 0)
+		{
+			switch (event.type)
+			{
+			case ENET_EVENT_TYPE_CONNECT:
+				event.peer->data = new Viewer;
+				stats.spectators++;
+				sendSettings(event.peer);
+				break;
+
+			case ENET_EVENT_TYPE_RECEIVE:
+				if (event.packet->dataLength && event.packet->data[0] == spectatorResync && event.peer->data)
+				{
+					*(Viewer *)event.peer->data = {};
+				}
+				enet_packet_destroy(event.packet);
+				break;
+
+			case ENET_EVENT_TYPE_DISCONNECT:
+				if (event.peer->data)
+				{
+					delete (Viewer *)event.peer->data;
+					event.peer->data = nullptr;
+					stats.spectators--;
+				}
+				break;
+
+			default:
+				break;
+			}
+		}
+	}
+
+	void Broadcaster::endFrame(std::uint16_t keys)
+	{
+		if (!enetHost) { return; }
+
+		std::uint32_t frame = (std::uint32_t)stats.frames;
+		const State &state = emulator->state;
+
+		//the keys for the spectators that run the core
+		message.clear();
+		writeInt(message, spectatorFrame, 1);
+		writeInt(message, frame, 4);
+		writeInt(message, keys, 2);
+		send(message, [](const Viewer &viewer) { return viewer.synced; }, nullptr);
+
+		//the display for the ones that don't yet, nothing when it didn't change
+		bool displayChanged = std::memcmp(&previousDisplay, &state.display, sizeof(Display)) != 0;
+		for (int full = 0; full < 2; full++)
+		{
+			if (!full && !displayChanged) { continue; }
+
+			message.clear();
+			writeInt(message, full ? spectatorFullDisplay : spectatorDisplayDelta, 1);
+			writeInt(message, frame, 4);
+			writeInt(message, state.display.hires, 1);
+			encodeDelta(full ? nullptr : &previousDisplay.planes[0][0][0], &state.display.planes[0][0][0],
+				sizeof(state.display.planes), message);
+
+			if (full) { send(message, [](const Viewer &viewer) { return !viewer.synced && !viewer.hasDisplay; }, &stats.deltaBytes); }
+			else { send(message, [](const Viewer &viewer) { return !viewer.synced && viewer.hasDisplay; }, &stats.deltaBytes); }
+		}
+		previousDisplay = state.display;
+
+		for (std::size_t p = 0; p < enetHost->peerCount; p++)
+		{
+			Viewer *viewer = (Viewer *)enetHost->peers[p].data;
+			if (viewer && enetHost->peers[p].state == ENET_PEER_STATE_CONNECTED) { viewer->hasDisplay = true; }
+		}
+
+		stats.frames++;
+		if (stats.frames % keyframeInterval == 0)
+		{
+			message.clear();
+			writeInt(message, spectatorHash, 1);
+			writeInt(message, frame, 4);
+			writeInt(message, hashState(state), 8);
+			send(message, [](const Viewer &viewer) { return viewer.synced; }, nullptr);
+
+			message.clear();
+			writeInt(message, spectatorKeyframe, 1);
+			writeInt(message, stats.frames, 4);
+			writeInt(message, sizeof(State), 4);
+			encodeDelta(nullptr, (const std::uint8_t *)&state, sizeof(State), message);
+			send(message, [](const Viewer &viewer) { return !viewer.synced; }, &stats.keyframeBytes);
+
+			for (std::size_t p = 0; p < enetHost->peerCount; p++)
+			{
+				Viewer *viewer = (Viewer *)enetHost->peers[p].data;
+				if (viewer && enetHost->peers[p].state == ENET_PEER_STATE_CONNECTED) { viewer->synced = true; }
+			}
+		}
+
+		enet_host_flush(enetHost);
+	}
+
+	bool Spectator::join(const char *address, std::uint16_t port)
+	{
+		close();
+		if (enet_initialize() != 0)
+		{
+			status = failed;
+			return false;
+		}
+
+		ENetAddress hostAddress = {};
+		enetHost = enet_host_create(nullptr, 1, 1, 0, 0);
+		if (!enetHost || enet_address_set_host(&hostAddress, address) != 0)
+		{
+			close();
+			status = failed;
+			return false;
+		}
+		hostAddress.port = port;
+
+		peer = enet_host_connect(enetHost, &hostAddress, 1, 0);
+		if (!peer)
+		{
+			close();
+			status = failed;
+			return false;
+		}
+
+		status = connecting;
+		frame = 0;
+		desyncFrame = -1;
+		resyncs = 0;
+		receivedBytes = 0;
+		deltaDisplay = {};
+		deltaDirtyRows = ~0ull;
+		waitingForFullDisplay = true;
+		return true;
+	}
+
+	void Spectator::close()
+	{
+		if (!enetHost) { return; }
+
+		if (peer)
+		{
+			enet_peer_disconnect_now(peer, 0);
+			peer = nullptr;
+		}
+		enet_host_destroy(enetHost);
+		enetHost = nullptr;
+		enet_deinitialize();
+
+		if (status != failed) { status = disconnected; }
+	}
+
+	std::uint64_t Spectator::takeDirtyRows()
+	{
+		if (status == synced) { return emulator->takeDirtyRows(); }
+
+		std::uint64_t rows = deltaDirtyRows;
+		deltaDirtyRows = 0;
+		return rows;
+	}
+
+	//the core went wrong, back to the display until the next keyframe
+	void Spectator::requestKeyframe()
+	{
+		status = watchingDisplay;
+		deltaDirtyRows = ~0ull;
+		resyncs++;
+
+		//a keyframe sent before the broadcaster got this would be followed by nothing,
+		//the full display it sends first tells when it did
+		waitingForFullDisplay = true;
+
+		std::uint8_t resync = spectatorResync;
+		if (peer) { enet_peer_send(peer, 0, enet_packet_create(&resync, 1, ENET_PACKET_FLAG_RELIABLE)); }
+	}
+
+	void Spectator::receive(const std::uint8_t *data, std::size_t size)
+	{
+		receivedBytes += size;
+
+		PacketReader reader(data, size);
+		std::uint8_t type = (std::uint8_t)reader.readInt(1);
+
+		if (type == spectatorSettings && status == connecting)
+		{
+			std::uint8_t platform = (std::uint8_t)reader.readInt(1);
+			Quirks quirks = quirksFromBits((std::uint32_t)reader.readInt(4));
+			int instructionsPerFrame = (int)reader.readInt(4);
+			std::uint8_t timing = (std::uint8_t)reader.readInt(1);
+			std::uint32_t seed = (std::uint32_t)reader.readInt(4);
+			std::uint32_t nextFrame = (std::uint32_t)reader.readInt(4);
+
+			if (!reader.ok || platform > (std::uint8_t)Platform::xoChip || timing > (std::uint8_t)Timing::cosmacVip)
+			{
+				status = failed;
+				return;
+			}
+
+			emulator->reset((Platform)platform, quirks, seed);
+			emulator->instructionsPerFrame = instructionsPerFrame;
+			emulator->timing = (Timing)timing;
+			frame = nextFrame;
+			status = watchingDisplay;
+		}
+		else if ((type == spectatorFullDisplay || type == spectatorDisplayDelta) && status == watchingDisplay)
+		{
+			std::uint32_t displayFrame = (std::uint32_t)reader.readInt(4);
+			bool hires = reader.readInt(1) != 0;
+			if (!reader.ok) { return; }
+
+			if (type == spectatorFullDisplay)
+			{
+				deltaDisplay.clear();
+				waitingForFullDisplay = false;
+			}
+			else if (waitingForFullDisplay) { return; }
+
+			if (!applyDelta(&deltaDisplay.planes[0][0][0], sizeof(deltaDisplay.planes), reader.rest(), reader.restSize()))
+			{
+				deltaDisplay.clear();
+			}
+			deltaDisplay.hires = hires;
+			deltaDirtyRows = ~0ull;
+			frame = displayFrame + 1;
+		}
+		else if (type == spectatorKeyframe && status == watchingDisplay && !waitingForFullDisplay)
+		{
+			std::uint32_t nextFrame = (std::uint32_t)reader.readInt(4);
+			std::uint32_t stateSize = (std::uint32_t)reader.readInt(4);
+			if (!reader.ok || stateSize != sizeof(State)) { status = failed; return; }
+
+			//decoded on the side so a broken keyframe leaves the spectator where it was
+			auto state = std::make_unique<State>();
+			std::memset((void *)state.get(), 0, sizeof(State));
+			if (!applyDelta((std::uint8_t *)state.get(), sizeof(State), reader.rest(), reader.restSize()) || !validState(*state))
+			{
+				requestKeyframe();
+				return;
+			}
+
+			emulator->state = *state;
+			emulator->state.dirtyRows = ~0ull;
+			frame = nextFrame;
+			status = synced;
+		}
+		else if (type == spectatorFrame && status == synced)
+		{
+			std::uint32_t keysFrame = (std::uint32_t)reader.readInt(4);
+			std::uint16_t keys = (std::uint16_t)reader.readInt(2);
+			if (!reader.ok || keysFrame != frame)
+			{
+				requestKeyframe();
+				return;
+			}
+
+			emulator->setKeys(keys);
+			emulator->runFrame();
+			frame++;
+		}
+		else if (type == spectatorHash && status == synced)
+		{
+			std::uint32_t hashFrame = (std::uint32_t)reader.readInt(4);
+			std::uint64_t hash = reader.readInt(8);
+			if (reader.ok && hashFrame + 1 == frame && hashState(emulator->state) != hash)
+			{
+				desyncFrame = hashFrame;
+				requestKeyframe();
+			}
+		}
+	}
+
+	void Spectator::poll()
+	{
+		if (!enetHost) { return; }
+
+		ENetEvent event;
+		while (enetHost && enet_host_service(enetHost, &event, 0) > 0)
+		{
+			switch (event.type)
+			{
+			case ENET_EVENT_TYPE_RECEIVE:
+				receive(event.packet->data, event.packet->dataLength);
+				enet_packet_destroy(event.packet);
+				break;
+
+			case ENET_EVENT_TYPE_DISCONNECT:
+				peer = nullptr;
+				if (status != failed) { status = disconnected; }
+				break;
+
+			default:
+				break;
+			}
+		}
+	}
+
+}
@@ -0,0 +1,260 @@
+#include <chip8service/client.h>
+#include <chip8net/packet.h>
+#include <chip8/display.h>
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace chip8
+{
+
+	bool ServiceClient::connect(const char *path)
+	{
+		close();
+
+		sockaddr_un address = {};
+		address.sun_family = AF_UNIX;
+		if (std::strlen(path) >= sizeof(address.sun_path))
+		{
+			error = "The socket path is too long";
+			return false;
+		}
+		std::strcpy(address.sun_path, path);
+
+		socket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+		if (socket < 0 || ::connect(socket, (sockaddr *)&address, sizeof(address)) != 0)
+		{
+			error = std::string("Can't connect to ") + path + ": " + std::strerror(errno);
+			close();
+			return false;
+		}
+		return true;
+	}
+
+	void ServiceClient::close()
+	{
+		if (socket >= 0)
+		{
+			::close(socket);
+			socket = -1;
+		}
+		input.clear();
+		received.clear();
+	}
+
+	std::uint32_t ServiceClient::send(std::uint8_t type, std::uint32_t session, const std::vector<std::uint8_t> &body)
+	{
+		if (socket < 0)
+		{
+			error = "Not connected";
+			return 0;
+		}
+		if (serviceRequestHeaderSize + body.size() > serviceMaxMessageSize)
+		{
+			error = "The request is too big";
+			return 0;
+		}
+
+		std::uint32_t id = nextId++;
+		if (!nextId) { nextId = 1; }
+
+		std::vector<std::uint8_t> out;
+		out.reserve(4 + serviceRequestHeaderSize + body.size());
+		writeInt(out, serviceRequestHeaderSize + body.size(), 4);
+		writeInt(out, type, 1);
+		writeInt(out, id, 4);
+		writeInt(out, session, 4);
+		out.insert(out.end(), body.begin(), body.end());
+
+		for (std::size_t sent = 0; sent < out.size();)
+		{
+			ssize_t written = ::send(socket, out.data() + sent, out.size() - sent, MSG_NOSIGNAL);
+			if (written <= 0)
+			{
+				if (written < 0 && errno == EINTR) { continue; }
+				error = "The service closed the connection";
+				close();
+				return 0;
+			}
+			sent += (std::size_t)written;
+		}
+		return id;
+	}
+
+	bool ServiceClient::receive(ServiceResponse &response)
+	{
+		if (!received.empty())
+		{
+			auto first = received.begin();
+			response = std::move(first->second);
+			received.erase(first);
+			return true;
+		}
+
+		std::uint8_t buffer[16 * 1024];
+		while (socket >= 0)
+		{
+			if (input.size() >= 4)
+			{
+				PacketReader reader(input.data(), input.size());
+				std::uint32_t size = (std::uint32_t)reader.readInt(4);
+				if (size < serviceResponseHeaderSize || size > serviceMaxMessageSize)
+				{
+					error = "The service sent a broken response";
+					close();
+					return false;
+				}
+				if (reader.restSize() >= size)
+				{
+					response.status = (std::uint8_t)reader.readInt(1);
+					response.id = (std::uint32_t)reader.readInt(4);
+					response.body.assign(reader.rest(), reader.rest() + size - serviceResponseHeaderSize);
+					input.erase(input.begin(), input.begin() + 4 + size);
+					return true;
+				}
+			}
+
+			ssize_t read = ::recv(socket, buffer, sizeof(buffer), 0);
+			if (read <= 0)
+			{
+				if (read < 0 && errno == EINTR) { continue; }
+				error = "The service closed the connection";
+				close();
+				return false;
+			}
+			input.insert(input.end(), buffer, buffer + read);
+		}
+
+		error = "Not connected";
+		return false;
+	}
+
+	bool ServiceClient::receive(std::uint32_t id, ServiceResponse &response)
+	{
+		auto found = received.find(id);
+		if (found != received.end())
+		{
+			response = std::move(found->second);
+			received.erase(found);
+			return true;
+		}
+
+		//the responses of the other requests wait for their receive
+		std::unordered_map<std::uint32_t, ServiceResponse> others;
+		others.swap(received);
+		bool ok = false;
+		while (receive(response))
+		{
+			if (response.id == id) { ok = true; break; }
+			others[response.id] = std::move(response);
+		}
+		received.swap(others);
+		return ok;
+	}
+
+	bool ServiceClient::call(std::uint8_t type, std::uint32_t session, const std::vector<std::uint8_t> &body, ServiceResponse &response)
+	{
+		std::uint32_t id = send(type, session, body);
+		if (!id || !receive(id, response)) { return false; }
+		if (response.status != serviceOk)
+		{
+			error = serviceStatusName(response.status);
+			return false;
+		}
+		return true;
+	}
+
+	std::uint32_t ServiceClient::open()
+	{
+		ServiceResponse response;
+		if (!call(serviceOpen, 0, {}, response)) { return 0; }
+		PacketReader reader(response.body.data(), response.body.size());
+		return (std::uint32_t)reader.readInt(4);
+	}
+
+	bool ServiceClient::closeSession(std::uint32_t session)
+	{
+		ServiceResponse response;
+		return call(serviceClose, session, {}, response);
+	}
+
+	bool ServiceClient::loadRom(std::uint32_t session, const std::uint8_t *rom, std::size_t size, int platform)
+	{
+		std::vector<std::uint8_t> body;
+		body.reserve(1 + size);
+		writeInt(body, platform < 0 ? serviceAnalyzePlatform : (std::uint8_t)platform, 1);
+		body.insert(body.end(), rom, rom + size);
+
+		ServiceResponse response;
+		return call(serviceLoadRom, session, body, response);
+	}
+
+	bool ServiceClient::setKeys(std::uint32_t session, std::uint16_t keys)
+	{
+		std::vector<std::uint8_t> body;
+		writeInt(body, keys, 2);
+
+		ServiceResponse response;
+		return call(serviceSetKeys, session, body, response);
+	}
+
+	bool ServiceClient::step(std::uint32_t session, std::uint32_t frames, std::uint64_t *stateHash)
+	{
+		std::vector<std::uint8_t> body;
+		writeInt(body, frames, 4);
+
+		ServiceResponse response;
+		if (!call(serviceStep, session, body, response)) { return false; }
+
+		PacketReader reader(response.body.data(), response.body.size());
+		reader.readInt(8);
+		std::uint64_t hash = reader.readInt(8);
+		if (stateHash) { *stateHash = hash; }
+		return reader.ok;
+	}
+
+	bool ServiceClient::framebuffer(std::uint32_t session, Display &display)
+	{
+		ServiceResponse response;
+		if (!call(serviceFramebuffer, session, {}, response)) { return false; }
+		if (response.body.size() != 1 + sizeof(display.planes))
+		{
+			error = "The service sent a broken framebuffer";
+			return false;
+		}
+
+		display.hires = response.body[0] != 0;
+		std::memcpy(display.planes, response.body.data() + 1, sizeof(display.planes));
+		return true;
+	}
+
+	bool ServiceClient::saveState(std::uint32_t session, std::vector<std::uint8_t> &savedState)
+	{
+		ServiceResponse response;
+		if (!call(serviceSaveState, session, {}, response)) { return false; }
+		savedState = std::move(response.body);
+		return true;
+	}
+
+	bool ServiceClient::loadState(std::uint32_t session, const std::vector<std::uint8_t> &savedState)
+	{
+		ServiceResponse response;
+		return call(serviceLoadState, session, savedState, response);
+	}
+
+	const char *serviceStatusName(std::uint8_t status)
+	{
+		switch (status)
+		{
+		case serviceOk: return "Ok";
+		case serviceUnknownSession: return "Unknown session";
+		case serviceBadRequest: return "Bad request";
+		case serviceRomTooBig: return "The rom is too big";
+		case serviceUnknownRequest: return "Unknown request";
+		default: return "Unknown status";
+		}
+	}
+
+}
@@ -0,0 +1,377 @@
+#include <chip8service/server.h>
+#include <chip8net/packet.h>
+#include <chip8/chip8.h>
+#include <chip8/delta.h>
+#include <chip8/hash.h>
+#include <chip8/romAnalyzer.h>
+#include <algorithm>
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <type_traits>
+#include <unistd.h>
+
+namespace chip8
+{
+
+	static_assert(std::is_trivially_copyable_v<State>, "the saved states copy the state as bytes");
+
+	struct ServiceServer::Connection
+	{
+		int socket = -1;
+		std::mutex writeMutex;
+		std::vector<std::uint8_t> input;
+
+		~Connection() { if (socket >= 0) { ::close(socket); } }
+
+		//blocks until the whole response is written, a client that went away just loses it
+		void respond(std::uint8_t status, std::uint32_t id, const std::vector<std::uint8_t> &body)
+		{
+			std::vector<std::uint8_t> out;
+			out.reserve(4 + serviceResponseHeaderSize + body.size());
+			writeInt(out, serviceResponseHeaderSize + body.size(), 4);
+			writeInt(out, status, 1);
+			writeInt(out, id, 4);
+			out.insert(out.end(), body.begin(), body.end());
+
+			std::lock_guard<std::mutex> lock(writeMutex);
+			for (std::size_t sent = 0; sent < out.size();)
+			{
+				ssize_t written = ::send(socket, out.data() + sent, out.size() - sent, MSG_NOSIGNAL);
+				if (written <= 0) { return; }
+				sent += (std::size_t)written;
+			}
+		}
+	};
+
+	struct ServiceServer::Session
+	{
+		std::uint32_t id = 0;
+		std::unique_ptr<Chip8> emulator = std::make_unique<Chip8>();
+
+		//guarded by the mutex of the server, scheduled while it is in readySessions or a worker runs it
+		std::deque<Job> jobs;
+		bool scheduled = false;
+	};
+
+	bool ServiceServer::start(const char *path, int threads)
+	{
+		sockaddr_un address = {};
+		address.sun_family = AF_UNIX;
+		if (std::strlen(path) >= sizeof(address.sun_path))
+		{
+			error = "The socket path is too long";
+			return false;
+		}
+		std::strcpy(address.sun_path, path);
+
+		listenSocket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+		::unlink(path);
+		if (listenSocket < 0 || ::bind(listenSocket, (sockaddr *)&address, sizeof(address)) != 0 ||
+			::listen(listenSocket, 64) != 0 || ::pipe(wakePipe) != 0)
+		{
+			error = std::string("Can't listen on ") + path + ": " + std::strerror(errno);
+			return false;
+		}
+
+		this->path = path;
+		stopping = false;
+		for (int t = 0; t < (threads > 0 ? threads : 1); t++) { workers.emplace_back([this]() { work(); }); }
+		return true;
+	}
+
+	void ServiceServer::stop()
+	{
+		stopping = true;
+		if (wakePipe[1] >= 0)
+		{
+			char wake = 0;
+			(void)!::write(wakePipe[1], &wake, 1);
+		}
+	}
+
+	ServiceServer::~ServiceServer()
+	{
+		stop();
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			jobsReady.notify_all();
+		}
+		for (std::thread &worker : workers) { worker.join(); }
+
+		if (listenSocket >= 0)
+		{
+			::close(listenSocket);
+			::unlink(path.c_str());
+		}
+		for (int fd : wakePipe) { if (fd >= 0) { ::close(fd); } }
+	}
+
+	void ServiceServer::run()
+	{
+		std::vector<std::shared_ptr<Connection>> connections;
+		std::vector<pollfd> polled;
+		std::uint8_t buffer[64 * 1024];
+
+		while (!stopping)
+		{
+			polled.clear();
+			polled.push_back({listenSocket, POLLIN, 0});
+			polled.push_back({wakePipe[0], POLLIN, 0});
+			for (auto &connection : connections) { polled.push_back({connection->socket, POLLIN, 0}); }
+
+			if (::poll(polled.data(), polled.size(), -1) < 0)
+			{
+				if (errno == EINTR) { continue; }
+				break;
+			}
+
+			if (polled[0].revents & POLLIN)
+			{
+				int socket = ::accept(listenSocket, nullptr, nullptr);
+				if (socket >= 0)
+				{
+					connections.push_back(std::make_shared<Connection>());
+					connections.back()->socket = socket;
+				}
+			}
+
+			//the new connection isn't in polled yet
+			for (std::size_t c = 0; c + 2 < polled.size(); c++)
+			{
+				if (!polled[c + 2].revents) { continue; }
+
+				std::shared_ptr<Connection> &connection = connections[c];
+				ssize_t read = ::recv(connection->socket, buffer, sizeof(buffer), 0);
+				if (read <= 0)
+				{
+					//the jobs still queued keep it alive, their responses go nowhere
+					::shutdown(connection->socket, SHUT_RDWR);
+					connection.reset();
+					continue;
+				}
+
+				std::vector<std::uint8_t> &input = connection->input;
+				input.insert(input.end(), buffer, buffer + read);
+
+				std::size_t used = 0;
+				while (input.size() - used >= 4)
+				{
+					PacketReader reader(input.data() + used, input.size() - used);
+					std::uint32_t size = (std::uint32_t)reader.readInt(4);
+					if (size < serviceRequestHeaderSize || size > serviceMaxMessageSize)
+					{
+						::shutdown(connection->socket, SHUT_RDWR);
+						break;
+					}
+					if (reader.restSize() < size) { break; }
+
+					dispatch(connection, std::vector<std::uint8_t>(reader.rest(), reader.rest() + size));
+					used += 4 + size;
+				}
+				input.erase(input.begin(), input.begin() + used);
+			}
+
+			connections.erase(std::remove(connections.begin(), connections.end(), nullptr), connections.end());
+		}
+	}
+
+	void ServiceServer::dispatch(const std::shared_ptr<Connection> &connection, std::vector<std::uint8_t> &&request)
+	{
+		requests++;
+
+		PacketReader reader(request.data(), request.size());
+		std::uint8_t type = (std::uint8_t)reader.readInt(1);
+		std::uint32_t id = (std::uint32_t)reader.readInt(4);
+		std::uint32_t sessionId = (std::uint32_t)reader.readInt(4);
+
+		std::unique_lock<std::mutex> lock(mutex);
+
+		//opening is cheap and has no session to wait for
+		if (type == serviceOpen)
+		{
+			auto session = std::make_shared<Session>();
+			session->id = nextSession++;
+			sessionTable[session->id] = session;
+			sessions++;
+			lock.unlock();
+
+			std::vector<std::uint8_t> body;
+			writeInt(body, session->id, 4);
+			connection->respond(serviceOk, id, body);
+			return;
+		}
+
+		auto found = sessionTable.find(sessionId);
+		if (found == sessionTable.end())
+		{
+			lock.unlock();
+			connection->respond(serviceUnknownSession, id, {});
+			return;
+		}
+
+		std::shared_ptr<Session> session = found->second;
+		session->jobs.push_back({connection, std::move(request)});
+		if (type == serviceClose)
+		{
+			//later requests for it are unknown, the queued ones still run
+			sessionTable.erase(found);
+			sessions--;
+		}
+		if (!session->scheduled)
+		{
+			session->scheduled = true;
+			readySessions.push_back(std::move(session));
+			jobsReady.notify_one();
+		}
+	}
+
+	void ServiceServer::work()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		while (true)
+		{
+			jobsReady.wait(lock, [&]() { return stopping || !readySessions.empty(); });
+			if (stopping) { return; }
+
+			std::shared_ptr<Session> session = std::move(readySessions.front());
+			readySessions.pop_front();
+
+			//one job at a time so a busy session doesn't starve the others
+			Job job = std::move(session->jobs.front());
+			session->jobs.pop_front();
+
+			lock.unlock();
+			execute(*session, job);
+			lock.lock();
+
+			if (session->jobs.empty()) { session->scheduled = false; }
+			else { readySessions.push_back(std::move(session)); }
+		}
+	}
+
+	void ServiceServer::execute(Session &session, const Job &job)
+	{
+		PacketReader reader(job.request.data(), job.request.size());
+		std::uint8_t type = (std::uint8_t)reader.readInt(1);
+		std::uint32_t id = (std::uint32_t)reader.readInt(4);
+		reader.readInt(4);
+
+		Chip8 &emulator = *session.emulator;
+		std::vector<std::uint8_t> body;
+		std::uint8_t status = serviceOk;
+
+		switch (type)
+		{
+		case serviceClose:
+			break;
+
+		case serviceLoadRom:
+		{
+			std::uint8_t platform = (std::uint8_t)reader.readInt(1);
+			if (!reader.ok || (platform > (std::uint8_t)Platform::xoChip && platform != serviceAnalyzePlatform))
+			{
+				status = serviceBadRequest;
+				break;
+			}
+
+			if (platform == serviceAnalyzePlatform)
+			{
+				RomAnalysis analysis = analyzeRom(reader.rest(), reader.restSize());
+				emulator.reset(analysis.platform, analysis.quirks);
+				emulator.instructionsPerFrame = analysis.instructionsPerFrame;
+			}
+			else { emulator.reset((Platform)platform); }
+
+			if (!emulator.loadRom(reader.rest(), reader.restSize()))
+			{
+				status = serviceRomTooBig;
+				break;
+			}
+
+			writeInt(body, (std::uint8_t)emulator.platform, 1);
+			writeInt(body, quirksToBits(emulator.quirks), 4);
+			writeInt(body, (std::uint32_t)emulator.instructionsPerFrame, 4);
+			break;
+		}
+
+		case serviceSetKeys:
+		{
+			std::uint16_t keys = (std::uint16_t)reader.readInt(2);
+			if (!reader.ok) { status = serviceBadRequest; break; }
+			emulator.setKeys(keys);
+			break;
+		}
+
+		case serviceStep:
+		{
+			std::uint32_t frames = (std::uint32_t)reader.readInt(4);
+			if (!reader.ok) { status = serviceBadRequest; break; }
+
+			for (std::uint32_t f = 0; f < frames; f++) { emulator.runFrame(); }
+			writeInt(body, emulator.state.frameCount, 8);
+			writeInt(body, hashState(emulator.state), 8);
+			break;
+		}
+
+		case serviceFramebuffer:
+		{
+			const Display &display = emulator.state.display;
+			writeInt(body, display.hires, 1);
+			const std::uint8_t *planes = &display.planes[0][0][0];
+			body.insert(body.end(), planes, planes + sizeof(display.planes));
+			break;
+		}
+
+		case serviceSaveState:
+			writeInt(body, (std::uint8_t)emulator.platform, 1);
+			writeInt(body, quirksToBits(emulator.quirks), 4);
+			writeInt(body, (std::uint32_t)emulator.instructionsPerFrame, 4);
+			writeInt(body, (std::uint8_t)emulator.timing, 1);
+			writeInt(body, emulator.seed, 4);
+			writeInt(body, sizeof(State), 4);
+			encodeDelta(nullptr, (const std::uint8_t *)&emulator.state, sizeof(State), body);
+			break;
+
+		case serviceLoadState:
+		{
+			std::uint8_t platform = (std::uint8_t)reader.readInt(1);
+			Quirks quirks = quirksFromBits((std::uint32_t)reader.readInt(4));
+			int instructionsPerFrame = (int)reader.readInt(4);
+			std::uint8_t timing = (std::uint8_t)reader.readInt(1);
+			std::uint32_t seed = (std::uint32_t)reader.readInt(4);
+			std::uint32_t stateSize = (std::uint32_t)reader.readInt(4);
+			if (!reader.ok || platform > (std::uint8_t)Platform::xoChip || timing > (std::uint8_t)Timing::cosmacVip ||
+				stateSize != sizeof(State))
+			{
+				status = serviceBadRequest;
+				break;
+			}
+
+			//decoded on the side so a broken state leaves the session as it was
+			auto state = std::make_unique<State>();
+			std::memset((void *)state.get(), 0, sizeof(State));
+			if (!applyDelta((std::uint8_t *)state.get(), sizeof(State), reader.rest(), reader.restSize()) ||
+				!validState(*state))
+			{
+				status = serviceBadRequest;
+				break;
+			}
+
+			emulator.reset((Platform)platform, quirks, seed);
+			emulator.instructionsPerFrame = instructionsPerFrame;
+			emulator.timing = (Timing)timing;
+			emulator.state = *state;
+			break;
+		}
+
+		default:
+			status = serviceUnknownRequest;
+			break;
+		}
+
+		job.connection->respond(status, id, body);
+	}
+
+}
@@ -0,0 +1,210 @@
+#include "debuggerWindow.h"
+#include "imgui.h"
+#include <algorithm>
+#include <chrono>
+
+static const char *stopDescription(const chip8::Debugger::Stop &stop)
+{
+	switch (stop.reason)
+	{
+	case chip8::Debugger::StopReason::none: return "Running";
+	case chip8::Debugger::StopReason::breakpoint: return "Stopped at a breakpoint";
+	case chip8::Debugger::StopReason::watchpoint: return "Stopped by a watchpoint";
+	case chip8::Debugger::StopReason::step: return "Stepped";
+	case chip8::Debugger::StopReason::paused: return "Paused";
+	case chip8::Debugger::StopReason::rewound: return "Stepped back";
+	}
+	return "";
+}
+
+void DebuggerWindow::render(chip8::Chip8 &emulator, bool canRewind)
+{
+	if (!show) { return; }
+
+	if (!ImGui::Begin("Debugger", &show))
+	{
+		ImGui::End();
+		return;
+	}
+
+	using chip8::Debugger;
+	const chip8::State &s = emulator.state;
+
+	if (running())
+	{
+		if (ImGui::Button("Pause"))
+		{
+			debugger.stop.reason = Debugger::StopReason::paused;
+			debugger.stop.pc = (std::uint16_t)(s.pc & emulator.memoryMask);
+		}
+	}
+	else
+	{
+		if (ImGui::Button("Continue")) { debugger.resume(); }
+		ImGui::SameLine();
+		if (ImGui::Button("Step")) { debugger.stepInstructions(1); }
+
+		if (canRewind)
+		{
+			ImGui::SameLine();
+			bool stepBack = ImGui::Button("Step back");
+			ImGui::SameLine();
+			bool runBack = ImGui::Button("Run back");
+			if (stepBack || runBack)
+			{
+				auto start = std::chrono::steady_clock::now();
+				bool went = stepBack ? history.stepBack(emulator, debugger) : history.runBack(emulator, debugger);
+				rewindMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+				rewindStatus = went ? "" : stepBack ? "Nothing recorded before this" : "No stop before this";
+			}
+		}
+	}
+	ImGui::SameLine();
+	ImGui::TextUnformatted(stopDescription(debugger.stop));
+
+	const Debugger::Stop &stop = debugger.stop;
+	if (stop.reason == Debugger::StopReason::watchpoint && stop.index < (int)debugger.watchpoints.size())
+	{
+		const Debugger::Watchpoint &watchpoint = debugger.watchpoints[stop.index];
+		if (watchpoint.kind == Debugger::Watchpoint::memory)
+		{
+			ImGui::Text("%03X wrote [%03X]: %02X -> %02X", stop.instructionPc, stop.address, stop.oldValue, stop.newValue);
+		}
+		else
+		{
+			ImGui::Text("%03X changed %s: %X -> %X", stop.instructionPc,
+				watchpoint.kind == Debugger::Watchpoint::registerI ? "I" : chip8::debuggerOperandName((std::uint8_t)stop.address),
+				stop.oldValue, stop.newValue);
+		}
+	}
+	if (emulator.midFrame()) { ImGui::TextUnformatted("In the middle of a frame"); }
+
+	if (canRewind)
+	{
+		chip8::History::Stats stats = history.stats();
+		ImGui::Text("History: %.1f s, %zu keyframes (%zu KB)", stats.frames / 60.f, stats.keyframes, stats.keyframeBytes / 1024);
+		if (stats.lastReplayedFrames || *rewindStatus)
+		{
+			ImGui::Text("Went back replaying %llu frames in %.2f ms %s", (unsigned long long)stats.lastReplayedFrames,
+				rewindMilliseconds, rewindStatus);
+		}
+	}
+
+	ImGui::Separator();
+	ImGui::Text("PC %03X  I %03X  SP %X  DT %02X  ST %02X", s.pc, s.i, s.sp, s.delayTimer, s.soundTimer);
+	for (int r = 0; r < 16; r++)
+	{
+		ImGui::Text("V%X %02X", r, s.v[r]);
+		if (r % 8 != 7) { ImGui::SameLine(); }
+	}
+
+	bool changed = false;
+
+	if (ImGui::CollapsingHeader("Breakpoints", ImGuiTreeNodeFlags_DefaultOpen))
+	{
+		for (std::size_t b = 0; b < debugger.breakpoints.size(); b++)
+		{
+			Debugger::Breakpoint &breakpoint = debugger.breakpoints[b];
+			ImGui::PushID((int)b);
+			changed |= ImGui::Checkbox("##enabled", &breakpoint.enabled);
+			ImGui::SameLine();
+			if (breakpoint.compare == Debugger::Compare::always) { ImGui::Text("%03X", breakpoint.address); }
+			else
+			{
+				ImGui::Text("%03X if %s %s %X", breakpoint.address, chip8::debuggerOperandName(breakpoint.operand),
+					chip8::debuggerCompareName(breakpoint.compare), breakpoint.value);
+			}
+			ImGui::SameLine();
+			ImGui::Text("(%llu hits)", (unsigned long long)breakpoint.hits);
+			ImGui::SameLine();
+			if (ImGui::SmallButton("Remove"))
+			{
+				debugger.breakpoints.erase(debugger.breakpoints.begin() + b);
+				changed = true;
+				ImGui::PopID();
+				break;
+			}
+			ImGui::PopID();
+		}
+
+		static const char *compares[] = {"always", "==", "!=", "<", "<=", ">", ">="};
+		static const char *operands[] = {"V0", "V1", "V2", "V3", "V4", "V5", "V6", "V7",
+			"V8", "V9", "VA", "VB", "VC", "VD", "VE", "VF", "I", "DT"};
+
+		ImGui::PushItemWidth(60);
+		ImGui::InputInt("##address", &newAddress, 0, 0, ImGuiInputTextFlags_CharsHexadecimal);
+		ImGui::SameLine();
+		ImGui::Combo("##operand", &newOperand, operands, IM_ARRAYSIZE(operands));
+		ImGui::SameLine();
+		ImGui::Combo("##compare", &newCompare, compares, IM_ARRAYSIZE(compares));
+		ImGui::SameLine();
+		ImGui::InputInt("##value", &newValue, 0, 0, ImGuiInputTextFlags_CharsHexadecimal);
+		ImGui::PopItemWidth();
+		ImGui::SameLine();
+		if (ImGui::Button("Add breakpoint"))
+		{
+			Debugger::Breakpoint breakpoint;
+			breakpoint.address = (std::uint16_t)(newAddress & 0xFFFF);
+			breakpoint.compare = (Debugger::Compare)newCompare;
+			breakpoint.operand = (std::uint8_t)newOperand;
+			breakpoint.value = (std::uint16_t)newValue;
+			debugger.breakpoints.push_back(breakpoint);
+			changed = true;
+		}
+	}
+
+	if (ImGui::CollapsingHeader("Watchpoints", ImGuiTreeNodeFlags_DefaultOpen))
+	{
+		for (std::size_t w = 0; w < debugger.watchpoints.size(); w++)
+		{
+			Debugger::Watchpoint &watchpoint = debugger.watchpoints[w];
+			ImGui::PushID((int)w + 0x10000);
+			changed |= ImGui::Checkbox("##enabled", &watchpoint.enabled);
+			ImGui::SameLine();
+			if (watchpoint.kind == Debugger::Watchpoint::memory)
+			{
+				ImGui::Text("[%03X..%03X]", watchpoint.address, (watchpoint.address + watchpoint.size - 1) & 0xFFFF);
+			}
+			else if (watchpoint.kind == Debugger::Watchpoint::registerV) { ImGui::Text("V%X", watchpoint.address & 0xF); }
+			else { ImGui::TextUnformatted("I"); }
+			ImGui::SameLine();
+			ImGui::Text("(%llu hits)", (unsigned long long)watchpoint.hits);
+			ImGui::SameLine();
+			if (ImGui::SmallButton("Remove"))
+			{
+				debugger.watchpoints.erase(debugger.watchpoints.begin() + w);
+				changed = true;
+				ImGui::PopID();
+				break;
+			}
+			ImGui::PopID();
+		}
+
+		static const char *kinds[] = {"memory", "V", "I"};
+
+		ImGui::PushItemWidth(60);
+		ImGui::Combo("##kind", &newWatchKind, kinds, IM_ARRAYSIZE(kinds));
+		ImGui::SameLine();
+		ImGui::InputInt("##watchAddress", &newWatchAddress, 0, 0, ImGuiInputTextFlags_CharsHexadecimal);
+		if (newWatchKind == Debugger::Watchpoint::memory)
+		{
+			ImGui::SameLine();
+			ImGui::InputInt("bytes", &newWatchSize, 0, 0);
+		}
+		ImGui::PopItemWidth();
+		ImGui::SameLine();
+		if (ImGui::Button("Add watchpoint"))
+		{
+			Debugger::Watchpoint watchpoint;
+			watchpoint.kind = (Debugger::Watchpoint::Kind)newWatchKind;
+			watchpoint.address = (std::uint16_t)(newWatchAddress & 0xFFFF);
+			watchpoint.size = (std::uint16_t)std::max(1, std::min(newWatchSize, 0xFFFF));
+			debugger.watchpoints.push_back(watchpoint);
+			changed = true;
+		}
+	}
+
+	if (changed) { debugger.update(); }
+
+	ImGui::End();
+}
@@ -0,0 +1,123 @@
+#include "disassemblyWindow.h"
+#include "imgui.h"
+
+static void toggleBreakpoint(chip8::Debugger &debugger, std::uint16_t address)
+{
+	for (std::size_t b = 0; b < debugger.breakpoints.size(); b++)
+	{
+		if (debugger.breakpoints[b].address == address)
+		{
+			debugger.breakpoints.erase(debugger.breakpoints.begin() + b);
+			debugger.update();
+			return;
+		}
+	}
+
+	chip8::Debugger::Breakpoint breakpoint;
+	breakpoint.address = address;
+	debugger.breakpoints.push_back(breakpoint);
+	debugger.update();
+}
+
+void DisassemblyWindow::render(const chip8::Chip8 &emulator, chip8::Debugger &debugger)
+{
+	if (!show) { return; }
+
+	if (!ImGui::Begin("Disassembly", &show))
+	{
+		ImGui::End();
+		return;
+	}
+
+	const chip8::State &s = emulator.state;
+	disassembly.follow(emulator, s.pc);
+
+	const std::size_t pcRow = disassembly.rowOf(s.pc);
+	if (followPc && s.pc != lastPc) { scrollToRow = (std::int32_t)pcRow; }
+	lastPc = s.pc;
+
+	ImGui::Checkbox("Follow PC", &followPc);
+	ImGui::SameLine();
+	ImGui::PushItemWidth(60);
+	bool goTo = ImGui::InputInt("##goTo", &goToAddress, 0, 0,
+		ImGuiInputTextFlags_CharsHexadecimal | ImGuiInputTextFlags_EnterReturnsTrue);
+	ImGui::PopItemWidth();
+	ImGui::SameLine();
+	if (ImGui::Button("Go to") || goTo)
+	{
+		scrollToRow = (std::int32_t)disassembly.rowOf((std::uint16_t)(goToAddress & emulator.memoryMask));
+		followPc = false;
+	}
+	ImGui::SameLine();
+	ImGui::TextDisabled("%zu rows, %llu disassembled", disassembly.rowCount(), (unsigned long long)disassembly.stats.made);
+
+	const ImGuiTableFlags flags = ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersV;
+	if (ImGui::BeginTable("disassembly", 5, flags))
+	{
+		ImGui::TableSetupScrollFreeze(0, 1);
+		ImGui::TableSetupColumn("", ImGuiTableColumnFlags_WidthFixed, ImGui::GetFontSize() * 1.5f);
+		ImGui::TableSetupColumn("Address", ImGuiTableColumnFlags_WidthFixed);
+		ImGui::TableSetupColumn("Bytes", ImGuiTableColumnFlags_WidthFixed);
+		ImGui::TableSetupColumn("Label", ImGuiTableColumnFlags_WidthFixed);
+		ImGui::TableSetupColumn("Instruction");
+		ImGui::TableHeadersRow();
+
+		//the whole memory is listed, the clipper only hands out the visible rows and the one to scroll to
+		ImGuiListClipper clipper;
+		clipper.Begin((int)disassembly.rowCount());
+		if (scrollToRow >= 0) { clipper.ForceDisplayRangeByIndices(scrollToRow, scrollToRow + 1); }
+		while (clipper.Step())
+		{
+			for (int r = clipper.DisplayStart; r < clipper.DisplayEnd; r++)
+			{
+				const chip8::Disassembly::Row &row = disassembly.row(r);
+				const bool isPc = (std::size_t)r == pcRow;
+
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn();
+				ImGui::PushID(r);
+				if (ImGui::Selectable("##row", isPc, ImGuiSelectableFlags_SpanAllColumns) && row.code)
+				{
+					toggleBreakpoint(debugger, row.address);
+				}
+				ImGui::PopID();
+				ImGui::SameLine();
+				if (debugger.breakAt.test(row.address)) { ImGui::TextColored({1, 0.3f, 0.3f, 1}, isPc ? "*>" : "*"); }
+				else if (isPc) { ImGui::TextUnformatted(">"); }
+
+				ImGui::TableNextColumn();
+				ImGui::Text(row.address > 0xFFF ? "%04X" : "%03X", row.address);
+
+				ImGui::TableNextColumn();
+				if (row.code)
+				{
+					if (row.size == 4)
+					{
+						ImGui::Text("%02X%02X %02X%02X", s.memory[row.address], s.memory[row.address + 1],
+							s.memory[row.address + 2], s.memory[row.address + 3]);
+					}
+					else { ImGui::Text("%02X%02X", s.memory[row.address], s.memory[row.address + 1]); }
+				}
+
+				ImGui::TableNextColumn();
+				char label[16];
+				if (disassembly.label(row.address, label, sizeof(label))) { ImGui::TextUnformatted(label); }
+
+				ImGui::TableNextColumn();
+				const char *text = disassembly.text(s, r);
+				if (row.code) { ImGui::TextUnformatted(text); }
+				else { ImGui::TextDisabled("%s", text); }
+
+				if (r == scrollToRow)
+				{
+					ImGui::SetScrollHereY(0.5f);
+					scrollToRow = -1;
+				}
+			}
+		}
+
+		ImGui::EndTable();
+	}
+
+	ImGui::End();
+}
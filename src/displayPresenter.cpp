@@ -0,0 +1,234 @@
+#include "displayPresenter.h"
+#include <cmath>
+#include <algorithm>
+
+#define SHADER_HEADER GL2D_OPNEGL_SHADER_VERSION "\n" GL2D_OPNEGL_SHADER_PRECISION "\n"
+
+//same inputs as the gl2d default vertex shader so it can be used with the renderer
+static const char *vertexShader =
+	SHADER_HEADER
+	"in vec2 quad_positions;\n"
+	"in vec4 quad_colors;\n"
+	"in vec2 texturePositions;\n"
+	"out vec4 v_color;\n"
+	"out vec2 v_texture;\n"
+	"void main()\n"
+	"{\n"
+	"	gl_Position = vec4(quad_positions, 0, 1);\n"
+	"	v_color = quad_colors;\n"
+	"	v_texture = texturePositions;\n"
+	"}\n";
+
+//Expands the display bits to palette colors and blends them with the last frame.
+//A pixel that turns on is shown at once, a pixel that turns off fades towards its new color.
+static const char *phosphorFragmentShader =
+	SHADER_HEADER
+	"out vec4 color;\n"
+	"in vec4 v_color;\n"
+	"in vec2 v_texture;\n"
+	"uniform sampler2D u_sampler;\n" //last persistence frame
+	"uniform usampler2D u_display;\n" //bit rows, plane 1 starts at row 64
+	"uniform ivec2 u_resolution;\n"
+	"uniform vec4 u_palette[4];\n"
+	"uniform float u_decay;\n"
+	"void main()\n"
+	"{\n"
+	"	ivec2 p = ivec2(v_texture.x * float(u_resolution.x), (1.0 - v_texture.y) * float(u_resolution.y));\n"
+	"	p = clamp(p, ivec2(0), u_resolution - 1);\n"
+	"	uint shift = uint(7 - (p.x & 7));\n"
+	"	uint b0 = (texelFetch(u_display, ivec2(p.x >> 3, p.y), 0).r >> shift) & 1u;\n"
+	"	uint b1 = (texelFetch(u_display, ivec2(p.x >> 3, p.y + 64), 0).r >> shift) & 1u;\n"
+	"	vec3 lit = u_palette[int(b0 | (b1 << 1u))].rgb;\n"
+	"	vec3 last = texture(u_sampler, v_texture).rgb;\n"
+	"	color = vec4(lit + max(last - lit, vec3(0.0)) * u_decay, 1.0);\n"
+	"}\n";
+
+//Scales the persistence buffer with nearest filtering and darkens the pixel borders.
+//The grid fades out when the pixels get too small on the screen.
+static const char *gridFragmentShader =
+	SHADER_HEADER
+	"out vec4 color;\n"
+	"in vec4 v_color;\n"
+	"in vec2 v_texture;\n"
+	"uniform sampler2D u_sampler;\n"
+	"uniform ivec2 u_resolution;\n"
+	"uniform float u_gridStrength;\n"
+	"void main()\n"
+	"{\n"
+	"	vec2 cell = v_texture * vec2(u_resolution);\n"
+	"	ivec2 p = clamp(ivec2(cell), ivec2(0), u_resolution - 1);\n"
+	"	vec3 c = texelFetch(u_sampler, p, 0).rgb;\n"
+	"	vec2 pixelsPerCell = 1.0 / max(fwidth(cell), vec2(0.0001));\n"
+	"	vec2 f = fract(cell);\n"
+	"	vec2 border = min(f, 1.0 - f) * pixelsPerCell;\n"
+	"	float line = 1.0 - smoothstep(0.0, 1.0, min(border.x, border.y));\n"
+	"	float visible = clamp((min(pixelsPerCell.x, pixelsPerCell.y) - 3.0) / 3.0, 0.0, 1.0);\n"
+	"	color = vec4(c * (1.0 - u_gridStrength * line * visible), 1.0) * v_color;\n"
+	"}\n";
+
+void DisplayPresenter::create()
+{
+	phosphorShader = gl2d::createShaderProgram(vertexShader, phosphorFragmentShader);
+	gridShader = gl2d::createShaderProgram(vertexShader, gridFragmentShader);
+
+	phosphorUniforms.display = glGetUniformLocation(phosphorShader.id, "u_display");
+	phosphorUniforms.resolution = glGetUniformLocation(phosphorShader.id, "u_resolution");
+	phosphorUniforms.palette = glGetUniformLocation(phosphorShader.id, "u_palette");
+	phosphorUniforms.decay = glGetUniformLocation(phosphorShader.id, "u_decay");
+
+	gridUniforms.resolution = glGetUniformLocation(gridShader.id, "u_resolution");
+	gridUniforms.gridStrength = glGetUniformLocation(gridShader.id, "u_gridStrength");
+
+	offscreenRenderer.create(0, 1);
+
+	//integer textures can't be filtered
+	glGenTextures(1, &displayTexture);
+	glBindTexture(GL_TEXTURE_2D, displayTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, chip8::displayRowBytes,
+		chip8::displayMaxHeight * chip8::displayPlanes, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, nullptr);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	resize({chip8::displayMaxWidth / 2, chip8::displayMaxHeight / 2});
+}
+
+void DisplayPresenter::cleanup()
+{
+	persistenceBuffers[0].cleanup();
+	persistenceBuffers[1].cleanup();
+	offscreenRenderer.cleanup();
+
+	glDeleteTextures(1, &displayTexture);
+	displayTexture = 0;
+
+	glDeleteProgram(phosphorShader.id);
+	glDeleteProgram(gridShader.id);
+	phosphorShader = {};
+	gridShader = {};
+	resolution = {};
+}
+
+void DisplayPresenter::resize(glm::ivec2 newResolution)
+{
+	resolution = newResolution;
+
+	for (auto &b : persistenceBuffers)
+	{
+		if (b.fbo) { b.resize(resolution.x, resolution.y); }
+		else { b.create(resolution.x, resolution.y); }
+
+		b.clear();
+	}
+
+	offscreenRenderer.updateWindowMetrics(resolution.x, resolution.y);
+}
+
+void DisplayPresenter::update(const chip8::Display &display, std::uint64_t dirtyRows, float deltaTime)
+{
+	glm::ivec2 displayResolution = {display.width(), display.height()};
+	if (displayResolution != resolution)
+	{
+		resize(displayResolution);
+		dirtyRows = ~0ull;
+	}
+
+	uploadStats.bytesThisFrame = 0;
+	uploadStats.rowsThisFrame = 0;
+
+	if (dirtyRows)
+	{
+		int first = 0;
+		int last = 63;
+		while (!(dirtyRows & (1ull << first))) { first++; }
+		while (!(dirtyRows & (1ull << last))) { last--; }
+		last = std::min(last, display.height() - 1);
+
+		if (first <= last)
+		{
+			const int rows = last - first + 1;
+
+			glBindTexture(GL_TEXTURE_2D, displayTexture);
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+			//one upload per plane, plane 1 starts at row 64 of the texture
+			for (int p = 0; p < chip8::displayPlanes; p++)
+			{
+				glTexSubImage2D(GL_TEXTURE_2D, 0, 0, p * chip8::displayMaxHeight + first, chip8::displayRowBytes,
+					rows, GL_RED_INTEGER, GL_UNSIGNED_BYTE, display.planes[p][first]);
+			}
+
+			uploadStats.rowsThisFrame = rows;
+			uploadStats.bytesThisFrame = rows * chip8::displayRowBytes * chip8::displayPlanes;
+			uploadStats.totalBytes += uploadStats.bytesThisFrame;
+		}
+	}
+
+	if (!uploadStats.bytesThisFrame)
+	{
+		uploadStats.skippedFrames++;
+	}
+
+	float decay = 0;
+	if (persistence > 0 && deltaTime > 0)
+	{
+		decay = std::exp(-deltaTime / persistence);
+	}
+
+	glUseProgram(phosphorShader.id);
+	glUniform1i(phosphorUniforms.display, 1);
+	glUniform2i(phosphorUniforms.resolution, resolution.x, resolution.y);
+	glUniform4fv(phosphorUniforms.palette, 4, &palette[0][0]);
+	glUniform1f(phosphorUniforms.decay, decay);
+
+	//the display goes in unit 1, the renderer binds the last frame in unit 0.
+	//unit 0 is left active because flushFBO unbinds the texture of the active unit
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, displayTexture);
+	glActiveTexture(GL_TEXTURE0);
+
+	int nextBuffer = 1 - currentBuffer;
+
+	offscreenRenderer.pushShader(phosphorShader);
+	offscreenRenderer.renderRectangle({0, 0, resolution.x, resolution.y},
+		persistenceBuffers[currentBuffer].texture);
+	offscreenRenderer.flushFBO(persistenceBuffers[nextBuffer]);
+	offscreenRenderer.popShader();
+
+	currentBuffer = nextBuffer;
+
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glActiveTexture(GL_TEXTURE0);
+}
+
+void DisplayPresenter::render(gl2d::Renderer2D &renderer, glm::vec4 rect)
+{
+	renderer.flush();
+
+	glUseProgram(gridShader.id);
+	glUniform2i(gridUniforms.resolution, resolution.x, resolution.y);
+	glUniform1f(gridUniforms.gridStrength, gridStrength);
+
+	renderer.pushShader(gridShader);
+	renderer.renderRectangle(rect, persistenceBuffers[currentBuffer].texture);
+	renderer.flush();
+	renderer.popShader();
+}
+
+glm::vec4 DisplayPresenter::fitRect(glm::vec4 area)
+{
+	float aspect = 2.f; //both resolutions are 2:1
+	float w = area.z;
+	float h = area.z / aspect;
+
+	if (h > area.w)
+	{
+		h = area.w;
+		w = h * aspect;
+	}
+
+	return {area.x + (area.z - w) / 2.f, area.y + (area.w - h) / 2.f, w, h};
+}
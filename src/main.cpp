@@ -1,8 +1,27 @@
 #include <SDL2/SDL.h>
 #include <glad/glad.h>
 #include <iostream>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <string>
 #include <gl2d/gl2d.h> //my 2d library, just to try OpenGL
 #include <openglErrorReporting.h>
+#include <displayPresenter.h>
+#include <profilerOverlay.h>
+#include <chip8/chip8.h>
+#include <chip8/mappedFile.h>
+#include <chip8/romLibrary.h>
+#include <romBrowser.h>
+#include <recompiledPlugins.h>
+#include <movieSession.h>
+#include <debuggerWindow.h>
+#include <disassemblyWindow.h>
+#include <memoryHeatWindow.h>
+#include <romProfilerWindow.h>
+#include <traceWindow.h>
+#include <chip8net/netplay.h>
+#include <chip8net/spectator.h>
 #undef main
 
 #pragma region imgui
@@ -12,6 +31,133 @@
 #include "imguiThemes.h"
 #pragma endregion
 
+//the usual layout, the left 4x4 keys of a qwerty keyboard
+static const SDL_Scancode keyMap[16] =
+{
+	SDL_SCANCODE_X, //0
+	SDL_SCANCODE_1, SDL_SCANCODE_2, SDL_SCANCODE_3, //1 2 3
+	SDL_SCANCODE_Q, SDL_SCANCODE_W, SDL_SCANCODE_E, //4 5 6
+	SDL_SCANCODE_A, SDL_SCANCODE_S, SDL_SCANCODE_D, //7 8 9
+	SDL_SCANCODE_Z, SDL_SCANCODE_C, //A B
+	SDL_SCANCODE_4, SDL_SCANCODE_R, SDL_SCANCODE_F, SDL_SCANCODE_V, //C D E F
+};
+
+static std::uint16_t readKeypad()
+{
+	const Uint8 *keyboard = SDL_GetKeyboardState(nullptr);
+	std::uint16_t keys = 0;
+	for (int i = 0; i < 16; i++)
+	{
+		if (keyboard[keyMap[i]]) { keys |= 1 << i; }
+	}
+	return keys;
+}
+
+//remembers the hash, platform and quirks of every rom that was opened
+static const char *romLibraryPath = "romLibrary.index";
+
+//resets the emulator with the settings the library has for this rom and loads it
+static bool loadRom(chip8::Chip8 &emulator, chip8::RomLibrary &library, RecompiledPlugins &plugins,
+	const char *path, chip8::RomInfo &loadedRom)
+{
+	const chip8::RomInfo *info = library.update(path);
+	if (!info)
+	{
+		std::cerr << "Can't read rom: " << path << std::endl;
+		return false;
+	}
+
+	chip8::MappedFile rom;
+	if (!rom.open(info->path.c_str()))
+	{
+		std::cerr << "Can't read rom: " << path << std::endl;
+		return false;
+	}
+
+	emulator.reset(info->platform, info->quirks);
+	emulator.instructionsPerFrame = info->instructionsPerFrame;
+	if (!emulator.loadRom(rom.data, rom.size))
+	{
+		std::cerr << "The rom is too big for " << chip8::platformName(info->platform) << ": " << path << std::endl;
+		return false;
+	}
+
+	if (const chip8::RecompiledRom *recompiled = plugins.find(info->path, info->hash, info->platform, info->quirks))
+	{
+		emulator.compiled = recompiled->run;
+	}
+
+	loadedRom = *info;
+	if (library.modified) { library.save(romLibraryPath); }
+	return true;
+}
+
+//address:port, false if there is no port
+static bool splitAddress(const char *text, std::string &address, std::uint16_t &port)
+{
+	address = text;
+	std::size_t colon = address.rfind(':');
+	if (colon == std::string::npos) { return false; }
+
+	port = (std::uint16_t)std::atoi(address.c_str() + colon + 1);
+	address.resize(colon);
+	return true;
+}
+
+//hosts on a port or joins address:port with the loaded rom
+static bool startNetplay(chip8::Netplay &netplay, chip8::Chip8 &emulator, const chip8::RomInfo &rom,
+	const char *hostPort, const char *joinAddress)
+{
+	chip8::MappedFile file;
+	if (!file.open(rom.path.c_str()))
+	{
+		std::cerr << "Can't read rom: " << rom.path << std::endl;
+		return false;
+	}
+
+	bool started = false;
+	if (hostPort)
+	{
+		started = netplay.host(emulator, file.data, file.size, (std::uint16_t)std::atoi(hostPort));
+	}
+	else
+	{
+		std::string address;
+		std::uint16_t port = 0;
+		if (!splitAddress(joinAddress, address, port))
+		{
+			std::cerr << "--join needs address:port" << std::endl;
+			return false;
+		}
+		started = netplay.join(emulator, file.data, file.size, address.c_str(), port);
+	}
+
+	if (!started) { std::cerr << netplay.error << std::endl; }
+	return started;
+}
+
+static void renderNetplay(const chip8::Netplay &netplay)
+{
+	if (!ImGui::Begin("Netplay"))
+	{
+		ImGui::End();
+		return;
+	}
+
+	static const char *statusNames[] = {"Idle", "Connecting", "Playing", "Disconnected", "Failed"};
+	ImGui::Text("%s, player %d", statusNames[netplay.status], netplay.player() + 1);
+	if (netplay.status == chip8::Netplay::failed) { ImGui::TextUnformatted(netplay.error.c_str()); }
+
+	const chip8::Rollback &rollback = netplay.rollback;
+	ImGui::Text("Frame %u, %d ahead of the remote keys", rollback.frame, (int)(rollback.frame - rollback.confirmedFrames));
+	ImGui::Text("Rollbacks: %llu (%llu frames, at most %d)", (unsigned long long)rollback.stats.rollbacks,
+		(unsigned long long)rollback.stats.resimulatedFrames, rollback.stats.mostResimulatedFrames);
+	ImGui::Text("Stalled frames: %llu", (unsigned long long)rollback.stats.stalledFrames);
+	if (rollback.desyncFrame >= 0) { ImGui::Text("Desync at frame %lld", (long long)rollback.desyncFrame); }
+
+	ImGui::End();
+}
+
 int main(int argc, char *argv[])
 {
 	// Initialize SDL
@@ -99,10 +245,92 @@ int main(int argc, char *argv[])
 	gl2d::Renderer2D renderer2d;
 	renderer2d.create();
 
+	//the state has the whole 64 KB of memory so it doesn't go on the stack
+	static chip8::Chip8 emulator;
+	emulator.reset(chip8::Platform::chip8);
+	bool romLoaded = false;
+
+	RecompiledPlugins recompiledPlugins;
+
+	chip8::RomInfo currentRom;
+	MovieSession movieSession;
+
+	chip8::Netplay netplay;
+	chip8::Broadcaster broadcaster;
+	chip8::Spectator spectator;
+
+	//mygame [rom] [--vip] [--record movie.c8m] [--replay movie.c8m] [--host port] [--join address:port]
+	//       [--broadcast port] [--watch address:port]
+	const char *romPath = nullptr;
+	const char *recordPath = nullptr;
+	const char *replayPath = nullptr;
+	const char *hostPort = nullptr;
+	const char *joinAddress = nullptr;
+	const char *broadcastPort = nullptr;
+	const char *watchAddress = nullptr;
+	bool vipTiming = false;
+	for (int i = 1; i < argc; i++)
+	{
+		if (!std::strcmp(argv[i], "--record") && i + 1 < argc) { recordPath = argv[++i]; }
+		else if (!std::strcmp(argv[i], "--replay") && i + 1 < argc) { replayPath = argv[++i]; }
+		else if (!std::strcmp(argv[i], "--vip")) { vipTiming = true; }
+		else if (!std::strcmp(argv[i], "--host") && i + 1 < argc) { hostPort = argv[++i]; }
+		else if (!std::strcmp(argv[i], "--join") && i + 1 < argc) { joinAddress = argv[++i]; }
+		else if (!std::strcmp(argv[i], "--broadcast") && i + 1 < argc) { broadcastPort = argv[++i]; }
+		else if (!std::strcmp(argv[i], "--watch") && i + 1 < argc) { watchAddress = argv[++i]; }
+		else { romPath = argv[i]; }
+	}
+
+	RomBrowser romBrowser;
+	romBrowser.create(romLibraryPath);
+	if (romPath)
+	{
+		romLoaded = loadRom(emulator, romBrowser.library, recompiledPlugins, romPath, currentRom);
+		if (vipTiming) { emulator.timing = chip8::Timing::cosmacVip; }
+	}
+
+	if (romLoaded && replayPath) { movieSession.startReplay(emulator, currentRom, replayPath); }
+	else if (romLoaded && recordPath) { movieSession.startRecording(emulator, currentRom, recordPath); }
+	else if (romLoaded && (hostPort || joinAddress)) { startNetplay(netplay, emulator, currentRom, hostPort, joinAddress); }
+
+	//the spectators get the frames played here from now on, not the netplay ones since those can be rolled back
+	if (broadcastPort && !broadcaster.start(emulator, (std::uint16_t)std::atoi(broadcastPort)))
+	{
+		std::cerr << "Can't broadcast on port " << broadcastPort << std::endl;
+	}
+
+	//watching needs no rom, the display comes from the broadcaster
+	std::string watchHost;
+	std::uint16_t watchPort = 0;
+	if (watchAddress && (!splitAddress(watchAddress, watchHost, watchPort) || !spectator.join(watchHost.c_str(), watchPort)))
+	{
+		std::cerr << "Can't watch " << watchAddress << std::endl;
+	}
+	bool watching = spectator.status != chip8::Spectator::idle;
+
+	DisplayPresenter displayPresenter;
+	displayPresenter.create();
+
+	ProfilerOverlay profiler;
+
+	DebuggerWindow debuggerWindow;
+	TraceWindow traceWindow;
+	DisassemblyWindow disassemblyWindow;
+	MemoryHeatWindow memoryHeatWindow;
+	RomProfilerWindow romProfilerWindow;
+
+	Uint64 lastTime = SDL_GetPerformanceCounter();
+	const float emulatorFrameTime = 1.f / 60.f;
+	float emulatorTimeAccumulator = 0;
+
 	// Main event loop
 	bool running = true;
 	while (running)
 	{
+		Uint64 time = SDL_GetPerformanceCounter();
+		float deltaTime = (float)(time - lastTime) / (float)SDL_GetPerformanceFrequency();
+		lastTime = time;
+
 		int w = 0, h = 0;
 		SDL_GetWindowSize(window, &w, &h);
 
@@ -138,21 +366,101 @@ int main(int argc, char *argv[])
 
 		glClear(GL_COLOR_BUFFER_BIT);
 
+		profiler.frameTime = deltaTime;
+		profiler.emulatedFrames = 0;
+		profiler.instructions = 0;
 
-		// Example ImGui window
-		ImGui::Begin("Test Window");
-		
-		ImGui::Text("Hello, world!");
-		ImGui::Button("I am Pressy the button!");
-		float values[5] = {0.5, 0.4, 0.3, 0.56, 0.46};
-		ImGui::PlotHistogram("I am a plot!", values, 5);
-		
-		ImGui::End();
+		if (netplay.status != chip8::Netplay::idle) { netplay.poll(); }
 
+		//the rolled back frames of netplay would stop at the breakpoints again
+		emulator.debugger = netplay.status == chip8::Netplay::idle ? &debuggerWindow.debugger : nullptr;
+		broadcaster.poll();
+		spectator.poll();
 
-		// testing opengl
-		renderer2d.renderRectangle({100, 100, 100, 100}, Colors_Orange);
-		renderer2d.flush();
+		auto runEmulatorFrame = [&]()
+		{
+			//netplay runs its own frames, the rolled back ones included
+			if (netplay.status != chip8::Netplay::idle)
+			{
+				if (netplay.advance(readKeypad())) { profiler.emulatedFrames++; }
+				return;
+			}
+
+			if (!debuggerWindow.running()) { return; }
+
+			//a frame the debugger stopped keeps its keys, movies and the history replay it with those
+			if (!emulator.midFrame())
+			{
+				emulator.setKeys(movieSession.frameKeys(readKeypad()));
+				debuggerWindow.history.beginFrame(emulator);
+			}
+			profiler.instructions += emulator.runFrame();
+
+			//the debugger stopped it, the frame ends when it continues
+			if (emulator.midFrame()) { return; }
+
+			profiler.emulatedFrames++;
+			movieSession.endFrame(emulator, emulator.state.keys);
+			broadcaster.endFrame(emulator.state.keys);
+		};
+
+		if (romLoaded && movieSession.unthrottled())
+		{
+			//replays run as fast as they can, but only for a part of the host frame so the window stays responsive
+			Uint64 replayStart = SDL_GetPerformanceCounter();
+			Uint64 replayBudget = SDL_GetPerformanceFrequency() / 100;
+			while (movieSession.unthrottled() && debuggerWindow.running() &&
+				SDL_GetPerformanceCounter() - replayStart < replayBudget)
+			{
+				runEmulatorFrame();
+			}
+			emulatorTimeAccumulator = 0;
+		}
+		else
+		{
+			//the emulator runs at 60 fps no matter the refresh rate,
+			//at most a few frames are caught up so a hitch doesn't snowball
+			emulatorTimeAccumulator = std::min(emulatorTimeAccumulator + deltaTime, emulatorFrameTime * 4);
+			while (emulatorTimeAccumulator >= emulatorFrameTime)
+			{
+				emulatorTimeAccumulator -= emulatorFrameTime;
+				if (romLoaded && !watching) { runEmulatorFrame(); }
+			}
+		}
+
+		if (watching) { displayPresenter.update(spectator.display(), spectator.takeDirtyRows(), deltaTime); }
+		else { displayPresenter.update(emulator.state.display, emulator.takeDirtyRows(), deltaTime); }
+		displayPresenter.render(renderer2d, displayPresenter.fitRect({0, 0, w, h}));
+
+		profiler.uploadedBytesThisFrame = displayPresenter.uploadStats.bytesThisFrame;
+		profiler.uploadedRowsThisFrame = displayPresenter.uploadStats.rowsThisFrame;
+		profiler.totalUploadedBytes = displayPresenter.uploadStats.totalBytes;
+		profiler.skippedUploads = displayPresenter.uploadStats.skippedFrames;
+		profiler.endFrame();
+		profiler.render();
+
+		std::string pickedRom;
+		if (romBrowser.render(pickedRom))
+		{
+			if (movieSession.mode == MovieSession::recording) { movieSession.stopRecording(); }
+			movieSession.mode = MovieSession::none;
+			netplay.close();
+			netplay.status = chip8::Netplay::idle;
+			romLoaded = loadRom(emulator, romBrowser.library, recompiledPlugins, pickedRom.c_str(), currentRom);
+			if (vipTiming) { emulator.timing = chip8::Timing::cosmacVip; }
+			disassemblyWindow.clear();
+		}
+
+		movieSession.render(emulator, romLoaded ? &currentRom : nullptr);
+		if (netplay.status != chip8::Netplay::idle) { renderNetplay(netplay); }
+		if (romLoaded && !watching && netplay.status == chip8::Netplay::idle)
+		{
+			debuggerWindow.render(emulator, movieSession.mode == MovieSession::none && !broadcaster.active());
+			traceWindow.render(debuggerWindow.debugger);
+			disassemblyWindow.render(emulator, debuggerWindow.debugger);
+			memoryHeatWindow.render(emulator, debuggerWindow.debugger);
+			romProfilerWindow.render(emulator, debuggerWindow.debugger);
+		}
 
 
 	#pragma region imgui
@@ -173,6 +481,14 @@ int main(int argc, char *argv[])
 		SDL_GL_SwapWindow(window);
 	}
 
+	if (movieSession.mode == MovieSession::recording) { movieSession.stopRecording(); }
+	romBrowser.cleanup();
+	emulator.compiled = nullptr;
+	recompiledPlugins.cleanup();
+	displayPresenter.cleanup();
+	memoryHeatWindow.cleanup();
+	renderer2d.cleanup();
+
 	// Cleanup ImGui
 	ImGui_ImplOpenGL3_Shutdown();
 	ImGui_ImplSDL2_Shutdown();
@@ -0,0 +1,111 @@
+#include "memoryHeatWindow.h"
+#include "imgui.h"
+#include <algorithm>
+
+//brightness by the bit length of the counter, so 1 hit and 60000 both show
+static std::uint8_t heatLevel(std::uint16_t count)
+{
+	if (!count) { return 0; }
+	int bits = 0;
+	while (count >> bits) { bits++; }
+	return (std::uint8_t)std::min(255, 60 + bits * 12);
+}
+
+void MemoryHeatWindow::cleanup()
+{
+	if (texture.id)
+	{
+		texture.cleanup();
+		texture.id = 0;
+	}
+	textureWidth = 0;
+	textureHeight = 0;
+}
+
+void MemoryHeatWindow::render(const chip8::Chip8 &emulator, chip8::Debugger &debugger)
+{
+	if (!show) { return; }
+
+	if (!ImGui::Begin("Memory heat", &show))
+	{
+		ImGui::End();
+		return;
+	}
+
+	bool collecting = debugger.heat != nullptr;
+	if (ImGui::Checkbox("Collect", &collecting))
+	{
+		if (collecting && !heat) { heat = std::make_unique<chip8::MemoryHeat>(); }
+		debugger.heat = collecting ? heat.get() : nullptr;
+	}
+
+	if (!heat)
+	{
+		ImGui::End();
+		return;
+	}
+
+	ImGui::SameLine();
+	if (ImGui::Button("Clear")) { heat->clear(); }
+	ImGui::SameLine();
+	ImGui::Checkbox("Fade", &fade);
+	ImGui::SameLine();
+	ImGui::PushItemWidth(80);
+	ImGui::SliderInt("##fade", &fadeShift, 1, 8, "1/%d");
+	ImGui::PopItemWidth();
+	ImGui::TextColored({1, 0.3f, 0.3f, 1}, "write");
+	ImGui::SameLine();
+	ImGui::TextColored({0.3f, 1, 0.3f, 1}, "execute");
+	ImGui::SameLine();
+	ImGui::TextColored({0.4f, 0.5f, 1, 1}, "read");
+
+	//64 bytes a row for 4 KB, 256 for 64 KB, square either way
+	const int bytes = (int)emulator.memoryMask + 1;
+	const int width = bytes > 0x1000 ? 256 : 64;
+	const int height = bytes / width;
+
+	pixels.resize((std::size_t)bytes);
+	const std::uint16_t *reads = heat->plane(chip8::MemoryHeat::read);
+	const std::uint16_t *writes = heat->plane(chip8::MemoryHeat::write);
+	const std::uint16_t *executes = heat->plane(chip8::MemoryHeat::execute);
+	for (int a = 0; a < bytes; a++)
+	{
+		//RGBA in memory order
+		pixels[a] = (std::uint32_t)heatLevel(writes[a]) | (std::uint32_t)heatLevel(executes[a]) << 8 |
+			(std::uint32_t)heatLevel(reads[a]) << 16 | 0xFF000000u;
+	}
+
+	if (width != textureWidth || height != textureHeight)
+	{
+		cleanup();
+		texture.createFromBuffer((const char *)pixels.data(), width, height, true, false);
+		textureWidth = width;
+		textureHeight = height;
+	}
+	else
+	{
+		texture.bind();
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+		texture.unbind();
+	}
+
+	//the map shows what the frames since the last one did, then it fades, but not while stopped
+	if (fade && debugger.heat && !debugger.stopped()) { heat->decay(fadeShift); }
+
+	ImVec2 available = ImGui::GetContentRegionAvail();
+	float scale = std::max(1.f, std::min(available.x / width, available.y / height));
+	ImVec2 origin = ImGui::GetCursorScreenPos();
+	ImGui::Image((ImTextureID)(std::intptr_t)texture.id, ImVec2(width * scale, height * scale));
+
+	if (ImGui::IsItemHovered())
+	{
+		ImVec2 mouse = ImGui::GetIO().MousePos;
+		int x = std::clamp((int)((mouse.x - origin.x) / scale), 0, width - 1);
+		int y = std::clamp((int)((mouse.y - origin.y) / scale), 0, height - 1);
+		int address = y * width + x;
+		ImGui::SetTooltip("%03X: %02X\nread %u\nwritten %u\nexecuted %u", address, emulator.state.memory[address],
+			reads[address], writes[address], executes[address]);
+	}
+
+	ImGui::End();
+}
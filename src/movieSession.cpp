@@ -0,0 +1,141 @@
+#include "movieSession.h"
+#include "imgui.h"
+#include <chip8/mappedFile.h>
+
+//loads the rom again after a reset, the recompiled code stays if the settings didn't change
+static bool restartRom(chip8::Chip8 &emulator, const chip8::RomInfo &rom,
+	chip8::Platform platform, chip8::Quirks quirks, int instructionsPerFrame, chip8::Timing timing, std::uint32_t seed)
+{
+	chip8::MappedFile file;
+	if (!file.open(rom.path.c_str())) { return false; }
+
+	chip8::CompiledRunner compiled = emulator.compiled;
+	bool sameSettings = platform == emulator.platform && chip8::quirksToBits(quirks) == chip8::quirksToBits(emulator.quirks);
+
+	emulator.reset(platform, quirks, seed);
+	emulator.instructionsPerFrame = instructionsPerFrame;
+	emulator.timing = timing;
+	if (sameSettings) { emulator.compiled = compiled; }
+
+	return emulator.loadRom(file.data, file.size);
+}
+
+bool MovieSession::startRecording(chip8::Chip8 &emulator, const chip8::RomInfo &rom, const std::string &path)
+{
+	if (!restartRom(emulator, rom, emulator.platform, emulator.quirks, emulator.instructionsPerFrame, emulator.timing, emulator.seed))
+	{
+		status = "Can't read the rom";
+		mode = none;
+		return false;
+	}
+
+	movie.begin(emulator, rom.hash);
+	moviePath = path;
+	mode = recording;
+	status = "Recording";
+	return true;
+}
+
+bool MovieSession::stopRecording()
+{
+	if (mode != recording) { return false; }
+	mode = none;
+
+	if (!movie.save(moviePath.c_str()))
+	{
+		status = "Can't write " + moviePath;
+		return false;
+	}
+
+	status = "Saved " + std::to_string(movie.frameCount) + " frames to " + moviePath;
+	return true;
+}
+
+bool MovieSession::startReplay(chip8::Chip8 &emulator, const chip8::RomInfo &rom, const std::string &path)
+{
+	if (mode == recording) { stopRecording(); }
+	mode = none;
+
+	if (!movie.load(path.c_str()))
+	{
+		status = "Can't read movie " + path;
+		return false;
+	}
+
+	if (movie.romHash != rom.hash)
+	{
+		status = "The movie was recorded with another rom";
+		return false;
+	}
+
+	if (!restartRom(emulator, rom, movie.platform, movie.quirks, movie.instructionsPerFrame, movie.timing, movie.seed))
+	{
+		status = "Can't read the rom";
+		return false;
+	}
+
+	moviePath = path;
+	player.start(movie);
+	mode = playing;
+	status = "Playing";
+	return true;
+}
+
+void MovieSession::endFrame(const chip8::Chip8 &emulator, std::uint16_t keys)
+{
+	if (mode == recording)
+	{
+		movie.recordFrame(keys, chip8::hashState(emulator.state));
+	}
+	else if (mode == playing)
+	{
+		if (!player.endFrame(chip8::hashState(emulator.state)))
+		{
+			status = "Desync at frame " + std::to_string(player.desyncFrame);
+			mode = none;
+		}
+		else if (player.finished())
+		{
+			status = "Replay of " + std::to_string(movie.frameCount) + " frames matches";
+			mode = none;
+		}
+	}
+}
+
+void MovieSession::render(chip8::Chip8 &emulator, const chip8::RomInfo *rom)
+{
+	if (!show) { return; }
+
+	if (!ImGui::Begin("Movie", &show))
+	{
+		ImGui::End();
+		return;
+	}
+
+	if (!rom)
+	{
+		ImGui::TextUnformatted("No rom loaded");
+	}
+	else if (mode == recording)
+	{
+		if (ImGui::Button("Stop")) { stopRecording(); }
+		ImGui::SameLine();
+		ImGui::Text("Recording frame %u", movie.frameCount);
+	}
+	else if (mode == playing)
+	{
+		if (ImGui::Button("Stop")) { mode = none; status = "Stopped"; }
+		ImGui::SameLine();
+		ImGui::Text("Frame %u / %u", player.frame, movie.frameCount);
+	}
+	else
+	{
+		if (ImGui::Button("Record")) { startRecording(emulator, *rom, defaultPath(*rom)); }
+		ImGui::SameLine();
+		if (ImGui::Button("Replay")) { startReplay(emulator, *rom, defaultPath(*rom)); }
+	}
+
+	if (!status.empty()) { ImGui::TextUnformatted(status.c_str()); }
+
+	ImGui::End();
+}
@@ -0,0 +1,39 @@
+#include "profilerOverlay.h"
+#include "imgui.h"
+#include <algorithm>
+
+void ProfilerOverlay::endFrame()
+{
+	frameTimes[historyPosition] = frameTime * 1000.f;
+	uploadedBytes[historyPosition] = (float)uploadedBytesThisFrame;
+	historyPosition = (historyPosition + 1) % historySize;
+}
+
+void ProfilerOverlay::render()
+{
+	if (!show) { return; }
+
+	if (!ImGui::Begin("Profiler", &show))
+	{
+		ImGui::End();
+		return;
+	}
+
+	ImGui::Text("Frame: %.2f ms (%.0f fps)", frameTime * 1000.f, frameTime > 0 ? 1.f / frameTime : 0.f);
+	ImGui::PlotLines("##frameTimes", frameTimes, historySize, historyPosition, "frame time (ms)",
+		0.f, 40.f, ImVec2(0, 50));
+
+	ImGui::Separator();
+	ImGui::Text("Emulated frames: %d", emulatedFrames);
+	ImGui::Text("Instructions: %d", instructions);
+
+	ImGui::Separator();
+	ImGui::Text("Display upload: %d bytes (%d rows)", uploadedBytesThisFrame, uploadedRowsThisFrame);
+	float maxBytes = *std::max_element(uploadedBytes, uploadedBytes + historySize);
+	ImGui::PlotHistogram("##uploadedBytes", uploadedBytes, historySize, historyPosition, "bytes uploaded",
+		0.f, std::max(maxBytes, 1.f), ImVec2(0, 50));
+	ImGui::Text("Total uploaded: %llu bytes", (unsigned long long)totalUploadedBytes);
+	ImGui::Text("Frames without upload: %llu", (unsigned long long)skippedUploads);
+
+	ImGui::End();
+}
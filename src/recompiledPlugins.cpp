@@ -0,0 +1,64 @@
+#include "recompiledPlugins.h"
+#include <SDL2/SDL.h>
+#include <cctype>
+
+//the same name cmake gives the plugin with MAKE_C_IDENTIFIER
+static std::string pluginName(const std::string &romPath)
+{
+	std::size_t slash = romPath.find_last_of("/\\");
+	std::string name = romPath.substr(slash == std::string::npos ? 0 : slash + 1);
+	name = name.substr(0, name.find('.'));
+
+	for (char &c : name)
+	{
+		if (!std::isalnum((unsigned char)c)) { c = '_'; }
+	}
+	if (!name.empty() && std::isdigit((unsigned char)name[0])) { name = "_" + name; }
+
+#ifdef _WIN32
+	return "chip8rom_" + name + ".dll";
+#else
+	return "chip8rom_" + name + ".so";
+#endif
+}
+
+const chip8::RecompiledRom *RecompiledPlugins::find(const std::string &romPath, std::uint64_t romHash,
+	chip8::Platform platform, const chip8::Quirks &quirks)
+{
+	std::string name = pluginName(romPath);
+
+	auto found = loaded.find(name);
+	if (found == loaded.end())
+	{
+		char *basePath = SDL_GetBasePath();
+		std::string path = (basePath ? basePath : "") + name;
+		SDL_free(basePath);
+
+		void *handle = SDL_LoadObject(path.c_str());
+		found = loaded.emplace(name, handle).first;
+	}
+
+	if (!found->second) { return nullptr; }
+
+	auto get = (chip8::GetRecompiledRom)SDL_LoadFunction(found->second, CHIP8_RECOMPILED_ROM_ENTRY);
+	if (!get) { return nullptr; }
+
+	const chip8::RecompiledRom *rom = get();
+	if (!rom || rom->abiVersion != chip8::recompiledAbiVersion || rom->stateSize != sizeof(chip8::State)) { return nullptr; }
+
+	if (rom->romHash != romHash || rom->platform != platform || rom->quirks != chip8::quirksToBits(quirks))
+	{
+		return nullptr;
+	}
+
+	return rom;
+}
+
+void RecompiledPlugins::cleanup()
+{
+	for (auto &plugin : loaded)
+	{
+		if (plugin.second) { SDL_UnloadObject(plugin.second); }
+	}
+	loaded.clear();
+}
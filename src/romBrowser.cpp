@@ -0,0 +1,184 @@
+#include "romBrowser.h"
+#include <algorithm>
+#include <cctype>
+#include <string_view>
+
+static std::string_view fileName(const std::string &path)
+{
+	std::size_t slash = path.find_last_of('/');
+	return slash == std::string::npos ? std::string_view(path) : std::string_view(path).substr(slash + 1);
+}
+
+static bool containsNoCase(std::string_view text, std::string_view part)
+{
+	auto found = std::search(text.begin(), text.end(), part.begin(), part.end(),
+		[](char a, char b) { return std::tolower((unsigned char)a) == std::tolower((unsigned char)b); });
+	return found != text.end();
+}
+
+void RomBrowser::create(const char *indexPath)
+{
+	this->indexPath = indexPath;
+	library.load(indexPath);
+
+	folderPicker.SetTitle("Add rom folder");
+
+	if (!library.folders.empty()) { scanner.start(library, library.folders); }
+}
+
+void RomBrowser::cleanup()
+{
+	scanner.stop();
+	if (library.modified) { library.save(indexPath.c_str()); }
+}
+
+void RomBrowser::addFolder(const std::string &folder)
+{
+	std::string normalized = chip8::RomLibrary::normalizePath(folder.c_str());
+	if (std::find(library.folders.begin(), library.folders.end(), normalized) != library.folders.end()) { return; }
+
+	library.folders.push_back(normalized);
+	library.modified = true;
+	scanner.start(library, library.folders);
+}
+
+void RomBrowser::removeFolder(int index)
+{
+	std::string folder = library.folders[index];
+	if (folder.back() != '/') { folder += '/'; }
+
+	library.folders.erase(library.folders.begin() + index);
+	library.removeUnder(folder);
+	library.modified = true;
+	visibleDirty = true;
+
+	scanner.stop();
+	if (!library.folders.empty()) { scanner.start(library, library.folders); }
+}
+
+void RomBrowser::rebuildVisible()
+{
+	visibleDirty = false;
+	visible.clear();
+
+	std::string_view part = filter;
+	for (int i = 0; i < (int)library.roms.size(); i++)
+	{
+		if (part.empty() || containsNoCase(fileName(library.roms[i].path), part))
+		{
+			visible.push_back(i);
+		}
+	}
+
+	std::sort(visible.begin(), visible.end(), [&](int a, int b)
+	{
+		return fileName(library.roms[a].path) < fileName(library.roms[b].path);
+	});
+}
+
+bool RomBrowser::render(std::string &pickedPath)
+{
+	//the results are applied even when the window is hidden so the index stays current
+	if (scanner.poll(library)) { visibleDirty = true; }
+	if (library.modified && !scanner.scanning()) { library.save(indexPath.c_str()); }
+
+	if (!show) { return false; }
+
+	bool picked = false;
+
+	if (ImGui::Begin("Library", &show))
+	{
+		if (ImGui::Button("Add folder")) { folderPicker.Open(); }
+		ImGui::SameLine();
+		if (ImGui::Button("Rescan") && !library.folders.empty()) { scanner.start(library, library.folders); }
+		ImGui::SameLine();
+
+		if (scanner.scanning())
+		{
+			ImGui::Text("Scanning: %d found, %d hashed", scanner.filesFound.load(), scanner.filesHashed.load());
+		}
+		else
+		{
+			ImGui::Text("%d roms%s", (int)library.roms.size(), scanner.watching() ? ", watching for changes" : "");
+		}
+
+		if (ImGui::CollapsingHeader("Folders"))
+		{
+			for (int i = 0; i < (int)library.folders.size(); i++)
+			{
+				ImGui::PushID(i);
+				bool remove = ImGui::SmallButton("x");
+				ImGui::SameLine();
+				ImGui::TextUnformatted(library.folders[i].c_str());
+				ImGui::PopID();
+
+				if (remove)
+				{
+					removeFolder(i);
+					break;
+				}
+			}
+		}
+
+		if (ImGui::InputTextWithHint("##filter", "filter", filter, sizeof(filter))) { visibleDirty = true; }
+		if (visibleDirty) { rebuildVisible(); }
+
+		const ImGuiTableFlags tableFlags = ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY |
+			ImGuiTableFlags_Resizable | ImGuiTableFlags_BordersOuter;
+		if (ImGui::BeginTable("roms", 3, tableFlags))
+		{
+			ImGui::TableSetupScrollFreeze(0, 1);
+			ImGui::TableSetupColumn("Name", ImGuiTableColumnFlags_WidthStretch);
+			ImGui::TableSetupColumn("Platform", ImGuiTableColumnFlags_WidthFixed);
+			ImGui::TableSetupColumn("Size", ImGuiTableColumnFlags_WidthFixed);
+			ImGui::TableHeadersRow();
+
+			//there can be thousands of roms, only the visible rows are submitted
+			ImGuiListClipper clipper;
+			clipper.Begin((int)visible.size());
+			while (clipper.Step())
+			{
+				for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++)
+				{
+					const chip8::RomInfo &info = library.roms[visible[row]];
+					std::string_view name = fileName(info.path);
+
+					ImGui::TableNextRow();
+					ImGui::TableNextColumn();
+					ImGui::PushID(row);
+					ImGui::Selectable("##rom", false, ImGuiSelectableFlags_SpanAllColumns | ImGuiSelectableFlags_AllowDoubleClick);
+					if (ImGui::IsItemHovered())
+					{
+						ImGui::SetTooltip("%s\n%016llx", info.path.c_str(), (unsigned long long)info.hash);
+						if (ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left))
+						{
+							pickedPath = info.path;
+							picked = true;
+						}
+					}
+					ImGui::PopID();
+					ImGui::SameLine();
+					ImGui::TextUnformatted(name.data(), name.data() + name.size());
+
+					ImGui::TableNextColumn();
+					ImGui::TextUnformatted(chip8::platformName(info.platform));
+
+					ImGui::TableNextColumn();
+					ImGui::Text("%llu", (unsigned long long)info.size);
+				}
+			}
+
+			ImGui::EndTable();
+		}
+	}
+	ImGui::End();
+
+	folderPicker.Display();
+	if (folderPicker.HasSelected())
+	{
+		addFolder(folderPicker.GetSelected().generic_u8string());
+		folderPicker.ClearSelected();
+	}
+
+	return picked;
+}
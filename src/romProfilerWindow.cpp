@@ -0,0 +1,243 @@
+#include "romProfilerWindow.h"
+#include <chip8/disassembly.h>
+#include "imgui.h"
+#include <algorithm>
+
+static double percent(std::uint64_t part, std::uint64_t total)
+{
+	return total ? 100.0 * (double)part / (double)total : 0;
+}
+
+//the column and direction of the table, false when it doesn't sort
+static bool sortSpec(int &column, bool &descending)
+{
+	ImGuiTableSortSpecs *specs = ImGui::TableGetSortSpecs();
+	if (!specs || !specs->SpecsCount) { return false; }
+	column = specs->Specs[0].ColumnIndex;
+	descending = specs->Specs[0].SortDirection == ImGuiSortDirection_Descending;
+	return true;
+}
+
+//sorts by the key of the column, the first column breaks the ties
+template<class T, class Key>
+static void sortRows(std::vector<T> &rows, bool descending, Key key)
+{
+	std::stable_sort(rows.begin(), rows.end(), [&](const T &a, const T &b)
+	{
+		return descending ? key(b) < key(a) : key(a) < key(b);
+	});
+}
+
+void RomProfilerWindow::render(const chip8::Chip8 &emulator, chip8::Debugger &debugger)
+{
+	if (!show) { return; }
+
+	if (!ImGui::Begin("Profiler", &show))
+	{
+		ImGui::End();
+		return;
+	}
+
+	bool profiling = debugger.profiler != nullptr;
+	if (ImGui::Checkbox("Profile", &profiling))
+	{
+		if (profiling && !profiler) { profiler = std::make_unique<chip8::RomProfiler>(); }
+		debugger.profiler = profiling ? profiler.get() : nullptr;
+	}
+
+	if (!profiler)
+	{
+		ImGui::End();
+		return;
+	}
+
+	ImGui::SameLine();
+	if (ImGui::Button("Clear")) { profiler->clear(); }
+	ImGui::SameLine();
+	if (ImGui::Button("Save stacks"))
+	{
+		status = profiler->saveCollapsedStacks("profile.folded", false) &&
+			profiler->saveCollapsedStacks("profile-time.folded", true) ?
+			"saved profile.folded and profile-time.folded" : "couldn't write profile.folded";
+	}
+	ImGui::SameLine();
+	const std::uint64_t total = profiler->totalInstructions();
+	ImGui::Text("%llu instructions %s", (unsigned long long)total, status);
+
+	const ImGuiTableFlags flags = ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersV |
+		ImGuiTableFlags_Sortable | ImGuiTableFlags_Resizable;
+	int column = 0;
+	bool descending = false;
+
+	if (ImGui::BeginTabBar("profile"))
+	{
+		if (ImGui::BeginTabItem("Subroutines"))
+		{
+			if (ImGui::BeginTable("subroutines", 6, flags))
+			{
+				ImGui::TableSetupScrollFreeze(0, 1);
+				ImGui::TableSetupColumn("Address");
+				ImGui::TableSetupColumn("Calls");
+				ImGui::TableSetupColumn("Self");
+				ImGui::TableSetupColumn("Self %");
+				ImGui::TableSetupColumn("Total", ImGuiTableColumnFlags_DefaultSort | ImGuiTableColumnFlags_PreferSortDescending);
+				ImGui::TableSetupColumn("Total ms");
+				ImGui::TableHeadersRow();
+
+				//a few hundred at most, made again every frame
+				functions = profiler->functions();
+				if (sortSpec(column, descending))
+				{
+					using Function = chip8::RomProfiler::Function;
+					switch (column)
+					{
+					case 0: sortRows(functions, descending, [](const Function &f) { return f.address; }); break;
+					case 1: sortRows(functions, descending, [](const Function &f) { return f.calls; }); break;
+					case 2: case 3: sortRows(functions, descending, [](const Function &f) { return f.self.instructions; }); break;
+					case 4: sortRows(functions, descending, [](const Function &f) { return f.total.instructions; }); break;
+					case 5: sortRows(functions, descending, [](const Function &f) { return f.total.nanoseconds; }); break;
+					}
+				}
+
+				for (const chip8::RomProfiler::Function &function : functions)
+				{
+					ImGui::TableNextRow();
+					ImGui::TableNextColumn();
+					if (function.root) { ImGui::Text("main"); }
+					else { ImGui::Text("sub_%03X", function.address); }
+					ImGui::TableNextColumn();
+					ImGui::Text("%llu", (unsigned long long)function.calls);
+					ImGui::TableNextColumn();
+					ImGui::Text("%llu", (unsigned long long)function.self.instructions);
+					ImGui::TableNextColumn();
+					ImGui::Text("%.1f", percent(function.self.instructions, total));
+					ImGui::TableNextColumn();
+					ImGui::Text("%llu (%.1f%%)", (unsigned long long)function.total.instructions, percent(function.total.instructions, total));
+					ImGui::TableNextColumn();
+					ImGui::Text("%.3f", function.total.nanoseconds / 1e6);
+				}
+				ImGui::EndTable();
+			}
+			ImGui::EndTabItem();
+		}
+
+		if (ImGui::BeginTabItem("Addresses"))
+		{
+			if (ImGui::BeginTable("addresses", 5, flags))
+			{
+				ImGui::TableSetupScrollFreeze(0, 1);
+				ImGui::TableSetupColumn("Address");
+				ImGui::TableSetupColumn("Instruction", ImGuiTableColumnFlags_NoSort);
+				ImGui::TableSetupColumn("Count", ImGuiTableColumnFlags_DefaultSort | ImGuiTableColumnFlags_PreferSortDescending);
+				ImGui::TableSetupColumn("%");
+				ImGui::TableSetupColumn("ms");
+				ImGui::TableHeadersRow();
+
+				addresses.clear();
+				for (std::uint32_t address = 0; address <= emulator.memoryMask; address++)
+				{
+					if (profiler->address((std::uint16_t)address).instructions) { addresses.push_back((std::uint16_t)address); }
+				}
+				if (sortSpec(column, descending))
+				{
+					const chip8::RomProfiler &p = *profiler;
+					switch (column)
+					{
+					case 0: sortRows(addresses, descending, [](std::uint16_t a) { return a; }); break;
+					case 2: case 3: sortRows(addresses, descending, [&](std::uint16_t a) { return p.address(a).instructions; }); break;
+					case 4: sortRows(addresses, descending, [&](std::uint16_t a) { return p.address(a).nanoseconds; }); break;
+					}
+				}
+
+				//only the rows on screen are disassembled
+				ImGuiListClipper clipper;
+				clipper.Begin((int)addresses.size());
+				while (clipper.Step())
+				{
+					for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++)
+					{
+						const std::uint16_t address = addresses[row];
+						const chip8::RomProfiler::Counter &counter = profiler->address(address);
+						const std::uint8_t *bytes = emulator.state.memory;
+						const std::uint32_t mask = emulator.memoryMask;
+						const std::uint16_t opcode = (std::uint16_t)(bytes[address] << 8 | bytes[(address + 1) & mask]);
+						const std::uint16_t operand = (std::uint16_t)(bytes[(address + 2) & mask] << 8 | bytes[(address + 3) & mask]);
+						char text[48];
+						chip8::disassembleInstruction(opcode, operand, nullptr, text, sizeof(text));
+
+						ImGui::TableNextRow();
+						ImGui::TableNextColumn();
+						ImGui::Text("%03X", address);
+						ImGui::TableNextColumn();
+						ImGui::TextUnformatted(text);
+						ImGui::TableNextColumn();
+						ImGui::Text("%llu", (unsigned long long)counter.instructions);
+						ImGui::TableNextColumn();
+						ImGui::Text("%.1f", percent(counter.instructions, total));
+						ImGui::TableNextColumn();
+						ImGui::Text("%.3f", counter.nanoseconds / 1e6);
+					}
+				}
+				ImGui::EndTable();
+			}
+			ImGui::EndTabItem();
+		}
+
+		if (ImGui::BeginTabItem("Opcodes"))
+		{
+			if (ImGui::BeginTable("opcodes", 5, flags))
+			{
+				ImGui::TableSetupScrollFreeze(0, 1);
+				ImGui::TableSetupColumn("Opcode");
+				ImGui::TableSetupColumn("Count", ImGuiTableColumnFlags_DefaultSort | ImGuiTableColumnFlags_PreferSortDescending);
+				ImGui::TableSetupColumn("%");
+				ImGui::TableSetupColumn("ms");
+				ImGui::TableSetupColumn("ns each");
+				ImGui::TableHeadersRow();
+
+				opcodes.clear();
+				for (std::uint32_t kind = 0; kind < 0x10000; kind++)
+				{
+					if (profiler->opcode((std::uint16_t)kind).instructions) { opcodes.push_back((std::uint16_t)kind); }
+				}
+				if (sortSpec(column, descending))
+				{
+					const chip8::RomProfiler &p = *profiler;
+					auto each = [&](std::uint16_t k) { return p.opcode(k).nanoseconds / (double)p.opcode(k).instructions; };
+					switch (column)
+					{
+					case 0: sortRows(opcodes, descending, [](std::uint16_t k) { return k; }); break;
+					case 1: case 2: sortRows(opcodes, descending, [&](std::uint16_t k) { return p.opcode(k).instructions; }); break;
+					case 3: sortRows(opcodes, descending, [&](std::uint16_t k) { return p.opcode(k).nanoseconds; }); break;
+					case 4: sortRows(opcodes, descending, each); break;
+					}
+				}
+
+				for (std::uint16_t kind : opcodes)
+				{
+					const chip8::RomProfiler::Counter &counter = profiler->opcode(kind);
+					char name[8];
+					chip8::RomProfiler::opcodeKindName(kind, name);
+
+					ImGui::TableNextRow();
+					ImGui::TableNextColumn();
+					ImGui::TextUnformatted(name);
+					ImGui::TableNextColumn();
+					ImGui::Text("%llu", (unsigned long long)counter.instructions);
+					ImGui::TableNextColumn();
+					ImGui::Text("%.1f", percent(counter.instructions, total));
+					ImGui::TableNextColumn();
+					ImGui::Text("%.3f", counter.nanoseconds / 1e6);
+					ImGui::TableNextColumn();
+					ImGui::Text("%.1f", counter.nanoseconds / (double)counter.instructions);
+				}
+				ImGui::EndTable();
+			}
+			ImGui::EndTabItem();
+		}
+
+		ImGui::EndTabBar();
+	}
+
+	ImGui::End();
+}
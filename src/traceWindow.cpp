@@ -0,0 +1,74 @@
+#include "traceWindow.h"
+#include "imgui.h"
+
+void TraceWindow::render(chip8::Debugger &debugger)
+{
+	if (!show) { return; }
+
+	if (!ImGui::Begin("Trace", &show))
+	{
+		ImGui::End();
+		return;
+	}
+
+	bool recording = debugger.trace != nullptr;
+	if (ImGui::Checkbox("Record", &recording))
+	{
+		if (recording && !trace) { trace = std::make_unique<chip8::Trace>(); }
+		debugger.trace = recording ? trace.get() : nullptr;
+	}
+
+	if (!trace)
+	{
+		ImGui::End();
+		return;
+	}
+
+	ImGui::SameLine();
+	if (ImGui::Button("Clear")) { trace->clear(); }
+	ImGui::SameLine();
+	if (ImGui::Button("Save")) { status = trace->save("trace.c8t") ? "saved trace.c8t" : "couldn't write trace.c8t"; }
+	ImGui::SameLine();
+	ImGui::Checkbox("Follow", &follow);
+	ImGui::SameLine();
+	ImGui::Text("%llu instructions, %zu kept %s", (unsigned long long)trace->recorded(), trace->size(), status);
+
+	const ImGuiTableFlags flags = ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersV;
+	if (ImGui::BeginTable("trace", 5, flags))
+	{
+		ImGui::TableSetupScrollFreeze(0, 1);
+		ImGui::TableSetupColumn("#");
+		ImGui::TableSetupColumn("PC");
+		ImGui::TableSetupColumn("Opcode");
+		ImGui::TableSetupColumn("I");
+		ImGui::TableSetupColumn("Changed");
+		ImGui::TableHeadersRow();
+
+		//millions of rows, the clipper only hands out the visible ones
+		ImGuiListClipper clipper;
+		clipper.Begin((int)trace->size());
+		while (clipper.Step())
+		{
+			for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++)
+			{
+				const chip8::TraceEntry &entry = (*trace)[row];
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn();
+				ImGui::Text("%llu", (unsigned long long)(trace->first() + row));
+				ImGui::TableNextColumn();
+				ImGui::Text("%03X", entry.pc);
+				ImGui::TableNextColumn();
+				ImGui::Text("%04X", entry.opcode);
+				ImGui::TableNextColumn();
+				ImGui::Text("%03X", entry.i);
+				ImGui::TableNextColumn();
+				if (entry.changedRegister != chip8::traceNoRegister) { ImGui::Text("V%X = %02X", entry.changedRegister, entry.value); }
+			}
+		}
+
+		if (follow && debugger.trace) { ImGui::SetScrollHereY(1.f); }
+		ImGui::EndTable();
+	}
+
+	ImGui::End();
+}
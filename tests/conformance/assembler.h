@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <initializer_list>
+#include <map>
+#include <string>
+#include <vector>
+#include <chip8/chip8.h>
+
+//Just enough of an assembler to write the test roms in c++: raw opcodes plus labels
+//for the instructions that take an address (1NNN, 2NNN, ANNN, BNNN).
+struct Assembler
+{
+	std::vector<std::uint8_t> rom;
+
+	std::uint16_t here() const { return (std::uint16_t)(chip8::programStart + rom.size()); }
+
+	void op(std::uint16_t opcode)
+	{
+		rom.push_back((std::uint8_t)(opcode >> 8));
+		rom.push_back((std::uint8_t)opcode);
+	}
+
+	void bytes(std::initializer_list<std::uint8_t> data) { rom.insert(rom.end(), data); }
+
+	//pads with zeros up to an address
+	void org(std::uint16_t address)
+	{
+		if (address > here()) { rom.resize(address - chip8::programStart, 0); }
+	}
+
+	void label(const std::string &name) { labels[name] = here(); }
+
+	//an instruction with the address of a label in the low 12 bits, like op(0x1000) + "loop"
+	void op(std::uint16_t opcode, const std::string &target)
+	{
+		fixups.push_back({rom.size(), target});
+		op(opcode);
+	}
+
+	void jump(const std::string &target) { op(0x1000, target); }
+	void call(const std::string &target) { op(0x2000, target); }
+	void setI(const std::string &target) { op(0xA000, target); }
+
+	//resolves the labels, an unknown label is an empty rom so the test fails loudly
+	std::vector<std::uint8_t> finish()
+	{
+		for (const Fixup &fixup : fixups)
+		{
+			auto found = labels.find(fixup.label);
+			if (found == labels.end()) { return {}; }
+			rom[fixup.offset] |= (std::uint8_t)((found->second >> 8) & 0xF);
+			rom[fixup.offset + 1] = (std::uint8_t)found->second;
+		}
+		return rom;
+	}
+
+private:
+
+	struct Fixup
+	{
+		std::size_t offset = 0;
+		std::string label;
+	};
+
+	std::map<std::string, std::uint16_t> labels;
+	std::vector<Fixup> fixups;
+};
@@ -0,0 +1,166 @@
+#include "testRoms.h"
+#include "assembler.h"
+#include <chip8/romAnalyzer.h>
+#include <chip8/vipTiming.h>
+#include <cstdio>
+#include <memory>
+
+using namespace chip8;
+
+static int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+	if (!ok)
+	{
+		std::printf("FAIL %s\n", what);
+		failures++;
+	}
+}
+
+static RomAnalysis analyze(Assembler &a)
+{
+	std::vector<std::uint8_t> rom = a.finish();
+	return analyzeRom(rom.data(), rom.size());
+}
+
+//the quirks and platform the analyzer picks from what the code does
+static void checkAnalyzer()
+{
+	//8X06, the schip way of shifting VX in place
+	Assembler inPlace;
+	inPlace.op(0x6105); //V1 = 5
+	inPlace.op(0x6000); //V0 = 0
+	inPlace.op(0x8106); //V1 >>= 1
+	inPlace.label("end");
+	inPlace.jump("end");
+	std::vector<std::uint8_t> rom = inPlace.finish();
+	RomAnalysis analysis = analyzeRom(rom.data(), rom.size());
+	check(analysis.platform == Platform::chip8 && analysis.shiftsOtherRegister && !analysis.shiftsFromVy,
+		"analyzer: 8X06 is found");
+	check(analysis.quirks.shiftVx && !defaultQuirks(Platform::chip8).shiftVx, "analyzer: 8X06 picks the shift of VX");
+
+	//and the run does what the program means with them
+	auto emulator = std::make_unique<Chip8>();
+	emulator->reset(analysis.platform, analysis.quirks);
+	emulator->loadRom(rom.data(), rom.size());
+	emulator->runFrame();
+	check(emulator->state.v[1] == 2, "analyzer: 8X06 shifts VX with the picked quirks");
+
+	//8XY6 from another register, the original shift of VY
+	Assembler fromVy;
+	fromVy.op(0x6204);
+	fromVy.op(0x8126); //V1 = V2 >> 1
+	fromVy.op(0x8106);
+	fromVy.label("end");
+	fromVy.jump("end");
+	analysis = analyze(fromVy);
+	check(analysis.shiftsFromVy && !analysis.quirks.shiftVx, "analyzer: 8XY6 keeps the shift of VY");
+
+	//schip programs keep the quirk of schip
+	Assembler schip;
+	schip.op(0x00FF);
+	schip.op(0x8126);
+	schip.label("end");
+	schip.jump("end");
+	analysis = analyze(schip);
+	check(analysis.platform == Platform::schip && analysis.quirks.shiftVx, "analyzer: schip keeps its shift");
+
+	//FX55 at FFE writes past 0xFFF, only xo-chip has memory there
+	Assembler wraps;
+	wraps.op(0xAFFE);
+	wraps.op(0xF355);
+	wraps.label("end");
+	wraps.jump("end");
+	analysis = analyze(wraps);
+	check(analysis.indexWraps && analysis.usesHighMemory && analysis.platform == Platform::xoChip,
+		"analyzer: I past 0xFFF picks xo-chip");
+
+	//a sprite that ends right at 0xFFF doesn't wrap
+	Assembler fits;
+	fits.op(0xAFFB);
+	fits.op(0xD015);
+	fits.label("end");
+	fits.jump("end");
+	analysis = analyze(fits);
+	check(!analysis.indexWraps && analysis.platform == Platform::chip8, "analyzer: I up to 0xFFF stays chip8");
+
+	//I set behind a skip or moved by FX1E isn't known
+	Assembler unknown;
+	unknown.op(0x3000);
+	unknown.op(0xAFFE);
+	unknown.op(0xF355);
+	unknown.op(0xA100);
+	unknown.op(0xF01E);
+	unknown.op(0xD01F);
+	unknown.label("end");
+	unknown.jump("end");
+	analysis = analyze(unknown);
+	check(!analysis.indexWraps && analysis.platform == Platform::chip8, "analyzer: an unknown I isn't a wrap");
+}
+
+//The instructions in the frames of the VIP timing, against the cycles added up by hand.
+//A frame has vipCyclesPerFrame = 3668 - 1024 - 46 = 2598 cycles, every instruction 68 for the fetch and its own.
+static void checkVipTiming()
+{
+	static_assert(vipCyclesPerFrame == 2598, "the counts below are for 2598 cycles a frame");
+
+	auto emulator = std::make_unique<Chip8>();
+	auto start = [&](Assembler &a, Quirks quirks)
+	{
+		std::vector<std::uint8_t> rom = a.finish();
+		emulator->reset(Platform::chip8, quirks);
+		emulator->timing = Timing::cosmacVip;
+		emulator->loadRom(rom.data(), rom.size());
+	};
+	Quirks noWait = defaultQuirks(Platform::chip8);
+	noWait.displayWait = false;
+
+	//7001 costs 78 and 1200 80, 158 a pair: 16 pairs are 2528 cycles, the instruction that goes
+	//past the end of the frame still runs and its debt is taken from the next frame
+	Assembler loop;
+	loop.label("loop");
+	loop.op(0x7001);
+	loop.jump("loop");
+	start(loop, noWait);
+	int executed = emulator->runFrame();
+	check(executed == 33 && emulator->state.cycleBalance == 2598 - 16 * 158 - 78, "vip: the first frame, 33 instructions and 8 cycles owed");
+	executed = emulator->runFrame();
+	check(executed == 33 && emulator->state.cycleBalance == -8 + 2598 - 16 * 158 - 80, "vip: the debt is paid by the next frame");
+	executed = emulator->runFrame();
+	check(executed == 33 && emulator->state.cycleBalance == -18 + 2598 - 16 * 158 - 78, "vip: and the one after");
+	check(emulator->state.v[0] == 50, "vip: the loop ran as many times");
+
+	//DXYN is 26 and 14 a row, 34 a row when X isn't a multiple of 8, then jumps of 80 fill the frame
+	auto draw = [&](std::uint8_t x, Quirks quirks)
+	{
+		Assembler a;
+		a.op((std::uint16_t)(0x6000 | x)); //74
+		a.op(0x6100);                      //74
+		a.op(0xD015);
+		a.label("end");
+		a.jump("end");
+		start(a, quirks);
+		return emulator->runFrame();
+	};
+	const int aligned = 74 + 74 + 68 + 26 + 5 * 14;
+	executed = draw(8, noWait);
+	check(executed == 3 + 29 && emulator->state.cycleBalance == 2598 - aligned - 29 * 80, "vip: an aligned draw");
+	const int shifted = 74 + 74 + 68 + 26 + 5 * 34;
+	executed = draw(3, noWait);
+	check(executed == 3 + 28 && emulator->state.cycleBalance == 2598 - shifted - 28 * 80, "vip: a shifted draw costs more");
+
+	//under the display wait the draw ends the frame and the rest of it is not carried over
+	executed = draw(8, defaultQuirks(Platform::chip8));
+	check(executed == 3 && emulator->state.cycleBalance == 0, "vip: the display wait gives the frame away");
+	executed = emulator->runFrame();
+	check(executed == 33 && emulator->state.cycleBalance == 2598 - 33 * 80, "vip: the next frame starts without a debt");
+}
+
+int runChecks()
+{
+	failures = 0;
+	checkAnalyzer();
+	checkVipTiming();
+	return failures;
+}
@@ -0,0 +1,255 @@
+//chip8-tests: runs the conformance test roms without a window and compares the final framebuffers
+//with the golden hashes in tests/conformance/golden.txt.
+//usage: chip8-tests [--golden file] [--roms folder] [--filter text] [--threads N] [--update]
+//       chip8-tests --write-rom test file
+//
+//Every test runs once per variant (a platform and its quirks), the runs are spread over a thread pool.
+//Roms put in the roms folder (tests/conformance/roms by default, for example a community test suite)
+//run too, with the settings the analyzer picks. Then the checks of checks.cpp, what the analyzer picks
+//for small roms and the frame lengths of the VIP timing.
+//--update rewrites the golden file with the current results, check the lines that changed before committing.
+//--write-rom only writes the rom of a built in test, the build recompiles one into a plugin to test it.
+
+#include "testRoms.h"
+#include <chip8/chip8.h>
+#include <chip8/hash.h>
+#include <chip8/mappedFile.h>
+#include <chip8/romAnalyzer.h>
+#include <chip8/romLibrary.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <thread>
+
+#ifndef CHIP8_TESTS_FOLDER
+#define CHIP8_TESTS_FOLDER "tests/conformance/"
+#endif
+
+using namespace chip8;
+
+struct Run
+{
+	const ConformanceTest *test = nullptr;
+	const TestVariant *variant = nullptr;
+
+	std::uint64_t hash = 0;
+	Display display;
+
+	std::string key() const { return test->name + " " + variant->name; }
+};
+
+static void runTest(Run &run)
+{
+	auto emulator = std::make_unique<Chip8>();
+	emulator->reset(run.variant->platform, run.variant->quirks);
+
+	const ConformanceTest &test = *run.test;
+	if (!emulator->loadRom(test.rom.data(), test.rom.size()))
+	{
+		run.hash = 0;
+		return;
+	}
+	if (test.platformHint) { writeMemory(emulator->state, 0x1FF, test.platformHint); }
+
+	std::size_t nextKey = 0;
+	for (int frame = 0; frame < test.frames; frame++)
+	{
+		while (nextKey < test.keys.size() && test.keys[nextKey].frame <= frame)
+		{
+			emulator->setKeys(test.keys[nextKey++].keys);
+		}
+		emulator->runFrame();
+	}
+
+	run.display = emulator->state.display;
+	run.hash = xxHash64(run.display.planes, sizeof(run.display.planes), run.display.hires);
+}
+
+//the screen as text, the digit is the palette index of the pixel
+static void printDisplay(const Display &display)
+{
+	for (int y = 0; y < display.height(); y++)
+	{
+		std::string line = "    ";
+		for (int x = 0; x < display.width(); x++)
+		{
+			int color = display.getColorIndex(x, y);
+			line += color ? (char)('0' + color) : '.';
+		}
+		std::printf("%s\n", line.c_str());
+	}
+}
+
+static std::map<std::string, std::uint64_t> loadGolden(const std::string &path)
+{
+	std::map<std::string, std::uint64_t> golden;
+	std::ifstream file(path);
+	std::string line;
+	while (std::getline(file, line))
+	{
+		if (line.empty() || line[0] == '#') { continue; }
+
+		std::istringstream fields(line);
+		std::string test, variant, hash;
+		if (fields >> test >> variant >> hash)
+		{
+			golden[test + " " + variant] = std::strtoull(hash.c_str(), nullptr, 16);
+		}
+	}
+	return golden;
+}
+
+//the roms of the folder as tests, each with the settings the analyzer picks
+static void addRomFolder(std::vector<ConformanceTest> &tests, const std::string &folder)
+{
+	std::error_code error;
+	std::vector<std::string> files;
+	for (auto &entry : std::filesystem::directory_iterator(folder, error))
+	{
+		std::string path = entry.path().generic_string();
+		if (entry.is_regular_file(error) && RomLibrary::isRomFile(path)) { files.push_back(path); }
+	}
+	std::sort(files.begin(), files.end());
+
+	for (const std::string &path : files)
+	{
+		MappedFile file;
+		if (!file.open(path.c_str())) { continue; }
+
+		RomAnalysis analysis = analyzeRom(file.data, file.size);
+
+		static const char *names[] = {"chip8", "schip", "xochip"};
+
+		ConformanceTest test;
+		test.name = std::filesystem::path(path).filename().string();
+		test.rom.assign(file.data, file.data + file.size);
+		test.variants = {{names[(int)analysis.platform], analysis.platform, analysis.quirks}};
+		test.frames = 600;
+		test.platformHint = (std::uint8_t)((int)analysis.platform + 1);
+		tests.push_back(std::move(test));
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	std::string goldenPath = CHIP8_TESTS_FOLDER "golden.txt";
+	std::string romFolder = CHIP8_TESTS_FOLDER "roms";
+	std::string filter;
+	int threadCount = (int)std::thread::hardware_concurrency();
+	bool update = false;
+
+	if (argc == 4 && !std::strcmp(argv[1], "--write-rom"))
+	{
+		for (const ConformanceTest &test : builtinTests())
+		{
+			if (test.name != argv[2]) { continue; }
+
+			std::ofstream file(argv[3], std::ios::binary);
+			file.write((const char *)test.rom.data(), (std::streamsize)test.rom.size());
+			if (file.good()) { return 0; }
+			std::fprintf(stderr, "can't write %s\n", argv[3]);
+			return 1;
+		}
+		std::fprintf(stderr, "no built in test %s\n", argv[2]);
+		return 1;
+	}
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!std::strcmp(argv[i], "--golden") && i + 1 < argc) { goldenPath = argv[++i]; }
+		else if (!std::strcmp(argv[i], "--roms") && i + 1 < argc) { romFolder = argv[++i]; }
+		else if (!std::strcmp(argv[i], "--filter") && i + 1 < argc) { filter = argv[++i]; }
+		else if (!std::strcmp(argv[i], "--threads") && i + 1 < argc) { threadCount = std::atoi(argv[++i]); }
+		else if (!std::strcmp(argv[i], "--update")) { update = true; }
+		else
+		{
+			std::fprintf(stderr, "usage: chip8-tests [--golden file] [--roms folder] [--filter text] [--threads N] [--update]\n"
+				"       chip8-tests --write-rom test file\n");
+			return 2;
+		}
+	}
+	if (threadCount < 1) { threadCount = 1; }
+
+	std::vector<ConformanceTest> tests = builtinTests();
+	addRomFolder(tests, romFolder);
+
+	std::vector<Run> runs;
+	for (const ConformanceTest &test : tests)
+	{
+		for (const TestVariant &variant : test.variants)
+		{
+			Run run;
+			run.test = &test;
+			run.variant = &variant;
+			if (filter.empty() || run.key().find(filter) != std::string::npos) { runs.push_back(run); }
+		}
+	}
+
+	std::atomic<std::size_t> next{0};
+	std::vector<std::thread> threads;
+	for (int t = 0; t < threadCount; t++)
+	{
+		threads.emplace_back([&]()
+		{
+			for (std::size_t r; (r = next++) < runs.size();) { runTest(runs[r]); }
+		});
+	}
+	for (std::thread &thread : threads) { thread.join(); }
+
+	std::map<std::string, std::uint64_t> golden = loadGolden(goldenPath);
+
+	if (update)
+	{
+		for (const Run &run : runs) { golden[run.key()] = run.hash; }
+
+		std::ofstream file(goldenPath);
+		file << "# chip8-tests: test variant framebuffer-hash, written by chip8-tests --update\n";
+		for (auto &entry : golden)
+		{
+			char hash[17];
+			std::snprintf(hash, sizeof(hash), "%016llx", (unsigned long long)entry.second);
+			file << entry.first << " " << hash << "\n";
+		}
+
+		if (!file)
+		{
+			std::fprintf(stderr, "can't write %s\n", goldenPath.c_str());
+			return 2;
+		}
+		std::printf("wrote %zu hashes to %s\n", golden.size(), goldenPath.c_str());
+		return 0;
+	}
+
+	int failed = 0;
+	for (const Run &run : runs)
+	{
+		auto expected = golden.find(run.key());
+		if (expected != golden.end() && expected->second == run.hash) { continue; }
+
+		failed++;
+		if (expected == golden.end())
+		{
+			std::printf("FAIL %s: no golden hash (got %016llx), run with --update to add it\n",
+				run.key().c_str(), (unsigned long long)run.hash);
+		}
+		else
+		{
+			std::printf("FAIL %s: framebuffer hash %016llx, expected %016llx\n", run.key().c_str(),
+				(unsigned long long)run.hash, (unsigned long long)expected->second);
+		}
+		printDisplay(run.display);
+	}
+
+	std::printf("%d of %zu runs passed\n", (int)(runs.size() - failed), runs.size());
+
+	const int checksFailed = runChecks();
+	if (checksFailed) { std::printf("%d checks failed\n", checksFailed); }
+	return failed || checksFailed ? 1 : 0;
+}
@@ -0,0 +1,296 @@
+#include "testRoms.h"
+#include "assembler.h"
+
+using namespace chip8;
+
+//Register use in all the tests: V0 is the value to print, V6 and V7 the cursor,
+//V1 and VF are trashed by the print routine, the others are free.
+
+static void set(Assembler &a, int x, std::uint8_t value) { a.op((std::uint16_t)(0x6000 | (x << 8) | value)); }
+static void copy(Assembler &a, int x, int y) { a.op((std::uint16_t)(0x8000 | (x << 8) | (y << 4))); }
+static void print(Assembler &a) { a.call("print"); }
+
+//prints V0 as two hex digits at V6, V7 and moves the cursor, 5 values per line
+static void printRoutine(Assembler &a)
+{
+	a.label("print");
+	a.op(0x8100); //V1 = V0
+	for (int s = 0; s < 4; s++) { a.op(0x8116); } //V1 >>= 1 (the same register, no quirk)
+	a.op(0xF129);
+	a.op(0xD675);
+	a.op(0x7605);
+	a.op(0x610F);
+	a.op(0x8102); //V1 = V0 & 0xF
+	a.op(0xF129);
+	a.op(0xD675);
+	a.op(0x7607);
+	a.op(0x463C); //the end of the line at x 60
+	a.jump("newline");
+	a.op(0x00EE);
+
+	a.label("newline");
+	a.op(0x6600);
+	a.op(0x7706);
+	a.op(0x00EE);
+}
+
+static Assembler begin()
+{
+	Assembler a;
+	a.op(0x00E0);
+	a.op(0x6600);
+	a.op(0x6700);
+	a.jump("main");
+	printRoutine(a);
+	a.label("main");
+	return a;
+}
+
+static void end(Assembler &a)
+{
+	a.label("end");
+	a.jump("end");
+}
+
+std::vector<TestVariant> platformVariants()
+{
+	return
+	{
+		{"chip8", Platform::chip8, defaultQuirks(Platform::chip8)},
+		{"schip", Platform::schip, defaultQuirks(Platform::schip)},
+		{"xochip", Platform::xoChip, defaultQuirks(Platform::xoChip)},
+	};
+}
+
+//chip8 with one quirk flipped at a time, on top of the platforms
+static std::vector<TestVariant> quirkVariants()
+{
+	std::vector<TestVariant> variants = platformVariants();
+
+	static const char *names[] = {"vfReset", "memoryIncrement", "displayWait", "clipping", "shiftVx", "jumpVx"};
+	std::uint32_t chip8Bits = quirksToBits(defaultQuirks(Platform::chip8));
+	for (int q = 0; q < 6; q++)
+	{
+		variants.push_back({std::string("chip8-") + names[q], Platform::chip8, quirksFromBits(chip8Bits ^ (1u << q))});
+	}
+
+	return variants;
+}
+
+//the arithmetic, logic, memory, call and skip instructions, one printed value each
+static ConformanceTest opcodesTest()
+{
+	Assembler a = begin();
+
+	set(a, 0, 0x3C); print(a);                                      //6XNN 3C
+	set(a, 0, 0xF0); a.op(0x7025); print(a);                        //7XNN 15
+	set(a, 2, 0x5A); copy(a, 0, 2); print(a);                       //8XY0 5A
+	set(a, 0, 0x0F); set(a, 2, 0xA0); a.op(0x8021); print(a);       //8XY1 AF
+	set(a, 0, 0x3C); set(a, 2, 0x0F); a.op(0x8022); print(a);       //8XY2 0C
+	set(a, 0, 0x55); set(a, 2, 0xFF); a.op(0x8023); print(a);       //8XY3 AA
+	set(a, 0, 0x78); set(a, 2, 0x9A); a.op(0x8024); print(a);       //8XY4 12
+	set(a, 0, 0x50); set(a, 2, 0x20); a.op(0x8025); print(a);       //8XY5 30
+	set(a, 0, 0x20); set(a, 2, 0x50); a.op(0x8027); print(a);       //8XY7 30
+	set(a, 0, 0x81); set(a, 2, 0x81); a.op(0x8026); print(a);       //8XY6 40
+	set(a, 0, 0x41); set(a, 2, 0x41); a.op(0x802E); print(a);       //8XYE 82
+
+	a.setI("data"); set(a, 2, 3); a.op(0xF21E); a.op(0xF065); print(a); //ANNN FX1E FX65 44
+
+	//FX33 231 -> 02 03 01
+	set(a, 0, 231); a.setI("scratch"); a.op(0xF033); a.setI("scratch"); a.op(0xF265);
+	copy(a, 3, 1); copy(a, 4, 2);
+	print(a); copy(a, 0, 3); print(a); copy(a, 0, 4); print(a);
+
+	//FX55 and FX65 round trip 33
+	set(a, 0, 0x11); set(a, 1, 0x22); set(a, 2, 0x33); a.setI("scratch"); a.op(0xF255);
+	set(a, 0, 0); set(a, 1, 0); set(a, 2, 0); a.setI("scratch"); a.op(0xF265);
+	copy(a, 0, 2); print(a);
+
+	a.call("sub"); print(a); //2NNN 00EE 99
+
+	//3XNN 4XNN 5XY0 9XY0, the additions that are not skipped make 26
+	set(a, 0, 0); set(a, 2, 5); set(a, 3, 5);
+	a.op(0x3205); a.op(0x7001);
+	a.op(0x3206); a.op(0x7002);
+	a.op(0x4205); a.op(0x7004);
+	a.op(0x4206); a.op(0x7008);
+	a.op(0x5230); a.op(0x7010);
+	a.op(0x9230); a.op(0x7020);
+	set(a, 3, 6);
+	a.op(0x9230); a.op(0x7040);
+	print(a);
+
+	a.op(0xC000); print(a); //CXNN with a mask of 0 is 00
+
+	set(a, 0, 0x20); a.op(0xF015); a.op(0xF007); print(a); //FX15 FX07 20 or 1F if a frame ended in between
+
+	set(a, 0, 0x0A); a.op(0xF029); set(a, 2, 0); a.op(0xF21E); a.op(0xF065); print(a); //FX29, the top row of A is F0
+
+	end(a);
+
+	a.label("sub");
+	set(a, 0, 0x99);
+	a.op(0x00EE);
+
+	a.label("data");
+	a.bytes({0x11, 0x22, 0x33, 0x44, 0x55});
+	a.label("scratch");
+	a.bytes({0, 0, 0, 0});
+
+	return {"opcodes", a.finish(), platformVariants(), {}, 300};
+}
+
+//the results and VF of the arithmetic, also with VF as the destination
+static ConformanceTest flagsTest()
+{
+	Assembler a = begin();
+
+	//prints V0 and then VF
+	auto result = [&](std::uint16_t opcode, std::uint8_t x, std::uint8_t y)
+	{
+		set(a, 0, x);
+		set(a, 2, y);
+		a.op(opcode);
+		copy(a, 5, 0xF);
+		print(a);
+		copy(a, 0, 5);
+		print(a);
+	};
+
+	result(0x8024, 0x10, 0x20); //30 00
+	result(0x8024, 0xF0, 0x20); //10 01
+	result(0x8025, 0x30, 0x10); //20 01
+	result(0x8025, 0x10, 0x30); //E0 00
+	result(0x8027, 0x10, 0x30); //20 01
+	result(0x8027, 0x30, 0x10); //E0 00
+	result(0x8026, 0x03, 0x03); //01 01
+	result(0x802E, 0x81, 0x81); //02 01
+
+	//VF as the destination, the flag wins over the result
+	set(a, 0xF, 0xF0); set(a, 2, 0x20); a.op(0x8F24); copy(a, 0, 0xF); print(a); //01
+	set(a, 0xF, 0x30); set(a, 2, 0x10); a.op(0x8F25); copy(a, 0, 0xF); print(a); //01
+	set(a, 0xF, 0x10); set(a, 2, 0x30); a.op(0x8F27); copy(a, 0, 0xF); print(a); //01
+	set(a, 0xF, 0x03); a.op(0x8FF6); copy(a, 0, 0xF); print(a); //01
+	set(a, 0xF, 0x40); a.op(0x8FFE); copy(a, 0, 0xF); print(a); //00
+
+	//the logic instructions and VF
+	set(a, 0xF, 0x55); set(a, 0, 1); set(a, 2, 2); a.op(0x8021); copy(a, 0, 0xF); print(a); //00 or 55
+
+	end(a);
+	return {"flags", a.finish(), platformVariants(), {}, 300};
+}
+
+//prints what every quirk did, run with each quirk flipped on its own
+static ConformanceTest quirksTest()
+{
+	Assembler a = begin();
+
+	//vfReset: 00 when set, 55 when not
+	set(a, 0xF, 0x55); set(a, 0, 1); set(a, 2, 2); a.op(0x8021); copy(a, 0, 0xF); print(a);
+
+	//memoryIncrement: FX65 after FX55 reads the next byte (BB) when I moved, the stored 11 when not
+	a.setI("buffer"); set(a, 0, 0x11); a.op(0xF055); a.op(0xF065); print(a);
+
+	//shiftVx: 08 shifting V0, 02 shifting V2
+	set(a, 0, 0x10); set(a, 2, 0x04); a.op(0x8026); print(a);
+
+	//jumpVx: B300 jumps to 300 + V0 (sets 01) or 300 + V3 = 304 (sets 02)
+	set(a, 0, 0); set(a, 3, 4); a.op(0xB300);
+	a.label("jumped");
+	print(a);
+
+	//clipping: a sprite at x 60 wraps to x 0 unless it is clipped, VF tells if the pixel at 0 was lit
+	a.setI("line"); set(a, 2, 60); set(a, 3, 31); a.op(0xD231);
+	a.setI("dot"); set(a, 2, 0); a.op(0xD231); copy(a, 0, 0xF); print(a);
+
+	//displayWait: the number of draws in 3 frames, one per frame with the wait
+	set(a, 4, 0); set(a, 0, 3); a.op(0xF015); a.setI("empty");
+	a.label("waitLoop");
+	a.op(0xD231); a.op(0x7401); a.op(0xF007); a.op(0x3000); a.jump("waitLoop");
+	copy(a, 0, 4); print(a);
+
+	end(a);
+
+	a.label("buffer");
+	a.bytes({0xAA, 0xBB});
+	a.label("line");
+	a.bytes({0xFF});
+	a.label("dot");
+	a.bytes({0x80});
+	a.label("empty");
+	a.bytes({0x00});
+
+	a.org(0x300);
+	set(a, 0, 1); a.jump("jumped");
+	set(a, 0, 2); a.jump("jumped");
+
+	return {"quirks", a.finish(), quirkVariants(), {}, 300};
+}
+
+//FX0A waits for a press and release, EX9E and EXA1 see a held key
+static ConformanceTest keypadTest()
+{
+	Assembler a = begin();
+
+	a.op(0xF00A); print(a); //0A
+	a.op(0xF00A); print(a); //03
+
+	set(a, 2, 5);
+	a.label("waitForFive");
+	a.op(0xE29E); a.jump("waitForFive");
+	set(a, 0, 0x55); print(a); //55
+
+	set(a, 0, 0); a.op(0xE2A1); set(a, 0, 1); print(a); //01, 5 is still held
+	set(a, 2, 6); set(a, 0, 0); a.op(0xE2A1); set(a, 0, 1); print(a); //00, 6 is not
+
+	end(a);
+
+	std::vector<KeyEvent> keys =
+	{
+		{10, 1 << 0xA}, {14, 0},
+		{20, 1 << 0x3}, {22, 1 << 0x3 | 1 << 0x7}, {25, 0},
+		{40, 1 << 0x5},
+	};
+
+	return {"keypad", a.finish(), platformVariants(), keys, 120};
+}
+
+//how many draws fit in a few frames, in lores and in hires where schip never waits
+static ConformanceTest displayWaitTest()
+{
+	Assembler a = begin();
+
+	auto countDraws = [&](int into)
+	{
+		a.op((std::uint16_t)(0x6000 | (into << 8)));
+		set(a, 0, 4);
+		a.op(0xF015);
+		a.setI("empty");
+		std::string loop = "loop" + std::to_string(into);
+		a.label(loop);
+		a.op(0xD001);
+		a.op((std::uint16_t)(0x7001 | (into << 8)));
+		a.op(0xF007);
+		a.op(0x3000);
+		a.jump(loop);
+	};
+
+	countDraws(8);
+	a.op(0x00FF);
+	countDraws(9);
+
+	copy(a, 0, 8); print(a);
+	copy(a, 0, 9); print(a);
+
+	end(a);
+
+	a.label("empty");
+	a.bytes({0x00});
+
+	return {"display-wait", a.finish(), platformVariants(), {}, 120};
+}
+
+std::vector<ConformanceTest> builtinTests()
+{
+	return {opcodesTest(), flagsTest(), quirksTest(), keypadTest(), displayWaitTest()};
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <chip8/chip8.h>
+
+//one set of settings a test runs with, the golden hashes are per test and variant
+struct TestVariant
+{
+	std::string name;
+	chip8::Platform platform = chip8::Platform::chip8;
+	chip8::Quirks quirks = {};
+};
+
+//the keypad changes to this at the start of the frame
+struct KeyEvent
+{
+	int frame = 0;
+	std::uint16_t keys = 0;
+};
+
+struct ConformanceTest
+{
+	std::string name;
+	std::vector<std::uint8_t> rom;
+	std::vector<TestVariant> variants;
+	std::vector<KeyEvent> keys;
+	int frames = 300;
+
+	//written to 0x1FF before the run, the community test suites pick their platform from it
+	std::uint8_t platformHint = 0;
+};
+
+//The test roms that come with the repo. Each one prints what the instructions it tests did
+//as hex digits, so any difference in behaviour shows up in the final framebuffer:
+//opcodes, flags, quirks, keypad and display-wait.
+std::vector<ConformanceTest> builtinTests();
+
+//the three platforms with their default quirks
+std::vector<TestVariant> platformVariants();
+
+//The checks that aren't a framebuffer: what the analyzer picks for small roms
+//and the instructions in the frames of the VIP timing.
+//Prints a line for each one that fails, returns how many did.
+int runChecks();
@@ -0,0 +1,676 @@
+//chip8-debugger-test: the breakpoints, watchpoints, steps and trace of chip8::Debugger on a small rom,
+//and that a run stopped and resumed by the debugger ends in the same state as one without it.
+//Then going back with chip8::History over 5 minutes of a rom that reads keys, against runs from the start,
+//the rows, labels and cached text of chip8::Disassembly, the counters of chip8::MemoryHeat,
+//the counts and call stacks of chip8::RomProfiler on nested subroutines, stops under the VIP timing
+//breakpoints at a PC that ran past the end of the memory and the instruction after a key wait.
+//The exit code is 1 if a check failed.
+
+#include "../conformance/assembler.h"
+#include <chip8/debugger.h>
+#include <chip8/disassembly.h>
+#include <chip8/history.h>
+#include <chip8/memoryHeat.h>
+#include <chip8/romProfiler.h>
+#include <chip8/trace.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+using namespace chip8;
+
+//the states are 66 KB each so they don't go on the stack
+static Chip8 reference;
+static Chip8 emulator;
+
+static int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+	if (!ok)
+	{
+		std::printf("FAILED: %s\n", what);
+		failures++;
+	}
+}
+
+static std::uint16_t keysFor(std::uint64_t frame)
+{
+	return (frame / 5) % 2 ? (std::uint16_t)(1 << (frame % 16)) : 0;
+}
+
+static double millisecondsSince(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void checkHistory()
+{
+	Assembler a;
+	a.op(0x6100);        //200 V1 = 0
+	a.label("loop");
+	a.op(0xC00F);        //202 V0 = a random key
+	a.op(0xE09E);        //204 skip if it is down
+	a.op(0x7101);        //206 V1 += 1
+	a.op(0xF015);        //208 DT = V0
+	a.op(0xA300);        //20A I = 300
+	a.op(0xF133);        //20C the digits of V1 at I
+	a.op(0x8210);        //20E V2 = V1
+	a.op(0x633F);        //210 V3 = 3F
+	a.op(0x8232);        //212 V2 &= V3
+	a.op(0x4200);        //214 every 64 times around the loop
+	a.op(0xF40A);        //216 wait for a key
+	a.jump("loop");      //218
+	std::vector<std::uint8_t> rom = a.finish();
+
+	auto restart = [&](Chip8 &chip8)
+	{
+		chip8.reset(Platform::chip8);
+		chip8.loadRom(rom.data(), rom.size());
+	};
+
+	//the frames with their keys from the start, stopping where History lands
+	auto runFromStart = [&](Chip8 &chip8, std::uint64_t count)
+	{
+		restart(chip8);
+		Debugger stopper;
+		stopper.runToInstruction(count);
+		chip8.debugger = &stopper;
+		while (!stopper.stopped())
+		{
+			if (!chip8.midFrame())
+			{
+				if (chip8.state.instructionCount >= count) { break; }
+				chip8.setKeys(keysFor(chip8.state.frameCount));
+			}
+			chip8.runFrame();
+		}
+		chip8.debugger = nullptr;
+	};
+
+	Debugger debugger;
+	History history;
+	emulator.debugger = &debugger;
+	auto runFrame = [&]()
+	{
+		if (!emulator.midFrame())
+		{
+			emulator.setKeys(keysFor(emulator.state.frameCount));
+			history.beginFrame(emulator);
+		}
+		emulator.runFrame();
+	};
+
+	//5 minutes
+	restart(emulator);
+	std::uint64_t minuteCount = 0;
+	for (int f = 0; f < 60 * 60 * 5; f++)
+	{
+		if (f == 60 * 60) { minuteCount = emulator.state.instructionCount; }
+		runFrame();
+	}
+	check(history.stats().frames == 60 * 60 * 5, "the history has every frame");
+
+	//two stops at the increment
+	debugger.breakpoints = {{0x206}};
+	debugger.update();
+	while (!debugger.stopped()) { runFrame(); }
+	const std::uint64_t firstStop = emulator.state.instructionCount;
+	debugger.resume();
+	while (!debugger.stopped()) { runFrame(); }
+	const std::uint64_t position = emulator.state.instructionCount;
+
+	auto start = std::chrono::steady_clock::now();
+	check(history.stepBack(emulator, debugger), "steps back");
+	double stepBackTime = millisecondsSince(start);
+	check(emulator.state.instructionCount == position - 1 && debugger.stop.reason == Debugger::StopReason::rewound,
+		"it goes back one instruction");
+	runFromStart(reference, position - 1);
+	check(hashState(emulator.state) == hashState(reference.state) && emulator.midFrame() == reference.midFrame(),
+		"it is where running from the start gets");
+
+	debugger.resume();
+	while (!debugger.stopped()) { runFrame(); }
+	check(debugger.stop.reason == Debugger::StopReason::breakpoint && emulator.state.instructionCount == position,
+		"continuing stops at the same breakpoint again");
+
+	start = std::chrono::steady_clock::now();
+	check(history.runBack(emulator, debugger), "runs back");
+	double runBackTime = millisecondsSince(start);
+	check(debugger.stop.reason == Debugger::StopReason::breakpoint && emulator.state.pc == 0x206 &&
+		emulator.state.instructionCount == firstStop, "it goes back to the stop before");
+	check(history.runBack(emulator, debugger) && emulator.state.instructionCount < firstStop && emulator.state.pc == 0x206,
+		"it finds stops from before the breakpoint was set");
+
+	//4 minutes back
+	start = std::chrono::steady_clock::now();
+	check(history.seek(emulator, minuteCount + 5), "seeks minutes back");
+	double seekTime = millisecondsSince(start);
+	runFromStart(reference, minuteCount + 5);
+	check(emulator.state.instructionCount == minuteCount + 5 && hashState(emulator.state) == hashState(reference.state),
+		"it is where running from the start gets");
+	check(!history.seek(emulator, minuteCount + 6), "it can't seek forward");
+
+	//the history goes on from there with new frames
+	debugger.breakpoints.clear();
+	debugger.update();
+	debugger.resume();
+	for (int f = 0; f < 600; f++) { runFrame(); }
+	check(history.stepBack(emulator, debugger), "steps back after recording again");
+	runFromStart(reference, emulator.state.instructionCount);
+	check(hashState(emulator.state) == hashState(reference.state), "the new frames replay too");
+	emulator.debugger = nullptr;
+
+	const double frameTime = 1000.0 / 60;
+	check(stepBackTime < frameTime && seekTime < frameTime, "going back takes less than a frame");
+	History::Stats stats = history.stats();
+	std::printf("history: %zu keyframes, %zu KB, step back %.3f ms, run back %.3f ms, seek %.3f ms\n",
+		stats.keyframes, stats.keyframeBytes / 1024, stepBackTime, runBackTime, seekTime);
+}
+
+static void checkDisassembly()
+{
+	Assembler a;
+	a.call("draw");      //200
+	a.label("loop");
+	a.jump("loop");      //202
+	a.op(0x1234);        //204 never runs, a sprite
+	a.op(0x5678);        //206
+	a.label("draw");
+	a.setI("sprite");    //208
+	a.op(0xD015);        //20A
+	a.op(0x00EE);        //20C
+	a.label("sprite");
+	a.op(0xF090);        //20E
+	a.op(0x90F0);        //210
+	std::vector<std::uint8_t> rom = a.finish();
+
+	emulator.reset(Platform::chip8);
+	emulator.loadRom(rom.data(), rom.size());
+
+	Disassembly disassembly;
+	check(disassembly.follow(emulator, emulator.state.pc) && disassembly.analyzed(), "the first follow lays the rows out");
+	check(!disassembly.follow(emulator, 0x202), "following known code is free");
+
+	auto textAt = [&](std::uint16_t address)
+	{
+		std::size_t row = disassembly.rowOf(address);
+		return disassembly.row(row).address == address ? std::string(disassembly.text(emulator.state, row)) : std::string("?");
+	};
+	auto rowAt = [&](std::uint16_t address) { return disassembly.row(disassembly.rowOf(address)); };
+
+	check(textAt(0x200) == "CALL sub_208" && textAt(0x202) == "JP label_202", "the targets have labels");
+	check(textAt(0x208) == "LD I, data_20E" && textAt(0x20A) == "DRW V0, V1, 5" && textAt(0x20C) == "RET", "the code");
+	check(!rowAt(0x204).code && rowAt(0x204).size == 4 && textAt(0x204) == "DB 12 34 56 78", "what doesn't run is data");
+	check(!rowAt(0x20E).code && textAt(0x20E) == "DB F0 90" && textAt(0x210) == "DB 90 F0 00 00 00 00 00 00",
+		"the sprite is data, in rows aligned to 8 bytes");
+	check(rowAt(0x50).address == 0x50 && !rowAt(0x50).code, "the font is data");
+
+	std::uint64_t made = disassembly.stats.made;
+	textAt(0x200);
+	textAt(0x20A);
+	check(disassembly.stats.made == made, "the texts are kept");
+
+	//written by the program, only that row is made again
+	writeMemory(emulator.state, 0x20B, 0x1A);
+	check(textAt(0x20A) == "DRW V0, V1, A" && textAt(0x200) == "CALL sub_208", "a write makes the row again");
+	check(disassembly.stats.made == made + 1, "only the written row");
+
+	//code the program jumps to at run time
+	writeMemory(emulator.state, 0x204, 0x60);
+	writeMemory(emulator.state, 0x205, 0x07);
+	check(disassembly.follow(emulator, 0x204) && rowAt(0x204).code && textAt(0x204) == "LD V0, 07", "new code is followed");
+	check(!disassembly.follow(emulator, 0x100), "below 0x200 isn't followed");
+
+	//the same rom draws its sprite once and loops
+	emulator.reset(Platform::chip8);
+	emulator.loadRom(rom.data(), rom.size());
+	Debugger debugger;
+	MemoryHeat heat;
+	debugger.heat = &heat;
+	check(debugger.armed(), "the heat arms the debugger");
+	emulator.debugger = &debugger;
+	for (int f = 0; f < 3; f++) { emulator.runFrame(); }
+	emulator.debugger = nullptr;
+
+	check(heat.get(MemoryHeat::execute, 0x200) == 1 && heat.get(MemoryHeat::execute, 0x201) == 1, "the call ran once");
+	check(heat.get(MemoryHeat::execute, 0x202) > 10 && heat.get(MemoryHeat::execute, 0x204) == 0, "the loop is hot");
+	bool spriteRead = true;
+	for (std::uint16_t address = 0x20E; address < 0x213; address++) { spriteRead &= heat.get(MemoryHeat::read, address) == 1; }
+	check(spriteRead && heat.get(MemoryHeat::read, 0x213) == 0, "the sprite was read");
+	check(heat.get(MemoryHeat::write, 0x20E) == 0, "nothing was written");
+
+	const std::uint16_t hot = heat.get(MemoryHeat::execute, 0x202);
+	heat.decay(4);
+	check(heat.get(MemoryHeat::execute, 0x202) == hot - (hot >> 4) - 1, "the counters decay");
+	check(heat.get(MemoryHeat::read, 0x20E) == 0, "a single hit fades at once");
+	for (int d = 0; d < 200; d++) { heat.decay(4); }
+	check(heat.get(MemoryHeat::execute, 0x202) == 0, "they fade out");
+}
+
+static void checkProfiler()
+{
+	Assembler a;
+	a.op(0x6000);        //200 V0 = 0
+	a.label("loop");
+	a.op(0x2208);        //202 call the outer subroutine
+	a.op(0x7001);        //204 V0 += 1
+	a.jump("loop");      //206
+	a.op(0x8100);        //208 V1 = V0
+	a.op(0x220E);        //20A call the inner one
+	a.op(0x00EE);        //20C
+	a.op(0x7201);        //20E V2 += 1
+	a.op(0x00EE);        //210
+	std::vector<std::uint8_t> rom = a.finish();
+
+	const int frames = 60;
+	reference.reset(Platform::chip8);
+	reference.loadRom(rom.data(), rom.size());
+	for (int f = 0; f < frames; f++) { reference.runFrame(); }
+
+	emulator.reset(Platform::chip8);
+	emulator.loadRom(rom.data(), rom.size());
+	Debugger debugger;
+	RomProfiler profiler;
+	debugger.profiler = &profiler;
+	check(debugger.armed(), "the profiler arms the debugger");
+	emulator.debugger = &debugger;
+	for (int f = 0; f < frames; f++) { emulator.runFrame(); }
+	emulator.debugger = nullptr;
+	check(hashState(emulator.state) == hashState(reference.state), "the profiler doesn't change the run");
+
+	auto at = [&](std::uint16_t address) { return profiler.address(address).instructions; };
+	std::uint64_t counted = 0;
+	for (std::uint32_t address = 0; address < memorySize; address++) { counted += at((std::uint16_t)address); }
+	check(profiler.totalInstructions() == emulator.state.instructionCount && counted == profiler.totalInstructions(),
+		"every instruction is counted once");
+	check(at(0x200) == 1 && at(0x202) > 50 && at(0x20A) - at(0x20E) <= 1, "by address");
+	check(profiler.opcode(0x2000).instructions == at(0x202) + at(0x20A), "the calls by opcode");
+	check(profiler.opcode(0x00EE).instructions == at(0x20C) + at(0x210), "the returns by opcode");
+
+	check(RomProfiler::opcodeKind(0x8124) == 0x8004 && RomProfiler::opcodeKind(0xD125) == 0xD000 &&
+		RomProfiler::opcodeKind(0xF365) == 0xF065 && RomProfiler::opcodeKind(0x00C4) == 0x00C0, "the kinds of opcodes");
+	char name[8];
+	RomProfiler::opcodeKindName(0x8004, name);
+	std::string names = name;
+	RomProfiler::opcodeKindName(0xF065, name);
+	names += name;
+	RomProfiler::opcodeKindName(0x00EE, name);
+	names += name;
+	check(names == "8XY4FX6500EE", "the names of the kinds");
+
+	std::vector<RomProfiler::Function> functions = profiler.functions();
+	check(functions.size() == 3 && functions[0].root && functions[0].address == 0x200, "the root and two subroutines");
+	if (functions.size() == 3)
+	{
+		const RomProfiler::Function &main = functions[0], &outer = functions[1], &inner = functions[2];
+		check(outer.address == 0x208 && outer.calls == at(0x202) && inner.address == 0x20E && inner.calls == at(0x20A),
+			"the calls");
+		check(main.self.instructions == at(0x200) + at(0x202) + at(0x204) + at(0x206) &&
+			outer.self.instructions == at(0x208) + at(0x20A) + at(0x20C) &&
+			inner.self.instructions == at(0x20E) + at(0x210), "the instructions in each");
+		check(inner.total.instructions == inner.self.instructions &&
+			outer.total.instructions == outer.self.instructions + inner.total.instructions &&
+			main.total.instructions == profiler.totalInstructions(), "the totals have the callees");
+		check(main.total.nanoseconds > 0 && outer.total.nanoseconds <= main.total.nanoseconds, "the time is sampled");
+	}
+
+	const char *foldedPath = "chip8-debugger-test.folded";
+	check(profiler.saveCollapsedStacks(foldedPath, false), "the stacks save");
+	std::string folded;
+	if (std::FILE *file = std::fopen(foldedPath, "rb"))
+	{
+		char buffer[256];
+		std::size_t read;
+		while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0) { folded.append(buffer, read); }
+		std::fclose(file);
+	}
+	std::remove(foldedPath);
+	const std::string innerLine = "main;sub_208;sub_20E " + std::to_string(at(0x20E) + at(0x210)) + "\n";
+	check(folded.find(innerLine) != std::string::npos && folded.find("main ") == 0, "one line per stack");
+
+	profiler.clear();
+	check(profiler.totalInstructions() == 0 && profiler.functions().empty(), "clear");
+}
+
+//stops in the middle of the frames of the VIP timing, the cycles owed carry over the stops
+static void checkVipStops()
+{
+	Assembler a;
+	a.label("loop");
+	a.op(0x7001);        //200 V0 += 1
+	a.op(0xF033);        //202 the digits of V0, a cost that changes with V0
+	a.jump("loop");      //204
+	std::vector<std::uint8_t> rom = a.finish();
+
+	auto restart = [&](Chip8 &chip8)
+	{
+		chip8.reset(Platform::chip8);
+		chip8.timing = Timing::cosmacVip;
+		chip8.loadRom(rom.data(), rom.size());
+	};
+
+	const int frames = 10;
+	restart(reference);
+	int referenceExecuted = 0;
+	for (int f = 0; f < frames; f++) { referenceExecuted += reference.runFrame(); }
+
+	restart(emulator);
+	Debugger debugger;
+	debugger.breakpoints = {{0x202}};
+	debugger.update();
+	emulator.debugger = &debugger;
+	int executed = 0;
+	int stops = 0;
+	bool midFrame = true;
+	while (emulator.state.frameCount < frames)
+	{
+		executed += emulator.runFrame();
+		if (debugger.stopped())
+		{
+			stops++;
+			midFrame &= emulator.midFrame() && emulator.state.pc == 0x202;
+			debugger.resume();
+		}
+	}
+	emulator.debugger = nullptr;
+
+	check(stops > frames && midFrame, "vip: the breakpoint stops in the middle of the frames");
+	check(executed == referenceExecuted, "vip: the stopped frames run as many instructions");
+	check(emulator.state.cycleBalance == reference.state.cycleBalance && hashState(emulator.state) == hashState(reference.state),
+		"vip: the stopped frames end like the normal ones");
+}
+
+//a PC that runs past 0xFFF on chip8 fetches from the wrapped address, the breakpoints and the heat see that one
+static void checkWrappedPc()
+{
+	Assembler a;
+	a.op(0x1FFE);        //200 to the last instruction of the memory
+	std::vector<std::uint8_t> rom = a.finish();
+
+	emulator.reset(Platform::chip8);
+	emulator.loadRom(rom.data(), rom.size());
+	writeMemory(emulator.state, 0xFFE, 0x70);
+	writeMemory(emulator.state, 0xFFF, 0x01);  //FFE V0 += 1, the PC goes on to 1000
+	writeMemory(emulator.state, 0x000, 0x12);
+	writeMemory(emulator.state, 0x001, 0x00);  //000 (1000) back to 200
+
+	Debugger debugger;
+	MemoryHeat heat;
+	debugger.heat = &heat;
+	debugger.breakpoints = {{0x000}};
+	debugger.update();
+	emulator.debugger = &debugger;
+
+	emulator.runFrame();
+	check(debugger.stop.reason == Debugger::StopReason::breakpoint && debugger.stop.pc == 0x000 &&
+		emulator.state.pc == 0x1000, "a breakpoint at the wrapped PC stops");
+	check(heat.get(MemoryHeat::execute, 0xFFE) == 1 && heat.get(MemoryHeat::execute, 0xFFF) == 1, "the heat of the last word");
+
+	debugger.resume();
+	emulator.runFrame();
+	check(debugger.stopped() && emulator.state.pc == 0x1000 && emulator.state.v[0] == 2, "it resumes and stops the next time");
+	check(heat.get(MemoryHeat::execute, 0x000) == 1 && heat.get(MemoryHeat::execute, 0x1000) == 0, "the heat is at the wrapped PC");
+	emulator.debugger = nullptr;
+}
+
+//the instruction after FX0A goes through the checks like any other, and the key it writes is a register change
+static void checkKeyWait()
+{
+	Assembler a;
+	a.op(0xA300);        //200 I = 300
+	a.op(0xF30A);        //202 V3 = the next key
+	a.op(0xF333);        //204 the digits of V3 at I
+	a.label("loop");
+	a.jump("loop");      //206
+	std::vector<std::uint8_t> rom = a.finish();
+
+	const std::uint16_t keys[] = {0, 1 << 7, 0, 0, 0};
+	const int frames = sizeof(keys) / sizeof(keys[0]);
+	auto restart = [&](Chip8 &chip8)
+	{
+		chip8.reset(Platform::chip8);
+		chip8.loadRom(rom.data(), rom.size());
+	};
+
+	restart(reference);
+	int referenceExecuted = 0;
+	for (int f = 0; f < frames; f++)
+	{
+		reference.setKeys(keys[f]);
+		referenceExecuted += reference.runFrame();
+	}
+
+	//the frames with the debugger, resuming every stop
+	std::vector<Debugger::Stop> stops;
+	auto run = [&](Debugger &debugger)
+	{
+		restart(emulator);
+		emulator.debugger = &debugger;
+		int executed = 0;
+		while (emulator.state.frameCount < frames)
+		{
+			if (!emulator.midFrame()) { emulator.setKeys(keys[emulator.state.frameCount]); }
+			executed += emulator.runFrame();
+			if (debugger.stopped())
+			{
+				stops.push_back(debugger.stop);
+				debugger.resume();
+			}
+		}
+		emulator.debugger = nullptr;
+		return executed;
+	};
+
+	Debugger debugger;
+	debugger.breakpoints = {{0x204}};
+	Debugger::Watchpoint watch;
+	watch.kind = Debugger::Watchpoint::registerV;
+	watch.address = 3;
+	debugger.watchpoints = {watch};
+	debugger.update();
+	const int executed = run(debugger);
+
+	check(stops.size() == 2, "key wait: the watchpoint and the breakpoint stop once each");
+	if (stops.size() == 2)
+	{
+		check(stops[0].reason == Debugger::StopReason::watchpoint && stops[0].instructionPc == 0x202 && stops[0].pc == 0x204 &&
+			stops[0].oldValue == 0 && stops[0].newValue == 7, "key wait: the watchpoint sees the key written");
+		check(stops[1].reason == Debugger::StopReason::breakpoint && stops[1].pc == 0x204, "key wait: the breakpoint after FX0A stops");
+	}
+	check(debugger.watchpoints[0].hits == 1 && debugger.breakpoints[0].hits == 1, "key wait: the hits are counted");
+	check(executed == referenceExecuted && hashState(emulator.state) == hashState(reference.state),
+		"key wait: the stopped frames end like the normal ones");
+
+	//the trace has no hole after the wait
+	Debugger tracer;
+	Trace trace(10);
+	tracer.trace = &trace;
+	run(tracer);
+	check(trace.recorded() == emulator.state.instructionCount, "key wait: every instruction is traced");
+	bool traced = trace.size() >= 3;
+	for (std::size_t e = 0; e + 1 < trace.size() && traced; e++) { traced = trace[e + 1].pc == std::min(trace[e].pc + 2, 0x206); }
+	check(traced && trace[0].pc == 0x200 && trace[2].pc == 0x204 && trace[2].opcode == 0xF333, "key wait: the trace follows FX0A");
+
+	//the heat of the instruction after the wait and of what it wrote
+	Debugger heater;
+	MemoryHeat heat;
+	heater.heat = &heat;
+	run(heater);
+	check(heat.get(MemoryHeat::execute, 0x204) == 1 && heat.get(MemoryHeat::execute, 0x205) == 1,
+		"key wait: the heat of the instruction after FX0A");
+	check(heat.get(MemoryHeat::write, 0x300) == 1 && heat.get(MemoryHeat::write, 0x302) == 1 && emulator.state.memory[0x302] == 7,
+		"key wait: the heat of its writes");
+
+	//the profiler counts it too
+	Debugger profiling;
+	RomProfiler profiler;
+	profiling.profiler = &profiler;
+	run(profiling);
+	check(profiler.totalInstructions() == emulator.state.instructionCount && profiler.address(0x204).instructions == 1 &&
+		profiler.opcode(0xF033).instructions == 1, "key wait: the profiler counts the instruction after FX0A");
+}
+
+int main()
+{
+	Assembler a;
+	a.op(0x6005);        //200 V0 = 5
+	a.label("loop");
+	a.op(0x7001);        //202 V0 += 1
+	a.op(0xA300);        //204 I = 300
+	a.op(0xF033);        //206 the digits of V0 at I
+	a.op(0x8100);        //208 V1 = V0
+	a.jump("loop");      //20A
+	std::vector<std::uint8_t> rom = a.finish();
+
+	auto restart = [&](Chip8 &chip8)
+	{
+		chip8.reset(Platform::chip8);
+		chip8.loadRom(rom.data(), rom.size());
+	};
+
+	const int frames = 10;
+	restart(reference);
+	for (int f = 0; f < frames; f++) { reference.runFrame(); }
+	const std::uint64_t referenceHash = hashState(reference.state);
+
+	Debugger debugger;
+	emulator.debugger = &debugger;
+
+	//runs the frames resuming every stop, returns the number of stops
+	auto runResuming = [&](int maxStops)
+	{
+		int stops = 0;
+		while (emulator.state.frameCount < frames && stops <= maxStops)
+		{
+			emulator.runFrame();
+			if (debugger.stopped())
+			{
+				stops++;
+				debugger.resume();
+			}
+		}
+		return stops;
+	};
+
+	//a breakpoint that is never reached runs the debug loop to the same end
+	restart(emulator);
+	debugger.breakpoints = {{0xFFE}};
+	debugger.update();
+	check(debugger.armed(), "a breakpoint arms the debugger");
+	check(runResuming(0) == 0, "an unreached breakpoint doesn't stop");
+	check(hashState(emulator.state) == referenceHash, "the debug loop runs like the normal one");
+
+	//stops before the instruction, in the middle of the frame
+	restart(emulator);
+	debugger.breakpoints = {{0x206}};
+	debugger.update();
+	emulator.runFrame();
+	check(debugger.stop.reason == Debugger::StopReason::breakpoint && debugger.stop.index == 0, "the breakpoint stops");
+	check(emulator.state.pc == 0x206 && emulator.state.v[0] == 6, "it stops before the instruction");
+	check(emulator.midFrame() && emulator.state.frameCount == 0, "the frame isn't over");
+	debugger.resume();
+	emulator.runFrame();
+	check(debugger.stopped() && emulator.state.v[0] == 7, "it stops again the next time around the loop");
+	debugger.resume();
+	int stops = runResuming(1000);
+	check(stops > frames, "every time around the loop stops");
+	check(!emulator.midFrame() && hashState(emulator.state) == referenceHash, "the stopped frames end like the normal ones");
+	check(debugger.breakpoints[0].hits == (std::uint64_t)stops + 2, "the hits are counted");
+
+	//conditional
+	restart(emulator);
+	debugger.breakpoints = {{0x206, Debugger::Compare::equal, Debugger::operandV0, 20}};
+	debugger.update();
+	check(runResuming(1000) == 1, "the conditional breakpoint stops once");
+	check(hashState(emulator.state) == referenceHash, "the conditional breakpoint doesn't change the run");
+
+	//a memory watchpoint on the ones digit
+	restart(emulator);
+	debugger.breakpoints.clear();
+	Debugger::Watchpoint memoryWatch;
+	memoryWatch.address = 0x302;
+	debugger.watchpoints = {memoryWatch};
+	debugger.update();
+	emulator.runFrame();
+	const Debugger::Stop &stop = debugger.stop;
+	check(stop.reason == Debugger::StopReason::watchpoint, "the memory watchpoint stops");
+	check(stop.instructionPc == 0x206 && stop.pc == 0x208, "it stops after the instruction that wrote");
+	check(stop.address == 0x302 && stop.oldValue == 0 && stop.newValue == 6, "it reports the write");
+	debugger.resume();
+	check(runResuming(1000) > frames && hashState(emulator.state) == referenceHash, "the memory watchpoint doesn't change the run");
+
+	//a register watchpoint
+	restart(emulator);
+	Debugger::Watchpoint registerWatch;
+	registerWatch.kind = Debugger::Watchpoint::registerV;
+	registerWatch.address = 1;
+	debugger.watchpoints = {registerWatch};
+	debugger.update();
+	emulator.runFrame();
+	check(stop.reason == Debugger::StopReason::watchpoint && stop.instructionPc == 0x208, "the register watchpoint stops");
+	check(stop.oldValue == 0 && stop.newValue == 6, "it reports the change");
+
+	//single steps
+	restart(emulator);
+	debugger.watchpoints.clear();
+	debugger.update();
+	check(!debugger.armed(), "nothing set doesn't arm the debugger");
+	for (std::uint16_t pc : {0x202, 0x204, 0x206})
+	{
+		debugger.stepInstructions(1);
+		emulator.runFrame();
+		check(debugger.stop.reason == Debugger::StopReason::step && emulator.state.pc == pc, "a step runs one instruction");
+	}
+	debugger.resume();
+	runResuming(0);
+	check(hashState(emulator.state) == referenceHash, "the steps don't change the run");
+
+	//the trace keeps the last 16 instructions
+	restart(emulator);
+	Trace trace(4);
+	debugger.trace = &trace;
+	check(debugger.armed(), "a trace arms the debugger");
+	runResuming(0);
+	check(hashState(emulator.state) == referenceHash, "the trace doesn't change the run");
+	check(trace.size() == 16 && trace.recorded() > 16, "the ring keeps its capacity");
+	bool traced = true;
+	for (std::size_t e = 1; e < trace.size(); e++)
+	{
+		//the loop body, 202 to 20A
+		std::uint16_t expected = trace[e - 1].pc == 0x20A ? 0x202 : trace[e - 1].pc + 2;
+		traced &= trace[e].pc == expected;
+		traced &= trace[e].opcode == (emulator.state.memory[expected] << 8 | emulator.state.memory[expected + 1]);
+		if (trace[e].pc == 0x202) { traced &= trace[e].changedRegister == 0; }
+		if (trace[e].pc == 0x204) { traced &= trace[e].changedRegister == traceNoRegister && trace[e].i == 0x300; }
+	}
+	check(traced, "the entries follow the loop");
+	debugger.trace = nullptr;
+
+	const char *tracePath = "chip8-debugger-test.c8t";
+	check(trace.save(tracePath), "the trace saves");
+	if (std::FILE *file = std::fopen(tracePath, "rb"))
+	{
+		std::uint8_t header[32] = {};
+		TraceEntry last;
+		bool read = std::fread(header, 1, sizeof(header), file) == sizeof(header);
+		std::fseek(file, (long)(sizeof(header) + 15 * sizeof(TraceEntry)), SEEK_SET);
+		read &= std::fread(&last, sizeof(last), 1, file) == 1;
+		std::fclose(file);
+		std::remove(tracePath);
+		check(read && std::memcmp(header, "C8TRACE1", 8) == 0 && header[8] == sizeof(TraceEntry) && header[16] == 16,
+			"the file has the header");
+		check(read && std::memcmp(&last, &trace[15], sizeof(last)) == 0, "the file has the entries oldest first");
+	}
+
+	checkHistory();
+	checkDisassembly();
+	checkProfiler();
+	checkVipStops();
+	checkWrappedPc();
+	checkKeyWait();
+
+	std::printf("%s\n", failures ? "FAILED" : "all debugger checks passed");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,401 @@
+//chip8-difftest: runs the core and the reference interpreter side by side and compares them.
+//usage: chip8-difftest [roms or folders...] [--random N] [--frames N] [--interval N] [--seed S] [--plugin file]
+//
+//Every rom (folders are searched for roms) runs with the settings the analyzer picks,
+//--random adds N generated opcode streams with random platforms, quirks and speeds.
+//--plugin runs the one rom given through a plugin made by chip8-recompiler instead of the interpreter.
+//The state hashes are compared every --interval frames. When they differ the run is replayed
+//from the last matching frame to find the first frame and then the first instruction that
+//diverged, and the fields that differ are printed. The exit code is 1 if anything diverged.
+
+#define SDL_MAIN_HANDLED
+#include <SDL2/SDL.h>
+#include "reference.h"
+#include <chip8/chip8.h>
+#include <chip8/hash.h>
+#include <chip8/mappedFile.h>
+#include <chip8/recompiled.h>
+#include <chip8/romAnalyzer.h>
+#include <chip8/romLibrary.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace chip8;
+
+struct TestCase
+{
+	std::string name;
+	std::vector<std::uint8_t> rom;
+	Platform platform = Platform::chip8;
+	Quirks quirks = {};
+	int instructionsPerFrame = 11;
+	CompiledRunner compiled = nullptr;
+};
+
+//both machines, copied whole for the checkpoints
+struct Machines
+{
+	Chip8 fast;
+	ReferenceChip8 reference;
+};
+
+static std::uint64_t splitmix64(std::uint64_t x)
+{
+	x += 0x9E3779B97F4A7C15ull;
+	x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+	x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+	return x ^ (x >> 31);
+}
+
+//the same keys for a frame on every replay, held for a few frames so FX0A sees releases
+static std::uint16_t frameKeys(std::uint64_t caseSeed, std::uint64_t frame)
+{
+	std::uint64_t r = splitmix64(caseSeed ^ (frame / 4));
+	return (r & 3) ? 0 : (std::uint16_t)(1 << ((r >> 8) & 15));
+}
+
+static void runFrame(Machines &m, std::uint64_t caseSeed)
+{
+	std::uint16_t keys = frameKeys(caseSeed, m.fast.state.frameCount);
+	m.fast.setKeys(keys);
+	m.reference.state.keys = keys;
+	m.fast.runFrame();
+	m.reference.runFrame();
+}
+
+//one instruction of the fast core, through the recompiled code when it takes it
+static void stepFast(Chip8 &fast)
+{
+	if (fast.compiled && !fast.state.halted && !fast.state.waitingForKey && fast.compiled(fast.state, 1)) { return; }
+	fast.step();
+}
+
+static bool statesMatch(Machines &m)
+{
+	return hashState(m.fast.state) == m.reference.hash();
+}
+
+static void printDifferences(Machines &m)
+{
+	const State &a = m.fast.state;
+	const State &b = m.reference.state;
+
+	auto field = [](const char *name, long long fast, long long reference)
+	{
+		if (fast != reference) { std::printf("    %-12s core %llx, reference %llx\n", name, fast, reference); }
+	};
+
+	field("pc", a.pc, b.pc);
+	field("i", a.i, b.i);
+	field("sp", a.sp, b.sp);
+	for (int r = 0; r < 16; r++)
+	{
+		char name[8];
+		std::snprintf(name, sizeof(name), "v%X", r);
+		field(name, a.v[r], b.v[r]);
+	}
+	for (int r = 0; r < stackSize; r++) { field("stack", a.stack[r], b.stack[r]); }
+	field("delay timer", a.delayTimer, b.delayTimer);
+	field("sound timer", a.soundTimer, b.soundTimer);
+	field("plane mask", a.planeMask, b.planeMask);
+	field("pitch", a.pitch, b.pitch);
+	field("rng", a.rng, b.rng);
+	field("halted", a.halted, b.halted);
+	field("waiting", a.waitingForKey, b.waitingForKey);
+	field("wait keys", a.waitKeys, b.waitKeys);
+	field("hires", a.display.hires, b.display.hires);
+
+	for (int r = 0; r < 16; r++) { field("flags", a.flags[r], b.flags[r]); field("audio", a.audioPattern[r], b.audioPattern[r]); }
+
+	for (int address = 0; address < memorySize; address++)
+	{
+		if (a.memory[address] != b.memory[address])
+		{
+			std::printf("    memory %04X  core %02X, reference %02X\n", address, a.memory[address], b.memory[address]);
+			break;
+		}
+	}
+
+	for (int p = 0; p < displayPlanes; p++)
+	{
+		for (int y = 0; y < displayMaxHeight; y++)
+		{
+			if (std::memcmp(a.display.planes[p][y], b.display.planes[p][y], displayRowBytes))
+			{
+				std::printf("    display plane %d row %d differs\n", p, y);
+				p = displayPlanes;
+				break;
+			}
+		}
+	}
+
+	//the same state with a different hash means the core didn't keep its incremental hashes up to date
+	State recomputed = a;
+	rehashState(recomputed);
+	if (recomputed.memoryHash != a.memoryHash) { std::printf("    the incremental memory hash of the core is wrong\n"); }
+	if (recomputed.displayHash != a.displayHash) { std::printf("    the incremental display hash of the core is wrong\n"); }
+}
+
+//Replays from the checkpoint to find the first frame whose hashes differ (binary search),
+//then steps that frame one instruction at a time.
+static void bisect(const Machines &checkpoint, std::uint64_t caseSeed, std::uint64_t badFrame)
+{
+	std::uint64_t good = checkpoint.fast.state.frameCount;
+	std::uint64_t bad = badFrame;
+	auto probe = std::make_unique<Machines>();
+
+	while (bad - good > 1)
+	{
+		std::uint64_t middle = good + (bad - good) / 2;
+		*probe = checkpoint;
+		while (probe->fast.state.frameCount < middle) { runFrame(*probe, caseSeed); }
+
+		if (statesMatch(*probe)) { good = middle; }
+		else { bad = middle; }
+	}
+
+	*probe = checkpoint;
+	while (probe->fast.state.frameCount < good) { runFrame(*probe, caseSeed); }
+
+	//how many instructions the frame runs, at least one step for halts and key waits
+	auto counter = std::make_unique<Machines>(*probe);
+	std::uint64_t fastStart = counter->fast.state.instructionCount;
+	std::uint64_t referenceStart = counter->reference.state.instructionCount;
+	runFrame(*counter, caseSeed);
+	std::uint64_t fastExecuted = counter->fast.state.instructionCount - fastStart;
+	std::uint64_t referenceExecuted = counter->reference.state.instructionCount - referenceStart;
+	std::uint64_t steps = std::max(fastExecuted, referenceExecuted) + 1;
+
+	std::uint16_t keys = frameKeys(caseSeed, good);
+	probe->fast.setKeys(keys);
+	probe->reference.state.keys = keys;
+
+	for (std::uint64_t s = 0; s < steps; s++)
+	{
+		std::uint16_t pc = probe->fast.state.pc;
+		std::uint32_t mask = probe->fast.memoryMask;
+		std::uint16_t opcode = (std::uint16_t)((probe->fast.state.memory[pc & mask] << 8) | probe->fast.state.memory[(pc + 1) & mask]);
+
+		stepFast(probe->fast);
+		probe->reference.step();
+
+		if (!statesMatch(*probe))
+		{
+			std::printf("  first divergence in frame %llu, instruction %llu of the frame: %04X at %03X\n",
+				(unsigned long long)good, (unsigned long long)s, opcode, pc);
+			printDifferences(*probe);
+			return;
+		}
+	}
+
+	std::printf("  first divergence at the end of frame %llu (the core ran %llu instructions, the reference %llu)\n",
+		(unsigned long long)good, (unsigned long long)fastExecuted, (unsigned long long)referenceExecuted);
+	printDifferences(*counter);
+}
+
+static bool runCase(const TestCase &test, std::uint64_t caseSeed, std::uint64_t frames, std::uint64_t interval)
+{
+	auto machines = std::make_unique<Machines>();
+	Chip8 &fast = machines->fast;
+
+	fast.reset(test.platform, test.quirks, (std::uint32_t)splitmix64(caseSeed) | 1);
+	fast.instructionsPerFrame = test.instructionsPerFrame;
+	if (!fast.loadRom(test.rom.data(), test.rom.size()))
+	{
+		std::printf("%s: the rom is too big for %s\n", test.name.c_str(), platformName(test.platform));
+		return false;
+	}
+	fast.compiled = test.compiled;
+	machines->reference.start(fast);
+
+	auto checkpoint = std::make_unique<Machines>(*machines);
+
+	for (std::uint64_t frame = 1; frame <= frames; frame++)
+	{
+		runFrame(*machines, caseSeed);
+
+		if (frame % interval && frame != frames) { continue; }
+
+		if (statesMatch(*machines))
+		{
+			*checkpoint = *machines;
+			continue;
+		}
+
+		std::printf("%s: %s quirks %02x, %d instructions per frame diverged before frame %llu\n", test.name.c_str(),
+			platformName(test.platform), quirksToBits(test.quirks), test.instructionsPerFrame, (unsigned long long)frame);
+		bisect(*checkpoint, caseSeed, frame);
+		return false;
+	}
+
+	return true;
+}
+
+//Random instruction streams: every opcode group is equally likely, with the operands random,
+//so the rarer instructions (scrolls, plane selection, register ranges) get run too.
+static std::vector<std::uint8_t> randomRom(std::uint64_t seed, std::size_t size)
+{
+	std::vector<std::uint8_t> rom(size);
+	for (std::size_t a = 0; a + 1 < size; a += 2)
+	{
+		std::uint64_t r = splitmix64(seed + a);
+		std::uint16_t opcode = (std::uint16_t)r;
+
+		switch ((r >> 16) & 7)
+		{
+		case 0:
+		{
+			//no 00FD, a halted program doesn't test anything
+			static const std::uint16_t system[] = {0x00C0, 0x00D0, 0x00E0, 0x00EE, 0x00FB, 0x00FC, 0x00FE, 0x00FF};
+			int k = (r >> 20) & 7;
+			opcode = (std::uint16_t)(system[k] | (k < 2 ? (r >> 24) & 0xF : 0));
+		}
+		break;
+		//jumps and calls stay in the rom
+		case 1: opcode = (std::uint16_t)((opcode & 0xF000) | (programStart + ((r >> 32) % size & ~1ull))); break;
+		case 2: opcode = (std::uint16_t)(0x5000 | (opcode & 0x0FF0) | ((r >> 32) % 4)); break;
+		case 3: opcode = (std::uint16_t)(0x8000 | (opcode & 0x0FF0) | ((r >> 32) % 8 == 7 ? 0xE : (r >> 32) % 8)); break;
+		case 4:
+		{
+			static const std::uint8_t fx[] = {0x00, 0x01, 0x02, 0x07, 0x0A, 0x15, 0x18, 0x1E, 0x29, 0x30, 0x33, 0x3A, 0x55, 0x65, 0x75, 0x85};
+			opcode = (std::uint16_t)(0xF000 | (opcode & 0x0F00) | fx[(r >> 32) & 15]);
+		}
+		break;
+		default: break; //anything, mostly the common arithmetic, skips and draws
+		}
+
+		rom[a] = (std::uint8_t)(opcode >> 8);
+		rom[a + 1] = (std::uint8_t)opcode;
+	}
+	return rom;
+}
+
+static void addRom(std::vector<TestCase> &cases, const std::string &path)
+{
+	MappedFile file;
+	if (!file.open(path.c_str()))
+	{
+		std::fprintf(stderr, "can't read %s\n", path.c_str());
+		return;
+	}
+
+	RomAnalysis analysis = analyzeRom(file.data, file.size);
+
+	TestCase test;
+	test.name = path;
+	test.rom.assign(file.data, file.data + file.size);
+	test.platform = analysis.platform;
+	test.quirks = analysis.quirks;
+	test.instructionsPerFrame = analysis.instructionsPerFrame;
+	cases.push_back(std::move(test));
+}
+
+static bool usePlugin(TestCase &test, const char *path, void *&handle)
+{
+	handle = SDL_LoadObject(path);
+	if (!handle) { return false; }
+
+	auto get = (GetRecompiledRom)SDL_LoadFunction(handle, CHIP8_RECOMPILED_ROM_ENTRY);
+	const RecompiledRom *rom = get ? get() : nullptr;
+	if (!rom || rom->abiVersion != recompiledAbiVersion || rom->stateSize != sizeof(State)) { return false; }
+	if (rom->romHash != xxHash64(test.rom.data(), test.rom.size())) { return false; }
+
+	//the plugin decides the settings, the code was translated for them
+	test.platform = rom->platform;
+	test.quirks = quirksFromBits(rom->quirks);
+	test.compiled = rom->run;
+	test.name += " (recompiled)";
+	return true;
+}
+
+int main(int argc, char *argv[])
+{
+	std::vector<TestCase> cases;
+	std::vector<std::string> roms;
+	long long randomCount = 0;
+	std::uint64_t frames = 600;
+	std::uint64_t interval = 16;
+	std::uint64_t seed = 1;
+	const char *pluginPath = nullptr;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!std::strcmp(argv[i], "--random") && i + 1 < argc) { randomCount = std::atoll(argv[++i]); }
+		else if (!std::strcmp(argv[i], "--frames") && i + 1 < argc) { frames = std::strtoull(argv[++i], nullptr, 10); }
+		else if (!std::strcmp(argv[i], "--interval") && i + 1 < argc) { interval = std::strtoull(argv[++i], nullptr, 10); }
+		else if (!std::strcmp(argv[i], "--seed") && i + 1 < argc) { seed = std::strtoull(argv[++i], nullptr, 10); }
+		else if (!std::strcmp(argv[i], "--plugin") && i + 1 < argc) { pluginPath = argv[++i]; }
+		else if (argv[i][0] != '-') { roms.push_back(argv[i]); }
+		else
+		{
+			std::fprintf(stderr, "unknown argument %s\n", argv[i]);
+			return 2;
+		}
+	}
+	if (interval == 0) { interval = 1; }
+
+	for (const std::string &path : roms)
+	{
+		std::error_code error;
+		if (!std::filesystem::is_directory(path, error))
+		{
+			addRom(cases, path);
+			continue;
+		}
+
+		std::vector<std::string> found;
+		for (auto &entry : std::filesystem::recursive_directory_iterator(path, error))
+		{
+			std::string file = entry.path().generic_string();
+			if (entry.is_regular_file(error) && RomLibrary::isRomFile(file)) { found.push_back(file); }
+		}
+		std::sort(found.begin(), found.end());
+		for (const std::string &file : found) { addRom(cases, file); }
+	}
+
+	void *plugin = nullptr;
+	if (pluginPath)
+	{
+		if (cases.size() != 1 || !usePlugin(cases[0], pluginPath, plugin))
+		{
+			std::fprintf(stderr, "--plugin needs one rom and a plugin made from it, %s can't be used\n", pluginPath);
+			return 2;
+		}
+	}
+
+	for (long long r = 0; r < randomCount; r++)
+	{
+		std::uint64_t caseSeed = splitmix64(seed * 0x100000001B3ull + r);
+
+		TestCase test;
+		test.name = "random " + std::to_string(r);
+		test.platform = (Platform)(r % 3);
+		test.quirks = quirksFromBits((std::uint32_t)(caseSeed >> 8));
+		test.instructionsPerFrame = 1 + (int)((caseSeed >> 16) % 200);
+		test.rom = randomRom(caseSeed, test.platform == Platform::xoChip ? 0x2000 : 0xE00);
+		cases.push_back(std::move(test));
+	}
+
+	if (cases.empty())
+	{
+		std::fprintf(stderr, "usage: chip8-difftest [roms or folders...] [--random N] [--frames N] [--interval N] [--seed S] [--plugin file]\n");
+		return 2;
+	}
+
+	int failed = 0;
+	for (std::size_t c = 0; c < cases.size(); c++)
+	{
+		if (!runCase(cases[c], splitmix64(seed + c), frames, interval)) { failed++; }
+	}
+
+	if (plugin) { SDL_UnloadObject(plugin); }
+
+	std::printf("%d of %d runs of %llu frames diverged\n", failed, (int)cases.size(), (unsigned long long)frames);
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,346 @@
+#include "reference.h"
+#include <cstring>
+
+using namespace chip8;
+
+void ReferenceChip8::start(const Chip8 &emulator)
+{
+	state = emulator.state;
+	platform = emulator.platform;
+	quirks = emulator.quirks;
+	instructionsPerFrame = emulator.instructionsPerFrame;
+	memoryMask = emulator.memoryMask;
+}
+
+std::uint64_t ReferenceChip8::hash()
+{
+	rehashState(state);
+	return hashState(state);
+}
+
+bool ReferenceChip8::getPixel(int plane, int x, int y) const
+{
+	return state.display.getPixel(plane, x, y);
+}
+
+void ReferenceChip8::setPixel(int plane, int x, int y, bool on)
+{
+	std::uint8_t &byte = state.display.planes[plane][y][x / 8];
+	std::uint8_t bit = (std::uint8_t)(0x80 >> (x % 8));
+	if (on) { byte |= bit; }
+	else { byte &= ~bit; }
+}
+
+void ReferenceChip8::skip()
+{
+	bool longInstruction = platform == Platform::xoChip && read(state.pc) == 0xF0 && read(state.pc + 1) == 0x00;
+	state.pc += longInstruction ? 4 : 2;
+}
+
+void ReferenceChip8::scroll(int dx, int dy)
+{
+	const int w = state.display.width();
+	const int h = state.display.height();
+
+	for (int p = 0; p < displayPlanes; p++)
+	{
+		if (!planeSelected(p)) { continue; }
+
+		Display old = state.display;
+		for (int y = 0; y < h; y++)
+		{
+			for (int x = 0; x < w; x++)
+			{
+				int fromX = x - dx;
+				int fromY = y - dy;
+				bool inside = fromX >= 0 && fromX < w && fromY >= 0 && fromY < h;
+				setPixel(p, x, y, inside && old.getPixel(p, fromX, fromY));
+			}
+		}
+	}
+}
+
+void ReferenceChip8::draw(int xRegister, int yRegister, int n)
+{
+	const int w = state.display.width();
+	const int h = state.display.height();
+	const int x = state.v[xRegister] % w;
+	const int y = state.v[yRegister] % h;
+
+	const bool big = n == 0 && platform != Platform::chip8;
+	const int rows = big ? 16 : n;
+	const int columns = big ? 16 : 8;
+
+	std::uint32_t address = state.i;
+	int collisions = 0;
+
+	for (int p = 0; p < displayPlanes; p++)
+	{
+		if (!planeSelected(p)) { continue; }
+
+		for (int r = 0; r < rows; r++)
+		{
+			std::uint16_t bits = read(address++);
+			if (big) { bits = (std::uint16_t)((bits << 8) | read(address++)); }
+			else { bits <<= 8; }
+
+			int py = y + r;
+			if (py >= h)
+			{
+				if (quirks.clipping)
+				{
+					if (platform == Platform::schip && state.display.hires) { collisions++; }
+					continue;
+				}
+				py -= h;
+			}
+
+			bool hit = false;
+			for (int c = 0; c < columns; c++)
+			{
+				if (!(bits & (0x8000 >> c))) { continue; }
+
+				int px = x + c;
+				if (px >= w)
+				{
+					if (quirks.clipping) { continue; }
+					px -= w;
+				}
+
+				bool on = getPixel(p, px, py);
+				if (on) { hit = true; }
+				setPixel(p, px, py, !on);
+			}
+
+			if (hit) { collisions++; }
+		}
+	}
+
+	if (platform == Platform::schip && state.display.hires) { state.v[0xF] = (std::uint8_t)collisions; }
+	else { state.v[0xF] = collisions ? 1 : 0; }
+}
+
+void ReferenceChip8::step()
+{
+	State &s = state;
+
+	if (s.halted) { return; }
+
+	if (s.waitingForKey)
+	{
+		std::uint16_t released = s.waitKeys & ~s.keys;
+		if (!released)
+		{
+			s.waitKeys |= s.keys;
+			return;
+		}
+
+		for (int key = 0; key < 16; key++)
+		{
+			if (released & (1 << key))
+			{
+				s.v[s.keyRegister] = (std::uint8_t)key;
+				break;
+			}
+		}
+		s.waitingForKey = false;
+		s.waitKeys = 0;
+	}
+
+	const std::uint16_t opcode = (std::uint16_t)((read(s.pc) << 8) | read(s.pc + 1));
+	s.pc += 2;
+	s.instructionCount++;
+	if (onInstruction) { onInstruction(opcode); }
+
+	const int x = (opcode >> 8) & 0xF;
+	const int y = (opcode >> 4) & 0xF;
+	const int n = opcode & 0xF;
+	const std::uint8_t nn = opcode & 0xFF;
+	const std::uint16_t nnn = opcode & 0xFFF;
+	std::uint8_t &vx = s.v[x];
+	std::uint8_t &vy = s.v[y];
+	std::uint8_t &vf = s.v[0xF];
+
+	switch (opcode >> 12)
+	{
+	case 0x0:
+		if ((opcode & 0xFFF0) == 0x00C0) { scroll(0, n); }
+		else if ((opcode & 0xFFF0) == 0x00D0) { scroll(0, -n); }
+		else if (opcode == 0x00E0)
+		{
+			for (int p = 0; p < displayPlanes; p++)
+			{
+				if (planeSelected(p)) { std::memset(s.display.planes[p], 0, sizeof(s.display.planes[p])); }
+			}
+		}
+		else if (opcode == 0x00EE)
+		{
+			s.sp = (s.sp + stackSize - 1) % stackSize;
+			s.pc = s.stack[s.sp];
+		}
+		else if (opcode == 0x00FB) { scroll(4, 0); }
+		else if (opcode == 0x00FC) { scroll(-4, 0); }
+		else if (opcode == 0x00FD) { s.halted = true; }
+		else if (opcode == 0x00FE || opcode == 0x00FF)
+		{
+			s.display.hires = opcode == 0x00FF;
+			s.display.clear();
+		}
+		break;
+
+	case 0x1: s.pc = nnn; break;
+
+	case 0x2:
+		s.stack[s.sp] = s.pc;
+		s.sp = (s.sp + 1) % stackSize;
+		s.pc = nnn;
+		break;
+
+	case 0x3: if (vx == nn) { skip(); } break;
+	case 0x4: if (vx != nn) { skip(); } break;
+
+	case 0x5:
+		if (n == 0)
+		{
+			if (vx == vy) { skip(); }
+		}
+		else if (n == 2 || n == 3)
+		{
+			int count = (x <= y ? y - x : x - y) + 1;
+			int direction = x <= y ? 1 : -1;
+			for (int a = 0; a < count; a++)
+			{
+				int r = x + a * direction;
+				if (n == 2) { write(s.i + a, s.v[r]); }
+				else { s.v[r] = read(s.i + a); }
+			}
+		}
+		break;
+
+	case 0x6: vx = nn; break;
+	case 0x7: vx = (std::uint8_t)(vx + nn); break;
+
+	case 0x8:
+	{
+		const std::uint8_t a = vx;
+		const std::uint8_t b = vy;
+		switch (n)
+		{
+		case 0x0: vx = b; break;
+		case 0x1: vx = a | b; if (quirks.vfReset) { vf = 0; } break;
+		case 0x2: vx = a & b; if (quirks.vfReset) { vf = 0; } break;
+		case 0x3: vx = a ^ b; if (quirks.vfReset) { vf = 0; } break;
+		case 0x4: vx = (std::uint8_t)(a + b); vf = a + b > 255 ? 1 : 0; break;
+		case 0x5: vx = (std::uint8_t)(a - b); vf = a >= b ? 1 : 0; break;
+		case 0x7: vx = (std::uint8_t)(b - a); vf = b >= a ? 1 : 0; break;
+		case 0x6:
+		{
+			std::uint8_t value = quirks.shiftVx ? a : b;
+			vx = value / 2;
+			vf = value % 2;
+		}
+		break;
+		case 0xE:
+		{
+			std::uint8_t value = quirks.shiftVx ? a : b;
+			vx = (std::uint8_t)(value * 2);
+			vf = value >= 128 ? 1 : 0;
+		}
+		break;
+		}
+	}
+	break;
+
+	case 0x9: if (n == 0 && vx != vy) { skip(); } break;
+	case 0xA: s.i = nnn; break;
+	case 0xB: s.pc = (std::uint16_t)(nnn + (quirks.jumpVx ? vx : s.v[0])); break;
+
+	case 0xC:
+	{
+		std::uint32_t r = s.rng;
+		r ^= r << 13;
+		r ^= r >> 17;
+		r ^= r << 5;
+		s.rng = r;
+		vx = (std::uint8_t)(r >> 24) & nn;
+	}
+	break;
+
+	case 0xD: draw(x, y, n); drew = true; break;
+
+	case 0xE:
+	{
+		bool down = (s.keys >> (vx % 16)) & 1;
+		if (nn == 0x9E && down) { skip(); }
+		if (nn == 0xA1 && !down) { skip(); }
+	}
+	break;
+
+	case 0xF:
+		switch (nn)
+		{
+		case 0x00:
+			if (x == 0)
+			{
+				s.i = (std::uint16_t)((read(s.pc) << 8) | read(s.pc + 1));
+				s.pc += 2;
+			}
+			break;
+		case 0x01: s.planeMask = x % 4; break;
+		case 0x02: for (int a = 0; a < 16; a++) { s.audioPattern[a] = read(s.i + a); } break;
+		case 0x07: vx = s.delayTimer; break;
+		case 0x0A: s.waitingForKey = true; s.keyRegister = (std::uint8_t)x; s.waitKeys = 0; break;
+		case 0x15: s.delayTimer = vx; break;
+		case 0x18: s.soundTimer = vx; break;
+		case 0x1E: s.i = (std::uint16_t)(s.i + vx); break;
+		case 0x29: s.i = (std::uint16_t)(smallFontAddress + (vx % 16) * 5); break;
+		case 0x30: s.i = (std::uint16_t)(bigFontAddress + (vx % 16) * 10); break;
+		case 0x33:
+		{
+			std::uint8_t value = vx;
+			write(s.i, value / 100);
+			write(s.i + 1, (value / 10) % 10);
+			write(s.i + 2, value % 10);
+		}
+		break;
+		case 0x3A: s.pitch = vx; break;
+		case 0x55:
+			for (int r = 0; r <= x; r++) { write(s.i + r, s.v[r]); }
+			if (quirks.memoryIncrement) { s.i = (std::uint16_t)(s.i + x + 1); }
+			break;
+		case 0x65:
+			for (int r = 0; r <= x; r++) { s.v[r] = read(s.i + r); }
+			if (quirks.memoryIncrement) { s.i = (std::uint16_t)(s.i + x + 1); }
+			break;
+		case 0x75: for (int r = 0; r <= x; r++) { s.flags[r] = s.v[r]; } break;
+		case 0x85: for (int r = 0; r <= x; r++) { s.v[r] = s.flags[r]; } break;
+		}
+		break;
+	}
+}
+
+int ReferenceChip8::runFrame()
+{
+	int executed = 0;
+
+	while (executed < instructionsPerFrame)
+	{
+		if (state.halted || state.waitingForKey)
+		{
+			step();
+			break;
+		}
+
+		drew = false;
+		step();
+		executed++;
+
+		if (drew && quirks.displayWait && !state.display.hires) { break; }
+	}
+
+	if (state.delayTimer) { state.delayTimer--; }
+	if (state.soundTimer) { state.soundTimer--; }
+	state.frameCount++;
+
+	return executed;
+}
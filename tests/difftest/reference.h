@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <chip8/chip8.h>
+
+//The reference for the differential tests: a slow interpreter written straight from the spec,
+//one pixel at a time and without any of the tricks of the core (no byte wide sprite xor,
+//no incremental hashes, no recompiled code). It shares chip8::State so the states can be compared.
+struct ReferenceChip8
+{
+	chip8::State state;
+
+	chip8::Platform platform = chip8::Platform::chip8;
+	chip8::Quirks quirks = {};
+	int instructionsPerFrame = 11;
+	std::uint32_t memoryMask = 0xFFF;
+
+	//called with every opcode before it runs, the fuzzer counts them for coverage
+	void (*onInstruction)(std::uint16_t opcode) = nullptr;
+
+	//copies the state and the settings, the fonts and the rom come from the core
+	void start(const chip8::Chip8 &emulator);
+
+	void step();
+	int runFrame();
+
+	//the hash of the state computed from scratch, comparable with chip8::hashState of the core
+	std::uint64_t hash();
+
+private:
+
+	std::uint8_t read(std::uint32_t address) const { return state.memory[address & memoryMask]; }
+	void write(std::uint32_t address, std::uint8_t value) { state.memory[address & memoryMask] = value; }
+
+	bool getPixel(int plane, int x, int y) const;
+	void setPixel(int plane, int x, int y, bool on);
+	bool planeSelected(int plane) const { return state.planeMask & (1 << plane); }
+
+	void skip();
+	void draw(int x, int y, int n);
+	void scroll(int dx, int dy);
+
+	bool drew = false;
+};
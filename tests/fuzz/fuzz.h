@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <chip8/chip8.h>
+
+//A fuzz input: 4 bytes of settings, the keypad of the first frames, then the rom.
+//
+//  byte 0   platform (modulo 3)
+//  byte 1   quirk bits (quirksFromBits)
+//  byte 2   instructions per frame - 1
+//  byte 3   number of key frames, 2 bytes each follow
+//  ...      the rom
+//
+//Every input runs fuzzFrames frames, the keys repeat when there are fewer key frames.
+struct FuzzInput
+{
+	chip8::Platform platform = chip8::Platform::chip8;
+	chip8::Quirks quirks = {};
+	int instructionsPerFrame = 1;
+
+	const std::uint8_t *keys = nullptr;
+	std::size_t keyFrames = 0;
+
+	const std::uint8_t *rom = nullptr;
+	std::size_t romSize = 0;
+
+	bool parse(const std::uint8_t *data, std::size_t size)
+	{
+		if (size < 4) { return false; }
+
+		platform = (chip8::Platform)(data[0] % 3);
+		quirks = chip8::quirksFromBits(data[1]);
+		instructionsPerFrame = data[2] + 1;
+
+		keys = data + 4;
+		keyFrames = data[3];
+		if (keyFrames * 2 > size - 4) { keyFrames = (size - 4) / 2; }
+
+		rom = keys + keyFrames * 2;
+		romSize = size - 4 - keyFrames * 2;
+		return true;
+	}
+
+	std::uint16_t frameKeys(std::uint64_t frame) const
+	{
+		if (!keyFrames) { return 0; }
+		const std::uint8_t *k = keys + (frame % keyFrames) * 2;
+		return (std::uint16_t)(k[0] | (k[1] << 8));
+	}
+};
+
+constexpr int fuzzFrames = 60;
+
+inline std::vector<std::uint8_t> encodeFuzzInput(chip8::Platform platform, const chip8::Quirks &quirks,
+	int instructionsPerFrame, const std::vector<std::uint16_t> &keys, const std::uint8_t *rom, std::size_t romSize)
+{
+	std::vector<std::uint8_t> data;
+	data.push_back((std::uint8_t)platform);
+	data.push_back((std::uint8_t)chip8::quirksToBits(quirks));
+	data.push_back((std::uint8_t)(instructionsPerFrame - 1));
+	data.push_back((std::uint8_t)keys.size());
+	for (std::uint16_t k : keys)
+	{
+		data.push_back((std::uint8_t)k);
+		data.push_back((std::uint8_t)(k >> 8));
+	}
+	data.insert(data.end(), rom, rom + romSize);
+	return data;
+}
+
+//Coverage of the opcode handlers on top of the compiler instrumentation: one counter per pair of
+//consecutive handlers. libFuzzer reads them from its extra counters section, the replay driver
+//uses them to keep the mutations that reached new pairs.
+constexpr int fuzzCounterCount = 4096;
+extern std::uint8_t fuzzCounters[fuzzCounterCount];
+
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t *data, std::size_t size);
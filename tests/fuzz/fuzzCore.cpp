@@ -0,0 +1,103 @@
+//The fuzz target of the core: runs a rom from the input with its settings and keys,
+//next to the reference interpreter of the differential tests, and aborts when
+//- the core runs more instructions in a frame than it was given (a runaway fast path)
+//- the incremental hashes of the core don't match the state
+//- the core and the reference end up in different states
+//Out of bounds accesses and undefined behaviour are left to the sanitizers.
+
+#include "fuzz.h"
+#include "reference.h"
+#include <cstdio>
+#include <cstdlib>
+
+using namespace chip8;
+
+#if defined(__linux__)
+__attribute__((used, section("__libfuzzer_extra_counters")))
+#endif
+std::uint8_t fuzzCounters[fuzzCounterCount];
+
+//a small id for every opcode handler of the core, the operands don't matter
+static int handlerId(std::uint16_t opcode)
+{
+	const int group = opcode >> 12;
+	const int n = opcode & 0xF;
+	const int nn = opcode & 0xFF;
+	int handler = 0;
+
+	switch (group)
+	{
+	case 0x0:
+		if ((opcode & 0xFFF0) == 0x00C0) { handler = 1; }
+		else if ((opcode & 0xFFF0) == 0x00D0) { handler = 2; }
+		else if (opcode >= 0x00E0 && opcode <= 0x00FF) { handler = 3 + (opcode & 0x1F); }
+		break;
+	case 0x5: case 0x8: case 0x9: handler = n; break;
+	case 0xE: handler = nn == 0x9E ? 1 : nn == 0xA1 ? 2 : 0; break;
+	case 0xF:
+	{
+		static const std::uint8_t known[] = {0x00, 0x01, 0x02, 0x07, 0x0A, 0x15, 0x18, 0x1E, 0x29, 0x30, 0x33, 0x3A, 0x55, 0x65, 0x75, 0x85};
+		handler = 16;
+		for (int k = 0; k < 16; k++) { if (known[k] == nn) { handler = k; break; } }
+	}
+	break;
+	case 0xD: handler = n == 0 ? 1 : 0; break;
+	}
+
+	return group * 64 + handler;
+}
+
+static int previousHandler = 0;
+
+static void countInstruction(std::uint16_t opcode)
+{
+	int handler = handlerId(opcode);
+	std::uint8_t &counter = fuzzCounters[(previousHandler * 1024 + handler) % fuzzCounterCount];
+	if (counter != 0xFF) { counter++; }
+	previousHandler = handler;
+}
+
+static void fail(const char *message, const FuzzInput &input)
+{
+	std::fprintf(stderr, "chip8-fuzz: %s (%s, quirks %02x, %d instructions per frame, rom of %zu bytes)\n", message,
+		platformName(input.platform), quirksToBits(input.quirks), input.instructionsPerFrame, input.romSize);
+	std::abort();
+}
+
+//the states are 66 KB each so they don't go on the stack
+static Chip8 fast;
+static ReferenceChip8 reference;
+static State recomputed;
+
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t *data, std::size_t size)
+{
+	FuzzInput input;
+	if (!input.parse(data, size)) { return 0; }
+
+	fast.reset(input.platform, input.quirks);
+	fast.instructionsPerFrame = input.instructionsPerFrame;
+	if (!fast.loadRom(input.rom, input.romSize)) { return 0; }
+
+	reference.start(fast);
+	reference.onInstruction = countInstruction;
+	previousHandler = 0;
+
+	for (int frame = 0; frame < fuzzFrames; frame++)
+	{
+		std::uint16_t keys = input.frameKeys(frame);
+		fast.setKeys(keys);
+		reference.state.keys = keys;
+
+		if (fast.runFrame() > input.instructionsPerFrame) { fail("a frame ran more instructions than it was given", input); }
+		reference.runFrame();
+	}
+
+	recomputed = fast.state;
+	rehashState(recomputed);
+	if (recomputed.memoryHash != fast.state.memoryHash) { fail("the incremental memory hash is wrong", input); }
+	if (recomputed.displayHash != fast.state.displayHash) { fail("the incremental display hash is wrong", input); }
+
+	if (hashState(fast.state) != reference.hash()) { fail("the core and the reference interpreter diverged", input); }
+
+	return 0;
+}
@@ -0,0 +1,282 @@
+//The driver of chip8-fuzz for compilers without libFuzzer.
+//usage: chip8-fuzz corpus files or folders... [-runs=N] [-seed=S] [-timeout=seconds]
+//
+//Runs every input of the corpus, then mutates them for -runs executions (0 only replays the corpus,
+//which is what the test does). A mutation is kept when it reaches a new count bucket of the
+//handler pair counters, and it is written to the first folder given.
+//Crashes, sanitizer reports and inputs that run longer than -timeout leave the input in crash-chip8-fuzz.
+
+#include "fuzz.h"
+#include <chip8/hash.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__SANITIZE_ADDRESS__) || defined(__SANITIZE_UNDEFINED__)
+#include <sanitizer/common_interface_defs.h>
+#define CHIP8_FUZZ_DEATH_CALLBACK 1
+#endif
+
+namespace fs = std::filesystem;
+
+static const char *crashPath = "crash-chip8-fuzz";
+
+static const std::uint8_t *currentData = nullptr;
+static std::size_t currentSize = 0;
+static std::atomic<long long> currentStart{0}; //ms since the start of the driver, 0 while idle
+
+static const auto driverStart = std::chrono::steady_clock::now();
+
+static long long milliseconds()
+{
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - driverStart).count() + 1;
+}
+
+//also called from the crash handler, stdio there is fine for a process that is dying anyway
+static void saveCurrentInput()
+{
+	if (!currentData) { return; }
+
+	std::FILE *file = std::fopen(crashPath, "wb");
+	if (!file) { return; }
+	std::fwrite(currentData, 1, currentSize, file);
+	std::fclose(file);
+
+	const char message[] = "chip8-fuzz: the input was saved to crash-chip8-fuzz\n";
+	std::fwrite(message, 1, sizeof(message) - 1, stderr);
+}
+
+static void crashHandler(int signal)
+{
+	saveCurrentInput();
+	std::signal(signal, SIG_DFL);
+	std::raise(signal);
+}
+
+static void runInput(const std::vector<std::uint8_t> &input)
+{
+	currentData = input.data();
+	currentSize = input.size();
+	currentStart.store(milliseconds());
+
+	LLVMFuzzerTestOneInput(input.data(), input.size());
+
+	currentStart.store(0);
+}
+
+//the same buckets as libFuzzer, a loop running 5 or 6 times isn't new coverage
+static std::uint8_t bucket(std::uint8_t count)
+{
+	if (count == 0) { return 0; }
+	if (count <= 3) { return (std::uint8_t)(1 << (count - 1)); }
+	if (count <= 7) { return 8; }
+	if (count <= 15) { return 16; }
+	if (count <= 31) { return 32; }
+	if (count <= 127) { return 64; }
+	return 128;
+}
+
+//returns true when the last run reached a bucket no earlier run did
+static bool takeCoverage(std::vector<std::uint8_t> &seen)
+{
+	bool found = false;
+	for (int c = 0; c < fuzzCounterCount; c++)
+	{
+		std::uint8_t b = bucket(fuzzCounters[c]);
+		if (b & ~seen[c])
+		{
+			seen[c] |= b;
+			found = true;
+		}
+		fuzzCounters[c] = 0;
+	}
+	return found;
+}
+
+static int coveredPairs(const std::vector<std::uint8_t> &seen)
+{
+	return (int)std::count_if(seen.begin(), seen.end(), [](std::uint8_t b) { return b != 0; });
+}
+
+static std::vector<std::uint8_t> mutate(const std::vector<std::vector<std::uint8_t>> &corpus, std::mt19937_64 &random)
+{
+	std::vector<std::uint8_t> data = corpus.empty() ? std::vector<std::uint8_t>(4) : corpus[random() % corpus.size()];
+	constexpr std::size_t maxSize = 8 * 1024;
+
+	int mutations = 1 + random() % 4;
+	for (int m = 0; m < mutations; m++)
+	{
+		std::size_t position = data.empty() ? 0 : random() % data.size();
+
+		switch (random() % 6)
+		{
+		case 0: if (!data.empty()) { data[position] ^= (std::uint8_t)(1 << (random() % 8)); } break;
+		case 1: if (!data.empty()) { data[position] = (std::uint8_t)random(); } break;
+		case 2: if (!data.empty()) { data[random() % std::min<std::size_t>(4, data.size())] = (std::uint8_t)random(); } break;
+
+		//a whole random instruction, most of the interesting changes are whole opcodes
+		case 3:
+		{
+			std::uint16_t opcode = (std::uint16_t)random();
+			std::uint8_t bytes[2] = {(std::uint8_t)(opcode >> 8), (std::uint8_t)opcode};
+			data.insert(data.begin() + position, bytes, bytes + 2);
+		}
+		break;
+
+		case 4:
+			if (data.size() > 4)
+			{
+				std::size_t length = 1 + random() % std::min<std::size_t>(16, data.size() - position);
+				data.erase(data.begin() + position, data.begin() + position + length);
+			}
+			break;
+
+		//splice a piece of another input in
+		case 5:
+			if (!corpus.empty())
+			{
+				const std::vector<std::uint8_t> &other = corpus[random() % corpus.size()];
+				if (other.empty()) { break; }
+				std::size_t from = random() % other.size();
+				std::size_t length = 1 + random() % std::min<std::size_t>(64, other.size() - from);
+				data.insert(data.begin() + position, other.begin() + from, other.begin() + from + length);
+			}
+			break;
+		}
+
+		if (data.size() > maxSize) { data.resize(maxSize); }
+	}
+
+	return data;
+}
+
+static bool readFile(const fs::path &path, std::vector<std::uint8_t> &data)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file) { return false; }
+	data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	return true;
+}
+
+int main(int argc, char *argv[])
+{
+	long long runs = 0;
+	unsigned long long seed = 1;
+	int timeout = 10;
+	std::vector<fs::path> paths;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!std::strncmp(argv[i], "-runs=", 6)) { runs = std::atoll(argv[i] + 6); }
+		else if (!std::strncmp(argv[i], "-seed=", 6)) { seed = std::strtoull(argv[i] + 6, nullptr, 10); }
+		else if (!std::strncmp(argv[i], "-timeout=", 9)) { timeout = std::atoi(argv[i] + 9); }
+		else if (argv[i][0] == '-') { std::fprintf(stderr, "chip8-fuzz: %s is a libFuzzer flag, ignored\n", argv[i]); }
+		else { paths.push_back(argv[i]); }
+	}
+
+	std::signal(SIGABRT, crashHandler);
+	std::signal(SIGSEGV, crashHandler);
+	std::signal(SIGFPE, crashHandler);
+	std::signal(SIGILL, crashHandler);
+#ifdef CHIP8_FUZZ_DEATH_CALLBACK
+	__sanitizer_set_death_callback(saveCurrentInput);
+#endif
+
+	//the watchdog catches inputs that never finish
+	std::thread watchdog([timeout]()
+	{
+		for (;;)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(200));
+			long long start = currentStart.load();
+			if (start && milliseconds() - start > timeout * 1000ll)
+			{
+				std::fprintf(stderr, "chip8-fuzz: an input ran for more than %d s\n", timeout);
+				saveCurrentInput();
+				std::_Exit(1);
+			}
+		}
+	});
+	watchdog.detach();
+
+	std::vector<std::vector<std::uint8_t>> corpus;
+	fs::path outputFolder;
+	for (const fs::path &path : paths)
+	{
+		std::error_code error;
+		if (fs::is_directory(path, error))
+		{
+			if (outputFolder.empty()) { outputFolder = path; }
+
+			std::vector<fs::path> files;
+			for (auto &entry : fs::directory_iterator(path, error))
+			{
+				if (entry.is_regular_file(error)) { files.push_back(entry.path()); }
+			}
+			std::sort(files.begin(), files.end());
+
+			for (const fs::path &file : files)
+			{
+				corpus.emplace_back();
+				if (!readFile(file, corpus.back())) { corpus.pop_back(); }
+			}
+		}
+		else
+		{
+			corpus.emplace_back();
+			if (!readFile(path, corpus.back()))
+			{
+				std::fprintf(stderr, "chip8-fuzz: can't read %s\n", path.string().c_str());
+				return 2;
+			}
+		}
+	}
+
+	std::vector<std::uint8_t> seen(fuzzCounterCount);
+	std::memset(fuzzCounters, 0, sizeof(fuzzCounters));
+
+	for (const std::vector<std::uint8_t> &input : corpus)
+	{
+		runInput(input);
+		takeCoverage(seen);
+	}
+	std::printf("chip8-fuzz: ran %zu inputs, %d handler pairs covered\n", corpus.size(), coveredPairs(seen));
+
+	std::mt19937_64 random(seed);
+	long long nextReport = 1024;
+	for (long long run = 1; run <= runs; run++)
+	{
+		std::vector<std::uint8_t> input = mutate(corpus, random);
+		runInput(input);
+
+		if (takeCoverage(seen))
+		{
+			if (!outputFolder.empty())
+			{
+				char name[32];
+				std::snprintf(name, sizeof(name), "%016llx", (unsigned long long)chip8::xxHash64(input.data(), input.size()));
+				std::ofstream((outputFolder / name).string(), std::ios::binary).write((const char *)input.data(), input.size());
+			}
+			corpus.push_back(std::move(input));
+		}
+
+		if (run == nextReport || run == runs)
+		{
+			std::printf("#%lld covered %d handler pairs, corpus %zu\n", run, coveredPairs(seen), corpus.size());
+			nextReport *= 2;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,119 @@
+//chip8-fuzz-seeds: writes a seed corpus for chip8-fuzz.
+//usage: chip8-fuzz-seeds folder [roms...]
+//
+//For every platform and every opcode handler it writes a small program that sets up the registers,
+//runs the handler in a loop and draws, so the fuzzer starts with every handler reachable.
+//Roms given on the command line are added with the settings the analyzer picks.
+
+#include "fuzz.h"
+#include <chip8/mappedFile.h>
+#include <chip8/romAnalyzer.h>
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+using namespace chip8;
+
+//one opcode for every handler of the core, the operands use V0-V3 and the sprite at 0x300
+static const std::uint16_t handlerOpcodes[] =
+{
+	0x00C3, 0x00D2, 0x00E0, 0x00FB, 0x00FC, 0x00FE, 0x00FF,
+	0x3012, 0x4012, 0x5010, 0x5022, 0x5023, 0x9010,
+	0x8010, 0x8011, 0x8012, 0x8013, 0x8014, 0x8015, 0x8016, 0x8017, 0x801E,
+	0xB300, 0xC0FF, 0xD015, 0xD010, 0xE09E, 0xE0A1,
+	0xF001, 0xF201, 0xF002, 0xF007, 0xF00A, 0xF015, 0xF018, 0xF01E, 0xF029, 0xF030, 0xF033,
+	0xF03A, 0xF355, 0xF365, 0xF375, 0xF385,
+};
+
+static std::vector<std::uint8_t> handlerProgram(std::uint16_t opcode)
+{
+	std::vector<std::uint8_t> rom;
+	auto put = [&](std::uint16_t op)
+	{
+		rom.push_back((std::uint8_t)(op >> 8));
+		rom.push_back((std::uint8_t)op);
+	};
+
+	put(0x6012); //V0 = 0x12
+	put(0x6134); //V1 = 0x34
+	put(0x6205); //V2 = 5
+	put(0x6307); //V3 = 7
+	put(0xA300); //I = 0x300
+	put(opcode); //0x20A, BNNN jumps into the padding and runs on from there
+	put(0xA300);
+	put(0xD235);
+	put(0x7001);
+	put(0x120A);
+
+	rom.resize(0x100, 0);
+	for (int b = 0; b < 32; b++) { rom.push_back((std::uint8_t)(0xF0 >> (b & 3) | b)); } //the sprite at 0x300
+	return rom;
+}
+
+static bool writeSeed(const std::filesystem::path &folder, const std::string &name, const std::vector<std::uint8_t> &data)
+{
+	std::ofstream file(folder / name, std::ios::binary);
+	file.write((const char *)data.data(), data.size());
+	return (bool)file;
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc < 2)
+	{
+		std::fprintf(stderr, "usage: chip8-fuzz-seeds folder [roms...]\n");
+		return 2;
+	}
+
+	std::filesystem::path folder = argv[1];
+	std::error_code error;
+	std::filesystem::create_directories(folder, error);
+
+	//a key pressed and released so FX0A finishes and both EX9E and EXA1 skip
+	const std::vector<std::uint16_t> keys = {0x0000, 0x0001, 0x0001, 0x0000, 0x1000, 0x0000};
+
+	int written = 0;
+	for (int p = 0; p < 3; p++)
+	{
+		Platform platform = (Platform)p;
+		int instructionsPerFrame = std::min(defaultInstructionsPerFrame(platform), 256);
+
+		for (std::uint16_t opcode : handlerOpcodes)
+		{
+			std::vector<std::uint8_t> rom = handlerProgram(opcode);
+			std::vector<std::uint8_t> input = encodeFuzzInput(platform, defaultQuirks(platform), instructionsPerFrame,
+				keys, rom.data(), rom.size());
+
+			char name[64];
+			std::snprintf(name, sizeof(name), "seed-%d-%04X", p, opcode);
+			if (!writeSeed(folder, name, input))
+			{
+				std::fprintf(stderr, "can't write to %s\n", folder.string().c_str());
+				return 2;
+			}
+			written++;
+		}
+	}
+
+	for (int i = 2; i < argc; i++)
+	{
+		MappedFile rom;
+		if (!rom.open(argv[i]))
+		{
+			std::fprintf(stderr, "can't read %s\n", argv[i]);
+			continue;
+		}
+
+		RomAnalysis analysis = analyzeRom(rom.data, rom.size);
+		std::vector<std::uint8_t> input = encodeFuzzInput(analysis.platform, analysis.quirks,
+			std::min(analysis.instructionsPerFrame, 256), keys, rom.data, rom.size);
+
+		writeSeed(folder, "rom-" + std::filesystem::path(argv[i]).filename().string(), input);
+		written++;
+	}
+
+	std::printf("wrote %d seeds to %s\n", written, folder.string().c_str());
+	return 0;
+}
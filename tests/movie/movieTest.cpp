@@ -0,0 +1,101 @@
+//chip8-movie-test: records a movie of a rom that reads a key with chip8-headless, replays it, then replays
+//a copy of it with a key pressed on one frame, which has to be reported as a desync at that frame.
+//usage: chip8-movie-test path/to/chip8-headless
+//The files are written in the current folder and removed. The exit code is 1 if a check failed.
+
+#include "../conformance/assembler.h"
+#include <chip8/movie.h>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+using namespace chip8;
+
+static int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+	if (!ok)
+	{
+		std::printf("FAILED: %s\n", what);
+		failures++;
+	}
+}
+
+static const char *romPath = "chip8-movie-test.ch8";
+static const char *moviePath = "chip8-movie-test.c8m";
+static const char *editedPath = "chip8-movie-test-edited.c8m";
+static const char *outputPath = "chip8-movie-test.txt";
+
+//runs chip8-headless with the arguments, returns true if it exited with 0, output gets what it printed
+static bool runHeadless(const std::string &headless, const std::string &arguments, std::string &output)
+{
+	std::string command = "\"" + headless + "\" " + arguments + " > " + outputPath;
+	const bool ok = std::system(command.c_str()) == 0;
+
+	std::ifstream file(outputPath);
+	std::stringstream text;
+	text << file.rdbuf();
+	output = text.str();
+	std::printf("%s", output.c_str());
+	return ok;
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc != 2)
+	{
+		std::fprintf(stderr, "usage: chip8-movie-test path/to/chip8-headless\n");
+		return 2;
+	}
+	const std::string headless = argv[1];
+
+	//V0 counts the frames key 5 was down in, its digits are in memory so the state hash changes with it
+	Assembler a;
+	a.op(0x6000);        //200 V0 = 0
+	a.label("loop");
+	a.op(0x6105);        //202 V1 = 5
+	a.op(0xE19E);        //204 skip if key 5 is down
+	a.jump("up");        //206
+	a.op(0x7001);        //208 V0 += 1
+	a.label("up");
+	a.op(0xA300);        //20A I = 300
+	a.op(0xF033);        //20C the digits of V0 at I
+	a.jump("loop");      //20E
+	std::vector<std::uint8_t> rom = a.finish();
+	{
+		std::ofstream file(romPath, std::ios::binary);
+		file.write((const char *)rom.data(), (std::streamsize)rom.size());
+		check((bool)file, "the rom is written");
+	}
+
+	const int frames = 120;
+	const std::uint32_t pressedFrame = 70;
+	std::string output;
+
+	check(runHeadless(headless, std::string(romPath) + " --frames " + std::to_string(frames) + " --record " + moviePath, output),
+		"the run is recorded");
+	check(runHeadless(headless, std::string(romPath) + " --replay " + moviePath, output) &&
+		output.find("replay matches the movie") != std::string::npos, "the replay matches");
+
+	//the same movie with key 5 down on one frame
+	Movie movie;
+	check(movie.load(moviePath) && movie.frameCount == (std::uint32_t)frames && movie.keyRuns.size() == 1,
+		"the movie has the frames with no keys");
+	movie.keyRuns = {{0, pressedFrame}, {1 << 5, 1}, {0, frames - pressedFrame - 1}};
+	check(movie.save(editedPath), "the edited movie is written");
+
+	const std::string desync = "desync at frame " + std::to_string(pressedFrame);
+	check(!runHeadless(headless, std::string(romPath) + " --replay " + editedPath, output) &&
+		output.find(desync) != std::string::npos, "the changed frame is reported as a desync");
+
+	std::remove(romPath);
+	std::remove(moviePath);
+	std::remove(editedPath);
+	std::remove(outputPath);
+
+	std::printf("%s\n", failures ? "FAILED" : "all movie checks passed");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,174 @@
+//chip8-netplay-test: a host and a guest in one process play each other over loopback with made up
+//network conditions, every frame both sides confirm is checked against a run without the network.
+//usage: chip8-netplay-test [--frames N] [--frame-ms N] [--latency ms] [--jitter ms] [--reorder percent]
+//                          [--loss percent] [--seed N]
+//
+//The conditions are simulated by ENet under its sockets (enet_socket_simulate) for every datagram
+//both ways, the connection and the acks too. A frame that ran with the wrong keys and wasn't rolled back
+//changes the state hash (see testSession.h). Prints the rollbacks, the frames run again and the frame
+//times with their spikes (frames over 4 times the median). The exit code is 1 on a mismatch.
+//The handshake is simulated too, with much loss ENet can give up connecting.
+
+#include "testSession.h"
+#include <chip8net/netplay.h>
+#include <enet/enet.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace chip8;
+
+//the states are 66 KB each so they don't go on the stack
+static Chip8 hostEmulator;
+static Chip8 guestEmulator;
+static Chip8 referenceEmulator;
+
+int main(int argc, char *argv[])
+{
+	std::uint32_t frames = 300;
+	int frameMs = 8;
+	ENetSimulation conditions = {};
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!std::strcmp(argv[i], "--frames") && i + 1 < argc) { frames = (std::uint32_t)std::atoi(argv[++i]); }
+		else if (!std::strcmp(argv[i], "--frame-ms") && i + 1 < argc) { frameMs = std::atoi(argv[++i]); }
+		else if (!std::strcmp(argv[i], "--latency") && i + 1 < argc) { conditions.latency = (enet_uint32)std::atoi(argv[++i]); }
+		else if (!std::strcmp(argv[i], "--jitter") && i + 1 < argc) { conditions.jitter = (enet_uint32)std::atoi(argv[++i]); }
+		else if (!std::strcmp(argv[i], "--reorder") && i + 1 < argc) { conditions.reorderPercent = (enet_uint32)std::atoi(argv[++i]); }
+		else if (!std::strcmp(argv[i], "--loss") && i + 1 < argc) { conditions.lossPercent = (enet_uint32)std::atoi(argv[++i]); }
+		else if (!std::strcmp(argv[i], "--seed") && i + 1 < argc) { conditions.seed = (enet_uint32)std::atoi(argv[++i]); }
+		else
+		{
+			std::fprintf(stderr, "usage: chip8-netplay-test [--frames N] [--frame-ms N] [--latency ms] [--jitter ms] [--reorder percent]\n"
+				"                          [--loss percent] [--seed N]\n");
+			return 2;
+		}
+	}
+	if (!conditions.seed) { conditions.seed = 1; } //the same run every time
+
+	if (enet_socket_simulate(&conditions) != 0)
+	{
+		std::fprintf(stderr, "ENet can't simulate the network on this platform\n");
+		return 2;
+	}
+
+	std::vector<std::uint8_t> rom = testRom();
+
+	//the hashes of the run without the network, the sides can run a few frames past the end while they settle
+	std::uint32_t referenceFrames = frames + 4 * Rollback::maxFrames;
+	std::vector<std::uint64_t> referenceHashes(referenceFrames);
+	referenceEmulator.reset(Platform::chip8);
+	referenceEmulator.loadRom(rom.data(), rom.size());
+	for (std::uint32_t f = 0; f < referenceFrames; f++)
+	{
+		referenceEmulator.setKeys(scriptKeys(0, f) | scriptKeys(1, f));
+		referenceEmulator.runFrame();
+		referenceHashes[f] = hashState(referenceEmulator.state);
+	}
+
+	Netplay host;
+	Netplay guest;
+
+	hostEmulator.reset(Platform::chip8);
+	if (!host.host(hostEmulator, rom.data(), rom.size(), 0))
+	{
+		std::fprintf(stderr, "host: %s\n", host.error.c_str());
+		return 2;
+	}
+	if (!guest.join(guestEmulator, rom.data(), rom.size(), "127.0.0.1", host.port()))
+	{
+		std::fprintf(stderr, "guest: %s\n", guest.error.c_str());
+		return 2;
+	}
+
+	Netplay *sides[2] = {&host, &guest};
+	std::uint32_t checkedFrames[2] = {};
+	std::vector<double> frameTimes[2];
+	bool ok = true;
+
+	auto start = std::chrono::steady_clock::now();
+	auto elapsed = [&]() { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); };
+
+	while (ok && (checkedFrames[0] < frames || checkedFrames[1] < frames))
+	{
+		for (int p = 0; p < 2; p++)
+		{
+			Netplay &side = *sides[p];
+			auto frameStart = std::chrono::steady_clock::now();
+			side.poll();
+
+			if (side.status == Netplay::failed || side.status == Netplay::disconnected)
+			{
+				std::printf("player %d: %s\n", p, side.status == Netplay::failed ? side.error.c_str() : "disconnected");
+				ok = false;
+				break;
+			}
+			if (side.rollback.frame >= referenceFrames)
+			{
+				std::printf("player %d ran out of reference frames before the other side confirmed frame %u\n", p, frames);
+				ok = false;
+				break;
+			}
+
+			if (side.advance(scriptKeys(p, side.rollback.frame)))
+			{
+				frameTimes[p].push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - frameStart).count());
+			}
+
+			std::uint32_t hashFrame = 0;
+			std::uint64_t hash = 0;
+			if (side.rollback.confirmedHash(hashFrame, hash))
+			{
+				if (hash != referenceHashes[hashFrame])
+				{
+					std::printf("player %d: frame %u has the hash %016llx, expected %016llx\n", p, hashFrame,
+						(unsigned long long)hash, (unsigned long long)referenceHashes[hashFrame]);
+					ok = false;
+					break;
+				}
+				checkedFrames[p] = hashFrame + 1;
+			}
+			if (side.rollback.desyncFrame >= 0)
+			{
+				std::printf("player %d: desync with the other side at frame %lld\n", p, (long long)side.rollback.desyncFrame);
+				ok = false;
+				break;
+			}
+		}
+
+		if (elapsed() > 60)
+		{
+			std::printf("timed out at frames %u and %u\n", host.rollback.frame, guest.rollback.frame);
+			ok = false;
+		}
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(frameMs));
+	}
+
+	for (int p = 0; p < 2; p++)
+	{
+		const Rollback::Stats &stats = sides[p]->rollback.stats;
+		std::printf("player %d: %u frames, %llu rollbacks, %llu frames run again (at most %d at once), %llu stalls\n", p,
+			sides[p]->rollback.frame, (unsigned long long)stats.rollbacks, (unsigned long long)stats.resimulatedFrames,
+			stats.mostResimulatedFrames, (unsigned long long)stats.stalledFrames);
+
+		std::vector<double> &times = frameTimes[p];
+		if (times.empty()) { continue; }
+		std::sort(times.begin(), times.end());
+		double median = times[times.size() / 2];
+		std::size_t spikes = times.end() - std::upper_bound(times.begin(), times.end(), 4 * median);
+		std::printf("          frame time median %.1f us, p99 %.1f us, max %.1f us, %zu spikes\n", median * 1e6,
+			times[std::min(times.size() - 1, times.size() * 99 / 100)] * 1e6, times.back() * 1e6, spikes);
+	}
+	std::printf("%s in %.2f s with %u ms latency, %u ms jitter, %u%% reordered and %u%% lost\n", ok ? "in sync" : "FAILED",
+		elapsed(), conditions.latency, conditions.jitter, conditions.reorderPercent, conditions.lossPercent);
+
+	enet_socket_simulate(nullptr);
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,143 @@
+//chip8-spectator-test: one broadcaster and many spectators in one process over loopback.
+//usage: chip8-spectator-test [--spectators N] [--frames N] [--frame-ms N] [--keyframe-interval N]
+//
+//The spectators join spread over the whole session. At the end the ones that got a keyframe
+//have to be at the last frame with the same state hash as the broadcaster, the ones that joined
+//after the last keyframe have to show the same display from the deltas.
+
+#include "testSession.h"
+#include <chip8net/spectator.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace chip8;
+
+//the state has the whole 64 KB of memory so it doesn't go on the stack
+static Chip8 emulator;
+
+int main(int argc, char *argv[])
+{
+	int spectatorCount = 200;
+	std::uint32_t frames = 330;
+	int frameMs = 2;
+	int keyframeInterval = 60;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!std::strcmp(argv[i], "--spectators") && i + 1 < argc) { spectatorCount = std::atoi(argv[++i]); }
+		else if (!std::strcmp(argv[i], "--frames") && i + 1 < argc) { frames = (std::uint32_t)std::atoi(argv[++i]); }
+		else if (!std::strcmp(argv[i], "--frame-ms") && i + 1 < argc) { frameMs = std::atoi(argv[++i]); }
+		else if (!std::strcmp(argv[i], "--keyframe-interval") && i + 1 < argc) { keyframeInterval = std::atoi(argv[++i]); }
+		else
+		{
+			std::fprintf(stderr, "usage: chip8-spectator-test [--spectators N] [--frames N] [--frame-ms N] [--keyframe-interval N]\n");
+			return 2;
+		}
+	}
+	if (spectatorCount < 1 || frames < 1 || keyframeInterval < 1) { return 2; }
+
+	std::vector<std::uint8_t> rom = testRom();
+	emulator.reset(Platform::chip8);
+	emulator.loadRom(rom.data(), rom.size());
+
+	Broadcaster broadcaster;
+	broadcaster.keyframeInterval = keyframeInterval;
+	if (!broadcaster.start(emulator, 0, spectatorCount))
+	{
+		std::fprintf(stderr, "can't start the broadcaster\n");
+		return 2;
+	}
+
+	std::vector<std::unique_ptr<Spectator>> spectators;
+	auto pollAll = [&]()
+	{
+		broadcaster.poll();
+		for (auto &spectator : spectators) { spectator->poll(); }
+	};
+
+	auto start = std::chrono::steady_clock::now();
+	auto elapsed = [&]() { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); };
+
+	for (std::uint32_t frame = 0; frame < frames; frame++)
+	{
+		//they join over the whole session, the last ones after the last keyframe
+		while ((int)spectators.size() < spectatorCount && spectators.size() * frames < (std::size_t)spectatorCount * frame)
+		{
+			spectators.push_back(std::make_unique<Spectator>());
+			if (!spectators.back()->join("127.0.0.1", broadcaster.port()))
+			{
+				std::fprintf(stderr, "spectator %zu can't connect\n", spectators.size() - 1);
+				return 2;
+			}
+		}
+
+		pollAll();
+
+		std::uint16_t keys = scriptKeys(0, frame) | scriptKeys(1, frame);
+		emulator.setKeys(keys);
+		emulator.runFrame();
+		broadcaster.endFrame(keys);
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(frameMs));
+	}
+
+	//everything still in flight
+	std::uint64_t hash = hashState(emulator.state);
+	auto done = [&]()
+	{
+		for (auto &spectator : spectators)
+		{
+			if (spectator->status == Spectator::synced && spectator->frame != frames) { return false; }
+			if (spectator->status == Spectator::watchingDisplay &&
+				std::memcmp(&spectator->display(), &emulator.state.display, sizeof(Display)) != 0) { return false; }
+			if (spectator->status == Spectator::connecting) { return false; }
+		}
+		return true;
+	};
+	for (double settleStart = elapsed(); !done() && elapsed() - settleStart < 5;)
+	{
+		pollAll();
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	int synced = 0, watching = 0, failed = 0, resyncs = 0;
+	for (std::size_t s = 0; s < spectators.size(); s++)
+	{
+		const Spectator &spectator = *spectators[s];
+		resyncs += spectator.resyncs;
+
+		bool ok = false;
+		if (spectator.status == Spectator::synced)
+		{
+			ok = spectator.frame == frames && hashState(spectator.emulator->state) == hash;
+			synced += ok;
+		}
+		else if (spectator.status == Spectator::watchingDisplay)
+		{
+			ok = std::memcmp(&spectator.display(), &emulator.state.display, sizeof(Display)) == 0;
+			watching += ok;
+		}
+
+		if (!ok)
+		{
+			failed++;
+			std::printf("spectator %zu: status %d at frame %u\n", s, (int)spectator.status, spectator.frame);
+		}
+	}
+
+	const Broadcaster::Stats &stats = broadcaster.stats;
+	std::printf("%d spectators: %d in sync, %d on the display deltas, %d wrong, %d resyncs\n",
+		(int)spectators.size(), synced, watching, failed, resyncs);
+	std::printf("sent %llu bytes (%llu of keyframes, %llu of display deltas), %.1f bytes per spectator per frame\n",
+		(unsigned long long)stats.sentBytes, (unsigned long long)stats.keyframeBytes, (unsigned long long)stats.deltaBytes,
+		(double)stats.sentBytes / spectators.size() / frames);
+	std::printf("%s in %.2f s\n", failed ? "FAILED" : "all spectators match", elapsed());
+
+	//both kinds have to be covered for the test to mean something
+	return failed || !synced || !watching ? 1 : 0;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+//The session the netplay tests play: a rom that reads all the keys, draws for the pressed ones
+//and takes random numbers, so a frame that ran with the wrong keys changes the state hash.
+inline std::vector<std::uint8_t> testRom()
+{
+	std::vector<std::uint8_t> rom;
+	auto put = [&](std::uint16_t op)
+	{
+		rom.push_back((std::uint8_t)(op >> 8));
+		rom.push_back((std::uint8_t)op);
+	};
+
+	put(0xA2F0); //200 I = the sprite
+	put(0x6000); //202 V0 = 0
+	put(0xE09E); //204 skip if key V0 is down
+	put(0x1210); //206 to the next key
+	put(0x7101); //208 V1 += 1
+	put(0x8204); //20A V2 += V0
+	put(0xD121); //20C draw one row at V1, V2
+	put(0xC30F); //20E V3 = random
+	put(0x7001); //210 V0 += 1
+	put(0x3010); //212 skip if V0 == 16
+	put(0x1204); //214 the next key
+	put(0x1202); //216 all the keys again
+
+	rom.resize(0xF0, 0);
+	rom.push_back(0xFF); //2F0 the sprite
+	return rom;
+}
+
+//player 0 presses keys 0-7, player 1 keys 8-F, each holds them for a while
+inline std::uint16_t scriptKeys(int player, std::uint32_t frame)
+{
+	std::uint32_t period = player ? 11 : 7;
+	std::uint32_t x = (frame / period) * 2654435761u + (std::uint32_t)player * 40503u;
+	x ^= x >> 15;
+	x *= 0x2C1B3C6Du;
+	x ^= x >> 12;
+	return (std::uint16_t)((x & 0xFF) << (player * 8));
+}
@@ -0,0 +1,262 @@
+//chip8-service-load-test: many clients, each with many sessions, against the emulation service.
+//usage: chip8-service-load-test [--socket path] [--clients N] [--sessions N] [--rounds N] [--frames N] [--threads N]
+//
+//Without --socket the service runs in the same process on a temporary socket.
+//Every round a client pipelines the keys and a step for all its sessions and checks the state hashes
+//against a run without the service. At the end a saved state is loaded back and has to run the same
+//frames again, and corrupted ones have to be refused. Prints the requests per second and the latencies, the exit code is 1 on a mismatch.
+
+#include "../netplay/testSession.h"
+#include <chip8/chip8.h>
+#include <chip8/delta.h>
+#include <chip8/hash.h>
+#include <chip8net/packet.h>
+#include <chip8service/client.h>
+#include <chip8service/server.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+using namespace chip8;
+using Clock = std::chrono::steady_clock;
+
+//the states are 66 KB each so they don't go on the stack
+static Chip8 referenceEmulator;
+
+struct Options
+{
+	std::string socket;
+	int clients = 8;
+	int sessions = 16;
+	int rounds = 60;
+	std::uint32_t frames = 5;
+};
+
+//the sessions of odd index play the keys of player 1
+static std::vector<std::uint64_t> referenceHashes[2];
+
+static std::mutex printMutex;
+static std::atomic<int> failures{0};
+
+static void fail(int client, const std::string &message)
+{
+	std::lock_guard<std::mutex> lock(printMutex);
+	std::printf("client %d: %s\n", client, message.c_str());
+	failures++;
+}
+
+static void runClient(const Options &options, int client, const std::vector<std::uint8_t> &rom, std::vector<double> &latencies)
+{
+	ServiceClient service;
+	if (!service.connect(options.socket.c_str())) { fail(client, service.error); return; }
+
+	std::vector<std::uint32_t> sessions;
+	for (int s = 0; s < options.sessions; s++)
+	{
+		std::uint32_t session = service.open();
+		if (!session || !service.loadRom(session, rom.data(), rom.size(), (int)Platform::chip8))
+		{
+			fail(client, "can't start a session: " + service.error);
+			return;
+		}
+		sessions.push_back(session);
+	}
+
+	std::unordered_map<std::uint32_t, Clock::time_point> sentAt;
+	std::unordered_map<std::uint32_t, int> stepOf; //the step requests and their session index
+	ServiceResponse response;
+
+	for (int round = 0; round < options.rounds; round++)
+	{
+		for (int s = 0; s < options.sessions; s++)
+		{
+			std::vector<std::uint8_t> body;
+			writeInt(body, scriptKeys(s & 1, (std::uint32_t)round), 2);
+			sentAt[service.send(serviceSetKeys, sessions[s], body)] = Clock::now();
+
+			body.clear();
+			writeInt(body, options.frames, 4);
+			std::uint32_t id = service.send(serviceStep, sessions[s], body);
+			sentAt[id] = Clock::now();
+			stepOf[id] = s;
+		}
+		if (sentAt.count(0)) { fail(client, service.error); return; }
+
+		while (!sentAt.empty())
+		{
+			if (!service.receive(response)) { fail(client, service.error); return; }
+
+			auto sent = sentAt.find(response.id);
+			if (sent == sentAt.end()) { fail(client, "a response to no request"); return; }
+			latencies.push_back(std::chrono::duration<double>(Clock::now() - sent->second).count());
+			sentAt.erase(sent);
+
+			if (response.status != serviceOk) { fail(client, serviceStatusName(response.status)); return; }
+
+			auto step = stepOf.find(response.id);
+			if (step == stepOf.end()) { continue; }
+
+			PacketReader reader(response.body.data(), response.body.size());
+			std::uint64_t frameCount = reader.readInt(8);
+			std::uint64_t hash = reader.readInt(8);
+			if (frameCount != (std::uint64_t)(round + 1) * options.frames || hash != referenceHashes[step->second & 1][round])
+			{
+				fail(client, "session " + std::to_string(step->second) + " doesn't match the run without the service");
+				return;
+			}
+			stepOf.erase(step);
+		}
+	}
+
+	//a saved state has to run the same frames again
+	std::uint32_t session = sessions[0];
+	std::vector<std::uint8_t> savedState;
+	std::uint64_t hashes[2] = {};
+	Display display[2];
+	bool ok = service.saveState(session, savedState) &&
+		service.setKeys(session, 0x0F0F) && service.step(session, 30, &hashes[0]) && service.framebuffer(session, display[0]) &&
+		service.loadState(session, savedState) &&
+		service.setKeys(session, 0x0F0F) && service.step(session, 30, &hashes[1]) && service.framebuffer(session, display[1]);
+	if (!ok) { fail(client, "the saved state: " + service.error); return; }
+	if (hashes[0] != hashes[1] || std::memcmp(&display[0], &display[1], sizeof(Display)) != 0)
+	{
+		fail(client, "the loaded state runs differently");
+		return;
+	}
+
+	//a state the core can't run is refused and the session keeps its own
+	const std::size_t headerSize = 18;
+	auto state = std::make_unique<State>();
+	std::memset((void *)state.get(), 0, sizeof(State));
+	if (savedState.size() < headerSize ||
+		!applyDelta((std::uint8_t *)state.get(), sizeof(State), savedState.data() + headerSize, savedState.size() - headerSize))
+	{
+		fail(client, "the saved state doesn't decode");
+		return;
+	}
+	std::uint64_t before = 0, after = 0;
+	ok = service.step(session, 0, &before);
+	for (int corruption = 0; corruption < 4 && ok; corruption++)
+	{
+		auto corrupted = std::make_unique<State>(*state);
+		const std::uint8_t two = 2;
+		if (corruption == 0) { corrupted->sp = stackSize; }
+		if (corruption == 1) { corrupted->keyRegister = 16; }
+		if (corruption == 2) { std::memcpy(&corrupted->halted, &two, 1); }
+		if (corruption == 3) { corrupted->planeMask = 4; }
+
+		std::vector<std::uint8_t> blob(savedState.begin(), savedState.begin() + headerSize);
+		encodeDelta(nullptr, (const std::uint8_t *)corrupted.get(), sizeof(State), blob);
+		if (service.loadState(session, blob) || service.error != serviceStatusName(serviceBadRequest))
+		{
+			fail(client, "a corrupted state " + std::to_string(corruption) + " was loaded");
+			return;
+		}
+	}
+	ok = ok && service.step(session, 0, &after);
+	if (!ok || before != after)
+	{
+		fail(client, "a refused state changed the session");
+		return;
+	}
+
+	for (std::uint32_t s : sessions)
+	{
+		if (!service.closeSession(s)) { fail(client, "can't close a session: " + service.error); return; }
+	}
+	if (service.step(session, 1) || service.error != serviceStatusName(serviceUnknownSession))
+	{
+		fail(client, "a closed session still runs");
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	Options options;
+	int threads = (int)std::thread::hardware_concurrency();
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!std::strcmp(argv[i], "--socket") && i + 1 < argc) { options.socket = argv[++i]; }
+		else if (!std::strcmp(argv[i], "--clients") && i + 1 < argc) { options.clients = std::atoi(argv[++i]); }
+		else if (!std::strcmp(argv[i], "--sessions") && i + 1 < argc) { options.sessions = std::atoi(argv[++i]); }
+		else if (!std::strcmp(argv[i], "--rounds") && i + 1 < argc) { options.rounds = std::atoi(argv[++i]); }
+		else if (!std::strcmp(argv[i], "--frames") && i + 1 < argc) { options.frames = (std::uint32_t)std::atoi(argv[++i]); }
+		else if (!std::strcmp(argv[i], "--threads") && i + 1 < argc) { threads = std::atoi(argv[++i]); }
+		else
+		{
+			std::fprintf(stderr, "usage: chip8-service-load-test [--socket path] [--clients N] [--sessions N] [--rounds N] [--frames N] [--threads N]\n");
+			return 2;
+		}
+	}
+	if (options.clients < 1 || options.sessions < 1 || options.rounds < 1 || options.frames < 1) { return 2; }
+	if (threads < 1) { threads = 1; }
+
+	std::vector<std::uint8_t> rom = testRom();
+
+	for (int player = 0; player < 2; player++)
+	{
+		referenceEmulator.reset(Platform::chip8);
+		referenceEmulator.loadRom(rom.data(), rom.size());
+		for (int round = 0; round < options.rounds; round++)
+		{
+			referenceEmulator.setKeys(scriptKeys(player, (std::uint32_t)round));
+			for (std::uint32_t f = 0; f < options.frames; f++) { referenceEmulator.runFrame(); }
+			referenceHashes[player].push_back(hashState(referenceEmulator.state));
+		}
+	}
+
+	ServiceServer server;
+	std::thread serverThread;
+	if (options.socket.empty())
+	{
+		options.socket = "/tmp/chip8-service-test-" + std::to_string(::getpid()) + ".sock";
+		if (!server.start(options.socket.c_str(), threads))
+		{
+			std::fprintf(stderr, "%s\n", server.error.c_str());
+			return 2;
+		}
+		serverThread = std::thread([&]() { server.run(); });
+	}
+
+	std::vector<std::vector<double>> latencies(options.clients);
+	std::vector<std::thread> clients;
+	auto start = Clock::now();
+	for (int c = 0; c < options.clients; c++)
+	{
+		clients.emplace_back([&, c]() { runClient(options, c, rom, latencies[c]); });
+	}
+	for (std::thread &client : clients) { client.join(); }
+	double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+	if (serverThread.joinable())
+	{
+		server.stop();
+		serverThread.join();
+	}
+
+	std::vector<double> all;
+	for (auto &clientLatencies : latencies) { all.insert(all.end(), clientLatencies.begin(), clientLatencies.end()); }
+	std::sort(all.begin(), all.end());
+	auto percentile = [&](double p) { return all.empty() ? 0.0 : all[std::min(all.size() - 1, (std::size_t)(p * all.size()))] * 1000; };
+
+	std::printf("%d clients x %d sessions, %d rounds of %u frames, %d threads\n", options.clients, options.sessions,
+		options.rounds, options.frames, threads);
+	std::printf("%zu pipelined requests in %.2f s (%.0f requests/s, %.0f frames/s)\n", all.size(), seconds, all.size() / seconds,
+		(double)options.clients * options.sessions * options.rounds * options.frames / seconds);
+	std::printf("latency p50 %.3f ms, p90 %.3f ms, p99 %.3f ms, max %.3f ms\n", percentile(0.5), percentile(0.9),
+		percentile(0.99), all.empty() ? 0.0 : all.back() * 1000);
+	std::printf("%s\n", failures ? "FAILED" : "all sessions match");
+
+	return failures ? 1 : 0;
+}
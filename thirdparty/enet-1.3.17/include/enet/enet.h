@@ -509,6 +509,27 @@ ENET_API int        enet_socket_shutdown (ENetSocket, ENetSocketShutdown);
 ENET_API void       enet_socket_destroy (ENetSocket);
 ENET_API int        enet_socketset_select (ENetSocket, ENetSocketSet *, ENetSocketSet *, enet_uint32);
 
+/**
+ * Made up network conditions applied to every datagram sent through enet_socket_send,
+ * to test on one machine. The delayed datagrams go out from later ENet socket calls
+ * of the process, so it has to keep servicing its hosts. Not thread safe.
+ */
+typedef struct _ENetSimulation
+{
+   enet_uint32 latency;        /**< milliseconds every datagram is held */
+   enet_uint32 jitter;         /**< up to this many milliseconds more, at random */
+   enet_uint32 reorderPercent; /**< chance a datagram is held twice as long so the next ones pass it */
+   enet_uint32 lossPercent;    /**< chance a datagram is dropped */
+   enet_uint32 seed;           /**< of the random numbers, 0 picks one */
+} ENetSimulation;
+
+/**
+  Sets the simulated network conditions of the process, NULL turns them off
+  (the datagrams still held are sent then).
+  @returns 0 on success, < 0 if the platform has no simulation
+*/
+ENET_API int        enet_socket_simulate (const ENetSimulation *);
+
 /** @} */
 
 /** @defgroup Address ENet address functions
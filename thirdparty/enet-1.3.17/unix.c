@@ -17,6 +17,7 @@
 
 #define ENET_BUILDING_LIB 1
 #include "enet/enet.h"
+#include "enet/time.h"
 
 #ifdef __APPLE__
 #ifdef HAS_POLL
@@ -420,11 +421,131 @@ enet_socket_shutdown (ENetSocket socket, ENetSocketShutdown how)
     return shutdown (socket, (int) how);
 }
 
+static ENetSimulation simulation;
+static int simulating = 0;
+static enet_uint32 simulationRandom = 1;
+
+typedef struct _ENetSimulatedDatagram
+{
+    ENetListNode node;
+    ENetSocket socket;
+    ENetAddress address;
+    int hasAddress;
+    enet_uint32 sendTime;
+    size_t length;
+    enet_uint8 data [1];
+} ENetSimulatedDatagram;
+
+static ENetList simulatedDatagrams;
+static int simulatedDatagramsReady = 0;
+
+static int enet_socket_send_now (ENetSocket, const ENetAddress *, const ENetBuffer *, size_t);
+
+static enet_uint32
+enet_simulation_random (void)
+{
+    simulationRandom ^= simulationRandom << 13;
+    simulationRandom ^= simulationRandom >> 17;
+    simulationRandom ^= simulationRandom << 5;
+    return simulationRandom;
+}
+
+/* sends the held datagrams that are due (all of them with everything), drops the ones of dropSocket */
+static void
+enet_simulation_flush (int everything, ENetSocket dropSocket)
+{
+    ENetListIterator current, next;
+    enet_uint32 now;
+
+    if (! simulatedDatagramsReady)
+      return;
+
+    now = enet_time_get ();
+
+    for (current = enet_list_begin (& simulatedDatagrams);
+         current != enet_list_end (& simulatedDatagrams);
+         current = next)
+    {
+        ENetSimulatedDatagram * datagram = (ENetSimulatedDatagram *) current;
+        ENetBuffer buffer;
+
+        next = enet_list_next (current);
+
+        if (datagram -> socket != dropSocket)
+        {
+            if (! everything && ENET_TIME_LESS (now, datagram -> sendTime))
+              continue;
+
+            buffer.data = datagram -> data;
+            buffer.dataLength = datagram -> length;
+            enet_socket_send_now (datagram -> socket, datagram -> hasAddress ? & datagram -> address : NULL, & buffer, 1);
+        }
+
+        enet_list_remove (current);
+        enet_free (datagram);
+    }
+}
+
+/* the timeout of a wait, shortened to the next held datagram */
+static enet_uint32
+enet_simulation_timeout (enet_uint32 timeout)
+{
+    ENetListIterator current;
+    enet_uint32 now;
+
+    if (! simulatedDatagramsReady)
+      return timeout;
+
+    now = enet_time_get ();
+
+    for (current = enet_list_begin (& simulatedDatagrams);
+         current != enet_list_end (& simulatedDatagrams);
+         current = enet_list_next (current))
+    {
+        ENetSimulatedDatagram * datagram = (ENetSimulatedDatagram *) current;
+        enet_uint32 delay = ENET_TIME_LESS (now, datagram -> sendTime) ? datagram -> sendTime - now : 0;
+
+        if (delay < timeout)
+          timeout = delay;
+    }
+
+    return timeout;
+}
+
+int
+enet_socket_simulate (const ENetSimulation * conditions)
+{
+    if (! simulatedDatagramsReady)
+    {
+        enet_list_clear (& simulatedDatagrams);
+        simulatedDatagramsReady = 1;
+    }
+
+    if (conditions == NULL)
+    {
+        simulating = 0;
+        enet_simulation_flush (1, ENET_SOCKET_NULL);
+        return 0;
+    }
+
+    simulation = * conditions;
+    simulating = 1;
+
+    simulationRandom = simulation.seed ? simulation.seed : enet_host_random_seed ();
+    if (simulationRandom == 0)
+      simulationRandom = 1;
+
+    return 0;
+}
+
 void
 enet_socket_destroy (ENetSocket socket)
 {
     if (socket != -1)
+    {
+      enet_simulation_flush (0, socket);
       close (socket);
+    }
 }
 
 int
@@ -432,6 +553,60 @@ enet_socket_send (ENetSocket socket,
                   const ENetAddress * address,
                   const ENetBuffer * buffers,
                   size_t bufferCount)
+{
+    ENetSimulatedDatagram * datagram;
+    enet_uint32 delay;
+    size_t length = 0, i;
+
+    enet_simulation_flush (0, ENET_SOCKET_NULL);
+
+    if (! simulating)
+      return enet_socket_send_now (socket, address, buffers, bufferCount);
+
+    for (i = 0; i < bufferCount; ++ i)
+      length += buffers [i].dataLength;
+
+    /* a lost datagram looks sent */
+    if (enet_simulation_random () % 100 < simulation.lossPercent)
+      return (int) length;
+
+    delay = simulation.latency;
+    if (simulation.jitter > 0)
+      delay += enet_simulation_random () % (simulation.jitter + 1);
+    if (enet_simulation_random () % 100 < simulation.reorderPercent)
+      delay = delay > 0 ? delay * 2 : 1;
+
+    if (delay == 0)
+      return enet_socket_send_now (socket, address, buffers, bufferCount);
+
+    datagram = (ENetSimulatedDatagram *) enet_malloc (sizeof (ENetSimulatedDatagram) + length);
+    if (datagram == NULL)
+      return -1;
+
+    datagram -> socket = socket;
+    datagram -> hasAddress = address != NULL;
+    if (address != NULL)
+      datagram -> address = * address;
+    datagram -> sendTime = enet_time_get () + delay;
+    datagram -> length = length;
+
+    length = 0;
+    for (i = 0; i < bufferCount; ++ i)
+    {
+        memcpy (datagram -> data + length, buffers [i].data, buffers [i].dataLength);
+        length += buffers [i].dataLength;
+    }
+
+    enet_list_insert (enet_list_end (& simulatedDatagrams), datagram);
+
+    return (int) length;
+}
+
+static int
+enet_socket_send_now (ENetSocket socket,
+                      const ENetAddress * address,
+                      const ENetBuffer * buffers,
+                      size_t bufferCount)
 {
     struct msghdr msgHdr;
     struct sockaddr_in sin;
@@ -477,6 +652,8 @@ enet_socket_receive (ENetSocket socket,
     struct sockaddr_in sin;
     int recvLength;
 
+    enet_simulation_flush (0, ENET_SOCKET_NULL);
+
     memset (& msgHdr, 0, sizeof (struct msghdr));
 
     if (address != NULL)
@@ -526,6 +703,8 @@ enet_socketset_select (ENetSocket maxSocket, ENetSocketSet * readSet, ENetSocket
 int
 enet_socket_wait (ENetSocket socket, enet_uint32 * condition, enet_uint32 timeout)
 {
+    timeout = enet_simulation_timeout (timeout);
+
 #ifdef HAS_POLL
     struct pollfd pollSocket;
     int pollCount;
@@ -302,6 +302,12 @@ enet_socket_shutdown (ENetSocket socket, ENetSocketShutdown how)
     return shutdown (socket, (int) how) == SOCKET_ERROR ? -1 : 0;
 }
 
+int
+enet_socket_simulate (const ENetSimulation * conditions)
+{
+    return conditions == NULL ? 0 : -1;
+}
+
 void
 enet_socket_destroy (ENetSocket socket)
 {
@@ -1,5 +1,5 @@
 //////////////////////////////////////////////////
-//gl2d.h				1.5.0
+//gl2d.h				1.5.3
 //Copyright(c) 2020 Luta Vlad
 //https://github.com/meemknight/gl2d
 //
@@ -18,6 +18,10 @@
 //		pixel art sprite atlases
 //	draw to screen of frame buffer that	can \
 //		be used as a texture
+//	command buffers that can be recorded \
+//		on worker threads
+//	text layout cache
+//	signed distance field fonts
 //
 //	a particle system that can use a custom \
 //	shader and apply a pixelate effect
@@ -58,6 +62,10 @@
 #include <stb_image/stb_image.h>
 #include <stb_truetype/stb_truetype.h>
 #include <vector>
+#include <string>
+#include <string_view>
+#include <list>
+#include <unordered_map>
 
 namespace gl2d
 {
@@ -92,6 +100,10 @@ namespace gl2d
 
 	ShaderProgram createShaderProgram(const char *vertex, const char *fragment);
 
+	//The shader used to draw text with signed distance field fonts (Font::sdf).
+	//Push it before rendering the text and flush before poping it.
+	ShaderProgram getSDFFontShader();
+
 	struct Camera;
 
 	namespace internal
@@ -243,6 +255,7 @@ namespace gl2d
 		stbtt_packedchar *packedCharsBuffer = 0;
 		int               packedCharsBufferSize = 0;
 		float             max_height = 0.f;
+		bool              sdf = false;
 
 		Font() {}
 		explicit Font(const char *file) { createFromFile(file); }
@@ -250,6 +263,16 @@ namespace gl2d
 		void createFromTTF(const unsigned char *ttf_data, const size_t ttf_data_size);
 		void createFromFile(const char *file);
 
+		//Bakes a signed distance field atlas instead of a bitmap one. One small atlas stays crisp
+		//at every text size but it has to be drawn with getSDFFontShader().
+		//The glyphs have the same metrics as createFromTTF so the text functions work the same.
+		//If cacheFile is set the baked atlas is saved there and loaded from there next time,
+		//as long as it was baked from the same ttf data with the same settings.
+		//bakeSize is the glyph height in pixels used for the distance field.
+		void createFromTTFSDF(const unsigned char *ttf_data, const size_t ttf_data_size,
+			const char *cacheFile = nullptr, int bakeSize = 48);
+		void createFromFileSDF(const char *file, const char *cacheFile = nullptr, int bakeSize = 48);
+
 		void cleanup();
 	};
 
@@ -321,6 +344,136 @@ namespace gl2d
 	};
 
 
+	//A command buffer records quads on the CPU only, it doesn't make any OpenGL calls,
+	//so different threads can each fill their own command buffer at the same time.
+	//Call Renderer2D::beginCommandBuffer on the rendering thread to copy the current
+	//camera and window metrics into it, fill it on any thread, and then give it back
+	//to the renderer with Renderer2D::submitCommandBuffers.
+	struct CommandBuffer
+	{
+		CommandBuffer() {};
+
+		//4 elements each component, same layout as the renderer
+		std::vector<glm::vec2>spritePositions;
+		std::vector<glm::vec4>spriteColors;
+		std::vector<glm::vec2>texturePositions;
+		std::vector<Texture>spriteTextures;
+
+		//snapshot of the renderer state taken in beginCommandBuffer
+		Camera currentCamera = {};
+		int windowW = -1;
+		int windowH = -1;
+
+		//Reserves space for quadCount quads so recording doesn't reallocate.
+		void reserve(size_t quadCount);
+
+		//clears the recorded quads but keeps the memory
+		void clear();
+
+		//returns the number of recorded quads
+		size_t quadCount() const { return spriteTextures.size(); }
+
+		void renderRectangle(const Rect transforms, const Texture texture, const Color4f colors[4], const glm::vec2 origin = {}, const float rotationDegrees = 0.f, const glm::vec4 textureCoords = GL2D_DefaultTextureCoords);
+		inline void renderRectangle(const Rect transforms, const Texture texture, const Color4f colors = {1,1,1,1}, const glm::vec2 origin = {}, const float rotationDegrees = 0, const glm::vec4 textureCoords = GL2D_DefaultTextureCoords)
+		{
+			Color4f c[4] = {colors,colors,colors,colors};
+			renderRectangle(transforms, texture, c, origin, rotationDegrees, textureCoords);
+		}
+
+		//abs rotation means that the rotaion is relative to the screen rather than object
+		void renderRectangleAbsRotation(const Rect transforms, const Texture texture, const Color4f colors[4], const glm::vec2 origin = {}, const float rotationDegrees = 0.f, const glm::vec4 textureCoords = GL2D_DefaultTextureCoords);
+
+		void renderRectangle(const Rect transforms, const Color4f colors[4], const glm::vec2 origin = {0,0}, const float rotationDegrees = 0);
+		inline void renderRectangle(const Rect transforms, const Color4f colors, const glm::vec2 origin = {0,0}, const float rotationDegrees = 0)
+		{
+			Color4f c[4] = {colors,colors,colors,colors};
+			renderRectangle(transforms, c, origin, rotationDegrees);
+		}
+
+		void renderLine(const glm::vec2 start, const glm::vec2 end, const Color4f color, const float width = 2.f);
+	};
+
+	//Remembers the layout of recently drawn text (the glyph quads relative to the text position,
+	//the measured size and the wrapped string) so text that doesn't change from a frame to another
+	//isn't measured and laid out again. Entries are keyed by the string, the font texture, the size,
+	//the spacings and the wrap width and the least recently used ones are evicted first.
+	//If you cleanup a font and create another one call clear, the texture id might be reused.
+	struct TextLayoutCache
+	{
+		struct Glyph
+		{
+			Rect rect = {};
+			glm::vec4 textureCoords = {};
+		};
+
+		//the wrapped layouts have their own kinds, a wrap width of 0 still wraps at every space
+		enum Kind
+		{
+			glyphLayout,
+			textSize,
+			wrappedText,
+			wrappedGlyphLayout,
+			wrappedTextSize,
+		};
+
+		struct Key
+		{
+			size_t hash = 0;
+			GLuint font = 0;
+			int kind = 0;
+			float size = 0;
+			float spacing = 0;
+			float lineSpace = 0;
+			float wrapWidth = 0;
+			bool showInCenter = 0;
+
+			bool operator==(const Key &other) const
+			{
+				return hash == other.hash && font == other.font && kind == other.kind &&
+					size == other.size && spacing == other.spacing && lineSpace == other.lineSpace &&
+					wrapWidth == other.wrapWidth && showInCenter == other.showInCenter;
+			}
+		};
+
+		struct KeyHasher
+		{
+			size_t operator()(const Key &k) const;
+		};
+
+		struct Entry
+		{
+			Key key = {};
+			std::string text;
+			std::vector<Glyph> glyphs;
+			glm::vec2 textSize = {};
+			std::string wrapped;
+			int lineCount = 0;
+		};
+
+		//maximum number of entries, 0 disables the cache
+		size_t capacity = 1024;
+
+		size_t hits = 0;
+		size_t misses = 0;
+
+		std::list<Entry> entries; //most recently used first
+		std::unordered_map<Key, std::list<Entry>::iterator, KeyHasher> lookup;
+
+		static Key makeKey(Kind kind, std::string_view text, const Font &font, float size,
+			float spacing = 0, float lineSpace = 0, float wrapWidth = 0, bool showInCenter = 0);
+
+		//returns nullptr on a miss, on a hit the entry becomes the most recently used
+		Entry *find(const Key &key, std::string_view text);
+
+		//adds a new empty entry, evicting the least recently used one if the cache is full.
+		//The returned entry stays valid until the next insert or clear.
+		Entry &insert(const Key &key, std::string_view text);
+
+		size_t size() const { return entries.size(); }
+
+		void clear();
+	};
+
 	enum Renderer2DBufferType
 	{
 		quadPositions,
@@ -407,6 +560,10 @@ namespace gl2d
 			//texturePositionsCount = 0;
 		}
 
+		//Text layouts are looked up here before measuring the text again,
+		//set textLayoutCache.capacity to 0 to disable it.
+		TextLayoutCache textLayoutCache;
+
 		glm::vec2 getTextSize(const char *text, const Font font, const float size = 1.5f,
 			const float spacing = 4, const float line_space = 3);
 
@@ -500,6 +657,16 @@ namespace gl2d
 		//will reset on the current stack
 		void resetCameraAndShader();
 
+		//Copies the current camera and window metrics into the command buffer and clears it.
+		//Call this on the rendering thread before handing the buffer to a worker.
+		void beginCommandBuffer(CommandBuffer &commandBuffer);
+
+		//Appends the quads recorded in the command buffers to this renderer, in the order
+		//of the array, so the result is the same as if they were rendered here one after another.
+		//Call it after all the workers have finished, the buffers are not cleared.
+		void submitCommandBuffers(const CommandBuffer *commandBuffers, size_t count);
+		void submitCommandBuffer(const CommandBuffer &commandBuffer) { submitCommandBuffers(&commandBuffer, 1); }
+
 		//Only when this function is called it draws to the screen the things rendered.
 		//If clearDrawData is false, the rendering information will be kept.
 		//Usefull if you want to render something twice or render again on top for some reason
@@ -1,5 +1,5 @@
 //////////////////////////////////////////////////
-//gl2d.cpp				1.5.0
+//gl2d.cpp				1.5.3
 //Copyright(c) 2020 Luta Vlad
 //https://github.com/meemknight/gl2d
 // 
@@ -54,6 +54,18 @@
 // started to add some more needed text functions
 // needed to be tested tho
 // 
+// 1.5.1
+// command buffers that can be recorded on 
+//  other threads and submitted to the renderer
+// 
+// 1.5.2
+// text layout cache so unchanged text isn't
+//  measured and laid out every frame
+// 
+// 1.5.3
+// signed distance field fonts with an
+//  optional disk cache for the baked atlas
+// 
 /////////////////////////////////////////////////////////
 
 
@@ -76,6 +88,7 @@
 #include <sstream>
 #include <algorithm>
 #include <iostream>
+#include <limits>
 
 //if you are not using visual studio make shure you link to "Opengl32.lib"
 #ifdef _MSC_VER
@@ -122,6 +135,25 @@ namespace gl2d
 		"    color = v_color * texture2D(u_sampler, v_texture);\n"
 		"}\n";
 
+	static ShaderProgram sdfFontShader = {};
+
+	//the distance is stored in the alpha channel, 0.5 is the glyph edge.
+	//fwidth keeps the edge about one pixel wide at any text size.
+	static const char *sdfFontFragmentShader =
+		GL2D_OPNEGL_SHADER_VERSION "\n"
+		GL2D_OPNEGL_SHADER_PRECISION "\n"
+		"out vec4 color;\n"
+		"in vec4 v_color;\n"
+		"in vec2 v_texture;\n"
+		"uniform sampler2D u_sampler;\n"
+		"void main()\n"
+		"{\n"
+		"    float d = texture(u_sampler, v_texture).a;\n"
+		"    float w = max(fwidth(d), 0.0001);\n"
+		"    float a = smoothstep(0.5 - w, 0.5 + w, d);\n"
+		"    color = vec4(v_color.rgb, v_color.a * a);\n"
+		"}\n";
+
 #pragma endregion
 
 	static errorFuncType* errorFunc = defaultErrorFunc;
@@ -251,6 +283,7 @@ namespace gl2d
 	#endif
 
 		defaultShader = createShaderProgram(defaultVertexShader, defaultFragmentShader);
+		sdfFontShader = createShaderProgram(defaultVertexShader, sdfFontFragmentShader);
 		white1pxSquareTexture.create1PxSquare();
 
 		enableNecessaryGLFeatures();
@@ -260,6 +293,8 @@ namespace gl2d
 	{
 		white1pxSquareTexture.cleanup();
 		glDeleteShader(defaultShader.id);
+		glDeleteProgram(sdfFontShader.id);
+		sdfFontShader = {};
 		hasInitialized = false;
 	}
 
@@ -350,6 +385,11 @@ namespace gl2d
 		return shader;
 	}
 
+	ShaderProgram getSDFFontShader()
+	{
+		return sdfFontShader;
+	}
+
 #pragma endregion
 
 	///////////////////// Texture /////////////////////
@@ -441,7 +481,7 @@ namespace gl2d
 		delete[] fontMonochromeBuffer;
 		delete[] fontRgbaBuffer;
 
-		for (char c = ' '; c <= '~'; c++)
+		for (char c = ' '; c < '~'; c++)
 		{
 			const stbtt_aligned_quad  q = internal::fontGetGlyphQuad(*this, c);
 			const float               m = q.y1 - q.y0;
@@ -480,6 +520,254 @@ namespace gl2d
 		delete[] fileData;
 	}
 
+	//createFromTTF bakes the glyphs at this pixel height,
+	//sdf fonts scale their metrics to it so both kinds of fonts lay out text the same
+	static constexpr float fontBakeSize = 65;
+
+	struct SDFFontCacheHeader
+	{
+		char magic[8] = {'g','l','2','d','s','d','f','1'};
+		unsigned long long ttfHash = 0;
+		int bakeSize = 0;
+		int padding = 0;
+		int atlasW = 0;
+		int atlasH = 0;
+		int packedCharsBufferSize = 0;
+	};
+
+	//fnv-1a, only used to check that a cache file belongs to the ttf data
+	static unsigned long long hashFontData(const unsigned char *data, size_t size)
+	{
+		unsigned long long h = 14695981039346656037ull;
+		for (size_t i = 0; i < size; i++)
+		{
+			h ^= data[i];
+			h *= 1099511628211ull;
+		}
+		return h;
+	}
+
+	static bool loadSDFFontCache(const char *cacheFile, const SDFFontCacheHeader &expected,
+		std::vector<unsigned char> &atlas, std::vector<stbtt_packedchar> &chars, glm::ivec2 &atlasSize)
+	{
+		std::ifstream file(cacheFile, std::ios::binary);
+		if (!file.is_open()) { return false; }
+
+		SDFFontCacheHeader header;
+		file.read((char *)&header, sizeof(header));
+
+		if (!file || memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 ||
+			header.ttfHash != expected.ttfHash || header.bakeSize != expected.bakeSize ||
+			header.padding != expected.padding ||
+			header.packedCharsBufferSize != expected.packedCharsBufferSize ||
+			header.atlasW <= 0 || header.atlasH <= 0 || header.atlasW > 8192 || header.atlasH > 8192)
+		{
+			return false;
+		}
+
+		chars.resize(header.packedCharsBufferSize);
+		atlas.resize((size_t)header.atlasW * header.atlasH);
+		file.read((char *)chars.data(), chars.size() * sizeof(stbtt_packedchar));
+		file.read((char *)atlas.data(), atlas.size());
+
+		if (!file) { return false; }
+
+		atlasSize = {header.atlasW, header.atlasH};
+		return true;
+	}
+
+	static void saveSDFFontCache(const char *cacheFile, const SDFFontCacheHeader &header,
+		const std::vector<unsigned char> &atlas, const std::vector<stbtt_packedchar> &chars)
+	{
+		std::ofstream file(cacheFile, std::ios::binary);
+
+		if (!file.is_open())
+		{
+			char c[300] = {0};
+			strcat(c, "error writing sdf font cache: ");
+			strncat(c + strlen(c), cacheFile, 250);
+			errorFunc(c, userDefinedData);
+			return;
+		}
+
+		file.write((const char *)&header, sizeof(header));
+		file.write((const char *)chars.data(), chars.size() * sizeof(stbtt_packedchar));
+		file.write((const char *)atlas.data(), atlas.size());
+	}
+
+	void Font::createFromTTFSDF(const unsigned char *ttf_data, const size_t ttf_data_size,
+		const char *cacheFile, int bakeSize)
+	{
+		bakeSize = std::max(bakeSize, 8);
+		const int padding = std::max(2, bakeSize / 8);
+		const int charCount = ('~' - ' ');
+
+		SDFFontCacheHeader header;
+		header.ttfHash = hashFontData(ttf_data, ttf_data_size);
+		header.bakeSize = bakeSize;
+		header.padding = padding;
+		header.packedCharsBufferSize = charCount;
+
+		std::vector<unsigned char> atlas;
+		std::vector<stbtt_packedchar> chars;
+		glm::ivec2 atlasSize = {};
+
+		const bool loadedFromCache = cacheFile && 
+			loadSDFFontCache(cacheFile, header, atlas, chars, atlasSize);
+
+		if (!loadedFromCache)
+		{
+			stbtt_fontinfo info = {};
+			if (!stbtt_InitFont(&info, ttf_data, stbtt_GetFontOffsetForIndex(ttf_data, 0)))
+			{
+				errorFunc("error loading ttf data for sdf font", userDefinedData);
+				return;
+			}
+
+			const float scale = stbtt_ScaleForPixelHeight(&info, (float)bakeSize);
+			const float metricsScale = fontBakeSize / bakeSize;
+
+			struct Glyph
+			{
+				unsigned char *bitmap = 0;
+				int w = 0, h = 0, xoff = 0, yoff = 0;
+				int x = 0, y = 0;
+			};
+
+			std::vector<Glyph> glyphs(charCount);
+			size_t area = 0;
+
+			for (int i = 0; i < charCount; i++)
+			{
+				Glyph &g = glyphs[i];
+				g.bitmap = stbtt_GetCodepointSDF(&info, scale, ' ' + i, padding, 128, 128.f / padding,
+					&g.w, &g.h, &g.xoff, &g.yoff);
+				if (!g.bitmap) { g.w = 0; g.h = 0; }
+				area += (size_t)(g.w + 1) * (g.h + 1);
+			}
+
+			//simple shelf packing, the glyphs have similar heights so little space is wasted
+			int atlasW = 64;
+			while ((size_t)atlasW * atlasW < area * 5 / 4) { atlasW *= 2; }
+
+			int x = 0, y = 0, rowH = 0;
+			for (auto &g : glyphs)
+			{
+				if (!g.bitmap) { continue; }
+				if (x + g.w > atlasW) { x = 0; y += rowH + 1; rowH = 0; }
+				g.x = x;
+				g.y = y;
+				x += g.w + 1;
+				rowH = std::max(rowH, g.h);
+			}
+
+			atlasSize = {atlasW, std::max(y + rowH, 1)};
+			atlas.assign((size_t)atlasSize.x * atlasSize.y, 0);
+			chars.assign(charCount, stbtt_packedchar{});
+
+			for (int i = 0; i < charCount; i++)
+			{
+				Glyph &g = glyphs[i];
+
+				int advance = 0, leftSideBearing = 0;
+				stbtt_GetCodepointHMetrics(&info, ' ' + i, &advance, &leftSideBearing);
+				chars[i].xadvance = advance * scale * metricsScale;
+
+				if (!g.bitmap) { continue; }
+
+				for (int row = 0; row < g.h; row++)
+				{
+					memcpy(&atlas[(size_t)(g.y + row) * atlasSize.x + g.x], g.bitmap + row * g.w, g.w);
+				}
+
+				//the quad only covers the glyph box, not the padding, so the glyph metrics
+				//match the bitmap fonts. The distance field inside the box is all the shader needs.
+				chars[i].x0 = (unsigned short)(g.x + padding);
+				chars[i].y0 = (unsigned short)(g.y + padding);
+				chars[i].x1 = (unsigned short)(g.x + g.w - padding);
+				chars[i].y1 = (unsigned short)(g.y + g.h - padding);
+				chars[i].xoff = (g.xoff + padding) * metricsScale;
+				chars[i].yoff = (g.yoff + padding) * metricsScale;
+				chars[i].xoff2 = (g.xoff + g.w - padding) * metricsScale;
+				chars[i].yoff2 = (g.yoff + g.h - padding) * metricsScale;
+
+				stbtt_FreeSDF(g.bitmap, nullptr);
+				g.bitmap = 0;
+			}
+
+			if (cacheFile)
+			{
+				header.atlasW = atlasSize.x;
+				header.atlasH = atlasSize.y;
+				saveSDFFontCache(cacheFile, header, atlas, chars);
+			}
+		}
+
+		size = atlasSize;
+		max_height = 0;
+		sdf = true;
+		packedCharsBufferSize = charCount;
+		packedCharsBuffer = new stbtt_packedchar[packedCharsBufferSize]{};
+		memcpy(packedCharsBuffer, chars.data(), charCount * sizeof(stbtt_packedchar));
+
+		//white glyphs, the distance goes in the alpha channel
+		std::vector<unsigned char> rgba(atlas.size() * 4, 255);
+		for (size_t i = 0; i < atlas.size(); i++)
+		{
+			rgba[i * 4 + 3] = atlas[i];
+		}
+
+		//Init texture
+		{
+			glGenTextures(1, &texture.id);
+			glBindTexture(GL_TEXTURE_2D, texture.id);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		}
+
+		//the glyphs packed are ' ' to '}', '~' - ' ' of them
+		for (char c = ' '; c < '~'; c++)
+		{
+			const stbtt_aligned_quad  q = internal::fontGetGlyphQuad(*this, c);
+			const float               m = q.y1 - q.y0;
+
+			if (m > max_height && m < 1.e+8f)
+			{
+				max_height = m;
+			}
+		}
+	}
+
+	void Font::createFromFileSDF(const char *file, const char *cacheFile, int bakeSize)
+	{
+		std::ifstream fileFont(file, std::ios::binary);
+
+		if (!fileFont.is_open())
+		{
+			char c[300] = {0};
+			strcat(c, "error openning: ");
+			strcat(c + strlen(c), file);
+			errorFunc(c, userDefinedData);
+			return;
+		}
+
+		int fileSize = 0;
+		fileFont.seekg(0, std::ios::end);
+		fileSize = (int)fileFont.tellg();
+		fileFont.seekg(0, std::ios::beg);
+		unsigned char *fileData = new unsigned char[fileSize];
+		fileFont.read((char *)fileData, fileSize);
+		fileFont.close();
+
+		createFromTTFSDF(fileData, fileSize, cacheFile, bakeSize);
+
+		delete[] fileData;
+	}
+
 	void Font::cleanup()
 	{
 		texture.cleanup();
@@ -628,9 +916,16 @@ namespace gl2d
 		renderRectangleAbsRotation(transforms, texture, colors, newOrigin, rotation, textureCoords);
 	}
 
-	void gl2d::Renderer2D::renderRectangleAbsRotation(const Rect transforms, 
+	//Used by both the renderer and the command buffers. It only touches the cpu side
+	//buffers of the target so it is safe to call from any thread.
+	template<class T>
+	static void pushQuadAbsRotation(T &target, const Rect transforms,
 		const Texture texture, const Color4f colors[4], const glm::vec2 origin, const float rotation, const glm::vec4 textureCoords)
 	{
+		const Camera &currentCamera = target.currentCamera;
+		const int windowW = target.windowW;
+		const int windowH = target.windowH;
+
 		Texture textureCopy = texture;
 
 		if (textureCopy.id == 0)
@@ -703,29 +998,35 @@ namespace gl2d
 		v3.y = internal::positionToScreenCoordsY(v3.y, (float)windowH);
 		v4.y = internal::positionToScreenCoordsY(v4.y, (float)windowH);
 
-		spritePositions.push_back(glm::vec2{ v1.x, v1.y });
-		spritePositions.push_back(glm::vec2{ v2.x, v2.y });
-		spritePositions.push_back(glm::vec2{ v4.x, v4.y });
+		target.spritePositions.push_back(glm::vec2{ v1.x, v1.y });
+		target.spritePositions.push_back(glm::vec2{ v2.x, v2.y });
+		target.spritePositions.push_back(glm::vec2{ v4.x, v4.y });
 
-		spritePositions.push_back(glm::vec2{ v2.x, v2.y });
-		spritePositions.push_back(glm::vec2{ v3.x, v3.y });
-		spritePositions.push_back(glm::vec2{ v4.x, v4.y });
+		target.spritePositions.push_back(glm::vec2{ v2.x, v2.y });
+		target.spritePositions.push_back(glm::vec2{ v3.x, v3.y });
+		target.spritePositions.push_back(glm::vec2{ v4.x, v4.y });
 
-		spriteColors.push_back(colors[0]);
-		spriteColors.push_back(colors[1]);
-		spriteColors.push_back(colors[3]);
-		spriteColors.push_back(colors[1]);
-		spriteColors.push_back(colors[2]);
-		spriteColors.push_back(colors[3]);
+		target.spriteColors.push_back(colors[0]);
+		target.spriteColors.push_back(colors[1]);
+		target.spriteColors.push_back(colors[3]);
+		target.spriteColors.push_back(colors[1]);
+		target.spriteColors.push_back(colors[2]);
+		target.spriteColors.push_back(colors[3]);
 
-		texturePositions.push_back(glm::vec2{ textureCoords.x, textureCoords.y }); //1
-		texturePositions.push_back(glm::vec2{ textureCoords.x, textureCoords.w }); //2
-		texturePositions.push_back(glm::vec2{ textureCoords.z, textureCoords.y }); //4
-		texturePositions.push_back(glm::vec2{ textureCoords.x, textureCoords.w }); //2
-		texturePositions.push_back(glm::vec2{ textureCoords.z, textureCoords.w }); //3
-		texturePositions.push_back(glm::vec2{ textureCoords.z, textureCoords.y }); //4
+		target.texturePositions.push_back(glm::vec2{ textureCoords.x, textureCoords.y }); //1
+		target.texturePositions.push_back(glm::vec2{ textureCoords.x, textureCoords.w }); //2
+		target.texturePositions.push_back(glm::vec2{ textureCoords.z, textureCoords.y }); //4
+		target.texturePositions.push_back(glm::vec2{ textureCoords.x, textureCoords.w }); //2
+		target.texturePositions.push_back(glm::vec2{ textureCoords.z, textureCoords.w }); //3
+		target.texturePositions.push_back(glm::vec2{ textureCoords.z, textureCoords.y }); //4
 
-		spriteTextures.push_back(textureCopy);
+		target.spriteTextures.push_back(textureCopy);
+	}
+
+	void gl2d::Renderer2D::renderRectangleAbsRotation(const Rect transforms, 
+		const Texture texture, const Color4f colors[4], const glm::vec2 origin, const float rotation, const glm::vec4 textureCoords)
+	{
+		pushQuadAbsRotation(*this, transforms, texture, colors, origin, rotation, textureCoords);
 	}
 
 	void Renderer2D::renderRectangle(const Rect transforms, const Color4f colors[4], const glm::vec2 origin, const float rotation)
@@ -1279,18 +1580,100 @@ namespace gl2d
 		return glm::vec4(v1.x, v1.y, v3.x, v3.y);
 	}
 
-	glm::vec2 Renderer2D::getTextSize(const char *text, const Font font,
-		const float size, const float spacing, const float line_space)
+	///////////////////// TextLayoutCache ///////////////////// 
+
+	size_t TextLayoutCache::KeyHasher::operator()(const Key &k) const
 	{
-		if (font.texture.id == 0)
+		size_t h = k.hash;
+		auto combine = [&](size_t v) { h ^= v + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2); };
+		combine(std::hash<GLuint>()(k.font));
+		combine(std::hash<int>()(k.kind));
+		combine(std::hash<float>()(k.size));
+		combine(std::hash<float>()(k.spacing));
+		combine(std::hash<float>()(k.lineSpace));
+		combine(std::hash<float>()(k.wrapWidth));
+		combine(k.showInCenter);
+		return h;
+	}
+
+	TextLayoutCache::Key TextLayoutCache::makeKey(Kind kind, std::string_view text, const Font &font, float size,
+		float spacing, float lineSpace, float wrapWidth, bool showInCenter)
+	{
+		Key k;
+		k.hash = std::hash<std::string_view>()(text);
+		k.font = font.texture.id;
+		k.kind = kind;
+		k.size = size;
+		k.spacing = spacing;
+		k.lineSpace = lineSpace;
+		k.wrapWidth = wrapWidth;
+		k.showInCenter = showInCenter;
+		return k;
+	}
+
+	TextLayoutCache::Entry *TextLayoutCache::find(const Key &key, std::string_view text)
+	{
+		if (!capacity) { return nullptr; }
+
+		auto found = lookup.find(key);
+
+		//the text is compared too so a hash collision can't return the wrong layout
+		if (found == lookup.end() || found->second->text != text)
 		{
-			errorFunc("Missing font", userDefinedData);
-			return {};
+			misses++;
+			return nullptr;
+		}
+
+		hits++;
+		entries.splice(entries.begin(), entries, found->second);
+		return &entries.front();
+	}
+
+	TextLayoutCache::Entry &TextLayoutCache::insert(const Key &key, std::string_view text)
+	{
+		auto found = lookup.find(key);
+		if (found != lookup.end())
+		{
+			//same key but different text (a collision), reuse the entry
+			entries.splice(entries.begin(), entries, found->second);
+		}
+		else if (capacity && entries.size() >= capacity)
+		{
+			//recycle the least recently used entry so its buffers keep their memory
+			lookup.erase(entries.back().key);
+			entries.splice(entries.begin(), entries, std::prev(entries.end()));
+		}
+		else
+		{
+			entries.emplace_front();
 		}
 
+		Entry &e = entries.front();
+		e.key = key;
+		e.text.assign(text.data(), text.size());
+		e.glyphs.clear();
+		e.textSize = {};
+		e.wrapped.clear();
+		e.lineCount = 0;
+
+		lookup[key] = entries.begin();
+
+		return e;
+	}
+
+	void TextLayoutCache::clear()
+	{
+		entries.clear();
+		lookup.clear();
+	}
+
+	///////////////////// Renderer2D - text ///////////////////// 
+
+	static glm::vec2 measureText(const char *text, const int text_length, const Font &font,
+		const float size, const float spacing, const float line_space)
+	{
 		glm::vec2 position = {};
 
-		const int text_length = (int)strlen(text);
 		Rect rectangle = {};
 		rectangle.x = position.x;
 		float linePositionY = position.y;
@@ -1358,6 +1741,33 @@ namespace gl2d
 
 	}
 
+	glm::vec2 Renderer2D::getTextSize(const char *text, const Font font,
+		const float size, const float spacing, const float line_space)
+	{
+		if (font.texture.id == 0)
+		{
+			errorFunc("Missing font", userDefinedData);
+			return {};
+		}
+
+		const std::string_view view(text);
+		const auto key = TextLayoutCache::makeKey(TextLayoutCache::textSize, view, font, size, spacing, line_space);
+
+		if (auto entry = textLayoutCache.find(key, view))
+		{
+			return entry->textSize;
+		}
+
+		glm::vec2 rez = measureText(text, (int)view.size(), font, size, spacing, line_space);
+
+		if (textLayoutCache.capacity)
+		{
+			textLayoutCache.insert(key, view).textSize = rez;
+		}
+
+		return rez;
+	}
+
 	float Renderer2D::determineTextRescaleFitSmaller(const std::string &str,
 		gl2d::Font &f, glm::vec4 transform, float maxSize)
 	{
@@ -1451,7 +1861,7 @@ namespace gl2d
 		return ret;
 	}
 
-	int  Renderer2D::wrap(const std::string &in, gl2d::Font &f,
+	static int wrapText(const std::string &in, const gl2d::Font &f,
 		float baseSize, float maxDimension, std::string *outRez)
 	{
 		if (outRez)
@@ -1520,7 +1930,7 @@ namespace gl2d
 				if (!wrap && !newLine)
 				{
 					float size = baseSize;
-					auto textSize = getTextSize(currentLine.c_str(), f, size);
+					auto textSize = measureText(currentLine.c_str(), (int)currentLine.size(), f, size, 4, 3);
 
 					if (textSize.x >= maxDimension && !newLine)
 					{
@@ -1544,35 +1954,53 @@ namespace gl2d
 		return newLineCounter + 1;
 	}
 
-	void Renderer2D::renderText(glm::vec2 position, const char *text, const Font font,
-		const Color4f color, const float size, const float spacing, const float line_space, bool showInCenter,
-		const Color4f ShadowColor
-		, const Color4f LightColor
-	)
+	int Renderer2D::wrap(const std::string &in, gl2d::Font &f,
+		float baseSize, float maxDimension, std::string *outRez)
 	{
-		if (font.texture.id == 0)
+		const auto key = TextLayoutCache::makeKey(TextLayoutCache::wrappedText, in, f, baseSize,
+			0, 0, maxDimension);
+
+		if (auto entry = textLayoutCache.find(key, in))
 		{
-			errorFunc("Missing font", userDefinedData);
-			return;
+			if (outRez) { *outRez = entry->wrapped; }
+			return entry->lineCount;
 		}
 
-		const int text_length = (int)strlen(text);
-		Rect rectangle;
-		rectangle.x = position.x;
-		float linePositionY = position.y;
+		if (!textLayoutCache.capacity)
+		{
+			return wrapText(in, f, baseSize, maxDimension, outRez);
+		}
+
+		auto &entry = textLayoutCache.insert(key, in);
+		entry.lineCount = wrapText(in, f, baseSize, maxDimension, &entry.wrapped);
+
+		if (outRez) { *outRez = entry.wrapped; }
+		return entry.lineCount;
+	}
+
+	//Computes the glyph quads relative to the text position,
+	//the origin is the bottom left corner (or the center if showInCenter is set)
+	static void layoutText(std::vector<TextLayoutCache::Glyph> &glyphs, const char *text, const int text_length,
+		const Font &font, const float size, const float spacing, const float line_space, bool showInCenter)
+	{
+		glyphs.clear();
+
+		Rect rectangle = {};
+		float linePositionY = 0;
+		glm::vec2 offset = {};
 
 		if (showInCenter)
 		{
 			//This is the y position we render at because it advances when we encounter newlines
 
-			float maxPos = 0;
-			float maxPosY = 0;
+			float maxPos = std::numeric_limits<float>::lowest();
+			float maxPosY = std::numeric_limits<float>::lowest();
 
 			for (int i = 0; i < text_length; i++)
 			{
 				if (text[i] == '\n')
 				{
-					rectangle.x = position.x;
+					rectangle.x = 0;
 					linePositionY += (font.max_height + line_space) * size;
 				}
 				else if (text[i] == '\t')
@@ -1604,32 +2032,31 @@ namespace gl2d
 
 					rectangle.y = linePositionY + quad.y0 * size;
 
-
 					rectangle.x += rectangle.z + spacing * size;
 					maxPos = std::max(maxPos, rectangle.x);
 					maxPosY = std::max(maxPosY, rectangle.y);
 				}
 			}
 
-			float padd = maxPos - position.x;
-			padd /= 2;
-			position.x -= padd;
-
-			float paddY = maxPosY - position.y;
-			position.y -= paddY;
+			//nothing visible, nothing to center
+			if (maxPos != std::numeric_limits<float>::lowest())
+			{
+				offset.x = -maxPos / 2;
+				offset.y = -maxPosY;
+			}
 		}
 
 		rectangle = {};
-		rectangle.x = position.x;
+		rectangle.x = offset.x;
 
 		//This is the y position we render at because it advances when we encounter newlines
-		linePositionY = position.y;
+		linePositionY = offset.y;
 
 		for (int i = 0; i < text_length; i++)
 		{
 			if (text[i] == '\n')
 			{
-				rectangle.x = position.x;
+				rectangle.x = offset.x;
 				linePositionY += (font.max_height + line_space) * size;
 			}
 			else if (text[i] == '\t')
@@ -1649,7 +2076,6 @@ namespace gl2d
 			}
 			else if (text[i] >= ' ' && text[i] <= '~')
 			{
-
 				const stbtt_aligned_quad quad = internal::fontGetGlyphQuad
 				(font, text[i]);
 
@@ -1659,64 +2085,225 @@ namespace gl2d
 				rectangle.z *= size;
 				rectangle.w *= size;
 
-				//rectangle.y = linePositionY - rectangle.w;
 				rectangle.y = linePositionY + quad.y0 * size;
 
-				glm::vec4 colorData[4] = {color, color, color, color};
+				glyphs.push_back({rectangle, glm::vec4{quad.s0, quad.t0, quad.s1, quad.t1}});
 
-				if (ShadowColor.w)
-				{
-					glm::vec2 pos = {-5, 3};
-					pos *= size;
-					renderRectangle({rectangle.x + pos.x, rectangle.y + pos.y,  rectangle.z, rectangle.w},
-						font.texture, ShadowColor, glm::vec2{0, 0}, 0,
-						glm::vec4{quad.s0, quad.t0, quad.s1, quad.t1});
-
-				}
+				rectangle.x += rectangle.z + spacing * size;
+			}
+		}
+	}
 
-				renderRectangle(rectangle, font.texture, colorData, glm::vec2{0, 0}, 0,
-					glm::vec4{quad.s0, quad.t0, quad.s1, quad.t1});
+	static void renderGlyphs(Renderer2D &renderer, glm::vec2 position, const std::vector<TextLayoutCache::Glyph> &glyphs,
+		const Font &font, const Color4f color, const float size, const Color4f ShadowColor, const Color4f LightColor)
+	{
+		glm::vec4 colorData[4] = {color, color, color, color};
 
-				if (LightColor.w)
-				{
-					glm::vec2 pos = {-2, 1};
-					pos *= size;
-					renderRectangle({rectangle.x + pos.x, rectangle.y + pos.y,  rectangle.z, rectangle.w},
-						font.texture,
-						LightColor, glm::vec2{0, 0}, 0,
-						glm::vec4{quad.s0, quad.t0, quad.s1, quad.t1});
+		for (auto &g : glyphs)
+		{
+			Rect rectangle = g.rect;
+			rectangle.x += position.x;
+			rectangle.y += position.y;
 
-				}
+			if (ShadowColor.w)
+			{
+				glm::vec2 pos = {-5, 3};
+				pos *= size;
+				renderer.renderRectangle({rectangle.x + pos.x, rectangle.y + pos.y,  rectangle.z, rectangle.w},
+					font.texture, ShadowColor, glm::vec2{0, 0}, 0, g.textureCoords);
+			}
 
+			renderer.renderRectangle(rectangle, font.texture, colorData, glm::vec2{0, 0}, 0, g.textureCoords);
 
-				rectangle.x += rectangle.z + spacing * size;
+			if (LightColor.w)
+			{
+				glm::vec2 pos = {-2, 1};
+				pos *= size;
+				renderer.renderRectangle({rectangle.x + pos.x, rectangle.y + pos.y,  rectangle.z, rectangle.w},
+					font.texture, LightColor, glm::vec2{0, 0}, 0, g.textureCoords);
 			}
 		}
 	}
 
+	void Renderer2D::renderText(glm::vec2 position, const char *text, const Font font,
+		const Color4f color, const float size, const float spacing, const float line_space, bool showInCenter,
+		const Color4f ShadowColor
+		, const Color4f LightColor
+	)
+	{
+		if (font.texture.id == 0)
+		{
+			errorFunc("Missing font", userDefinedData);
+			return;
+		}
+
+		const std::string_view view(text);
+		const auto key = TextLayoutCache::makeKey(TextLayoutCache::glyphLayout, view, font, size,
+			spacing, line_space, 0, showInCenter);
+
+		if (auto entry = textLayoutCache.find(key, view))
+		{
+			renderGlyphs(*this, position, entry->glyphs, font, color, size, ShadowColor, LightColor);
+			return;
+		}
+
+		if (!textLayoutCache.capacity)
+		{
+			std::vector<TextLayoutCache::Glyph> glyphs;
+			layoutText(glyphs, text, (int)view.size(), font, size, spacing, line_space, showInCenter);
+			renderGlyphs(*this, position, glyphs, font, color, size, ShadowColor, LightColor);
+			return;
+		}
+
+		auto &entry = textLayoutCache.insert(key, view);
+		layoutText(entry.glyphs, text, (int)view.size(), font, size, spacing, line_space, showInCenter);
+		renderGlyphs(*this, position, entry.glyphs, font, color, size, ShadowColor, LightColor);
+	}
+
 	void Renderer2D::renderTextWrapped(const std::string &text,
 		gl2d::Font f, glm::vec4 textPos, glm::vec4 color, float baseSize,
 		float spacing, float lineSpacing,
 		bool showInCenter, glm::vec4 shadowColor, glm::vec4 lightColor)
 	{
+		if (f.texture.id == 0)
+		{
+			errorFunc("Missing font", userDefinedData);
+			return;
+		}
+
+		//the wrapped layout is cached directly so a hit skips both the wrapping and the layout
+		const auto key = TextLayoutCache::makeKey(TextLayoutCache::wrappedGlyphLayout, text, f, baseSize,
+			spacing, lineSpacing, textPos.z, showInCenter);
+
+		if (auto entry = textLayoutCache.find(key, text))
+		{
+			renderGlyphs(*this, textPos, entry->glyphs, f, color, baseSize, shadowColor, lightColor);
+			return;
+		}
+
 		std::string newText;
-		wrap(text, f, baseSize, textPos.z, &newText);
-		renderText(textPos,
-			newText.c_str(), f, color, baseSize, spacing, lineSpacing, showInCenter,
-			shadowColor, lightColor);
+		wrapText(text, f, baseSize, textPos.z, &newText);
+
+		if (!textLayoutCache.capacity)
+		{
+			std::vector<TextLayoutCache::Glyph> glyphs;
+			layoutText(glyphs, newText.c_str(), (int)newText.size(), f, baseSize, spacing, lineSpacing, showInCenter);
+			renderGlyphs(*this, textPos, glyphs, f, color, baseSize, shadowColor, lightColor);
+			return;
+		}
+
+		auto &entry = textLayoutCache.insert(key, text);
+		layoutText(entry.glyphs, newText.c_str(), (int)newText.size(), f, baseSize, spacing, lineSpacing, showInCenter);
+		renderGlyphs(*this, textPos, entry.glyphs, f, color, baseSize, shadowColor, lightColor);
 	}
 
 	glm::vec2 Renderer2D::getTextSizeWrapped(const std::string &text,
 		gl2d::Font f, float maxTextLenght, float baseSize, float spacing, float lineSpacing)
 	{
+		if (f.texture.id == 0)
+		{
+			errorFunc("Missing font", userDefinedData);
+			return {};
+		}
+
+		const auto key = TextLayoutCache::makeKey(TextLayoutCache::wrappedTextSize, text, f, baseSize,
+			spacing, lineSpacing, maxTextLenght);
+
+		if (auto entry = textLayoutCache.find(key, text))
+		{
+			return entry->textSize;
+		}
+
 		std::string newText;
-		wrap(text, f, baseSize, maxTextLenght, &newText);
-		auto rez = getTextSize(
-			newText.c_str(), f, baseSize, spacing, lineSpacing);
+		wrapText(text, f, baseSize, maxTextLenght, &newText);
+		auto rez = measureText(newText.c_str(), (int)newText.size(), f, baseSize, spacing, lineSpacing);
+
+		if (textLayoutCache.capacity)
+		{
+			textLayoutCache.insert(key, text).textSize = rez;
+		}
 
 		return rez;
 	}
 
+	void Renderer2D::beginCommandBuffer(CommandBuffer &commandBuffer)
+	{
+		commandBuffer.clear();
+		commandBuffer.currentCamera = currentCamera;
+		commandBuffer.windowW = windowW;
+		commandBuffer.windowH = windowH;
+	}
+
+	void Renderer2D::submitCommandBuffers(const CommandBuffer *commandBuffers, size_t count)
+	{
+		size_t quads = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			quads += commandBuffers[i].spriteTextures.size();
+		}
+
+		//reserve once so merging is just a copy of each buffer
+		spritePositions.reserve(spritePositions.size() + quads * 6);
+		spriteColors.reserve(spriteColors.size() + quads * 6);
+		texturePositions.reserve(texturePositions.size() + quads * 6);
+		spriteTextures.reserve(spriteTextures.size() + quads);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			const CommandBuffer &c = commandBuffers[i];
+
+			spritePositions.insert(spritePositions.end(), c.spritePositions.begin(), c.spritePositions.end());
+			spriteColors.insert(spriteColors.end(), c.spriteColors.begin(), c.spriteColors.end());
+			texturePositions.insert(texturePositions.end(), c.texturePositions.begin(), c.texturePositions.end());
+			spriteTextures.insert(spriteTextures.end(), c.spriteTextures.begin(), c.spriteTextures.end());
+		}
+	}
+
+	///////////////////// CommandBuffer ///////////////////// 
+
+	void CommandBuffer::reserve(size_t quadCount)
+	{
+		spritePositions.reserve(quadCount * 6);
+		spriteColors.reserve(quadCount * 6);
+		texturePositions.reserve(quadCount * 6);
+		spriteTextures.reserve(quadCount);
+	}
+
+	void CommandBuffer::clear()
+	{
+		spritePositions.clear();
+		spriteColors.clear();
+		texturePositions.clear();
+		spriteTextures.clear();
+	}
+
+	void CommandBuffer::renderRectangle(const Rect transforms, const Texture texture, const Color4f colors[4], const glm::vec2 origin, const float rotation, const glm::vec4 textureCoords)
+	{
+		glm::vec2 newOrigin;
+		newOrigin.x = origin.x + transforms.x + (transforms.z / 2);
+		newOrigin.y = origin.y + transforms.y + (transforms.w / 2);
+		pushQuadAbsRotation(*this, transforms, texture, colors, newOrigin, rotation, textureCoords);
+	}
+
+	void CommandBuffer::renderRectangleAbsRotation(const Rect transforms, const Texture texture, const Color4f colors[4], const glm::vec2 origin, const float rotation, const glm::vec4 textureCoords)
+	{
+		pushQuadAbsRotation(*this, transforms, texture, colors, origin, rotation, textureCoords);
+	}
+
+	void CommandBuffer::renderRectangle(const Rect transforms, const Color4f colors[4], const glm::vec2 origin, const float rotation)
+	{
+		renderRectangle(transforms, white1pxSquareTexture, colors, origin, rotation);
+	}
+
+	void CommandBuffer::renderLine(const glm::vec2 start, const glm::vec2 end, const Color4f color, const float width)
+	{
+		glm::vec2 vector = end - start;
+		float length = glm::length(vector);
+		float angle = -glm::degrees(std::atan2(vector.y, vector.x));
+		renderRectangle({start - glm::vec2(0, width / 2.f), length, width},
+			color, {-length / 2, 0}, angle);
+	}
+
 	void Renderer2D::clearScreen(const Color4f color)
 	{
 		glBindFramebuffer(GL_FRAMEBUFFER, defaultFBO);
@@ -0,0 +1,171 @@
+//chip8-headless: runs a rom without a window, as fast as it goes.
+//usage: chip8-headless rom [--frames N] [--vip] [--replay movie.c8m] [--record movie.c8m]
+//       chip8-headless --serve socket [--threads N]
+//
+//--replay plays the keys of a movie and checks the state hash of every recorded frame,
+//the exit code is 1 if the run diverged from the recording.
+//--record saves a movie of the run (with no keys pressed) for later replays.
+//Without a movie the rom runs with the settings the analyzer picks.
+//--vip counts the machine cycles of the COSMAC VIP instead of instructions (a replay uses the timing of the movie).
+//--serve runs the emulation service on a Unix domain socket until it is killed, see chip8service/protocol.h.
+
+#include <chip8/chip8.h>
+#include <chip8/hash.h>
+#include <chip8/mappedFile.h>
+#include <chip8/movie.h>
+#include <chip8/romAnalyzer.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#ifdef CHIP8_SERVICE
+#include <chip8service/server.h>
+#include <thread>
+#endif
+
+//the state has the whole 64 KB of memory so it doesn't go on the stack
+static chip8::Chip8 emulator;
+
+int main(int argc, char *argv[])
+{
+	const char *romPath = nullptr;
+	const char *replayPath = nullptr;
+	const char *recordPath = nullptr;
+	long long frames = -1;
+	bool vipTiming = false;
+	const char *servePath = nullptr;
+	int threads = 0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!std::strcmp(argv[i], "--frames") && i + 1 < argc) { frames = std::atoll(argv[++i]); }
+		else if (!std::strcmp(argv[i], "--vip")) { vipTiming = true; }
+		else if (!std::strcmp(argv[i], "--replay") && i + 1 < argc) { replayPath = argv[++i]; }
+		else if (!std::strcmp(argv[i], "--record") && i + 1 < argc) { recordPath = argv[++i]; }
+		else if (!std::strcmp(argv[i], "--serve") && i + 1 < argc) { servePath = argv[++i]; }
+		else if (!std::strcmp(argv[i], "--threads") && i + 1 < argc) { threads = std::atoi(argv[++i]); }
+		else if (argv[i][0] != '-' && !romPath) { romPath = argv[i]; }
+		else
+		{
+			std::fprintf(stderr, "unknown argument %s\n", argv[i]);
+			return 2;
+		}
+	}
+
+	if (servePath)
+	{
+	#ifdef CHIP8_SERVICE
+		if (threads <= 0) { threads = (int)std::thread::hardware_concurrency(); }
+
+		//the sessions are 66 KB each, the server lives as long as the process
+		static chip8::ServiceServer server;
+		if (!server.start(servePath, threads))
+		{
+			std::fprintf(stderr, "%s\n", server.error.c_str());
+			return 2;
+		}
+		std::printf("serving on %s with %d threads\n", servePath, threads);
+		std::fflush(stdout);
+		server.run();
+		return 0;
+	#else
+		std::fprintf(stderr, "the service needs Unix domain sockets\n");
+		return 2;
+	#endif
+	}
+
+	if (!romPath)
+	{
+		std::fprintf(stderr, "usage: chip8-headless rom [--frames N] [--vip] [--replay movie.c8m] [--record movie.c8m]\n"
+			"       chip8-headless --serve socket [--threads N]\n");
+		return 2;
+	}
+
+	chip8::MappedFile rom;
+	if (!rom.open(romPath))
+	{
+		std::fprintf(stderr, "can't read %s\n", romPath);
+		return 2;
+	}
+	std::uint64_t romHash = chip8::xxHash64(rom.data, rom.size);
+
+	chip8::Movie movie;
+	chip8::MoviePlayer player;
+	if (replayPath)
+	{
+		if (!movie.load(replayPath))
+		{
+			std::fprintf(stderr, "can't read movie %s\n", replayPath);
+			return 2;
+		}
+		if (movie.romHash != romHash)
+		{
+			std::fprintf(stderr, "the movie was recorded with another rom\n");
+			return 2;
+		}
+
+		movie.resetEmulator(emulator);
+		player.start(movie);
+		if (frames < 0) { frames = movie.frameCount; }
+	}
+	else
+	{
+		chip8::RomAnalysis analysis = chip8::analyzeRom(rom.data, rom.size);
+		emulator.reset(analysis.platform, analysis.quirks);
+		emulator.instructionsPerFrame = analysis.instructionsPerFrame;
+		if (vipTiming) { emulator.timing = chip8::Timing::cosmacVip; }
+		if (frames < 0) { frames = 60 * 60; }
+	}
+
+	if (!emulator.loadRom(rom.data, rom.size))
+	{
+		std::fprintf(stderr, "the rom is too big for %s\n", chip8::platformName(emulator.platform));
+		return 2;
+	}
+
+	chip8::Movie recording;
+	if (recordPath) { recording.begin(emulator, romHash); }
+
+	auto start = std::chrono::steady_clock::now();
+
+	for (long long frame = 0; frame < frames; frame++)
+	{
+		std::uint16_t keys = replayPath ? player.keys() : 0;
+		emulator.setKeys(keys);
+		emulator.runFrame();
+
+		//the hash is only needed when something checks or stores it
+		if (replayPath || recordPath)
+		{
+			std::uint64_t stateHash = chip8::hashState(emulator.state);
+			if (replayPath && !player.endFrame(stateHash)) { break; }
+			if (recordPath) { recording.recordFrame(keys, stateHash); }
+		}
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::printf("%s: %s, %llu frames, %llu instructions in %.3f s (%.0f frames/s)\n", romPath,
+		chip8::platformName(emulator.platform),
+		(unsigned long long)emulator.state.frameCount, (unsigned long long)emulator.state.instructionCount,
+		seconds, seconds > 0 ? emulator.state.frameCount / seconds : 0.0);
+	std::printf("state hash %016llx\n", (unsigned long long)chip8::hashState(emulator.state));
+
+	if (recordPath && !recording.save(recordPath))
+	{
+		std::fprintf(stderr, "can't write movie %s\n", recordPath);
+		return 2;
+	}
+
+	if (replayPath)
+	{
+		if (player.desyncFrame >= 0)
+		{
+			std::printf("desync at frame %lld\n", (long long)player.desyncFrame);
+			return 1;
+		}
+		std::printf("replay matches the movie\n");
+	}
+
+	return 0;
+}
@@ -0,0 +1,307 @@
+//chip8-recompiler: translates the reachable code of a rom into c++ for a plugin.
+//usage: chip8-recompiler rom.ch8 output.cpp
+//
+//Every instruction the analyzer reaches becomes a case of one big switch on pc, consecutive
+//instructions fall through into each other so straight code runs without dispatching.
+//Drawing, scrolling, key waits and anything not reached statically are left to the interpreter:
+//the generated function returns and the core steps that instruction itself.
+//Each case checks that the opcode in memory is still the one that was translated,
+//so self modifying code goes back to the interpreter too.
+
+#include <chip8/chip8.h>
+#include <chip8/mappedFile.h>
+#include <chip8/romAnalyzer.h>
+#include <chip8/romLibrary.h>
+#include <cstdarg>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace chip8;
+
+static void append(std::string &out, const char *format, ...)
+{
+	char buffer[512] = {};
+	va_list args;
+	va_start(args, format);
+	std::vsnprintf(buffer, sizeof(buffer), format, args);
+	va_end(args);
+	out += buffer;
+}
+
+struct Translation
+{
+	const std::uint8_t *rom = nullptr;
+	std::size_t size = 0;
+	Platform platform = Platform::chip8;
+	Quirks quirks = {};
+	unsigned memoryMask = 0xFFF;
+
+	std::uint8_t byte(unsigned address) const
+	{
+		unsigned offset = address - programStart;
+		return offset < size ? rom[offset] : 0;
+	}
+};
+
+//the interpreter does these, they touch the display or wait for something
+static bool isLeftToInterpreter(std::uint16_t op)
+{
+	switch (op >> 12)
+	{
+	case 0x0: return op != 0x00EE;
+	case 0xD: return true;
+	case 0xF: return (op & 0xFF) == 0x0A;
+	}
+	return false;
+}
+
+//the code for one instruction, pc is the address of the instruction when it starts
+static void translate(std::string &out, const Translation &t, unsigned address, bool nextIsCase)
+{
+	const std::uint16_t op = (std::uint16_t)((t.byte(address) << 8) | t.byte(address + 1));
+	const int x = (op >> 8) & 0xF;
+	const int y = (op >> 4) & 0xF;
+	const int n = op & 0xF;
+	const int nn = op & 0xFF;
+	const int nnn = op & 0xFFF;
+	const unsigned mask = t.memoryMask;
+
+	unsigned next = address + 2;
+	if (op == 0xF000) { next = address + 4; }
+
+	append(out, "\tcase 0x%04X: //%04X\n\t{\n", address, op);
+
+	//the opcode can be changed by the program, then it isn't this code anymore
+	append(out, "\t\tif (m[0x%04X] != 0x%02X || m[0x%04X] != 0x%02X", address & mask, op >> 8, (address + 1) & mask, op & 0xFF);
+	if (op == 0xF000)
+	{
+		append(out, " || m[0x%04X] != 0x%02X || m[0x%04X] != 0x%02X",
+			(address + 2) & mask, t.byte(address + 2), (address + 3) & mask, t.byte(address + 3));
+	}
+	append(out, ") { goto done; }\n");
+
+	if (isLeftToInterpreter(op))
+	{
+		append(out, "\t\tgoto done;\n\t}\n");
+		return;
+	}
+
+	//the body, control flow ends the case with continue
+	std::string condition;
+
+	switch (op >> 12)
+	{
+	case 0x0: //00EE
+		append(out, "\t\ts.sp = (s.sp - 1) & %d; s.pc = s.stack[s.sp]; executed++; continue;\n\t}\n", stackSize - 1);
+		return;
+
+	case 0x1:
+		append(out, "\t\ts.pc = 0x%03X; executed++; continue;\n\t}\n", nnn);
+		return;
+
+	case 0x2:
+		append(out, "\t\ts.stack[s.sp] = 0x%04X; s.sp = (s.sp + 1) & %d; s.pc = 0x%03X; executed++; continue;\n\t}\n",
+			next & 0xFFFF, stackSize - 1, nnn);
+		return;
+
+	case 0x3: append(condition, "s.v[%d] == 0x%02X", x, nn); break;
+	case 0x4: append(condition, "s.v[%d] != 0x%02X", x, nn); break;
+
+	case 0x5:
+		if (n == 0) { append(condition, "s.v[%d] == s.v[%d]", x, y); }
+		else if (n == 2 || n == 3)
+		{
+			int step = x <= y ? 1 : -1;
+			for (int r = x, a = 0;; r += step, a++)
+			{
+				if (n == 2) { append(out, "\t\twriteMemory(s, (s.i + %d) & 0x%X, s.v[%d]);\n", a, mask, r); }
+				else { append(out, "\t\ts.v[%d] = m[(s.i + %d) & 0x%X];\n", r, a, mask); }
+				if (r == y) { break; }
+			}
+		}
+		break;
+
+	case 0x6: append(out, "\t\ts.v[%d] = 0x%02X;\n", x, nn); break;
+	case 0x7: append(out, "\t\ts.v[%d] += 0x%02X;\n", x, nn); break;
+
+	case 0x8:
+	{
+		const char *vfReset = t.quirks.vfReset ? " s.v[15] = 0;" : "";
+		const int shifted = t.quirks.shiftVx ? x : y;
+		switch (n)
+		{
+		case 0x0: append(out, "\t\ts.v[%d] = s.v[%d];\n", x, y); break;
+		case 0x1: append(out, "\t\ts.v[%d] |= s.v[%d];%s\n", x, y, vfReset); break;
+		case 0x2: append(out, "\t\ts.v[%d] &= s.v[%d];%s\n", x, y, vfReset); break;
+		case 0x3: append(out, "\t\ts.v[%d] ^= s.v[%d];%s\n", x, y, vfReset); break;
+		case 0x4: append(out, "\t\t{ int r = s.v[%d] + s.v[%d]; s.v[%d] = (std::uint8_t)r; s.v[15] = r > 0xFF; }\n", x, y, x); break;
+		case 0x5: append(out, "\t\t{ std::uint8_t f = s.v[%d] >= s.v[%d]; s.v[%d] -= s.v[%d]; s.v[15] = f; }\n", x, y, x, y); break;
+		case 0x6: append(out, "\t\t{ std::uint8_t value = s.v[%d]; s.v[%d] = value >> 1; s.v[15] = value & 1; }\n", shifted, x); break;
+		case 0x7: append(out, "\t\t{ std::uint8_t f = s.v[%d] >= s.v[%d]; s.v[%d] = s.v[%d] - s.v[%d]; s.v[15] = f; }\n", y, x, x, y, x); break;
+		case 0xE: append(out, "\t\t{ std::uint8_t value = s.v[%d]; s.v[%d] = (std::uint8_t)(value << 1); s.v[15] = value >> 7; }\n", shifted, x); break;
+		}
+	}
+	break;
+
+	case 0x9: if (n == 0) { append(condition, "s.v[%d] != s.v[%d]", x, y); } break;
+	case 0xA: append(out, "\t\ts.i = 0x%03X;\n", nnn); break;
+
+	case 0xB:
+		append(out, "\t\ts.pc = (std::uint16_t)(0x%03X + s.v[%d]); executed++; continue;\n\t}\n", nnn, t.quirks.jumpVx ? x : 0);
+		return;
+
+	case 0xC:
+		//the same xorshift as the interpreter so the runs stay deterministic
+		append(out, "\t\t{ std::uint32_t r = s.rng; r ^= r << 13; r ^= r >> 17; r ^= r << 5; s.rng = r; s.v[%d] = (std::uint8_t)(r >> 24) & 0x%02X; }\n", x, nn);
+		break;
+
+	case 0xE:
+		if (nn == 0x9E) { append(condition, "s.keys & (1 << (s.v[%d] & 15))", x); }
+		else if (nn == 0xA1) { append(condition, "!(s.keys & (1 << (s.v[%d] & 15)))", x); }
+		break;
+
+	case 0xF:
+		switch (nn)
+		{
+		case 0x00:
+			if (op == 0xF000) { append(out, "\t\ts.i = 0x%02X%02X;\n", t.byte(address + 2), t.byte(address + 3)); }
+			break;
+		case 0x01: append(out, "\t\ts.planeMask = %d;\n", x & 3); break;
+		case 0x02: append(out, "\t\tfor (int a = 0; a < 16; a++) { s.audioPattern[a] = m[(s.i + a) & 0x%X]; }\n", mask); break;
+		case 0x07: append(out, "\t\ts.v[%d] = s.delayTimer;\n", x); break;
+		case 0x15: append(out, "\t\ts.delayTimer = s.v[%d];\n", x); break;
+		case 0x18: append(out, "\t\ts.soundTimer = s.v[%d];\n", x); break;
+		case 0x1E: append(out, "\t\ts.i += s.v[%d];\n", x); break;
+		case 0x29: append(out, "\t\ts.i = (std::uint16_t)(0x%X + (s.v[%d] & 15) * 5);\n", smallFontAddress, x); break;
+		case 0x30: append(out, "\t\ts.i = (std::uint16_t)(0x%X + (s.v[%d] & 15) * 10);\n", bigFontAddress, x); break;
+		case 0x33:
+			append(out, "\t\twriteMemory(s, s.i & 0x%X, s.v[%d] / 100);\n", mask, x);
+			append(out, "\t\twriteMemory(s, (s.i + 1) & 0x%X, (s.v[%d] / 10) %% 10);\n", mask, x);
+			append(out, "\t\twriteMemory(s, (s.i + 2) & 0x%X, s.v[%d] %% 10);\n", mask, x);
+			break;
+		case 0x3A: append(out, "\t\ts.pitch = s.v[%d];\n", x); break;
+		case 0x55:
+			for (int r = 0; r <= x; r++) { append(out, "\t\twriteMemory(s, (s.i + %d) & 0x%X, s.v[%d]);\n", r, mask, r); }
+			if (t.quirks.memoryIncrement) { append(out, "\t\ts.i += %d;\n", x + 1); }
+			break;
+		case 0x65:
+			for (int r = 0; r <= x; r++) { append(out, "\t\ts.v[%d] = m[(s.i + %d) & 0x%X];\n", r, r, mask); }
+			if (t.quirks.memoryIncrement) { append(out, "\t\ts.i += %d;\n", x + 1); }
+			break;
+		case 0x75: append(out, "\t\tfor (int r = 0; r <= %d; r++) { s.flags[r] = s.v[r]; }\n", x); break;
+		case 0x85: append(out, "\t\tfor (int r = 0; r <= %d; r++) { s.v[r] = s.flags[r]; }\n", x); break;
+		}
+		break;
+	}
+
+	if (!condition.empty())
+	{
+		//xo-chip skips over the whole F000 NNNN, the interpreter checks the memory at run time too
+		if (t.platform == Platform::xoChip)
+		{
+			append(out, "\t\tif (%s) { s.pc = (m[0x%04X] == 0xF0 && m[0x%04X] == 0x00) ? 0x%04X : 0x%04X; executed++; continue; }\n",
+				condition.c_str(), next & mask, (next + 1) & mask, (next + 4) & 0xFFFF, (next + 2) & 0xFFFF);
+		}
+		else
+		{
+			append(out, "\t\tif (%s) { s.pc = 0x%04X; executed++; continue; }\n", condition.c_str(), (next + 2) & 0xFFFF);
+		}
+	}
+
+	append(out, "\t\ts.pc = 0x%04X; executed++;\n", next & 0xFFFF);
+	if (nextIsCase)
+	{
+		append(out, "\t\tif (executed >= budget) { goto done; }\n\t}\n\t[[fallthrough]];\n");
+	}
+	else
+	{
+		append(out, "\t\tcontinue;\n\t}\n");
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc < 3)
+	{
+		std::fprintf(stderr, "usage: chip8-recompiler rom output.cpp\n");
+		return 1;
+	}
+
+	MappedFile file;
+	if (!file.open(argv[1]) || !file.size)
+	{
+		std::fprintf(stderr, "can't read %s\n", argv[1]);
+		return 1;
+	}
+
+	std::vector<std::uint16_t> code;
+	RomAnalysis analysis = analyzeRom(file.data, file.size, &code);
+
+	Translation t;
+	t.rom = file.data;
+	t.size = file.size;
+	t.platform = analysis.platform;
+	t.quirks = analysis.quirks;
+	t.memoryMask = analysis.platform == Platform::xoChip ? 0xFFFF : 0xFFF;
+
+	std::uint64_t hash = xxHash64(file.data, file.size);
+
+	std::string out;
+	append(out, "//generated by chip8-recompiler from %s, don't edit\n", argv[1]);
+	append(out, "//%s, %d instructions\n", platformName(analysis.platform), (int)code.size());
+	out += "#include <chip8/recompiled.h>\n\n";
+	out += "using namespace chip8;\n\n";
+	out += "static int run(State &s, int budget)\n{\n";
+	out += "\tstd::uint8_t *m = s.memory;\n";
+	out += "\tint executed = 0;\n\n";
+	out += "\twhile (executed < budget)\n\t{\n";
+	out += "\tswitch (s.pc)\n\t{\n";
+
+	for (std::size_t i = 0; i < code.size(); i++)
+	{
+		const std::uint16_t op = (std::uint16_t)((t.byte(code[i]) << 8) | t.byte(code[i] + 1));
+		unsigned next = code[i] + (op == 0xF000 ? 4 : 2);
+		bool nextIsCase = i + 1 < code.size() && code[i + 1] == next;
+		translate(out, t, code[i], nextIsCase);
+	}
+
+	out += "\tdefault: goto done;\n";
+	out += "\t}\n";
+	out += "\t}\n\n";
+	out += "done:\n";
+	out += "\ts.instructionCount += executed;\n";
+	out += "\treturn executed;\n";
+	out += "}\n\n";
+
+	out += "static RecompiledRom makeRom()\n{\n";
+	out += "\tRecompiledRom rom;\n";
+	append(out, "\trom.romHash = 0x%016llxull;\n", (unsigned long long)hash);
+	append(out, "\trom.platform = (Platform)%d;\n", (int)analysis.platform);
+	append(out, "\trom.quirks = 0x%x;\n", quirksToBits(analysis.quirks));
+	append(out, "\trom.translatedInstructions = %d;\n", (int)code.size());
+	out += "\trom.run = run;\n";
+	out += "\treturn rom;\n}\n\n";
+
+	out += "CHIP8_PLUGIN_EXPORT const RecompiledRom *chip8GetRecompiledRom()\n{\n";
+	out += "\tstatic const RecompiledRom rom = makeRom();\n";
+	out += "\treturn &rom;\n}\n";
+
+	std::FILE *output = std::fopen(argv[2], "wb");
+	if (!output)
+	{
+		std::fprintf(stderr, "can't write %s\n", argv[2]);
+		return 1;
+	}
+	bool ok = std::fwrite(out.data(), 1, out.size(), output) == out.size();
+	ok = std::fclose(output) == 0 && ok;
+
+	if (!ok)
+	{
+		std::fprintf(stderr, "can't write %s\n", argv[2]);
+		return 1;
+	}
+
+	std::printf("%s: %s, %d instructions translated\n", argv[1], platformName(analysis.platform), (int)code.size());
+	return 0;
+}